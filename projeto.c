@@ -6,57 +6,387 @@
 #include <string.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <math.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <signal.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VARREDURA_X86 1  // núcleos SSE2/AVX2 disponíveis para as varreduras por colunas
+#endif
 #define MAX_HEAP 20  // capacidade máxima da estrutura de Heap (fila prioritária)
+#define MAX_TRIAGEM 5  // maior nível de triagem aceito (0 = paciente não triado)
+#define SUBFAIXAS_ESBOCO 8  // subdivisões por potência de 2 no esboço de percentis
+#define FAIXAS_ESBOCO 336   // faixas do esboço: cobre esperas de 0 ms até ~2^41 ms
+#define ANO_MINIMO 1900  // menor ano de entrada contabilizado nos agregados
+#define ANO_MAXIMO 2100  // maior ano de entrada contabilizado nos agregados
+#define ANOS_AGREGADOS (ANO_MAXIMO - ANO_MINIMO + 1)
+#define DATA_INVALIDA INT_MIN   // resultado de cria_data para dia/mês/ano inexistente ou fora da faixa
+#define TAMANHO_DATA_TEXTO 11   // "dd/mm/aaaa" com terminador
+#define IDADE_MAXIMA 120        // maior idade aceita no cadastro
+#define LARGURA_FAIXA_IDADE 10  // anos por faixa do histograma de idades
+#define FAIXAS_IDADE 13         // 0-9, 10-19, ..., 110-119 e 120+
+#define MAX_THREADS 16  // limite de threads usadas em tarefas paralelas
+#define LIMIAR_ORDENACAO_PARALELA 20000  // abaixo disso a ordenação roda em uma única thread
+#define ORDEM_ANO 0      // ordens disponíveis nos relatórios
+#define ORDEM_MES 1
+#define ORDEM_DIA 2
+#define ORDEM_IDADE 3
+#define QTDE_ORDENS 4
+#define TODAS_AS_ORDENS ((1 << QTDE_ORDENS) - 1)
+#define TAMANHO_ESCRITOR (1 << 16)  // bytes acumulados antes de cada gravação do relatório
+#define LAPIDE_INDICE ((ELista *)1)  // marca de posição removida no índice de RGs
+#define EXTENSAO_COMPACTADA ".pca"     // arquivos com esta extensão usam o formato compactado
+#define MAGICO_ARQUIVO_COMPACTADO "PCA1"
+#define REGISTROS_POR_BLOCO 4096       // registros por bloco colunar do arquivo compactado
+#define MAX_BYTES_BLOCO (REGISTROS_POR_BLOCO * 256)  // maior carga de bloco válida (um registro ocupa menos de 256 bytes)
+#define RG_DIGITOS 0   // RG formado só por dígitos
+#define RG_PONTUADO 1  // RG no padrão NN.NNN.NNN-N
+#define RG_TEXTO 2     // RG fora dos padrões, guardado como texto
+#define SALVAMENTO_NUNCA 0
+#define SALVAMENTO_EM_ANDAMENTO 1
+#define SALVAMENTO_CONCLUIDO 2
+#define SALVAMENTO_FALHOU 3
+#define ARQUIVO_REGISTRO_DISCO "dbPacientes.bpt"  // arquivo do registro em disco (B+tree)
+#define MAGICO_REGISTRO_DISCO "PBT1"
+#define TAMANHO_PAGINA 4096    // bytes por página do registro em disco
+#define CABECALHO_PAGINA 8     // tipo (1) + quantidade (2) + folha seguinte (4) + reserva (1)
+#define PAGINA_FOLHA 1
+#define PAGINA_INTERNA 2
+#define PAGINA_NENHUMA 0xFFFFFFFFu
+#define QUADROS_PADRAO 64      // quadros do cache de páginas (256 KB)
+#define QUADROS_MINIMOS 16     // mínimo para comportar as páginas fixadas durante uma inserção
+#define ARVORES_DISCO 3
+#define ARVORE_PRIMARIA 0      // RG -> registro completo
+#define ARVORE_NOME 1          // nome + RG
+#define ARVORE_DATA 2          // data de entrada + RG
+#define TAMANHO_CHAVE_RG 20
+#define TAMANHO_NOME_DISCO 100
+#define TAMANHO_MAX_CHAVE (TAMANHO_NOME_DISCO + TAMANHO_CHAVE_RG)
+#define TAMANHO_REGISTRO_DISCO (TAMANHO_NOME_DISCO + 20 + 4 * (int)sizeof(int))
+#define LARGURA_RG_COLUNA 32   // bytes por RG na coluna de dígitos (zeros ao final)
+#define VARREDURA_ESCALAR 0
+#define VARREDURA_SSE2 1
+#define VARREDURA_AVX2 2
+#define OP_CADASTRAR 1             // tipos de operação da sessão (gravados no arquivo de sessão)
+#define OP_CONSULTAR_NOME 2
+#define OP_ATUALIZAR 3
+#define OP_REMOVER 4
+#define OP_LISTAR 5
+#define OP_ENFILEIRAR 6
+#define OP_DESENFILEIRAR 7
+#define OP_INSERIR_PRIORITARIO 8
+#define OP_ATENDER_PRIORITARIO 9
+#define OP_CRITERIO 10
+#define OP_RELATORIO 11
+#define OP_DESFAZER 12
+#define OP_CARREGAR 13
+#define OP_IMPORTAR 14
+#define OP_SALVAR 15
+#define OP_DESISTIR 16             // paciente deixa a fila comum antes de ser atendido
+#define OP_POSICAO_FILA 17
+#define OP_DESISTIR_PRIORITARIO 18
+#define OP_POSICAO_PRIORITARIO 19
+#define QTDE_TIPOS_OPERACAO 20
+#define OPERACAO_OK 1              // resultados de executar_operacao
+#define OPERACAO_NAO_ENCONTRADO 0  // paciente, arquivo ou operação a desfazer inexistente
+#define OPERACAO_RECUSADA -1       // fila vazia ou cheia, ou orçamento de memória esgotado
+#define OPERACAO_INVALIDA -2       // idade ou data de entrada fora do calendário
+#define OPERACAO_DUPLICADA -3      // paciente já aguarda na fila escolhida
+#define MAGICO_SESSAO "PSS2"
+#define EVENTO_CHEGADA 0           // eventos da simulação de atendimento
+#define EVENTO_FIM_ATENDIMENTO 1
+#define LINHA_COMUM 0              // filas da simulação (índices dos resultados)
+#define LINHA_PRIORITARIA 1
+#define DISTRIBUICAO_EXPONENCIAL 0 // distribuições da duração dos atendimentos
+#define DISTRIBUICAO_FIXA 1
+#define DISTRIBUICAO_UNIFORME 2
+#define DISTRIBUICAO_ERLANG 3
+#define QTDE_DISTRIBUICOES 4
+#define PONTOS_CURVA 24            // amostras da curva de comprimento das filas
+#define MAX_DEPARTAMENTOS 16       // linhas de atendimento por especialidade
+#define MAX_ATENDENTES 64          // threads de atendentes somando todos os departamentos
+#define CAPACIDADE_INICIAL_DEQUE 64
+#define LIMIAR_ROUBO_PADRAO 4      // acúmulo mínimo para uma linha receber ajuda de outras
+#define ESPERA_OCIOSA_MS 2         // intervalo em que um atendente ocioso reavalia as outras linhas
+#define ESPERA_CARGA_MS 5000       // teste de carga: tempo máximo sem nenhum atendimento concluído
+#define MEM_CADASTRO 0             // categorias da contabilidade de memória (estrutura dona)
+#define MEM_FILA 1
+#define MEM_HEAP 2
+#define MEM_PILHA 3
+#define MEM_ABB 4
+#define MEM_DEPARTAMENTOS 5
+#define QTDE_CATEGORIAS_MEMORIA 6
+#define LIMITE_DESFAZER 1000       // operações guardadas na pilha; as mais antigas são descartadas
+#define CAPACIDADE_INICIAL_FILA 16 // posições iniciais do anel da fila comum (potência de 2)
+#define MAPA_VAZIO -1              // valores especiais das posições do mapa de espera
+#define LAPIDE_MAPA -2
+#define NOME_SEGMENTO_COMPARTILHADO "/dbPacientes"  // segmento POSIX dos terminais de recepção
+#define MAGICO_SEGMENTO "PSH3"
+#define CAPACIDADE_COMPARTILHADA 4096  // pacientes no cadastro e na fila comum do segmento (potência de 2)
+#define LAPIDE_COMPARTILHADA 1u        // índice de RG do segmento: posição removida (0 = vazia)
+#define MAX_PALAVRAS_DIARIO 4          // encadeamentos alterados por um passo de escrita do segmento
+#define ESPERA_SEGMENTO_MS 2000        // tempo máximo aguardando outro terminal terminar de criar o segmento
+#define IMPORTACAO_POR_ESCRITA 64      // pacientes copiados por seção de escrita na importação para o segmento
+#define SOCKET_SERVIDOR_PADRAO "dbPacientes.sock"  // socket Unix do modo servidor
+#define LIMITE_REQUISICAO 65536        // maior requisição aceita pelo servidor (bytes)
+#define LIMITE_SAIDA_CONEXAO (1 << 20) // respostas pendentes acima das quais o cliente deixa de ser lido
+#define MAX_EVENTOS_SERVIDOR 64
+#define PACIENTES_CARGA 1000           // pacientes cadastrados pelo gerador de carga antes da medição
+#define BITS_RAMO_VERSAO 5             // versões do cadastro: árvore de 32 ramos por nível
+#define RAMOS_VERSAO (1 << BITS_RAMO_VERSAO)
+#define MAX_LEITORES_VERSAO 64         // leituras isoladas abertas ao mesmo tempo
+#define VOLTAS_VAGA_LEITURA 64         // voltas pelas vagas antes de desistir de uma leitura isolada
+#define APOSENTADO_NO 0                // itens aguardando o fim das leituras para serem liberados
+#define APOSENTADO_REGISTRO 1
+#define APOSENTADO_VERSAO 2
+#define APOSENTADO_ARVORE 3            // árvore inteira, com os registros das folhas
 
 // *******************************************
 // DEFINIÇÕES DE ESTRUTURAS
 // *******************************************
 
-// Estrutura para representar uma data (dia, mês e ano)
+// Data compacta: dias desde 01/01/1970 em 32 bits. Datas se comparam como inteiros e a
+// diferença entre duas é o número de dias entre elas.
+typedef int Data;
+
+// Data decomposta no calendário, usada apenas na leitura e na exibição
 typedef struct {
     int dia;
     int mes;
     int ano;
-} Data;
+} DataCalendario;
 
 // Estrutura para armazenar os dados de um paciente
 typedef struct {
     char nome[100];
     int idade;
     char rg[20];
-    Data *entrada;  // data de entrada do paciente (ponteiro para estrutura Data)
+    Data entrada;  // data de entrada do paciente (guardada no próprio registro)
 } Registro;
 
 // Elemento da lista encadeada de pacientes (célula contendo um Registro)
 typedef struct ELista {
     Registro *dados;
     struct ELista *proximo;
+    unsigned int chave;  // ordem de cadastro: posição do paciente nas versões do cadastro
 } ELista;
 
+// Contagens agregadas do cadastro, mantidas a cada alteração (leitura sem percorrer registros)
+typedef struct {
+    long total;
+    long porAno[ANOS_AGREGADOS];          // admissões por ano de entrada
+    long porAnoMes[ANOS_AGREGADOS][12];   // admissões por ano e mês de entrada
+    long porIdade[FAIXAS_IDADE];          // histograma de idades
+    long foraDoIntervalo;                 // entradas com ano/mês fora da faixa contabilizada
+} Agregados;
+
+// Entrada do índice de RGs (tabela hash com endereçamento aberto)
+typedef struct {
+    unsigned long long hash;  // hash do RG normalizado
+    ELista *no;               // nó da lista (NULL = vazia, LAPIDE_INDICE = removida)
+    int duplicatas;           // nós da lista com este RG (o indexado e os repetidos)
+} EIndiceRG;
+
+// Índice hash dos pacientes pelo RG normalizado (somente dígitos)
+typedef struct {
+    EIndiceRG *entradas;
+    int capacidade;  // sempre potência de 2
+    int ocupadas;    // posições usadas, incluindo lápides
+    int qtde;        // RGs indexados
+} IndiceRG;
+
+// Nó da árvore de versões do cadastro. Depois de publicado, um nó nunca é alterado: cada
+// escrita copia o caminho até a chave alterada e reaproveita o restante da árvore.
+typedef struct NoVersao {
+    unsigned long edicao;        // escrita que criou o nó (só ela pode alterá-lo no lugar)
+    int ocupados;                // ramos não nulos
+    void *ramos[RAMOS_VERSAO];   // NoVersao* nos níveis internos, Registro* no último nível
+} NoVersao;
+
+// Versão imutável do cadastro: pacientes pela chave (ordem de cadastro)
+typedef struct {
+    NoVersao *raiz;
+    int altura;            // níveis abaixo da raiz
+    int qtde;
+    unsigned long versao;  // versão da lista publicada
+} VersaoCadastro;
+
+// Bloco substituído por uma escrita, liberado quando nenhuma leitura puder mais alcançá-lo
+typedef struct {
+    void *item;
+    int tipo;              // APOSENTADO_*
+    int altura;            // APOSENTADO_ARVORE: níveis abaixo da raiz
+    unsigned long epoca;   // época da publicação que o substituiu (0 = escrita em andamento)
+} ItemAposentado;
+
+// Versões publicadas do cadastro e a reciclagem por épocas. Quem altera a lista publica uma
+// nova versão sem esperar ninguém; cada leitura registra a época em que começou, e o que foi
+// substituído só é liberado depois que a época global avança duas vezes.
+typedef struct VersoesCadastro {
+    VersaoCadastro *atual;              // versão publicada (lida de forma atômica)
+    NoVersao *raiz;                     // árvore da escrita em andamento
+    int altura;
+    unsigned long edicao;
+    unsigned int proximaChave;
+    unsigned long epoca;                // época global (começa em 1)
+    unsigned long leitores[MAX_LEITORES_VERSAO];  // época de cada leitura aberta (0 = vaga livre)
+    ItemAposentado *aposentados;
+    int qtdeAposentados;
+    int capacidadeAposentados;
+    int aposentadosPublicados;          // os primeiros já têm época definida
+    long publicadas;
+    long liberados;
+} VersoesCadastro;
+
+// Leitura isolada: uma versão do cadastro mantida viva até fechar_leitura_cadastro
+typedef struct {
+    VersoesCadastro *versoes;
+    int vaga;
+    const VersaoCadastro *versao;
+} LeituraCadastro;
+
 // Estrutura da lista encadeada de pacientes cadastrados
 typedef struct {
     ELista *inicio;
     int qtde;
+    Agregados agregados;  // contagens mantidas incrementalmente
+    IndiceRG indiceRg;    // busca por RG em O(1)
+    unsigned long versao; // incrementada a cada alteração do cadastro
+    VersoesCadastro *versoes;  // NULL = sem leituras isoladas
 } Lista;
 
-// Elemento da fila de atendimento (célula duplamente encadeada contendo um Registro)
-typedef struct EFila {
-    struct EFila *proximo;
-    struct EFila *anterior;
-    Registro *dados;
-} EFila;
+// Resumo de uma carga ou de uma importação com mesclagem por RG
+typedef struct {
+    int inseridos;
+    int atualizados;
+    int ignorados;  // linhas repetidas, sem nenhuma alteração
+    int invalidos;  // linhas fora do formato ou registros com dados inválidos (descartados)
+} ResumoImportacao;
+
+// Estatísticas de espera atualizadas incrementalmente (média, máximo e esboço de percentis)
+typedef struct {
+    long entradas;                  // pacientes que entraram na fila no turno
+    long pendentes;                 // pacientes aguardando neste momento
+    long desistencias;              // pacientes que deixaram a fila sem atendimento
+    long amostras;                  // atendimentos com tempo de espera registrado
+    long long somaEspera;           // soma dos tempos de espera (ms)
+    long long maxEspera;            // maior tempo de espera observado (ms)
+    int maxAproximado;              // 1 se o máximo foi refeito pelo esboço após um atendimento desfeito
+    long contagem[FAIXAS_ESBOCO];   // histograma logarítmico dos tempos de espera
+} EstatisticasEspera;
+
+// Entrada do mapa de espera: RG do paciente -> sua entrada na fila (sequência ou índice)
+typedef struct {
+    unsigned long long hash;  // hash do RG normalizado
+    long long valor;          // MAPA_VAZIO, LAPIDE_MAPA ou o valor associado ao paciente
+} EMapaEspera;
 
-// Estrutura da fila de atendimento comum
+// Mapa hash (endereçamento aberto) dos pacientes que aguardam em uma fila. O RG de cada
+// entrada é conferido no próprio elemento da fila, obtido pela função 'registro'.
 typedef struct {
-    EFila *head;  // início da fila (primeiro elemento)
-    EFila *tail;  // fim da fila (último elemento)
+    EMapaEspera *entradas;
+    int capacidade;  // sempre potência de 2 (0 = mapa desativado)
+    int ocupadas;    // posições usadas, incluindo lápides
     int qtde;
+    int categoria;   // MEM_* da estrutura dona
+    const void *dona;
+    const Registro* (*registro)(const void *dona, long long valor);
+} MapaEspera;
+
+// Posição da fila de atendimento (paciente e instante de entrada)
+typedef struct {
+    Registro *dados;          // NULL = paciente desistiu (lápide até chegar ao início)
+    long long enfileiradoEm;  // instante em que o paciente entrou na fila (ms)
+} EFila;
+
+// Estrutura da fila de atendimento comum: deque em anel sobre um vetor contíguo, que dobra
+// quando enche. Inserir no fim, retirar do início e devolver ao início são O(1) amortizados,
+// sem alocação por operação. Cada posição tem um número de sequência crescente; quem desiste
+// vira lápide, e uma árvore de Fenwick sobre as posições do anel conta as lápides à frente.
+typedef struct {
+    EFila *itens;
+    int capacidade;  // sempre potência de 2 (índices calculados com máscara)
+    int inicio;      // posição do primeiro elemento
+    int qtde;        // posições ocupadas, incluindo as lápides
+    int lapides;
+    long long primeiraSequencia;  // sequência do primeiro elemento (as seguintes são consecutivas)
+    int *arvoreLapides;           // Fenwick sobre as posições do anel (NULL até a primeira desistência)
+    MapaEspera mapa;              // RG -> sequência (só na fila da sessão)
+    EstatisticasEspera estatisticas;  // tempos de espera do turno
 } Fila;
 
+// Nó da fila encadeada original, mantida só como referência no comparativo de desempenho
+typedef struct ENoFilaEncadeada {
+    struct ENoFilaEncadeada *proximo;
+    struct ENoFilaEncadeada *anterior;
+    EFila item;
+} ENoFilaEncadeada;
+
+typedef struct {
+    ENoFilaEncadeada *head;
+    ENoFilaEncadeada *tail;
+    int qtde;
+} FilaEncadeada;
+
+// Critério configurável de prioridade: combina idade, tempo de espera e nível de triagem
+typedef struct {
+    int pesoIdade;         // pontos por ano de idade
+    int pesoEspera;        // pontos por faixa de espera completada
+    int pesoTriagem;       // pontos por nível de triagem
+    int segundosPorFaixa;  // duração de cada faixa de espera (envelhecimento em degraus)
+    int maxFaixas;         // limite de faixas consideradas na pontuação
+} CriterioPrioridade;
+
+// Chave de prioridade pré-calculada de um paciente em espera. É o primeiro campo dos elementos
+// das filas prioritárias local e compartilhada, que dividem o cálculo e a ordenação.
+typedef struct {
+    long chave;               // pontuação calculada na última atualização (maior = mais urgente)
+    long long enfileiradoEm;  // instante de entrada na fila prioritária (ms)
+    long faixaEntrada;        // faixa de tempo global em que o paciente entrou
+    int faixas;               // faixas de espera já contabilizadas na chave
+    int triagem;              // nível de triagem (0 a MAX_TRIAGEM)
+    int idade;                // idade do paciente na entrada
+} ChavePrioridade;
+
+// Vetor de elementos de uma fila prioritária, cada um começando por sua ChavePrioridade.
+// 'posicionar' (se não for NULL) é avisado quando um elemento muda de índice.
+typedef struct {
+    void *elementos;
+    size_t tamanho;           // bytes de cada elemento
+    int qtde;
+    void (*posicionar)(void *dono, int indice);
+    void *dono;
+} VetorPrioridade;
+
+// Elemento da fila prioritária: chave de prioridade e paciente
+typedef struct {
+    ChavePrioridade prioridade;  // primeiro campo (ver VetorPrioridade)
+    Registro *paciente;
+    int entradaMapa;          // posição do paciente no mapa de espera (-1 = sem mapa)
+} EHeap;
+
 // Estrutura de Heap (fila de prioridade) para atendimento prioritário
 typedef struct {
-    Registro *dados[MAX_HEAP];  // array de ponteiros para registros (pacientes)
+    EHeap *dados;                  // array de elementos (pacientes e chaves), cresce sob demanda
     int qtde;
+    int capacidade;                // posições alocadas em 'dados'
+    int limite;                    // máximo de pacientes aceitos (0 = sem limite)
+    CriterioPrioridade criterio;   // critério usado para calcular as chaves
+    long faixaAtual;               // última faixa de tempo em que as chaves foram atualizadas
+    MapaEspera mapa;               // RG -> índice em 'dados' (só na fila da sessão)
+    EstatisticasEspera estatisticas;  // tempos de espera do turno
 } Heap;
 
 // Nó da árvore binária de busca (ABB) para pesquisa de pacientes
@@ -76,689 +406,8995 @@ typedef struct {
 typedef struct Cell {
     struct Cell *anterior;
     struct Cell *proximo;
-    char operacao;       // código da operação ('E' = Enfileirar, 'D' = Desenfileirar)
+    char operacao;       // código da operação ('E' = Enfileirar, 'D' = Desenfileirar, 'C' = Desistência)
     Registro *paciente;  // ponteiro para o paciente envolvido na operação
+    long long enfileiradoEm;  // instante original de entrada na fila (para desfazer atendimentos)
+    long long sequencia;      // sequência original na fila (para desfazer atendimentos e desistências)
+    long long esperaMs;       // espera contabilizada no atendimento (para desfazer atendimentos)
 } Cell;
 
 // Estrutura da pilha para registrar operações (desfazer enfileiramento/desenfileiramento)
 typedef struct {
     Cell *top;
+    Cell *base;  // operação mais antiga (descartada quando a pilha passa do limite)
     int qtde;
 } Stack;
 
+// Trecho do vetor entregue a uma thread de ordenação (ou de intercalação, quando meio > 0)
+typedef struct {
+    Registro **vetor;
+    Registro **auxiliar;
+    int inicio;
+    int meio;
+    int fim;
+    int (*criterio)(Registro, Registro);
+} TarefaOrdenacao;
+
+// Relatórios ordenados: cada ordem é um vetor de itens (chave << 32 | linha), onde a linha
+// indexa 'registros' e a chave é o campo da ordem com o bit de sinal invertido
+typedef struct {
+    Registro **registros;  // pacientes do mais antigo para o mais recente da lista
+    int qtde;
+    unsigned long long *ordens[QTDE_ORDENS];  // NULL se a ordem não foi pedida
+    LeituraCadastro leitura;  // versão do cadastro de onde vieram os registros (se houver)
+} Relatorio;
+
+// Trecho de uma passada da ordenação radix entregue a uma thread
+typedef struct {
+    unsigned long long *origem;
+    unsigned long long *destino;
+    int inicio;
+    int fim;
+    unsigned int minimo;   // menor chave (os dígitos são extraídos de chave - minimo)
+    int deslocamento;      // bits descartados antes do dígito da passada
+    long contagem[256];    // histograma do trecho; depois, posição de escrita de cada dígito
+} TarefaRadix;
+
+// Ordenação de uma ordem do relatório (e gravação opcional em arquivo), rodando em sua própria thread
+typedef struct {
+    Relatorio *relatorio;
+    int ordem;
+    int threads;               // threads disponíveis para a ordenação desta ordem
+    const char *prefixoArquivo;  // se não for NULL, grava <prefixo>_<ordem>.txt
+    int ok;
+} TarefaRelatorio;
+
+// Escritor com buffer: acumula linhas e grava em blocos grandes
+typedef struct {
+    FILE *destino;
+    char *dados;
+    size_t tamanho;
+    long bytes;  // total gravado
+} EscritorBuffer;
+
+// Lote de registros para carga em massa: a manutenção da lista e dos índices fica adiada até a confirmação
+typedef struct {
+    Registro *registros;
+    int qtde;
+    int capacidade;
+    int invalidos;  // registros lidos e descartados por estarem fora do formato ou inválidos
+} Lote;
+
+// Buffer de bytes crescente usado na codificação do arquivo compactado
+typedef struct {
+    unsigned char *dados;
+    size_t tamanho;
+    size_t capacidade;
+    int erro;  // 1 se faltou memória: o que seria acrescentado depois disso foi descartado
+} Buffer;
+
+// Cursor de leitura sobre a carga de um bloco do arquivo compactado
+typedef struct {
+    const unsigned char *dados;
+    size_t tamanho;
+    size_t posicao;
+    int erro;  // 1 se a leitura passou do fim ou encontrou dados inválidos
+} Leitor;
+
+// Quadro do cache de páginas do registro em disco
+typedef struct {
+    unsigned int numero;   // página carregada (PAGINA_NENHUMA se livre)
+    int pinos;             // usuários que estão com a página fixada
+    int referencia;        // bit de referência do algoritmo CLOCK
+    int suja;              // 1 se precisa ser gravada antes de sair do cache
+    int proximoNoBalde;    // encadeamento na tabela página -> quadro
+    unsigned char *dados;
+} QuadroPagina;
+
+// Cache de páginas de tamanho fixo com substituição CLOCK
+typedef struct {
+    int descritor;            // arquivo de páginas
+    QuadroPagina *quadros;
+    unsigned char *memoria;   // área contígua com o conteúdo de todos os quadros
+    int qtdeQuadros;
+    int *baldes;              // tabela hash página -> primeiro quadro do balde
+    int qtdeBaldes;
+    int ponteiro;             // posição do ponteiro do CLOCK
+    long leituras, escritas, acertos;
+    int erro;                 // 1 se alguma gravação de página falhou
+} CachePaginas;
+
+// Descritor de uma B+tree no arquivo (chaves de tamanho fixo comparadas byte a byte)
+typedef struct {
+    int tamanhoChave;
+    int tamanhoValor;
+    unsigned int raiz;  // página raiz
+} ArvoreBMais;
+
+// Registro de pacientes em disco: árvores primária e secundárias sobre o mesmo cache
+typedef struct {
+    CachePaginas cache;
+    ArvoreBMais arvores[ARVORES_DISCO];
+    unsigned int totalPaginas;
+    long qtde;
+} RegistroDisco;
+
+// Contexto da listagem por período: cada chave de data leva à leitura do registro na primária
+typedef struct {
+    RegistroDisco *rd;
+    void (*consumidor)(void *contexto, Registro *paciente);
+    void *contexto;
+} ContextoPeriodoDisco;
+
+// Versão congelada (imutável) do cadastro, entregue à thread de gravação
+typedef struct {
+    Registro *registros;      // cópia, quando a lista não tem versões
+    int qtde;
+    unsigned long versao;     // versão da lista no momento do congelamento
+    LeituraCadastro leitura;  // versão imutável lida sem cópia (lista com versões)
+} FotoRegistro;
+
+// Thread de leitura do teste de leituras isoladas
+typedef struct {
+    const Lista *lista;
+    int *encerrar;
+    Registro **registros;     // pacientes da versão lida
+    long leituras;            // versões percorridas por inteiro
+    long long registrosLidos;
+    long inconsistentes;      // versões incompletas ou com registros inválidos
+} LeitorVersoes;
+
+// Serviço de salvamento em segundo plano (uma thread de gravação por arquivo)
+typedef struct {
+    char nomeArquivo[256];
+    pthread_t thread;
+    int threadAtiva;
+    pthread_mutex_t trava;
+    pthread_cond_t sinal;
+    FotoRegistro *pendente;      // próxima foto a gravar (só a mais recente é mantida)
+    int encerrar;
+    int estado;                  // SALVAMENTO_*
+    long long ultimoPedido;      // instante do último pedido de salvamento (ms)
+    long long ultimoTermino;     // instante em que a última gravação terminou (ms)
+    long long ultimaDuracaoMs;
+    int ultimosRegistros;
+    unsigned long versaoSalva;   // versão da lista gravada por último
+    long salvamentos, falhas;
+    int intervaloAutomatico;     // segundos entre salvamentos automáticos (0 = desligado)
+    const Lista *lista;          // cadastro do salvamento automático (a thread lê só suas versões)
+} SalvamentoAssincrono;
+
+// Colunas contíguas extraídas do cadastro para varreduras sem percorrer a lista
+typedef struct {
+    int qtde;
+    Registro **registros;  // registro de cada linha (na ordem da lista)
+    int *idades;
+    int *dias;             // data de entrada em dias desde 01/01/1970
+    int *meses;
+    char *digitosRg;       // LARGURA_RG_COLUNA bytes por linha, mais uma linha de folga
+    unsigned long versao;  // versão da lista no momento da extração
+} ColunasPacientes;
+
+// Predicado conjuntivo da varredura (todas as condições precisam valer)
+typedef struct {
+    int idadeMinima, idadeMaxima;
+    int diaMinimo, diaMaximo;  // período de entrada em dias desde 01/01/1970
+    int mes;                   // mês de entrada (0 = qualquer)
+    char trechoRg[20];         // dígitos que o RG deve conter ("" = qualquer)
+} PredicadoVarredura;
+
+// Mapa de seleção: um bit por linha das colunas (1 = linha selecionada)
+typedef struct {
+    unsigned long long *palavras;
+    int qtdePalavras;
+    int qtde;  // linhas cobertas
+} MapaSelecao;
+
+// Paciente do cadastro compartilhado. Os encadeamentos são deslocamentos a partir do início
+// do segmento (0 = nenhum), válidos em todos os processos, onde quer que o segmento esteja mapeado.
+typedef struct {
+    Registro dados;
+    unsigned int anterior;
+    unsigned int proximo;
+} ENoCompartilhado;
+
+// Posição da fila comum compartilhada (os pacientes ficam no próprio anel)
+typedef struct {
+    Registro dados;
+    long long enfileiradoEm;
+} EFilaCompartilhada;
+
+// Elemento da fila prioritária compartilhada (mesma chave e envelhecimento do Heap local)
+typedef struct {
+    ChavePrioridade prioridade;  // primeiro campo (ver VetorPrioridade)
+    Registro dados;
+} EHeapCompartilhado;
+
+// Diário do passo de escrita em andamento no segmento: os campos do cabeçalho e os
+// encadeamentos que o passo pode alterar, com os valores anteriores. Se o escritor cai no
+// meio do passo, quem recupera a trava desfaz o passo com o diário.
+typedef struct {
+    int ativo;                   // 1 enquanto o passo altera o segmento
+    unsigned int inicioCadastro;
+    unsigned int livres;
+    int qtdeCadastro;
+    int filaInicio;
+    int filaQtde;
+    int heapQtde;
+    long faixaAtual;
+    int qtdePalavras;            // encadeamentos alterados até agora
+    unsigned int deslocPalavra[MAX_PALAVRAS_DIARIO];
+    unsigned int valorPalavra[MAX_PALAVRAS_DIARIO];
+    int heapSalvo;               // 1 se o heap foi copiado para a reserva antes de ser alterado
+} DiarioCompartilhado;
+
+// Cabeçalho do segmento de memória compartilhada, seguido pelas áreas do índice de RG, dos
+// nós do cadastro, do anel da fila comum, do heap e da reserva do heap. Escritores se excluem
+// pela trava; leitores não travam: copiam o que precisam e repetem a cópia se a versão mudou
+// no meio (seqlock).
+typedef struct {
+    char magico[4];
+    int pronto;                  // 1 depois que o criador terminou a inicialização
+    int capacidade;
+    unsigned int tamanho;        // bytes do segmento
+    pthread_mutex_t trava;       // compartilhada entre processos e robusta (sobrevive à queda do dono)
+    unsigned long long versao;   // ímpar enquanto uma escrita está em andamento
+    int terminais;               // processos conectados
+    unsigned int deslocIndice;   // áreas do segmento
+    unsigned int deslocNos;
+    unsigned int deslocFila;
+    unsigned int deslocHeap;
+    unsigned int deslocReserva;  // cópia do heap feita antes de alterá-lo (diário)
+    unsigned int inicioCadastro; // primeiro paciente do cadastro
+    unsigned int livres;         // nós livres, encadeados por 'proximo'
+    int qtdeCadastro;
+    int lapidesIndice;           // posições do índice de RG marcadas como removidas
+    int filaInicio;
+    int filaQtde;
+    int heapQtde;
+    CriterioPrioridade criterio;
+    long faixaAtual;
+    DiarioCompartilhado diario;
+    int inutilizavel;            // 1 se a recuperação encontrou o segmento corrompido
+} SegmentoCompartilhado;
+
+// Conexão de um terminal ao segmento
+typedef struct {
+    SegmentoCompartilhado *segmento;  // endereço do mapeamento neste processo
+    int descritor;
+} RegistroCompartilhado;
+
+// Cópia consistente do segmento, obtida sem travar os escritores
+typedef struct {
+    Registro *cadastro;
+    int qtdeCadastro;
+    EFilaCompartilhada *fila;
+    int qtdeFila;
+    EHeapCompartilhado *heap;
+    int qtdeHeap;
+    int terminais;
+} FotoCompartilhada;
+
+// Uma operação da sessão com seus argumentos, como digitados no menu
+typedef struct {
+    int tipo;             // OP_*
+    long long instante;   // instante da execução (ms)
+    char texto[100];      // nome, RG ou arquivo alvo, conforme o tipo
+    Registro paciente;    // dados completos (cadastro e atualização)
+    int valores[5];       // triagem, ordem do relatório ou pesos do critério
+    const unsigned char *conteudo;  // carregar e importar: arquivo lido, guardado na gravação
+    size_t tamanhoConteudo;         // (conteudo NULL = o arquivo não existia)
+} Operacao;
+
+// Resultado de uma operação, usado pelo menu para montar as mensagens
+typedef struct {
+    int status;                  // OPERACAO_*
+    Registro *paciente;          // paciente envolvido (consultado, enfileirado, atendido...)
+    EHeap atendido;              // paciente prioritário atendido
+    char desfeita;               // operação desfeita ('E', 'D' ou 'C')
+    int posicao;                 // pacientes à frente (consultas de posição)
+    Registro registroAtendido;   // cópia do paciente prioritário atendido (o heap libera o seu)
+    ResumoImportacao resumo;
+} ResultadoOperacao;
+
+// Gravação binária das operações de uma sessão
+typedef struct {
+    FILE *arquivo;
+    Buffer buffer;
+    long long ultimoInstante;  // instante da operação anterior (são gravadas as diferenças)
+    long operacoes;
+    long perdidas;             // operações não gravadas por falta de memória para codificá-las
+    char nomeArquivo[256];
+} GravadorSessao;
+
+// Paciente aguardando na linha de um departamento
+typedef struct {
+    Registro *paciente;       // cópia do paciente (liberada após o atendimento)
+    long long enfileiradoEm;  // instante de entrada na linha (ms)
+} ItemDepartamento;
+
+// Linha de atendimento de uma especialidade: deque circular com trava própria
+typedef struct {
+    char nome[40];
+    pthread_mutex_t trava;     // protege apenas esta linha (não há trava global)
+    pthread_cond_t sinal;      // acorda os atendentes da linha quando chega paciente
+    ItemDepartamento *itens;
+    int capacidade;
+    int inicio;
+    int qtde;                  // publicada de forma atômica (lida sem trava por outras linhas)
+    int atendentes;            // threads de atendentes da linha
+    int tempoAtendimentoMs;    // duração de cada atendimento nesta linha
+    unsigned mascaraAjuda;     // bit d = atendentes desta linha podem ajudar a linha d
+    int limiarRoubo;           // acúmulo mínimo para esta linha receber ajuda
+    long chegadas;
+    long roubados;             // pacientes levados por atendentes de outras linhas
+    long atendidos;            // atendimentos feitos pelos atendentes da linha (atômico)
+    long ajudas;               // desses, os feitos em outras linhas (atômico)
+    int maiorFila;
+    EstatisticasEspera espera; // tempos de espera até o início do atendimento
+} Departamento;
+
+struct CentralDepartamentos;
+
+// Thread de atendente ligada a um departamento
+typedef struct {
+    struct CentralDepartamentos *central;
+    pthread_t thread;
+    int departamento;
+} AtendenteDepartamento;
+
+// Conjunto de departamentos e seus atendentes
+typedef struct CentralDepartamentos {
+    Departamento departamentos[MAX_DEPARTAMENTOS];
+    int qtdeDepartamentos;
+    AtendenteDepartamento atendentes[MAX_ATENDENTES];
+    int qtdeAtendentes;        // threads em execução (0 = parados)
+    int encerrar;
+} CentralDepartamentos;
+
+// Estado de uma sessão de atendimento: todas as operações do menu passam por executar_operacao
+typedef struct {
+    Lista *lista;
+    Fila *fila;
+    Heap *heap;
+    Stack *pilha;
+    FILE *saida;              // destino das listagens (stdout ou descarte, na reprodução)
+    GravadorSessao *gravador; // NULL = sessão não está sendo gravada
+    CentralDepartamentos *departamentos;  // criada ao abrir o menu de departamentos
+    char *rascunho;           // na reprodução, base dos arquivos usados no lugar dos reais
+    RegistroDisco *disco;     // NULL = cadastro só em memória; senão, espelhado no registro em disco
+} Sessao;
+
+// Cliente conectado ao servidor local: requisições recebidas e respostas ainda não enviadas
+typedef struct ConexaoServidor {
+    int descritor;
+    Buffer entrada;   // bytes recebidos que ainda não formam uma requisição completa
+    Buffer saida;     // respostas acumuladas
+    size_t enviados;  // bytes de 'saida' já enviados
+    int eventos;      // eventos registrados no epoll (EPOLLIN e/ou EPOLLOUT)
+    struct ConexaoServidor *anterior, *proxima;  // conexões abertas (fechadas no encerramento)
+} ConexaoServidor;
+
+// Servidor local: uma sessão atendida por um laço de eventos (epoll) sobre um socket Unix
+typedef struct {
+    int epoll;
+    int escuta;
+    Sessao *sessao;
+    const char *diretorioDados;      // único diretório em que os clientes carregam e salvam
+    FILE *descarte;                  // saída das listagens quando não há captura
+    Buffer rascunho;                 // resposta em montagem
+    ConexaoServidor *abertas;
+    long conexoes;
+    long requisicoes;
+    EstatisticasEspera *latencias;   // por tipo de operação (ns)
+} ServidorLocal;
+
+// Uma conexão do gerador de carga (uma thread) e suas medições
+typedef struct {
+    const char *caminho;
+    int requisicoes;
+    int profundidade;                // requisições enviadas sem esperar resposta
+    unsigned long long estado;       // gerador pseudoaleatório da mistura de operações
+    EstatisticasEspera latencia;     // ns, do envio à chegada da resposta
+    long erros;                      // respostas recusadas, não encontradas ou inválidas
+    int falhou;                      // conexão perdida
+} ClienteCarga;
+
+// Parâmetros de uma simulação de atendimento
+typedef struct {
+    double chegadasPorHora;      // taxa média de chegadas (processo de Poisson)
+    double fracaoPrioritaria;    // parcela das chegadas que vai para a fila prioritária
+    double minutosAtendimento;   // duração média de um atendimento
+    int distribuicao;            // distribuição da duração (DISTRIBUICAO_*)
+    int atendentes;
+    int atendentesPrioritarios;  // atendentes que chamam primeiro a fila prioritária
+    double horas;                // tempo simulado
+    unsigned long long semente;
+} ConfigSimulacao;
+
+// Evento agendado da simulação
+typedef struct {
+    long long instante;   // ms simulados
+    long long sequencia;  // desempate entre eventos simultâneos (ordem de agendamento)
+    int tipo;             // EVENTO_CHEGADA ou EVENTO_FIM_ATENDIMENTO
+    int atendente;        // atendente que conclui o atendimento
+} EventoSimulacao;
+
+// Agenda de eventos (min-heap pelo instante)
+typedef struct {
+    EventoSimulacao *eventos;
+    int qtde;
+    int capacidade;
+    long long sequencia;
+} AgendaEventos;
+
+// Resultado de uma simulação ([LINHA_COMUM] e [LINHA_PRIORITARIA])
+typedef struct {
+    long eventos;
+    double segundosReais;
+    long chegadas[2];
+    long concluidos[2];
+    EstatisticasEspera espera[2];   // tempos de espera registrados pelas próprias filas
+    double mediaFila[2];            // comprimento médio ponderado pelo tempo
+    int maxFila[2];
+    int curva[2][PONTOS_CURVA];     // comprimento ao fim de cada intervalo
+    double ocupacao;                // fração do tempo com atendentes ocupados
+} ResultadoSimulacao;
+
+// Estado interno de uma simulação em andamento
+typedef struct {
+    const ConfigSimulacao *config;
+    ResultadoSimulacao *resultado;
+    unsigned long long estado;      // gerador pseudoaleatório
+    Fila *fila;
+    Heap heap;
+    AgendaEventos agenda;
+    Registro **emAtendimento;       // paciente de cada atendente (NULL = livre)
+    int *linhaAtendimento;          // fila de onde veio o paciente em atendimento
+    Registro **reserva;             // registros de pacientes já atendidos, para reaproveitar
+    int qtdeReserva;
+    int capacidadeReserva;
+    Data dataSimulada;
+    double mediaAtendimentoMs;
+    long long fim;                  // fim do tempo simulado (ms)
+    long long relogio;              // relógio virtual: instante do evento em curso (ms)
+    long long msOcupados;
+    long long ultimoEvento;
+    long long proximaAmostra;
+    int pontoCurva;
+    double areaFila[2];
+} EstadoSimulacao;
+
+// *******************************************
+// PROTÓTIPOS (funções usadas antes de sua definição)
+// *******************************************
+void limpar_console();
+void limpar_console_dinamico();
+void extrair_numeros_rg(const char *rg_original, char *rg_numerico);
+int termina_com(const char *texto, const char *sufixo);
+int salvar_arquivo_compactado(const Lista *lista, const char *nomeArquivo);
+int carregar_arquivo_compactado(Lista *lista, const char *nomeArquivo, ResumoImportacao *resumo);
+int executar_operacao(Sessao *sessao, const Operacao *op, ResultadoOperacao *resultado);
+void fechar_central_departamentos(CentralDepartamentos *central);
+int fila_retirar_fim(Fila *fila, EFila *item);
+EFila* elemento_fila(const Fila *fila, int i);
+void desmapear_paciente_fila(Fila *fila, const Registro *paciente);
+void restaurar_na_fila(Fila *fila, long long sequencia, EFila item);
+
 // *******************************************
 // FUNÇÕES PRINCIPAIS POR MÓDULO (CADASTRO, ATENDIMENTO, ETC.)
 // *******************************************
 
-// ** Módulo Cadastro de Pacientes ** 
+// ** Módulo Relógio ** 
 
-// Inicializa a lista encadeada de pacientes (aloca Lista e define valores iniciais)
-Lista* inicializa_lista() {
-    Lista *novaLista = malloc(sizeof(Lista));
-    if (novaLista != NULL) {
-        novaLista->inicio = NULL;
-        novaLista->qtde = 0;
-    }
-    return novaLista;
+// Quando não negativo, substitui o relógio real (reprodução de sessões gravadas). É lido
+// também pelas threads de salvamento, por isso só é acessado com operações atômicas.
+long long instanteSimulado = -1;
+
+// Diferença entre o relógio de parede e o monotônico, medida uma única vez
+long long origemRelogio;
+pthread_once_t origemRelogioDefinida = PTHREAD_ONCE_INIT;
+
+void medir_origem_relogio() {
+    struct timespec parede, monotonico;
+    clock_gettime(CLOCK_REALTIME, &parede);
+    clock_gettime(CLOCK_MONOTONIC, &monotonico);
+    origemRelogio = ((long long)parede.tv_sec - monotonico.tv_sec) * 1000
+                  + (parede.tv_nsec - monotonico.tv_nsec) / 1000000;
 }
 
-// Cria uma nova estrutura de Data com dia, mês e ano informados
-Data* cria_data(int dia, int mes, int ano) {
-    Data *novaData = malloc(sizeof(Data));
-    if (novaData != NULL) {
-        novaData->dia = dia;
-        novaData->mes = mes;
-        novaData->ano = ano;
+// Retorna o instante atual em milissegundos, usado para medir tempos de espera. Avança com
+// CLOCK_MONOTONIC, de modo que ajustes do relógio do sistema (NTP, acerto manual) não
+// reordenam nem congelam as esperas; a origem medida na primeira leitura mantém o valor em
+// milissegundos desde 1970, para datas e horários.
+long long instante_atual() {
+    long long simulado = __atomic_load_n(&instanteSimulado, __ATOMIC_RELAXED);
+    if (simulado >= 0) {
+        return simulado;
     }
-    return novaData;
+    pthread_once(&origemRelogioDefinida, medir_origem_relogio);
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return origemRelogio + (long long)agora.tv_sec * 1000 + agora.tv_nsec / 1000000;
 }
 
-// Insere um novo paciente no início da lista de pacientes cadastrados
-void cadastrar_paciente(Lista *lista, Registro paciente) {
-    // Aloca um novo nó para a lista e copia os dados do paciente para ele
-    ELista *novoNo = malloc(sizeof(ELista));
-    novoNo->dados = malloc(sizeof(Registro));
-    *novoNo->dados = paciente;
-    // Insere o novo nó no início (cabeça) da lista encadeada
-    novoNo->proximo = lista->inicio;
-    lista->inicio = novoNo;
-    lista->qtde++;
+// Fixa o relógio simulado no instante informado (-1 volta ao relógio real)
+void definir_instante_simulado(long long instante) {
+    __atomic_store_n(&instanteSimulado, instante, __ATOMIC_RELAXED);
 }
 
-// Imprime todos os pacientes presentes na lista de cadastrados
-void imprimir_lista(const Lista *lista) {
-    if (lista->inicio == NULL) {
-        limpar_console();
-        printf("\nNenhum paciente cadastrado.\nAdicione algum e tente novamente!\n");
-        return;
-    }
-    limpar_console();
-    printf("\n%d Pacientes cadastrados:\n\n",lista->qtde);
-    // Percorre a lista encadeada e imprime os dados de cada paciente
-    for (ELista *noAtual = lista->inicio; noAtual != NULL; noAtual = noAtual->proximo) {
-        printf("Nome: %s; Idade: %d; RG: %s; Entrada: %02d/%02d/%04d\n",
-               noAtual->dados->nome, noAtual->dados->idade, noAtual->dados->rg,
-               noAtual->dados->entrada->dia, noAtual->dados->entrada->mes, noAtual->dados->entrada->ano);
-    }
+// Relógio monotônico em nanossegundos, usado para medir a duração das operações
+long long instante_nanossegundos() {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (long long)agora.tv_sec * 1000000000LL + agora.tv_nsec;
 }
 
-// Busca na lista um paciente pelo nome. Retorna o ponteiro para o nó do paciente ou NULL se não encontrado.
-ELista* consultar_paciente_nome(const Lista *lista, const char *nome) {
-    ELista *noAtual = lista->inicio;
-    // Percorre a lista comparando os nomes
-    while (noAtual != NULL) {
-        if (strcmp(noAtual->dados->nome, nome) == 0) {
-            return noAtual;  // paciente encontrado
-        }
-        noAtual = noAtual->proximo;
-    }
-    return NULL;  // paciente não encontrado
+// ** Módulo Datas ** 
+
+// Converte uma data do calendário em número de dias desde 01/01/1970
+int dias_desde_epoca(int dia, int mes, int ano) {
+    ano -= mes <= 2;
+    int era = (ano >= 0 ? ano : ano - 399) / 400;
+    int anoDaEra = ano - era * 400;
+    int diaDoAno = (153 * (mes + (mes > 2 ? -3 : 9)) + 2) / 5 + dia - 1;
+    int diaDaEra = anoDaEra * 365 + anoDaEra / 4 - anoDaEra / 100 + diaDoAno;
+    return era * 146097 + diaDaEra - 719468;
 }
-ELista* consultar_paciente_rg(const Lista *lista, const char *rg) {
-    ELista *noAtual = lista->inicio;
 
-    char rg_busca[20];  // RG tratado do parâmetro
-    extrair_numeros_rg(rg, rg_busca);
+// Converte um número de dias desde 01/01/1970 de volta para dia, mês e ano
+void data_de_dias(int dias, int *dia, int *mes, int *ano) {
+    dias += 719468;
+    int era = (dias >= 0 ? dias : dias - 146096) / 146097;
+    int diaDaEra = dias - era * 146097;
+    int anoDaEra = (diaDaEra - diaDaEra / 1460 + diaDaEra / 36524 - diaDaEra / 146096) / 365;
+    int diaDoAno = diaDaEra - (365 * anoDaEra + anoDaEra / 4 - anoDaEra / 100);
+    int mp = (5 * diaDoAno + 2) / 153;
+    *dia = diaDoAno - (153 * mp + 2) / 5 + 1;
+    *mes = mp < 10 ? mp + 3 : mp - 9;
+    *ano = anoDaEra + era * 400 + (*mes <= 2);
+}
 
-    while (noAtual != NULL) {
-        char rg_paciente[20];  // RG tratado do paciente na lista
-        extrair_numeros_rg(noAtual->dados->rg, rg_paciente);
+int dias_no_mes(int mes, int ano) {
+    static const int dias[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int bissexto = (ano % 4 == 0 && ano % 100 != 0) || ano % 400 == 0;
+    return dias[mes - 1] + (mes == 2 && bissexto);
+}
 
-        if (strcmp(rg_paciente, rg_busca) == 0) {
-            return noAtual;  // paciente encontrado
-        }
-        noAtual = noAtual->proximo;
+// Cria a data compacta validando o calendário (31/02 não existe) e a faixa de anos aceita.
+// Retorna DATA_INVALIDA se a data não for válida.
+Data cria_data(int dia, int mes, int ano) {
+    if (ano < ANO_MINIMO || ano > ANO_MAXIMO || mes < 1 || mes > 12 || dia < 1 || dia > dias_no_mes(mes, ano)) {
+        return DATA_INVALIDA;
     }
+    return dias_desde_epoca(dia, mes, ano);
+}
 
-    return NULL;  // paciente não encontrado
+DataCalendario data_calendario(Data data) {
+    DataCalendario calendario;
+    data_de_dias(data, &calendario.dia, &calendario.mes, &calendario.ano);
+    return calendario;
 }
 
-// Atualiza os dados de um paciente existente na lista de cadastrados
-void atualizar_paciente(Lista *lista) {
-    char rgPaciente[100];
-    printf("\nDigite o RG do paciente: ");
-    fgets(rgPaciente, sizeof(rgPaciente), stdin);
-    rgPaciente[strcspn(rgPaciente, "\n")] = '\0';  // remove o newline do final da string
+// Dias decorridos entre duas datas: O(1)
+int dias_entre(Data inicio, Data fim) {
+    return fim - inicio;
+}
 
-    ELista *noEncontrado = consultar_paciente_rg(lista, rgPaciente);
-    if (noEncontrado == NULL) {
-        limpar_console();
-        printf("\nERRO!\nNão existe paciente com esse RG cadastrado.\n");
-        limpar_console_dinamico();
-        return;
-    }
-    // Menu de opções de atualização
-    int opcaoAtualizacao;
-    printf("\n╔════════════════════════════════════════════╗\n");
-    printf("║     QUAL INFORMAÇÃO DESEJA ATUALIZAR?      ║\n");
-    printf("╠════════════════════════════════════════════╣\n");
-    printf("║ 1 - Nome                                   ║\n");
-    printf("║ 2 - Idade                                  ║\n");
-    printf("║ 3 - RG                                     ║\n");
-    printf("║ 4 - Data de entrada                        ║\n");
-    printf("╚════════════════════════════════════════════╝\n");
-    printf("\nSelecione uma opção: ");
-    scanf("%d", &opcaoAtualizacao);
-    getchar();  // consome o '\n' deixado pelo scanf
+// Data de hoje segundo o relógio da sessão (na reprodução, o dia da gravação)
+Data data_de_hoje() {
+    return (Data)(instante_atual() / 86400000LL);
+}
 
-    switch (opcaoAtualizacao) {
-        case 1:
-            printf("Digite o novo NOME: ");
-            fgets(noEncontrado->dados->nome, sizeof(noEncontrado->dados->nome), stdin);
-            noEncontrado->dados->nome[strcspn(noEncontrado->dados->nome, "\n")] = '\0';
-            break;
-        case 2:
-            printf("Digite a nova IDADE: ");
-            scanf("%d", &noEncontrado->dados->idade);
-            getchar();
-            break;
-        case 3:
-            printf("Digite o novo RG: ");
-            fgets(noEncontrado->dados->rg, sizeof(noEncontrado->dados->rg), stdin);
-            noEncontrado->dados->rg[strcspn(noEncontrado->dados->rg, "\n")] = '\0';
-            break;
-        case 4: {
-            int dia, mes, ano;
-            printf("Digite a nova data de ENTRADA (dd mm aaaa): ");
-            scanf("%d %d %d", &dia, &mes, &ano);
-            getchar();
-            // Atualiza os campos da data de entrada do paciente encontrado
-            noEncontrado->dados->entrada->dia = dia;
-            noEncontrado->dados->entrada->mes = mes;
-            noEncontrado->dados->entrada->ano = ano;
-            break;
+// Tempo de permanência do paciente desde a entrada, em dias
+int dias_de_permanencia(const Registro *paciente) {
+    return dias_entre(paciente->entrada, data_de_hoje());
+}
+
+// Lê uma data "dd/mm/aaaa" sem sscanf. Retorna o ponteiro após a data ou NULL se ela não
+// estiver no formato ou não for uma data válida.
+const char* ler_data_texto(const char *texto, Data *data) {
+    int campos[3] = {0, 0, 0};
+    const int maxDigitos[3] = {2, 2, 4};
+    for (int c = 0; c < 3; c++) {
+        int digitos = 0;
+        while (*texto >= '0' && *texto <= '9' && digitos < maxDigitos[c]) {
+            campos[c] = campos[c] * 10 + (*texto++ - '0');
+            digitos++;
+        }
+        if (digitos == 0 || (c < 2 && *texto++ != '/')) {
+            return NULL;
         }
-        default:
-            limpar_console();
-            printf("\nERRO!\nOpção inválida, favor escolher outra\n");
-            limpar_console_dinamico();
-            return;
     }
-    limpar_console();
-    printf("\nSUCESSO! Dados do paciente atualizados!\n");
-    limpar_console_dinamico();
+    *data = cria_data(campos[0], campos[1], campos[2]);
+    return *data == DATA_INVALIDA ? NULL : texto;
 }
 
-// Remove um paciente da lista de cadastrados pelo nome
-void remover_paciente(Lista *lista, const char *nome) {
-    ELista *noAtual = lista->inicio;
-    ELista *noAnterior = NULL;
-    // Percorre a lista até encontrar o paciente ou chegar ao final
-    while (noAtual != NULL) {
-        if (strcmp(noAtual->dados->nome, nome) == 0) {
-            // Se encontrado, retira o nó da lista encadeada
-            if (noAnterior == NULL) {
-                // Removendo o primeiro nó da lista
-                lista->inicio = noAtual->proximo;
-            } else {
-                // Removendo um nó do meio ou fim da lista
-                noAnterior->proximo = noAtual->proximo;
-            }
-            // Libera a memória alocada para a data e para o nó removido
-            free(noAtual->dados->entrada);
-            free(noAtual);
-            lista->qtde--;
-            limpar_console();
-            printf("\nSUCESSO!\nExclusão de %s realizada.\n", nome);
-            limpar_console_dinamico();
-            return;
-        }
-        // Avança para o próximo nó
-        noAnterior = noAtual;
-        noAtual = noAtual->proximo;
+// Escreve a data como "dd/mm/aaaa" (sem printf) e retorna 'destino'
+char* escrever_data_texto(Data data, char destino[TAMANHO_DATA_TEXTO]) {
+    DataCalendario c = data_calendario(data);
+    destino[0] = (char)('0' + c.dia / 10);
+    destino[1] = (char)('0' + c.dia % 10);
+    destino[2] = '/';
+    destino[3] = (char)('0' + c.mes / 10);
+    destino[4] = (char)('0' + c.mes % 10);
+    destino[5] = '/';
+    for (int i = 9, ano = c.ano; i >= 6; i--, ano /= 10) {
+        destino[i] = (char)('0' + ano % 10);
     }
-    limpar_console();
-    printf("ERRO!\nNão existe paciente com esse NOME cadastrado.\n");
-    limpar_console_dinamico();
+    destino[10] = '\0';
+    return destino;
 }
 
-// ** Módulo Desfazer Operações (Pilha) ** 
+// Idade e data de entrada dentro do aceito pelo cadastro e RG com ao menos um dígito (os
+// índices e mapas identificam o paciente pelos dígitos do RG)
+int registro_valido(const Registro *paciente) {
+    char rgNumerico[20];
+    extrair_numeros_rg(paciente->rg, rgNumerico);
+    return paciente->idade >= 0 && paciente->idade <= IDADE_MAXIMA && paciente->entrada != DATA_INVALIDA &&
+           rgNumerico[0] != '\0';
+}
 
-// Cria uma nova célula da pilha de operações com o código da operação fornecido
-Cell* start_cell(char operacao) {
-    Cell *novaCelula = malloc(sizeof(Cell));
-    if (novaCelula != NULL) {
-        novaCelula->anterior = NULL;
-        novaCelula->proximo = NULL;
-        novaCelula->operacao = operacao;
-        novaCelula->paciente = NULL;
+// ** Módulo Memória ** 
+
+// Contabilidade de memória por estrutura dona. Regras de posse:
+// - Lista: nós e registros do cadastro (remover um paciente libera os dois) e as versões do
+//   cadastro (registros e nós substituídos são liberados quando as leituras abertas terminam);
+// - Fila e Heap: cópias próprias dos pacientes (independem do cadastro);
+// - Pilha: a célula 'D' passa a ser dona do paciente atendido até ser desfeita ou descartada;
+//   a célula 'E' apenas referencia a cópia que está na fila;
+// - ABB: cópias dos registros.
+const char *NOMES_CATEGORIAS_MEMORIA[QTDE_CATEGORIAS_MEMORIA] = {
+    "Cadastro", "Fila comum", "Fila prioritária", "Pilha (desfazer)", "Árvore (ABB)", "Departamentos"
+};
+long long memoriaViva[QTDE_CATEGORIAS_MEMORIA];     // bytes alocados e ainda não liberados
+long alocacoesVivas[QTDE_CATEGORIAS_MEMORIA];
+long long picoMemoria = 0;
+long long orcamentoMemoria = 0;  // limite para novas admissões (0 = sem limite)
+
+// Total de bytes vivos somando as estruturas
+long long memoria_total() {
+    long long total = 0;
+    for (int i = 0; i < QTDE_CATEGORIAS_MEMORIA; i++) {
+        total += __atomic_load_n(&memoriaViva[i], __ATOMIC_RELAXED);
     }
-    return novaCelula;
+    return total;
 }
 
-// Inicializa a pilha de operações (desfazimento) vazia
-Stack* start_stack() {
-    Stack *novaPilha = malloc(sizeof(Stack));
-    if (novaPilha != NULL) {
-        novaPilha->top = NULL;
-        novaPilha->qtde = 0;
+// Soma (ou retira, com valores negativos) bytes e alocações de uma categoria. Atômico, pois
+// o salvamento em segundo plano e os atendentes rodam em outras threads.
+void contabilizar_memoria(int categoria, long long bytes, long alocacoes) {
+    __atomic_fetch_add(&memoriaViva[categoria], bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alocacoesVivas[categoria], alocacoes, __ATOMIC_RELAXED);
+    if (bytes > 0) {
+        long long total = memoria_total();
+        long long pico = __atomic_load_n(&picoMemoria, __ATOMIC_RELAXED);
+        while (total > pico && !__atomic_compare_exchange_n(&picoMemoria, &pico, total, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
     }
-    return novaPilha;
 }
 
-// Empilha uma nova operação na pilha (registrando enfileiramento ou desenfileiramento)
-void push(Stack *pilha, char operacao, Registro *paciente) {
-    Cell *novaCelula = start_cell(operacao);
-    novaCelula->paciente = paciente;
-    // Coloca a nova célula no topo da pilha
-    novaCelula->proximo = pilha->top;
-    if (pilha->top != NULL) {
-        pilha->top->anterior = novaCelula;
+void* alocar_memoria(int categoria, size_t bytes) {
+    void *bloco = malloc(bytes);
+    if (bloco != NULL) {
+        contabilizar_memoria(categoria, (long long)bytes, 1);
     }
-    pilha->top = novaCelula;
-    pilha->qtde++;
+    return bloco;
 }
 
-// Desempilha a última operação da pilha e retorna o ponteiro para a célula removida (ou NULL se vazia)
-Cell* pop(Stack *pilha) {
-    if (pilha->qtde == 0) {
-        return NULL;
+void* alocar_zerada(int categoria, size_t qtde, size_t tamanho) {
+    void *bloco = calloc(qtde, tamanho);
+    if (bloco != NULL) {
+        contabilizar_memoria(categoria, (long long)(qtde * tamanho), 1);
     }
-    Cell *removida = pilha->top;
-    pilha->top = removida->proximo;
-    if (pilha->top != NULL) {
-        pilha->top->anterior = NULL;
+    return bloco;
+}
+
+void* realocar_memoria(int categoria, void *bloco, size_t bytesAntigos, size_t bytesNovos) {
+    void *novo = realloc(bloco, bytesNovos);
+    if (novo != NULL) {
+        contabilizar_memoria(categoria, (long long)bytesNovos - (long long)bytesAntigos, bloco == NULL ? 1 : 0);
     }
-    pilha->qtde--;
-    return removida;
+    return novo;
 }
 
-// Imprime o histórico de operações armazenado na pilha (do topo para a base)
-void imprimir_stack(const Stack *pilha) {
-    printf("\nHistórico de operações:\n");
-    if (pilha->top == NULL) {
-        printf("(Nenhuma operação registrada.)\n");
+// Libera um bloco informando o tamanho com que foi alocado
+void liberar_memoria(int categoria, void *bloco, size_t bytes) {
+    if (bloco == NULL) {
         return;
     }
-    // Percorre a pilha imprimindo cada operação
-    for (Cell *celulaAtual = pilha->top; celulaAtual != NULL; celulaAtual = celulaAtual->proximo) {
-        switch (celulaAtual->operacao) {
-            case 'E':
-                printf("Enfileiramento de %s\n", celulaAtual->paciente ? celulaAtual->paciente->nome : "(desconhecido)");
-                break;
-            case 'D':
-                printf("Desenfileiramento de %s\n", celulaAtual->paciente ? celulaAtual->paciente->nome : "(desconhecido)");
-                break;
-            default:
-                printf("Operação desconhecida\n");
-                break;
-        }
+    free(bloco);
+    contabilizar_memoria(categoria, -(long long)bytes, -1);
+}
+
+// Passa a posse de blocos de uma estrutura para outra (ex.: paciente atendido vai da fila à pilha)
+void transferir_memoria(int origem, int destino, size_t bytes, long alocacoes) {
+    contabilizar_memoria(origem, -(long long)bytes, -alocacoes);
+    contabilizar_memoria(destino, (long long)bytes, alocacoes);
+}
+
+// Orçamento esgotado: novas admissões (cadastros, filas, cargas) são recusadas
+int memoria_esgotada() {
+    return orcamentoMemoria > 0 && memoria_total() >= orcamentoMemoria;
+}
+
+// Mostra os bytes vivos por estrutura, o pico e o orçamento
+void mostrar_memoria() {
+    printf("\n%14s %10s  %s\n", "Bytes vivos", "Blocos", "Estrutura");
+    for (int i = 0; i < QTDE_CATEGORIAS_MEMORIA; i++) {
+        printf("%14lld %10ld  %s\n", __atomic_load_n(&memoriaViva[i], __ATOMIC_RELAXED),
+               __atomic_load_n(&alocacoesVivas[i], __ATOMIC_RELAXED), NOMES_CATEGORIAS_MEMORIA[i]);
+    }
+    printf("%14lld %10s  %s\n", memoria_total(), "", "Total");
+    printf("\nPico: %lld bytes | Orçamento: ", __atomic_load_n(&picoMemoria, __ATOMIC_RELAXED));
+    if (orcamentoMemoria > 0) {
+        printf("%lld bytes (%.1f%% em uso)%s\n", orcamentoMemoria, 100.0 * memoria_total() / orcamentoMemoria,
+               memoria_esgotada() ? " - ESGOTADO, novas admissões recusadas" : "");
+    } else {
+        printf("sem limite\n");
     }
-    printf("\n");
 }
 
-// Desfaz a última operação realizada na fila de atendimento comum, se possível
-void desfazer_ultima_operacao(Stack *pilha, Fila *fila) {
-    Cell *ultimaOperacao = pop(pilha);
-    if (ultimaOperacao == NULL) {
-        limpar_console();
-        printf("\nERRO!\nNão temos operações para reverter.\n");
-        limpar_console_dinamico();
+// Submenu da memória: uso atual e definição do orçamento
+void menu_memoria() {
+    limpar_console();
+    mostrar_memoria();
+    printf("\nNovo orçamento em KB (0 = sem limite, Enter mantém): ");
+    char linha[50];
+    if (fgets(linha, sizeof(linha), stdin) != NULL && linha[0] != '\n') {
+        orcamentoMemoria = atoll(linha) * 1024;
+        printf("\nOrçamento %s.\n", orcamentoMemoria > 0 ? "definido" : "removido");
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Estatísticas de Espera ** 
+
+// Zera as estatísticas de um turno (mantém a contagem de pacientes ainda aguardando)
+void zerar_estatisticas(EstatisticasEspera *est) {
+    long pendentes = est->pendentes;
+    memset(est, 0, sizeof(EstatisticasEspera));
+    est->pendentes = pendentes;
+}
+
+// Faixa do esboço para um tempo de espera: 8 subfaixas por potência de 2 (erro relativo < 12,5%)
+int faixa_esboco(long long esperaMs) {
+    if (esperaMs < SUBFAIXAS_ESBOCO) {
+        return esperaMs < 0 ? 0 : (int)esperaMs;
+    }
+    int expoente = 63 - __builtin_clzll((unsigned long long)esperaMs);
+    int sub = (int)((esperaMs >> (expoente - 3)) & (SUBFAIXAS_ESBOCO - 1));
+    int faixa = (expoente - 2) * SUBFAIXAS_ESBOCO + sub;
+    return faixa < FAIXAS_ESBOCO ? faixa : FAIXAS_ESBOCO - 1;
+}
+
+// Valor representativo (ponto médio) de uma faixa do esboço
+long long valor_faixa_esboco(int faixa) {
+    if (faixa < SUBFAIXAS_ESBOCO) {
+        return faixa;
+    }
+    int expoente = faixa / SUBFAIXAS_ESBOCO + 2;
+    long long largura = 1LL << (expoente - 3);
+    long long inicio = (long long)(SUBFAIXAS_ESBOCO + faixa % SUBFAIXAS_ESBOCO) << (expoente - 3);
+    return inicio + largura / 2;
+}
+
+// Paciente entrou na fila: O(1)
+void registrar_entrada(EstatisticasEspera *est) {
+    est->entradas++;
+    est->pendentes++;
+}
+
+// Entrada desfeita antes do atendimento: O(1)
+void cancelar_entrada(EstatisticasEspera *est) {
+    if (est->entradas > 0) est->entradas--;
+    if (est->pendentes > 0) est->pendentes--;
+}
+
+// Paciente deixou a fila sem ser atendido: O(1)
+void registrar_desistencia(EstatisticasEspera *est) {
+    if (est->pendentes > 0) est->pendentes--;
+    est->desistencias++;
+}
+
+// Desistência desfeita (paciente voltou à fila): O(1)
+void cancelar_desistencia(EstatisticasEspera *est) {
+    if (est->desistencias > 0) est->desistencias--;
+    est->pendentes++;
+}
+
+// Paciente atendido após esperar esperaMs: atualiza soma, máximo e esboço em O(1)
+void registrar_atendimento(EstatisticasEspera *est, long long esperaMs) {
+    if (esperaMs < 0) esperaMs = 0;
+    if (est->pendentes > 0) est->pendentes--;
+    est->amostras++;
+    est->somaEspera += esperaMs;
+    if (esperaMs >= est->maxEspera) {
+        est->maxEspera = esperaMs;
+        est->maxAproximado = 0;
+    }
+    est->contagem[faixa_esboco(esperaMs)]++;
+}
+
+// Maior valor que cai em uma faixa do esboço
+long long limite_faixa_esboco(int faixa) {
+    if (faixa < SUBFAIXAS_ESBOCO) {
+        return faixa;
+    }
+    int expoente = faixa / SUBFAIXAS_ESBOCO + 2;
+    long long inicio = (long long)(SUBFAIXAS_ESBOCO + faixa % SUBFAIXAS_ESBOCO) << (expoente - 3);
+    return inicio + (1LL << (expoente - 3)) - 1;
+}
+
+// Atendimento desfeito (paciente voltou à fila): retira a amostra em O(1).
+// Se a amostra era o máximo, ele é refeito pela maior faixa ainda ocupada do esboço
+// (limitado ao máximo anterior) e passa a ser exibido como aproximado.
+void cancelar_atendimento(EstatisticasEspera *est, long long esperaMs) {
+    if (esperaMs < 0) esperaMs = 0;
+    int faixa = faixa_esboco(esperaMs);
+    if (est->amostras == 0 || est->contagem[faixa] == 0) {
         return;
     }
-    // Verifica qual operação foi registrada e desfaz de acordo
-    switch (ultimaOperacao->operacao) {
-        case 'E': {  // Desfazer enfileiramento (remover último da fila)
-            EFila *ultimoNo = fila->tail;
-            if (ultimoNo != NULL) {
-                // Remove o último paciente da fila
-                fila->tail = ultimoNo->anterior;
-                if (fila->tail != NULL) {
-                    fila->tail->proximo = NULL;
-                } else {
-                    fila->head = NULL;
-                }
-                free(ultimoNo);
-                fila->qtde--;
-                limpar_console();
-                printf("\nSUCESSO!\nÚltimo paciente adicionado a fila foi retirado.\n");
-                limpar_console_dinamico();
-            }
-            break;
-        }
-        case 'D': {  // Desfazer desenfileiramento (recolocar paciente na frente da fila)
-            EFila *novoNo = malloc(sizeof(EFila));
-            novoNo->dados = ultimaOperacao->paciente;
-            novoNo->anterior = NULL;
-            novoNo->proximo = fila->head;
-            if (fila->head != NULL) {
-                fila->head->anterior = novoNo;
-            } else {
-                fila->tail = novoNo;
-            }
-            fila->head = novoNo;
-            fila->qtde++;
-            limpar_console();
-            printf("\nSUCESSO!\nÚltimo paciente removido da fila foi realocado nela.\n");
-            limpar_console_dinamico();
+    est->amostras--;
+    est->somaEspera -= esperaMs;
+    est->contagem[faixa]--;
+    est->pendentes++;
+    if (esperaMs < est->maxEspera && est->amostras > 0) {
+        return;
+    }
+    long long anterior = est->maxEspera;
+    est->maxEspera = 0;
+    est->maxAproximado = 0;
+    for (int i = FAIXAS_ESBOCO - 1; i >= 0; i--) {
+        if (est->contagem[i] > 0) {
+            long long limite = limite_faixa_esboco(i);
+            est->maxEspera = i == FAIXAS_ESBOCO - 1 || limite > anterior ? anterior : limite;
+            est->maxAproximado = 1;
             break;
         }
-        default:
-            limpar_console();
-            printf("\nERRO DESCONHECIDO!\n");
-            limpar_console_dinamico();
-            break;
     }
-    // Libera a memória da célula de operação removida da pilha
-    free(ultimaOperacao);
 }
 
-// ** Módulo Atendimento (Fila Comum) ** 
+// Tempo médio de espera (ms)
+double media_espera(const EstatisticasEspera *est) {
+    return est->amostras ? (double)est->somaEspera / est->amostras : 0.0;
+}
 
-// Inicializa a estrutura de fila de atendimento vazia
-Fila* inicializa_fila() {
-    Fila *novaFila = malloc(sizeof(Fila));
-    if (novaFila != NULL) {
-        novaFila->head = NULL;
-        novaFila->tail = NULL;
-        novaFila->qtde = 0;
+// Percentil aproximado (0 < p <= 100) consultando apenas as faixas do esboço, nunca a fila
+long long percentil_espera(const EstatisticasEspera *est, double p) {
+    if (est->amostras == 0) {
+        return 0;
     }
-    return novaFila;
+    long alvo = (long)(p / 100.0 * est->amostras + 0.999999);
+    if (alvo < 1) alvo = 1;
+    long acumulado = 0;
+    for (int i = 0; i < FAIXAS_ESBOCO; i++) {
+        acumulado += est->contagem[i];
+        if (acumulado >= alvo) {
+            long long valor = valor_faixa_esboco(i);
+            return valor > est->maxEspera ? est->maxEspera : valor;
+        }
+    }
+    return est->maxEspera;
 }
 
-// Insere (enfileira) um paciente da lista de cadastrados na fila de atendimento comum
-void enfileirar_paciente(Lista *lista, Fila *fila, Stack *pilhaOperacoes) {
-    char nomeBusca[100];
-    printf("\nDigite o NOME do paciente que deseja adicionar a fila: ");
-    fgets(nomeBusca, sizeof(nomeBusca), stdin);
-    nomeBusca[strcspn(nomeBusca, "\n")] = '\0';
-    // Verifica se o paciente existe na lista de cadastrados
-    ELista *pacienteEncontrado = consultar_paciente_nome(lista, nomeBusca);
-    if (pacienteEncontrado == NULL) {
-        limpar_console();
-        printf("\nERRO!\nNão existe paciente com esse NOME cadastrado.\n");
-        limpar_console_dinamico();
+// Exibe as estatísticas de espera de uma fila (tempos em minutos e segundos)
+void mostrar_estatisticas(const char *titulo, const EstatisticasEspera *est) {
+    printf("\nEstatísticas de espera - %s\n", titulo);
+    printf("Entradas no turno: %ld | Aguardando: %ld | Atendidos: %ld | Desistências: %ld\n",
+           est->entradas, est->pendentes, est->amostras, est->desistencias);
+    if (est->amostras == 0) {
+        printf("(Nenhum atendimento registrado no turno.)\n");
         return;
     }
-    // Duplica os dados do paciente encontrado para não alterar o cadastro original
-    Registro *copiaRegistro = malloc(sizeof(Registro));
-    *copiaRegistro = *(pacienteEncontrado->dados);
-    // Cria um novo nó de fila para o paciente e insere no final da fila
-    EFila *novoNoFila = malloc(sizeof(EFila));
-    novoNoFila->dados = copiaRegistro;
-    novoNoFila->proximo = NULL;
-    novoNoFila->anterior = fila->tail;
-    if (fila->qtde == 0) {
-        // Se a fila estava vazia, novo nó é tanto head quanto tail
-        fila->head = novoNoFila;
-        fila->tail = novoNoFila;
-    } else {
-        // Liga o novo nó após o antigo último elemento
-        fila->tail->proximo = novoNoFila;
-        fila->tail = novoNoFila;
+    long long valores[5] = {
+        (long long)media_espera(est), est->maxEspera,
+        percentil_espera(est, 50), percentil_espera(est, 90), percentil_espera(est, 99)
+    };
+    const char *rotulos[5] = {"Média", "Máximo", "p50", "p90", "p99"};
+    for (int i = 0; i < 5; i++) {
+        printf("%-6s: %lld min %02lld s%s\n", rotulos[i], valores[i] / 60000, (valores[i] / 1000) % 60,
+               i == 1 && est->maxAproximado ? " (aproximado: o atendimento mais longo foi desfeito)" : "");
     }
-    fila->qtde++;
-    // Registra a operação de enfileiramento na pilha de operações para possibilidade de desfazer
-    push(pilhaOperacoes, 'E', copiaRegistro);
+}
+
+// Mostra as estatísticas e permite iniciar um novo turno zerando os contadores
+void consultar_estatisticas(const char *titulo, EstatisticasEspera *est) {
     limpar_console();
-    printf("\nSUCESSO!\nPaciente %s adicionado à fila de atendimento.\n", copiaRegistro->nome);
+    mostrar_estatisticas(titulo, est);
+    printf("\nIniciar novo turno (zerar estatísticas)? (s/n): ");
+    char resposta;
+    scanf(" %c", &resposta);
+    getchar();
+    if (resposta == 's' || resposta == 'S') {
+        zerar_estatisticas(est);
+        printf("\nEstatísticas zeradas para o novo turno.\n");
+    }
     limpar_console_dinamico();
 }
 
-// Remove (desenfileira) o primeiro paciente da fila de atendimento comum e o atende
-void desenfileirar_paciente(Fila *fila, Stack *pilhaOperacoes) {
-    if (fila->qtde == 0) {
-        limpar_console();
-        printf("\nERRO!\nNão há pacientes na fila de atendimento.\n");
-        limpar_console_dinamico();
+// ** Módulo Índice de RG ** 
+
+// Hash FNV-1a de um RG já normalizado (somente dígitos)
+unsigned long long hash_rg(const char *rgNumerico) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (int i = 0; rgNumerico[i] != '\0'; i++) {
+        hash ^= (unsigned char)rgNumerico[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Inicializa o índice vazio com capacidade para algumas dezenas de pacientes
+void inicializar_indice_rg(IndiceRG *indice) {
+    indice->capacidade = 64;
+    indice->qtde = 0;
+    indice->ocupadas = 0;
+    indice->entradas = alocar_zerada(MEM_CADASTRO, (size_t)indice->capacidade, sizeof(EIndiceRG));
+}
+
+// Procura a posição do RG normalizado no índice. Retorna -1 se não estiver indexado.
+int posicao_indice_rg(const IndiceRG *indice, const char *rgNumerico, unsigned long long hash) {
+    int mascara = indice->capacidade - 1;
+    for (int i = (int)(hash & mascara); indice->entradas[i].no != NULL; i = (i + 1) & mascara) {
+        const EIndiceRG *entrada = &indice->entradas[i];
+        if (entrada->no != LAPIDE_INDICE && entrada->hash == hash) {
+            char rgEntrada[20];
+            extrair_numeros_rg(entrada->no->dados->rg, rgEntrada);
+            if (strcmp(rgEntrada, rgNumerico) == 0) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+// Busca o nó indexado para um RG em qualquer formato: O(1) esperado
+ELista* buscar_indice_rg(const IndiceRG *indice, const char *rg) {
+    char rgNumerico[20];
+    extrair_numeros_rg(rg, rgNumerico);
+    int posicao = posicao_indice_rg(indice, rgNumerico, hash_rg(rgNumerico));
+    return posicao < 0 ? NULL : indice->entradas[posicao].no;
+}
+
+// Dobra a capacidade do índice, descartando as lápides
+void redimensionar_indice_rg(IndiceRG *indice, int novaCapacidade) {
+    EIndiceRG *antigas = indice->entradas;
+    int capacidadeAntiga = indice->capacidade;
+    indice->entradas = alocar_zerada(MEM_CADASTRO, (size_t)novaCapacidade, sizeof(EIndiceRG));
+    indice->capacidade = novaCapacidade;
+    indice->ocupadas = indice->qtde;
+    int mascara = novaCapacidade - 1;
+    for (int i = 0; i < capacidadeAntiga; i++) {
+        if (antigas[i].no != NULL && antigas[i].no != LAPIDE_INDICE) {
+            int j = (int)(antigas[i].hash & mascara);
+            while (indice->entradas[j].no != NULL) {
+                j = (j + 1) & mascara;
+            }
+            indice->entradas[j] = antigas[i];
+        }
+    }
+    liberar_memoria(MEM_CADASTRO, antigas, (size_t)capacidadeAntiga * sizeof(EIndiceRG));
+}
+
+// Indexa um nó da lista pelo seu RG. Se o RG já estiver indexado, o nó passa a ser o indexado
+// (o mais recente, o mesmo que a busca sequencial a partir do início da lista encontraria).
+void indexar_rg(IndiceRG *indice, ELista *no) {
+    if ((indice->ocupadas + 1) * 4 >= indice->capacidade * 3) {
+        redimensionar_indice_rg(indice, indice->capacidade * 2);
+    }
+    char rgNumerico[20];
+    extrair_numeros_rg(no->dados->rg, rgNumerico);
+    unsigned long long hash = hash_rg(rgNumerico);
+    int posicao = posicao_indice_rg(indice, rgNumerico, hash);
+    if (posicao >= 0) {
+        indice->entradas[posicao].no = no;
+        indice->entradas[posicao].duplicatas++;
         return;
     }
-    // Remove o nó do início da fila (head)
-    EFila *removerNo = fila->head;
-    fila->head = removerNo->proximo;
-    if (fila->head != NULL) {
-        fila->head->anterior = NULL;
-    } else {
-        // Se a fila ficou vazia, ajusta o ponteiro tail
-        fila->tail = NULL;
+    int mascara = indice->capacidade - 1;
+    int i = (int)(hash & mascara);
+    while (indice->entradas[i].no != NULL && indice->entradas[i].no != LAPIDE_INDICE) {
+        i = (i + 1) & mascara;
     }
-    // Registra a operação de desenfileiramento na pilha, guardando o paciente atendido
-    push(pilhaOperacoes, 'D', removerNo->dados);
-    limpar_console();
-    printf("\nSUCESSO!\nPaciente %s atendido\n", removerNo->dados->nome);
-    limpar_console_dinamico();
-    // Libera o nó removido (mas não libera os dados do paciente, pois podem ser usados para desfazer)
-    free(removerNo);
-    fila->qtde--;
+    if (indice->entradas[i].no == NULL) {
+        indice->ocupadas++;
+    }
+    indice->entradas[i].no = no;
+    indice->entradas[i].hash = hash;
+    indice->entradas[i].duplicatas = 1;
+    indice->qtde++;
 }
 
-// Exibe todos os pacientes atualmente na fila de atendimento comum, na ordem de chegada
-void mostrar_fila(const Fila *fila) {
-    if (fila->qtde == 0) {
-        limpar_console();
-        printf("\nERRO!\nA fila de atendimento está vazia.\n");
-        limpar_console_dinamico();
+// Retira um nó do índice (deve ser chamado antes de alterar ou liberar o RG do nó).
+// Se outro nó da lista tiver o mesmo RG, ele passa a ser o indexado; a lista só é percorrida
+// quando a entrada conta mais de um nó com o RG.
+void desindexar_rg(IndiceRG *indice, const Lista *lista, ELista *no) {
+    char rgNumerico[20];
+    extrair_numeros_rg(no->dados->rg, rgNumerico);
+    int posicao = posicao_indice_rg(indice, rgNumerico, hash_rg(rgNumerico));
+    if (posicao < 0) {
         return;
     }
-    limpar_console();
-    printf("Pacientes na fila de atendimento:\n");
-    int posicao = 1;
-    // Percorre a fila do head ao tail imprimindo os pacientes em sequência
-    for (EFila *noAtual = fila->head; noAtual != NULL; noAtual = noAtual->proximo) {
-        printf("%d. Nome: %s; Idade: %d; RG: %s; Entrada: %02d/%02d/%04d\n",
-               posicao++, noAtual->dados->nome, noAtual->dados->idade, noAtual->dados->rg,
-               noAtual->dados->entrada->dia, noAtual->dados->entrada->mes, noAtual->dados->entrada->ano);
+    EIndiceRG *entrada = &indice->entradas[posicao];
+    if (entrada->no != no) {
+        entrada->duplicatas--;  // o nó era uma duplicata não indexada
+        return;
+    }
+    // Procura uma duplicata para assumir a entrada (só acontece com RGs repetidos no cadastro)
+    for (ELista *atual = entrada->duplicatas > 1 ? lista->inicio : NULL; atual != NULL; atual = atual->proximo) {
+        char rgAtual[20];
+        if (atual == no) {
+            continue;
+        }
+        extrair_numeros_rg(atual->dados->rg, rgAtual);
+        if (strcmp(rgAtual, rgNumerico) == 0) {
+            entrada->no = atual;
+            entrada->duplicatas--;
+            return;
+        }
     }
+    entrada->no = LAPIDE_INDICE;
+    indice->qtde--;
 }
 
-// ** Módulo Atendimento Prioritário (Heap) ** 
+// ** Módulo Mapa de Espera ** 
 
-// Calcula o índice do filho esquerdo no heap, dado o índice do pai
-int filho_esquerda(int indicePai) {
-    return 2 * indicePai + 1;
+// Ativa o mapa de espera de uma fila. 'registro' devolve o paciente associado a um valor.
+void inicializar_mapa_espera(MapaEspera *mapa, int categoria, const void *dona,
+                             const Registro* (*registro)(const void *dona, long long valor)) {
+    mapa->capacidade = 32;
+    mapa->ocupadas = 0;
+    mapa->qtde = 0;
+    mapa->categoria = categoria;
+    mapa->dona = dona;
+    mapa->registro = registro;
+    mapa->entradas = alocar_memoria(categoria, (size_t)mapa->capacidade * sizeof(EMapaEspera));
+    for (int i = 0; i < mapa->capacidade; i++) {
+        mapa->entradas[i].valor = MAPA_VAZIO;
+    }
 }
 
-// Calcula o índice do filho direito no heap, dado o índice do pai
-int filho_direita(int indicePai) {
-    return 2 * indicePai + 2;
+void liberar_mapa_espera(MapaEspera *mapa) {
+    liberar_memoria(mapa->categoria, mapa->entradas, (size_t)mapa->capacidade * sizeof(EMapaEspera));
+    mapa->entradas = NULL;
+    mapa->capacidade = 0;
 }
 
-// Calcula o índice do pai no heap, dado o índice de um filho
-int pai(int indiceFilho) {
-    return (indiceFilho - 1) / 2;
+// Posição do mapa ocupada pelo RG normalizado, ou -1 se o paciente não aguarda na fila
+int posicao_mapa_espera(const MapaEspera *mapa, const char *rgNumerico, unsigned long long hash) {
+    int mascara = mapa->capacidade - 1;
+    for (int i = (int)(hash & mascara); mapa->entradas[i].valor != MAPA_VAZIO; i = (i + 1) & mascara) {
+        const EMapaEspera *entrada = &mapa->entradas[i];
+        if (entrada->valor != LAPIDE_MAPA && entrada->hash == hash) {
+            const Registro *paciente = mapa->registro(mapa->dona, entrada->valor);
+            char rgEntrada[20];
+            extrair_numeros_rg(paciente->rg, rgEntrada);
+            if (strcmp(rgEntrada, rgNumerico) == 0) {
+                return i;
+            }
+        }
+    }
+    return -1;
 }
 
-// Função auxiliar para manter a propriedade do heap (reorganiza a partir de um índice pai)
-void peneirar(Heap *heap, int indicePai) {
-    int maior = indicePai;
-    int indiceEsq = filho_esquerda(indicePai);
-    int indiceDir = filho_direita(indicePai);
-    // Compara o pai com o filho esquerdo
-    if (indiceEsq < heap->qtde && heap->dados[indiceEsq]->idade > heap->dados[maior]->idade) {
-        maior = indiceEsq;
+// Posição do mapa de um RG em qualquer formato: O(1) esperado
+int buscar_mapa_espera(const MapaEspera *mapa, const char *rg) {
+    if (mapa->capacidade == 0) {
+        return -1;
     }
-    // Compara o pai (ou maior até agora) com o filho direito
-    if (indiceDir < heap->qtde && heap->dados[indiceDir]->idade > heap->dados[maior]->idade) {
-        maior = indiceDir;
+    char rgNumerico[20];
+    extrair_numeros_rg(rg, rgNumerico);
+    return posicao_mapa_espera(mapa, rgNumerico, hash_rg(rgNumerico));
+}
+
+// Reconstrói o mapa com a capacidade informada, descartando as lápides. As posições das
+// entradas mudam.
+void redimensionar_mapa_espera(MapaEspera *mapa, int capacidade) {
+    EMapaEspera *antigas = mapa->entradas;
+    int capacidadeAntiga = mapa->capacidade;
+    mapa->capacidade = capacidade;
+    mapa->ocupadas = mapa->qtde;
+    mapa->entradas = alocar_memoria(mapa->categoria, (size_t)mapa->capacidade * sizeof(EMapaEspera));
+    for (int i = 0; i < mapa->capacidade; i++) {
+        mapa->entradas[i].valor = MAPA_VAZIO;
     }
-    // Se um dos filhos for maior que o pai, realiza a troca e continua o processo recursivamente
-    if (maior != indicePai) {
-        Registro *temp = heap->dados[indicePai];
-        heap->dados[indicePai] = heap->dados[maior];
-        heap->dados[maior] = temp;
-        peneirar(heap, maior);
+    int mascara = mapa->capacidade - 1;
+    for (int i = 0; i < capacidadeAntiga; i++) {
+        if (antigas[i].valor >= 0) {
+            int j = (int)(antigas[i].hash & mascara);
+            while (mapa->entradas[j].valor != MAPA_VAZIO) {
+                j = (j + 1) & mascara;
+            }
+            mapa->entradas[j] = antigas[i];
+        }
     }
+    liberar_memoria(mapa->categoria, antigas, (size_t)capacidadeAntiga * sizeof(EMapaEspera));
 }
 
-// (Re)constrói o heap a partir dos dados atuais, garantindo a propriedade de max-heap
-void construir(Heap *heap) {
-    // Ajusta a partir dos nós internos (metade inicial do array)
-    for (int i = (heap->qtde / 2) - 1; i >= 0; i--) {
-        peneirar(heap, i);
+// Associa o paciente (que ainda não está no mapa) ao valor. Retorna a posição usada; se o
+// mapa precisou ser reconstruído, '*redimensionado' recebe 1 (as posições anteriores mudaram).
+int inserir_mapa_espera(MapaEspera *mapa, const Registro *paciente, long long valor, int *redimensionado) {
+    *redimensionado = 0;
+    if ((mapa->ocupadas + 1) * 4 >= mapa->capacidade * 3) {
+        // Só dobra se os pacientes no mapa ocupam metade dele; se o excesso é de lápides
+        // (entradas e saídas da fila), basta reconstruí-lo do mesmo tamanho
+        int capacidade = (mapa->qtde + 1) * 2 >= mapa->capacidade ? mapa->capacidade * 2 : mapa->capacidade;
+        redimensionar_mapa_espera(mapa, capacidade);
+        *redimensionado = 1;
+    }
+    char rgNumerico[20];
+    extrair_numeros_rg(paciente->rg, rgNumerico);
+    unsigned long long hash = hash_rg(rgNumerico);
+    int mascara = mapa->capacidade - 1;
+    int i = (int)(hash & mascara);
+    while (mapa->entradas[i].valor >= 0) {
+        i = (i + 1) & mascara;
+    }
+    if (mapa->entradas[i].valor == MAPA_VAZIO) {
+        mapa->ocupadas++;
     }
+    mapa->entradas[i].hash = hash;
+    mapa->entradas[i].valor = valor;
+    mapa->qtde++;
+    return i;
 }
 
-// Inicializa a estrutura de heap (fila prioritária) vazia
-void inicializar_heap(Heap *heap) {
-    heap->qtde = 0;
-    for (int i = 0; i < MAX_HEAP; i++) {
-        heap->dados[i] = NULL;
+// Retira a entrada de uma posição do mapa
+void remover_mapa_espera(MapaEspera *mapa, int posicao) {
+    mapa->entradas[posicao].valor = LAPIDE_MAPA;
+    mapa->qtde--;
+}
+
+// ** Módulo Versões do Cadastro (Leituras Isoladas) ** 
+// A lista continua sendo a estrutura de quem altera o cadastro. Com as versões ativadas, cada
+// alteração também publica uma versão imutável (árvore de 32 ramos pela chave de cadastro, com
+// cópia apenas do caminho alterado). Listagens, relatórios e salvamentos leem uma versão fixa,
+// obtida em O(1), enquanto as alterações seguem publicando versões novas sem esperar por elas.
+// Os registros publicados também são imutáveis: atualizar um paciente troca o registro do nó.
+
+NoVersao* criar_no_versao(VersoesCadastro *versoes) {
+    NoVersao *no = alocar_zerada(MEM_CADASTRO, 1, sizeof(NoVersao));
+    no->edicao = versoes->edicao;
+    return no;
+}
+
+// Guarda um bloco substituído pela escrita em andamento até que nenhuma leitura o alcance
+void aposentar_versao(VersoesCadastro *versoes, int tipo, void *item, int altura) {
+    if (versoes->qtdeAposentados == versoes->capacidadeAposentados) {
+        int capacidade = versoes->capacidadeAposentados ? versoes->capacidadeAposentados * 2 : 64;
+        versoes->aposentados = realocar_memoria(MEM_CADASTRO, versoes->aposentados,
+                                                (size_t)versoes->capacidadeAposentados * sizeof(ItemAposentado),
+                                                (size_t)capacidade * sizeof(ItemAposentado));
+        versoes->capacidadeAposentados = capacidade;
     }
+    versoes->aposentados[versoes->qtdeAposentados++] = (ItemAposentado){item, tipo, altura, 0};
 }
 
-// Insere um paciente na fila prioritária (heap), utilizando a idade como critério de prioridade (maior idade = maior prioridade)
-void inserir_heap(Heap *heap, Registro *paciente) {
-    if (heap->qtde >= MAX_HEAP) {
-        limpar_console();
-        printf("\nFila prioritária cheia (capacidade máxima atingida).\n");
-        limpar_console_dinamico();
+void liberar_arvore_versao(NoVersao *no, int altura, int comRegistros) {
+    if (no == NULL) {
         return;
     }
-    // Insere o novo paciente no final do array e então reorganiza o heap
-    heap->dados[heap->qtde] = paciente;
-    heap->qtde++;
-    construir(heap);
-    // (Nota: como usamos um max-heap de idade, o paciente de maior idade ficará na posição 0)
+    for (int i = 0; i < RAMOS_VERSAO; i++) {
+        if (altura > 0) {
+            liberar_arvore_versao(no->ramos[i], altura - 1, comRegistros);
+        } else if (comRegistros && no->ramos[i] != NULL) {
+            liberar_memoria(MEM_CADASTRO, no->ramos[i], sizeof(Registro));
+        }
+    }
+    liberar_memoria(MEM_CADASTRO, no, sizeof(NoVersao));
 }
 
-// Remove o paciente com maior prioridade (mais idoso) do heap e o considera atendido
-void remover_heap(Heap *heap) {
-    if (heap->qtde == 0) {
-        limpar_console();
-        printf("\nERRO!\nNão há pacientes na fila prioritária.\n");
-        limpar_console_dinamico();
+void liberar_aposentado(const ItemAposentado *aposentado) {
+    switch (aposentado->tipo) {
+        case APOSENTADO_NO:
+            liberar_memoria(MEM_CADASTRO, aposentado->item, sizeof(NoVersao));
+            break;
+        case APOSENTADO_REGISTRO:
+            liberar_memoria(MEM_CADASTRO, aposentado->item, sizeof(Registro));
+            break;
+        case APOSENTADO_VERSAO:
+            liberar_memoria(MEM_CADASTRO, aposentado->item, sizeof(VersaoCadastro));
+            break;
+        case APOSENTADO_ARVORE:
+            liberar_arvore_versao(aposentado->item, aposentado->altura, 1);
+            break;
+    }
+}
+
+// Grava 'registro' na chave (NULL retira) abaixo do nó e retorna o nó que o substitui. Nós
+// já publicados são copiados; os criados nesta escrita são alterados no lugar, de modo que
+// um lote inteiro copia cada nó no máximo uma vez.
+NoVersao* gravar_no_versao(VersoesCadastro *versoes, NoVersao *no, int altura, unsigned int chave, Registro *registro) {
+    if (no == NULL) {
+        if (registro == NULL) {
+            return NULL;
+        }
+        no = criar_no_versao(versoes);
+    } else if (no->edicao != versoes->edicao) {
+        NoVersao *copia = alocar_memoria(MEM_CADASTRO, sizeof(NoVersao));
+        *copia = *no;
+        copia->edicao = versoes->edicao;
+        aposentar_versao(versoes, APOSENTADO_NO, no, 0);
+        no = copia;
+    }
+    int ramo = (int)(chave >> (altura * BITS_RAMO_VERSAO)) & (RAMOS_VERSAO - 1);
+    void *antes = no->ramos[ramo];
+    void *depois = altura == 0 ? (void *)registro : (void *)gravar_no_versao(versoes, antes, altura - 1, chave, registro);
+    no->ramos[ramo] = depois;
+    no->ocupados += (depois != NULL) - (antes != NULL);
+    if (no->ocupados == 0) {
+        // Nó criado (ou copiado) nesta escrita: nenhuma leitura o conhece
+        liberar_memoria(MEM_CADASTRO, no, sizeof(NoVersao));
+        return NULL;
+    }
+    return no;
+}
+
+// Grava o registro da chave na versão em montagem (NULL retira o paciente)
+void gravar_versao(VersoesCadastro *versoes, unsigned int chave, Registro *registro) {
+    // A árvore ganha níveis conforme as chaves crescem; a raiz antiga vira o primeiro ramo
+    while (versoes->altura < 6 && (chave >> ((versoes->altura + 1) * BITS_RAMO_VERSAO)) != 0) {
+        if (versoes->raiz != NULL) {
+            NoVersao *raiz = criar_no_versao(versoes);
+            raiz->ramos[0] = versoes->raiz;
+            raiz->ocupados = 1;
+            versoes->raiz = raiz;
+        }
+        versoes->altura++;
+    }
+    versoes->raiz = gravar_no_versao(versoes, versoes->raiz, versoes->altura, chave, registro);
+}
+
+// Tenta avançar a época global (só se todas as leituras abertas já estiverem nela) e libera o
+// que foi aposentado há pelo menos duas épocas. Com 'tudo', libera tudo (nenhuma leitura aberta).
+void recolher_versoes(VersoesCadastro *versoes, int tudo) {
+    unsigned long epoca = __atomic_load_n(&versoes->epoca, __ATOMIC_SEQ_CST);
+    int avancar = 1;
+    for (int i = 0; i < MAX_LEITORES_VERSAO && avancar; i++) {
+        unsigned long leitor = __atomic_load_n(&versoes->leitores[i], __ATOMIC_SEQ_CST);
+        avancar = leitor == 0 || leitor == epoca;
+    }
+    if (!avancar && !tudo) {
         return;
     }
+    if (avancar) {
+        __atomic_store_n(&versoes->epoca, ++epoca, __ATOMIC_SEQ_CST);
+    }
+    // Os itens estão em ordem de época: libera o prefixo que já não pode ser alcançado
+    int liberados = 0;
+    while (liberados < versoes->aposentadosPublicados &&
+           (tudo || versoes->aposentados[liberados].epoca + 2 <= epoca)) {
+        liberar_aposentado(&versoes->aposentados[liberados++]);
+    }
+    if (liberados > 0) {
+        memmove(versoes->aposentados, versoes->aposentados + liberados,
+                (size_t)(versoes->qtdeAposentados - liberados) * sizeof(ItemAposentado));
+        versoes->qtdeAposentados -= liberados;
+        versoes->aposentadosPublicados -= liberados;
+        versoes->liberados += liberados;
+    }
+}
 
-    // O paciente mais idoso está no topo do heap
-    Registro *atendido = heap->dados[0];
-    limpar_console();
-    printf("Paciente prioritário atendido: %s (Idade: %d)\n", atendido->nome, atendido->idade);
-    limpar_console_dinamico();
+// Publica a árvore em montagem como a versão atual da lista. As leituras que já estavam
+// abertas continuam com a versão anterior; nada espera por elas.
+void publicar_versao(VersoesCadastro *versoes, const Lista *lista) {
+    VersaoCadastro *versao = alocar_memoria(MEM_CADASTRO, sizeof(VersaoCadastro));
+    *versao = (VersaoCadastro){versoes->raiz, versoes->altura, lista->qtde, lista->versao};
+    VersaoCadastro *anterior = __atomic_exchange_n(&versoes->atual, versao, __ATOMIC_SEQ_CST);
+    aposentar_versao(versoes, APOSENTADO_VERSAO, anterior, 0);
+    // A época é lida depois da troca: leituras que ainda veem a versão anterior já estão registradas
+    unsigned long epoca = __atomic_load_n(&versoes->epoca, __ATOMIC_SEQ_CST);
+    for (int i = versoes->aposentadosPublicados; i < versoes->qtdeAposentados; i++) {
+        versoes->aposentados[i].epoca = epoca;
+    }
+    versoes->aposentadosPublicados = versoes->qtdeAposentados;
+    versoes->edicao++;
+    versoes->publicadas++;
+    recolher_versoes(versoes, 0);
+}
 
-    // Substitui a raiz pelo último elemento e reduz a quantidade
-    heap->dados[0] = heap->dados[heap->qtde - 1];
-    heap->qtde--;
+// Ativa as versões na lista: a primeira é montada com os pacientes já cadastrados (O(n)).
+// A partir daí, cada alteração da lista publica uma versão nova.
+void ativar_versoes_lista(Lista *lista) {
+    if (lista->versoes != NULL) {
+        return;
+    }
+    VersoesCadastro *versoes = alocar_zerada(MEM_CADASTRO, 1, sizeof(VersoesCadastro));
+    versoes->epoca = 1;
+    versoes->edicao = 1;
+    versoes->atual = alocar_zerada(MEM_CADASTRO, 1, sizeof(VersaoCadastro));
+    // O início da lista é o cadastro mais recente, que fica com a maior chave
+    unsigned int chave = (unsigned int)lista->qtde;
+    for (ELista *no = lista->inicio; no != NULL; no = no->proximo) {
+        no->chave = --chave;
+        gravar_versao(versoes, no->chave, no->dados);
+    }
+    versoes->proximaChave = (unsigned int)lista->qtde;
+    lista->versoes = versoes;
+    publicar_versao(versoes, lista);
+}
+
+// Libera as versões da lista. Não pode haver leituras abertas.
+void desativar_versoes_lista(Lista *lista) {
+    VersoesCadastro *versoes = lista->versoes;
+    if (versoes == NULL) {
+        return;
+    }
+    // A árvore atual é da lista (seus registros são liberados junto com os nós da lista)
+    recolher_versoes(versoes, 1);
+    liberar_arvore_versao(versoes->raiz, versoes->altura, 0);
+    liberar_memoria(MEM_CADASTRO, versoes->atual, sizeof(VersaoCadastro));
+    liberar_memoria(MEM_CADASTRO, versoes->aposentados, (size_t)versoes->capacidadeAposentados * sizeof(ItemAposentado));
+    liberar_memoria(MEM_CADASTRO, versoes, sizeof(VersoesCadastro));
+    lista->versoes = NULL;
+}
+
+// Abre uma leitura isolada da versão atual do cadastro em O(1). Retorna 0 se a lista não tem
+// versões ativas ou se todas as vagas de leitura continuam ocupadas depois de
+// VOLTAS_VAGA_LEITURA voltas; quem chamou lê então a própria lista, o que só é seguro na thread
+// que altera o cadastro. Pode ser chamada de qualquer thread, ao mesmo tempo que as alterações.
+int abrir_leitura_cadastro(const Lista *lista, LeituraCadastro *leitura) {
+    VersoesCadastro *versoes = lista->versoes;
+    leitura->versoes = versoes;
+    leitura->versao = NULL;
+    if (versoes == NULL) {
+        return 0;
+    }
+    // Ocupa uma vaga com a época corrente antes de olhar a versão publicada
+    for (int tentativa = 0;; tentativa++) {
+        int vaga = tentativa % MAX_LEITORES_VERSAO;
+        unsigned long livre = 0;
+        unsigned long epoca = __atomic_load_n(&versoes->epoca, __ATOMIC_SEQ_CST);
+        if (__atomic_compare_exchange_n(&versoes->leitores[vaga], &livre, epoca, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            leitura->vaga = vaga;
+            break;
+        }
+        if (vaga == MAX_LEITORES_VERSAO - 1) {
+            if (tentativa / MAX_LEITORES_VERSAO + 1 >= VOLTAS_VAGA_LEITURA) {
+                return 0;  // vagas esgotadas
+            }
+            sched_yield();
+        }
+    }
+    leitura->versao = __atomic_load_n(&versoes->atual, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+// Encerra a leitura: a versão lida pode ser liberada pelas próximas alterações
+void fechar_leitura_cadastro(LeituraCadastro *leitura) {
+    if (leitura->versao != NULL) {
+        __atomic_store_n(&leitura->versoes->leitores[leitura->vaga], 0, __ATOMIC_RELEASE);
+        leitura->versao = NULL;
+    }
+}
+
+void percorrer_no_versao(const NoVersao *no, int altura, int maisRecentesPrimeiro,
+                         void (*visitar)(const Registro *, void *), void *contexto) {
+    for (int i = 0; i < RAMOS_VERSAO; i++) {
+        const void *ramo = no->ramos[maisRecentesPrimeiro ? RAMOS_VERSAO - 1 - i : i];
+        if (ramo == NULL) {
+            continue;
+        }
+        if (altura == 0) {
+            visitar(ramo, contexto);
+        } else {
+            percorrer_no_versao(ramo, altura - 1, maisRecentesPrimeiro, visitar, contexto);
+        }
+    }
+}
+
+// Visita os pacientes de uma versão em ordem de cadastro (ou na ordem da lista, do mais
+// recente para o mais antigo, com 'maisRecentesPrimeiro')
+void percorrer_versao(const VersaoCadastro *versao, int maisRecentesPrimeiro,
+                      void (*visitar)(const Registro *, void *), void *contexto) {
+    if (versao->raiz != NULL) {
+        percorrer_no_versao(versao->raiz, versao->altura, maisRecentesPrimeiro, visitar, contexto);
+    }
+}
+
+// ** Módulo Cadastro de Pacientes ** 
+
+// Inicializa a lista encadeada de pacientes (aloca Lista e define valores iniciais)
+Lista* inicializa_lista() {
+    Lista *novaLista = alocar_memoria(MEM_CADASTRO, sizeof(Lista));
+    if (novaLista != NULL) {
+        novaLista->inicio = NULL;
+        novaLista->qtde = 0;
+        memset(&novaLista->agregados, 0, sizeof(Agregados));
+        inicializar_indice_rg(&novaLista->indiceRg);
+        novaLista->versao = 0;
+        novaLista->versoes = NULL;
+    }
+    return novaLista;
+}
+
+// Soma (sinal = 1) ou retira (sinal = -1) um registro das contagens agregadas: O(1)
+void contabilizar_registro(Agregados *agregados, const Registro *paciente, int sinal) {
+    agregados->total += sinal;
+    int faixaIdade = paciente->idade / LARGURA_FAIXA_IDADE;
+    if (faixaIdade < 0) faixaIdade = 0;
+    if (faixaIdade >= FAIXAS_IDADE) faixaIdade = FAIXAS_IDADE - 1;
+    agregados->porIdade[faixaIdade] += sinal;
+    DataCalendario entrada = data_calendario(paciente->entrada);
+    int ano = entrada.ano;
+    int mes = entrada.mes;
+    if (ano < ANO_MINIMO || ano > ANO_MAXIMO || mes < 1 || mes > 12) {
+        agregados->foraDoIntervalo += sinal;
+        return;
+    }
+    agregados->porAno[ano - ANO_MINIMO] += sinal;
+    agregados->porAnoMes[ano - ANO_MINIMO][mes - 1] += sinal;
+}
+
+// Total de pacientes cadastrados: O(1)
+long total_pacientes(const Lista *lista) {
+    return lista->agregados.total;
+}
+
+// Admissões em um ano: O(1)
+long admissoes_no_ano(const Lista *lista, int ano) {
+    if (ano < ANO_MINIMO || ano > ANO_MAXIMO) {
+        return 0;
+    }
+    return lista->agregados.porAno[ano - ANO_MINIMO];
+}
+
+// Admissões em um mês de um ano: O(1)
+long admissoes_no_mes(const Lista *lista, int ano, int mes) {
+    if (ano < ANO_MINIMO || ano > ANO_MAXIMO || mes < 1 || mes > 12) {
+        return 0;
+    }
+    return lista->agregados.porAnoMes[ano - ANO_MINIMO][mes - 1];
+}
+
+// Pacientes na faixa de idade informada (faixa * 10 até faixa * 10 + 9 anos): O(1)
+long pacientes_na_faixa_idade(const Lista *lista, int faixa) {
+    if (faixa < 0 || faixa >= FAIXAS_IDADE) {
+        return 0;
+    }
+    return lista->agregados.porIdade[faixa];
+}
+
+// Cópia independente de um registro, contabilizada na estrutura que a possui
+Registro* copiar_registro(int categoria, const Registro *origem) {
+    Registro *copia = alocar_memoria(categoria, sizeof(Registro));
+    *copia = *origem;
+    return copia;
+}
+
+void destruir_registro(int categoria, Registro *registro) {
+    liberar_memoria(categoria, registro, sizeof(Registro));
+}
+
+// Com as versões ativas, publica a alteração da chave de um paciente: 'registro' passa a
+// ocupar a chave (NULL = paciente retirado) e 'substituido' só é liberado quando as leituras
+// abertas terminarem. Sem versões, 'substituido' é liberado na hora.
+void publicar_alteracao_lista(Lista *lista, unsigned int chave, Registro *registro, Registro *substituido) {
+    if (lista->versoes == NULL) {
+        destruir_registro(MEM_CADASTRO, substituido);
+        return;
+    }
+    gravar_versao(lista->versoes, chave, registro);
+    if (substituido != NULL) {
+        aposentar_versao(lista->versoes, APOSENTADO_REGISTRO, substituido, 0);
+    }
+    publicar_versao(lista->versoes, lista);
+}
+
+// Chave de cadastro do próximo paciente (só usada com as versões ativas)
+unsigned int proxima_chave_lista(Lista *lista) {
+    return lista->versoes != NULL ? lista->versoes->proximaChave++ : 0;
+}
+
+// Insere um novo paciente no início da lista de pacientes cadastrados
+void cadastrar_paciente(Lista *lista, Registro paciente) {
+    // Aloca um novo nó para a lista e copia os dados do paciente para ele
+    ELista *novoNo = alocar_memoria(MEM_CADASTRO, sizeof(ELista));
+    novoNo->dados = alocar_memoria(MEM_CADASTRO, sizeof(Registro));
+    *novoNo->dados = paciente;
+    novoNo->chave = proxima_chave_lista(lista);
+    // Insere o novo nó no início (cabeça) da lista encadeada
+    novoNo->proximo = lista->inicio;
+    lista->inicio = novoNo;
+    lista->qtde++;
+    lista->versao++;
+    contabilizar_registro(&lista->agregados, novoNo->dados, 1);
+    indexar_rg(&lista->indiceRg, novoNo);
+    publicar_alteracao_lista(lista, novoNo->chave, novoNo->dados, NULL);
+}
+
+// Mensagem para cadastro recusado por idade, data de entrada ou RG inválidos
+void avisar_registro_invalido() {
+    limpar_console();
+    printf("\nERRO!\nIdade (0 a %d), data de entrada ou RG (sem dígitos) inválido.\n", IDADE_MAXIMA);
+    limpar_console_dinamico();
+}
+
+// Imprime todos os pacientes presentes na lista de cadastrados
+void imprimir_lista(Sessao *sessao) {
+    limpar_console();
+    if (sessao->lista->inicio == NULL) {
+        printf("\nNenhum paciente cadastrado.\nAdicione algum e tente novamente!\n");
+        return;
+    }
+    printf("\n%d Pacientes cadastrados:\n\n", sessao->lista->qtde);
+    fflush(stdout);
+    Operacao op = {.tipo = OP_LISTAR};
+    executar_operacao(sessao, &op, NULL);
+}
+
+// Busca na lista um paciente pelo nome. Retorna o ponteiro para o nó do paciente ou NULL se não encontrado.
+ELista* consultar_paciente_nome(const Lista *lista, const char *nome) {
+    ELista *noAtual = lista->inicio;
+    // Percorre a lista comparando os nomes
+    while (noAtual != NULL) {
+        if (strcmp(noAtual->dados->nome, nome) == 0) {
+            return noAtual;  // paciente encontrado
+        }
+        noAtual = noAtual->proximo;
+    }
+    return NULL;  // paciente não encontrado
+}
+// Busca um paciente pelo RG (em qualquer formatação) usando o índice hash: O(1) esperado
+ELista* consultar_paciente_rg(const Lista *lista, const char *rg) {
+    return buscar_indice_rg(&lista->indiceRg, rg);
+}
+
+// Atualiza os dados de um paciente existente na lista de cadastrados
+void atualizar_paciente(Sessao *sessao) {
+    char rgPaciente[100];
+    printf("\nDigite o RG do paciente: ");
+    fgets(rgPaciente, sizeof(rgPaciente), stdin);
+    rgPaciente[strcspn(rgPaciente, "\n")] = '\0';  // remove o newline do final da string
+
+    ELista *noEncontrado = consultar_paciente_rg(sessao->lista, rgPaciente);
+    if (noEncontrado == NULL) {
+        limpar_console();
+        printf("\nERRO!\nNão existe paciente com esse RG cadastrado.\n");
+        limpar_console_dinamico();
+        return;
+    }
+    // Menu de opções de atualização
+    int opcaoAtualizacao;
+    printf("\n╔════════════════════════════════════════════╗\n");
+    printf("║     QUAL INFORMAÇÃO DESEJA ATUALIZAR?      ║\n");
+    printf("╠════════════════════════════════════════════╣\n");
+    printf("║ 1 - Nome                                   ║\n");
+    printf("║ 2 - Idade                                  ║\n");
+    printf("║ 3 - RG                                     ║\n");
+    printf("║ 4 - Data de entrada                        ║\n");
+    printf("╚════════════════════════════════════════════╝\n");
+    printf("\nSelecione uma opção: ");
+    scanf("%d", &opcaoAtualizacao);
+    getchar();  // consome o '\n' deixado pelo scanf
+
+    // Os novos dados partem dos atuais, com o campo escolhido alterado
+    Operacao op = {.tipo = OP_ATUALIZAR};
+    strcpy(op.texto, rgPaciente);
+    op.paciente = *noEncontrado->dados;
+    switch (opcaoAtualizacao) {
+        case 1:
+            printf("Digite o novo NOME: ");
+            fgets(op.paciente.nome, sizeof(op.paciente.nome), stdin);
+            op.paciente.nome[strcspn(op.paciente.nome, "\n")] = '\0';
+            break;
+        case 2:
+            printf("Digite a nova IDADE: ");
+            scanf("%d", &op.paciente.idade);
+            getchar();
+            break;
+        case 3:
+            printf("Digite o novo RG: ");
+            fgets(op.paciente.rg, sizeof(op.paciente.rg), stdin);
+            op.paciente.rg[strcspn(op.paciente.rg, "\n")] = '\0';
+            break;
+        case 4:
+            printf("Digite a nova data de ENTRADA (dd mm aaaa): ");
+            DataCalendario data;
+            scanf("%d %d %d", &data.dia, &data.mes, &data.ano);
+            getchar();
+            op.paciente.entrada = cria_data(data.dia, data.mes, data.ano);
+            break;
+        default:
+            limpar_console();
+            printf("\nERRO!\nOpção inválida, favor escolher outra\n");
+            limpar_console_dinamico();
+            return;
+    }
+    if (executar_operacao(sessao, &op, NULL) == OPERACAO_INVALIDA) {
+        avisar_registro_invalido();
+        return;
+    }
+    limpar_console();
+    printf("\nSUCESSO! Dados do paciente atualizados!\n");
+    limpar_console_dinamico();
+}
+
+// Retira um nó da lista (anterior = NULL se for o primeiro), atualizando agregados e índice.
+// Libera o nó e o registro (a lista é dona dos dois; com versões, o registro é liberado quando
+// as leituras que ainda o veem terminarem).
+void retirar_no_lista(Lista *lista, ELista *noAnterior, ELista *noAtual) {
+    if (noAnterior == NULL) {
+        // Removendo o primeiro nó da lista
+        lista->inicio = noAtual->proximo;
+    } else {
+        // Removendo um nó do meio ou fim da lista
+        noAnterior->proximo = noAtual->proximo;
+    }
+    contabilizar_registro(&lista->agregados, noAtual->dados, -1);
+    desindexar_rg(&lista->indiceRg, lista, noAtual);
+    // Libera o nó removido e, em seguida, o registro
+    Registro *dados = noAtual->dados;
+    unsigned int chave = noAtual->chave;
+    liberar_memoria(MEM_CADASTRO, noAtual, sizeof(ELista));
+    lista->qtde--;
+    lista->versao++;
+    publicar_alteracao_lista(lista, chave, NULL, dados);
+}
+
+// Remove da lista o primeiro paciente com o nome informado. Retorna 1 se removeu.
+int remover_paciente_nome(Lista *lista, const char *nome) {
+    ELista *noAtual = lista->inicio;
+    ELista *noAnterior = NULL;
+    // Percorre a lista até encontrar o paciente ou chegar ao final
+    while (noAtual != NULL) {
+        if (strcmp(noAtual->dados->nome, nome) == 0) {
+            // Se encontrado, retira o nó da lista encadeada
+            retirar_no_lista(lista, noAnterior, noAtual);
+            return 1;
+        }
+        // Avança para o próximo nó
+        noAnterior = noAtual;
+        noAtual = noAtual->proximo;
+    }
+    return 0;
+}
+
+// Remove um paciente da lista de cadastrados pelo nome
+void remover_paciente(Sessao *sessao, const char *nome) {
+    Operacao op = {.tipo = OP_REMOVER};
+    snprintf(op.texto, sizeof(op.texto), "%s", nome);
+    limpar_console();
+    if (executar_operacao(sessao, &op, NULL) == OPERACAO_OK) {
+        printf("\nSUCESSO!\nExclusão de %s realizada.\n", nome);
+    } else {
+        printf("ERRO!\nNão existe paciente com esse NOME cadastrado.\n");
+    }
+    limpar_console_dinamico();
+}
+
+// Remove o paciente indexado pelo RG, sem interação com o usuário. Retorna 1 se removeu.
+int remover_paciente_rg(Lista *lista, const char *rg) {
+    ELista *alvo = consultar_paciente_rg(lista, rg);
+    if (alvo == NULL) {
+        return 0;
+    }
+    ELista *noAnterior = NULL;
+    for (ELista *noAtual = lista->inicio; noAtual != alvo; noAtual = noAtual->proximo) {
+        noAnterior = noAtual;
+    }
+    retirar_no_lista(lista, noAnterior, alvo);
+    return 1;
+}
+
+// Substitui os dados de um paciente cadastrado pelos de 'novo', mantendo agregados e índice
+// de RGs em dia. O nó recebe um registro novo (o antigo pode estar sendo lido por uma versão).
+void alterar_paciente(Lista *lista, ELista *no, const Registro *novo) {
+    Registro *atual = no->dados;
+    Registro *substituto = copiar_registro(MEM_CADASTRO, novo);
+    int trocaRg = strcmp(atual->rg, novo->rg) != 0;
+    contabilizar_registro(&lista->agregados, atual, -1);
+    if (trocaRg) {
+        desindexar_rg(&lista->indiceRg, lista, no);
+    }
+    no->dados = substituto;
+    if (trocaRg) {
+        indexar_rg(&lista->indiceRg, no);
+    }
+    contabilizar_registro(&lista->agregados, substituto, 1);
+    lista->versao++;
+    publicar_alteracao_lista(lista, no->chave, substituto, atual);
+}
+
+// Libera todos os registros de uma lista e a deixa vazia. Com versões,
+// os registros saem junto com a árvore da versão atual, quando as leituras terminarem.
+void esvaziar_lista(Lista *lista) {
+    VersoesCadastro *versoes = lista->versoes;
+    ELista *noAtual = lista->inicio;
+    while (noAtual != NULL) {
+        ELista *proximo = noAtual->proximo;
+        if (versoes == NULL) {
+            destruir_registro(MEM_CADASTRO, noAtual->dados);
+        }
+        liberar_memoria(MEM_CADASTRO, noAtual, sizeof(ELista));
+        noAtual = proximo;
+    }
+    liberar_memoria(MEM_CADASTRO, lista->indiceRg.entradas, (size_t)lista->indiceRg.capacidade * sizeof(EIndiceRG));
+    lista->inicio = NULL;
+    lista->qtde = 0;
+    memset(&lista->agregados, 0, sizeof(Agregados));
+    inicializar_indice_rg(&lista->indiceRg);
+    lista->versao++;
+    if (versoes != NULL) {
+        if (versoes->raiz != NULL) {
+            aposentar_versao(versoes, APOSENTADO_ARVORE, versoes->raiz, versoes->altura);
+            versoes->raiz = NULL;
+        }
+        publicar_versao(versoes, lista);
+    }
+}
+
+// Libera a lista com todos os seus registros e o índice. Não pode haver leituras abertas.
+void destruir_lista(Lista *lista) {
+    esvaziar_lista(lista);
+    desativar_versoes_lista(lista);
+    liberar_memoria(MEM_CADASTRO, lista->indiceRg.entradas, (size_t)lista->indiceRg.capacidade * sizeof(EIndiceRG));
+    liberar_memoria(MEM_CADASTRO, lista, sizeof(Lista));
+}
+
+// ** Módulo Desfazer Operações (Pilha) ** 
+
+// Cria uma nova célula da pilha de operações com o código da operação fornecido
+Cell* start_cell(char operacao) {
+    Cell *novaCelula = alocar_memoria(MEM_PILHA, sizeof(Cell));
+    if (novaCelula != NULL) {
+        novaCelula->anterior = NULL;
+        novaCelula->proximo = NULL;
+        novaCelula->operacao = operacao;
+        novaCelula->paciente = NULL;
+        novaCelula->enfileiradoEm = 0;
+        novaCelula->sequencia = 0;
+        novaCelula->esperaMs = 0;
+    }
+    return novaCelula;
+}
+
+// Inicializa a pilha de operações (desfazimento) vazia
+Stack* start_stack() {
+    Stack *novaPilha = alocar_memoria(MEM_PILHA, sizeof(Stack));
+    if (novaPilha != NULL) {
+        novaPilha->top = NULL;
+        novaPilha->base = NULL;
+        novaPilha->qtde = 0;
+    }
+    return novaPilha;
+}
+
+// Libera uma célula retirada da pilha; as células 'D' e 'C' ainda são donas do paciente
+void descartar_celula(Cell *celula) {
+    if (celula->operacao == 'D' || celula->operacao == 'C') {
+        destruir_registro(MEM_PILHA, celula->paciente);
+    }
+    liberar_memoria(MEM_PILHA, celula, sizeof(Cell));
+}
+
+// Empilha uma nova operação na pilha (registrando enfileiramento ou desenfileiramento).
+// Acima de LIMITE_DESFAZER operações, a mais antiga é descartada.
+void push(Stack *pilha, char operacao, Registro *paciente) {
+    Cell *novaCelula = start_cell(operacao);
+    novaCelula->paciente = paciente;
+    // Coloca a nova célula no topo da pilha
+    novaCelula->proximo = pilha->top;
+    if (pilha->top != NULL) {
+        pilha->top->anterior = novaCelula;
+    } else {
+        pilha->base = novaCelula;
+    }
+    pilha->top = novaCelula;
+    pilha->qtde++;
+    if (pilha->qtde > LIMITE_DESFAZER) {
+        // A base é sempre mais antiga que qualquer célula que referencie o mesmo paciente
+        Cell *antiga = pilha->base;
+        pilha->base = antiga->anterior;
+        pilha->base->proximo = NULL;
+        pilha->qtde--;
+        descartar_celula(antiga);
+    }
+}
+
+// Desempilha a última operação da pilha e retorna o ponteiro para a célula removida (ou NULL se vazia)
+Cell* pop(Stack *pilha) {
+    if (pilha->qtde == 0) {
+        return NULL;
+    }
+    Cell *removida = pilha->top;
+    pilha->top = removida->proximo;
+    if (pilha->top != NULL) {
+        pilha->top->anterior = NULL;
+    } else {
+        pilha->base = NULL;
+    }
+    pilha->qtde--;
+    return removida;
+}
+
+// Libera a pilha, suas células e os pacientes atendidos que elas guardavam
+void destruir_pilha(Stack *pilha) {
+    for (Cell *celula = pilha->top; celula != NULL;) {
+        Cell *proxima = celula->proximo;
+        descartar_celula(celula);
+        celula = proxima;
+    }
+    liberar_memoria(MEM_PILHA, pilha, sizeof(Stack));
+}
+
+// Imprime o histórico de operações armazenado na pilha (do topo para a base)
+void imprimir_stack(const Stack *pilha) {
+    printf("\nHistórico de operações:\n");
+    if (pilha->top == NULL) {
+        printf("(Nenhuma operação registrada.)\n");
+        return;
+    }
+    // Percorre a pilha imprimindo cada operação
+    for (Cell *celulaAtual = pilha->top; celulaAtual != NULL; celulaAtual = celulaAtual->proximo) {
+        switch (celulaAtual->operacao) {
+            case 'E':
+                printf("Enfileiramento de %s\n", celulaAtual->paciente ? celulaAtual->paciente->nome : "(desconhecido)");
+                break;
+            case 'D':
+                printf("Desenfileiramento de %s\n", celulaAtual->paciente ? celulaAtual->paciente->nome : "(desconhecido)");
+                break;
+            case 'C':
+                printf("Desistência de %s\n", celulaAtual->paciente ? celulaAtual->paciente->nome : "(desconhecido)");
+                break;
+            default:
+                printf("Operação desconhecida\n");
+                break;
+        }
+    }
+    printf("\n");
+}
+
+// Desfaz a última operação registrada na pilha. Retorna o código da operação desfeita
+// ('E', 'D' ou 'C'), 0 se a pilha estava vazia ou '?' se a operação é desconhecida.
+char desfazer_operacao(Stack *pilha, Fila *fila) {
+    Cell *ultimaOperacao = pop(pilha);
+    if (ultimaOperacao == NULL) {
+        return 0;
+    }
+    char operacao = ultimaOperacao->operacao;
+    // Verifica qual operação foi registrada e desfaz de acordo
+    switch (operacao) {
+        case 'E': {  // Desfazer enfileiramento (remover último da fila)
+            EFila ultimo;
+            if (fila->qtde > 0) {
+                desmapear_paciente_fila(fila, elemento_fila(fila, fila->qtde - 1)->dados);
+            }
+            if (fila_retirar_fim(fila, &ultimo)) {
+                cancelar_entrada(&fila->estatisticas);
+                // A cópia enfileirada pertence à fila e é liberada
+                destruir_registro(MEM_FILA, ultimo.dados);
+            }
+            break;
+        }
+        case 'D':    // Desfazer desenfileiramento (recolocar paciente na frente da fila)
+        case 'C': {  // Desfazer desistência (recolocar paciente na posição que ocupava)
+            // O paciente volta a pertencer à fila, com a sequência e o instante originais de
+            // entrada; a amostra de espera registrada no atendimento (ou a desistência) é descartada
+            EFila item = {ultimaOperacao->paciente, ultimaOperacao->enfileiradoEm};
+            transferir_memoria(MEM_PILHA, MEM_FILA, sizeof(Registro), 1);
+            if (operacao == 'D') {
+                cancelar_atendimento(&fila->estatisticas, ultimaOperacao->esperaMs);
+            } else {
+                cancelar_desistencia(&fila->estatisticas);
+            }
+            restaurar_na_fila(fila, ultimaOperacao->sequencia, item);
+            break;
+        }
+        default:
+            operacao = '?';
+            break;
+    }
+    // Libera a célula removida da pilha (o paciente, se havia, já voltou para a fila)
+    liberar_memoria(MEM_PILHA, ultimaOperacao, sizeof(Cell));
+    return operacao;
+}
+
+// Desfaz a última operação e informa o resultado
+void desfazer_ultima_operacao(Sessao *sessao) {
+    Operacao op = {.tipo = OP_DESFAZER};
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    switch (resultado.desfeita) {
+        case 0:
+            printf("\nERRO!\nNão temos operações para reverter.\n");
+            break;
+        case 'E':
+            printf("\nSUCESSO!\nÚltimo paciente adicionado a fila foi retirado.\n");
+            break;
+        case 'D':
+            printf("\nSUCESSO!\nÚltimo paciente removido da fila foi realocado nela.\n");
+            break;
+        case 'C':
+            printf("\nSUCESSO!\nÚltimo paciente que desistiu voltou à sua posição na fila.\n");
+            break;
+        default:
+            printf("\nERRO DESCONHECIDO!\n");
+            break;
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Atendimento (Fila Comum) ** 
+
+// Inicializa a estrutura de fila de atendimento vazia
+Fila* inicializa_fila() {
+    Fila *novaFila = alocar_memoria(MEM_FILA, sizeof(Fila));
+    if (novaFila != NULL) {
+        novaFila->capacidade = CAPACIDADE_INICIAL_FILA;
+        novaFila->itens = alocar_memoria(MEM_FILA, CAPACIDADE_INICIAL_FILA * sizeof(EFila));
+        novaFila->inicio = 0;
+        novaFila->qtde = 0;
+        novaFila->lapides = 0;
+        novaFila->primeiraSequencia = 0;
+        novaFila->arvoreLapides = NULL;
+        novaFila->mapa.entradas = NULL;
+        novaFila->mapa.capacidade = 0;
+        memset(&novaFila->estatisticas, 0, sizeof(EstatisticasEspera));
+    }
+    return novaFila;
+}
+
+// Libera o anel e a estrutura da fila (os pacientes são liberados por quem os inseriu)
+void liberar_fila(Fila *fila) {
+    if (fila->arvoreLapides != NULL) {
+        liberar_memoria(MEM_FILA, fila->arvoreLapides, (fila->capacidade + 1) * sizeof(int));
+    }
+    if (fila->mapa.capacidade > 0) {
+        liberar_mapa_espera(&fila->mapa);
+    }
+    liberar_memoria(MEM_FILA, fila->itens, fila->capacidade * sizeof(EFila));
+    liberar_memoria(MEM_FILA, fila, sizeof(Fila));
+}
+
+// Elemento na posição i da fila (0 = primeiro)
+EFila* elemento_fila(const Fila *fila, int i) {
+    return &fila->itens[(fila->inicio + i) & (fila->capacidade - 1)];
+}
+
+// Pacientes aguardando (posições ocupadas menos as lápides)
+int pacientes_na_fila(const Fila *fila) {
+    return fila->qtde - fila->lapides;
+}
+
+// Árvore de Fenwick das lápides: soma 'delta' na posição do anel (O(log n))
+void somar_lapide(Fila *fila, int posicao, int delta) {
+    fila->lapides += delta;
+    for (int i = posicao + 1; i <= fila->capacidade; i += i & -i) {
+        fila->arvoreLapides[i] += delta;
+    }
+}
+
+// Lápides nas posições [0, fim) do anel (O(log n))
+int lapides_antes(const Fila *fila, int fim) {
+    int total = 0;
+    for (int i = fim; i > 0; i -= i & -i) {
+        total += fila->arvoreLapides[i];
+    }
+    return total;
+}
+
+// Reconstrói a árvore de Fenwick a partir das lápides do anel (O(n), usada quando o anel cresce)
+void reconstruir_arvore_lapides(Fila *fila) {
+    memset(fila->arvoreLapides, 0, (fila->capacidade + 1) * sizeof(int));
+    for (int i = 0; i < fila->qtde; i++) {
+        if (elemento_fila(fila, i)->dados == NULL) {
+            fila->arvoreLapides[((fila->inicio + i) & (fila->capacidade - 1)) + 1]++;
+        }
+    }
+    for (int i = 1; i <= fila->capacidade; i++) {
+        int acima = i + (i & -i);
+        if (acima <= fila->capacidade) {
+            fila->arvoreLapides[acima] += fila->arvoreLapides[i];
+        }
+    }
+}
+
+// Dobra o anel, copiando os elementos em ordem para o começo do novo vetor
+void crescer_fila(Fila *fila) {
+    int novaCapacidade = fila->capacidade * 2;
+    EFila *novos = alocar_memoria(MEM_FILA, novaCapacidade * sizeof(EFila));
+    for (int i = 0; i < fila->qtde; i++) {
+        novos[i] = *elemento_fila(fila, i);
+    }
+    liberar_memoria(MEM_FILA, fila->itens, fila->capacidade * sizeof(EFila));
+    fila->itens = novos;
+    fila->inicio = 0;
+    if (fila->arvoreLapides != NULL) {
+        liberar_memoria(MEM_FILA, fila->arvoreLapides, (fila->capacidade + 1) * sizeof(int));
+        fila->arvoreLapides = alocar_memoria(MEM_FILA, (novaCapacidade + 1) * sizeof(int));
+    }
+    fila->capacidade = novaCapacidade;
+    if (fila->arvoreLapides != NULL) {
+        reconstruir_arvore_lapides(fila);
+    }
+}
+
+// Operações do deque em anel (sem estatísticas; retiradas retornam 0 se a fila está vazia)
+void fila_inserir_fim(Fila *fila, EFila item) {
+    if (fila->qtde == fila->capacidade) {
+        crescer_fila(fila);
+    }
+    fila->itens[(fila->inicio + fila->qtde) & (fila->capacidade - 1)] = item;
+    fila->qtde++;
+}
+
+void fila_inserir_inicio(Fila *fila, EFila item) {
+    if (fila->qtde == fila->capacidade) {
+        crescer_fila(fila);
+    }
+    fila->inicio = (fila->inicio - 1) & (fila->capacidade - 1);
+    fila->itens[fila->inicio] = item;
+    fila->qtde++;
+    fila->primeiraSequencia--;
+}
+
+int fila_retirar_inicio(Fila *fila, EFila *item) {
+    if (fila->qtde == 0) {
+        return 0;
+    }
+    *item = fila->itens[fila->inicio];
+    fila->inicio = (fila->inicio + 1) & (fila->capacidade - 1);
+    fila->qtde--;
+    fila->primeiraSequencia++;
+    return 1;
+}
+
+int fila_retirar_fim(Fila *fila, EFila *item) {
+    if (fila->qtde == 0) {
+        return 0;
+    }
+    *item = *elemento_fila(fila, fila->qtde - 1);
+    fila->qtde--;
+    return 1;
+}
+
+// Elemento com o número de sequência informado, ou NULL se a sequência está fora da fila
+EFila* elemento_sequencia(const Fila *fila, long long sequencia) {
+    long long i = sequencia - fila->primeiraSequencia;
+    if (i < 0 || i >= fila->qtde) {
+        return NULL;
+    }
+    return elemento_fila(fila, (int)i);
+}
+
+// Paciente de uma sequência, consultado pelo mapa de espera para conferir o RG
+const Registro* registro_na_fila(const void *fila, long long sequencia) {
+    return elemento_sequencia(fila, sequencia)->dados;
+}
+
+// Ativa o mapa RG -> sequência, que permite desistências e consultas de posição por paciente
+void ativar_mapa_fila(Fila *fila) {
+    inicializar_mapa_espera(&fila->mapa, MEM_FILA, fila, registro_na_fila);
+}
+
+// Registra no mapa o paciente que acabou de ocupar a sequência informada
+void mapear_paciente_fila(Fila *fila, long long sequencia) {
+    if (fila->mapa.capacidade > 0) {
+        int redimensionado;
+        inserir_mapa_espera(&fila->mapa, elemento_sequencia(fila, sequencia)->dados, sequencia, &redimensionado);
+    }
+}
+
+// Retira do mapa um paciente que ainda ocupa sua posição na fila
+void desmapear_paciente_fila(Fila *fila, const Registro *paciente) {
+    if (fila->mapa.capacidade > 0) {
+        int posicao = buscar_mapa_espera(&fila->mapa, paciente->rg);
+        if (posicao >= 0) {
+            remover_mapa_espera(&fila->mapa, posicao);
+        }
+    }
+}
+
+// Descarta as lápides que chegaram ao início, para que o primeiro elemento seja sempre um paciente
+void descartar_lapides_inicio(Fila *fila) {
+    while (fila->qtde > 0 && fila->itens[fila->inicio].dados == NULL) {
+        EFila lapide;
+        somar_lapide(fila, fila->inicio, -1);
+        fila_retirar_inicio(fila, &lapide);
+    }
+}
+
+// Libera a fila e as cópias dos pacientes que aguardavam
+void destruir_fila(Fila *fila) {
+    for (int i = 0; i < fila->qtde; i++) {
+        destruir_registro(MEM_FILA, elemento_fila(fila, i)->dados);
+    }
+    liberar_fila(fila);
+}
+
+// Insere um paciente no final da fila, com entrada no instante 'agora' (ms)
+void inserir_na_fila_em(Fila *fila, Registro *paciente, long long agora) {
+    EFila item = {paciente, agora};
+    fila_inserir_fim(fila, item);
+    mapear_paciente_fila(fila, fila->primeiraSequencia + fila->qtde - 1);
+    registrar_entrada(&fila->estatisticas);
+}
+
+// Insere um paciente no final da fila, marcando o instante de entrada
+void inserir_na_fila(Fila *fila, Registro *paciente) {
+    inserir_na_fila_em(fila, paciente, instante_atual());
+}
+
+// Retira o primeiro paciente da fila e contabiliza sua espera até 'agora' (ms). Retorna NULL
+// se a fila está vazia; em 'enfileiradoEm' e 'esperaMs' (se não forem NULL) devolve o
+// instante em que ele entrou e a espera contabilizada.
+Registro* retirar_da_fila_em(Fila *fila, long long *enfileiradoEm, long long *esperaMs, long long agora) {
+    EFila item;
+    if (fila->qtde > 0) {
+        desmapear_paciente_fila(fila, fila->itens[fila->inicio].dados);
+    }
+    if (!fila_retirar_inicio(fila, &item)) {
+        return NULL;
+    }
+    if (fila->lapides > 0) {
+        descartar_lapides_inicio(fila);
+    }
+    // Contabiliza o tempo de espera do paciente atendido
+    long long espera = agora - item.enfileiradoEm;
+    registrar_atendimento(&fila->estatisticas, espera);
+    if (enfileiradoEm != NULL) {
+        *enfileiradoEm = item.enfileiradoEm;
+    }
+    if (esperaMs != NULL) {
+        *esperaMs = espera;
+    }
+    return item.dados;
+}
+
+// Retira o primeiro paciente da fila, contabilizando a espera até o instante atual
+Registro* retirar_da_fila(Fila *fila, long long *enfileiradoEm, long long *esperaMs) {
+    return retirar_da_fila_em(fila, enfileiradoEm, esperaMs, instante_atual());
+}
+
+// Recoloca um paciente na sua sequência original (desfazer atendimento ou desistência). Se a
+// sequência já saiu pelo início, as posições intermediárias voltam como lápides.
+void restaurar_na_fila(Fila *fila, long long sequencia, EFila item) {
+    EFila lapide = {NULL, 0};
+    if (fila->qtde == 0) {
+        fila->primeiraSequencia = sequencia + 1;
+    }
+    while (fila->primeiraSequencia > sequencia + 1) {
+        fila_inserir_inicio(fila, lapide);
+        if (fila->arvoreLapides == NULL) {
+            fila->arvoreLapides = alocar_zerada(MEM_FILA, fila->capacidade + 1, sizeof(int));
+        }
+        somar_lapide(fila, fila->inicio, 1);
+    }
+    if (fila->primeiraSequencia == sequencia + 1) {
+        fila_inserir_inicio(fila, item);
+    } else {
+        // A sequência ainda está no anel, ocupada por sua lápide
+        EFila *elemento = elemento_sequencia(fila, sequencia);
+        somar_lapide(fila, (int)(elemento - fila->itens), -1);
+        *elemento = item;
+    }
+    mapear_paciente_fila(fila, sequencia);
+}
+
+// Retira da fila o paciente com o RG informado, em qualquer posição: o mapa o encontra em
+// O(1) e sua posição vira lápide (O(log n) na árvore de Fenwick). Devolve o elemento e sua
+// sequência; retorna 0 se o paciente não aguarda na fila.
+int desistir_da_fila(Fila *fila, const char *rg, EFila *item, long long *sequencia) {
+    int posicao = buscar_mapa_espera(&fila->mapa, rg);
+    if (posicao < 0) {
+        return 0;
+    }
+    *sequencia = fila->mapa.entradas[posicao].valor;
+    remover_mapa_espera(&fila->mapa, posicao);
+    EFila *elemento = elemento_sequencia(fila, *sequencia);
+    *item = *elemento;
+    elemento->dados = NULL;
+    if (fila->arvoreLapides == NULL) {
+        fila->arvoreLapides = alocar_zerada(MEM_FILA, fila->capacidade + 1, sizeof(int));
+    }
+    somar_lapide(fila, (int)(elemento - fila->itens), 1);
+    descartar_lapides_inicio(fila);
+    registrar_desistencia(&fila->estatisticas);
+    return 1;
+}
+
+// Pacientes à frente do paciente com o RG informado (0 = é o próximo), ou -1 se ele não
+// aguarda na fila; em 'paciente' devolve o paciente encontrado. A sequência dá a distância até
+// o início; a árvore de Fenwick desconta as lápides do caminho, consultando no máximo dois
+// trechos do anel (O(log n)).
+int posicao_na_fila(const Fila *fila, const char *rg, Registro **paciente) {
+    int posicao = buscar_mapa_espera(&fila->mapa, rg);
+    if (posicao < 0) {
+        return -1;
+    }
+    long long sequencia = fila->mapa.entradas[posicao].valor;
+    *paciente = elemento_sequencia(fila, sequencia)->dados;
+    int distancia = (int)(sequencia - fila->primeiraSequencia);
+    if (fila->lapides == 0) {
+        return distancia;
+    }
+    int fim = fila->inicio + distancia;
+    int lapides;
+    if (fim <= fila->capacidade) {
+        lapides = lapides_antes(fila, fim) - lapides_antes(fila, fila->inicio);
+    } else {
+        lapides = lapides_antes(fila, fila->capacidade) - lapides_antes(fila, fila->inicio)
+                + lapides_antes(fila, fim - fila->capacidade);
+    }
+    return distancia - lapides;
+}
+
+// Coloca no fim da fila uma cópia do paciente com o nome informado e registra a operação na
+// pilha. Retorna OPERACAO_NAO_ENCONTRADO se o paciente não está cadastrado e OPERACAO_DUPLICADA
+// se ele já aguarda na fila; em 'enfileirado' devolve a cópia enfileirada.
+int enfileirar_registro(Lista *lista, Fila *fila, Stack *pilhaOperacoes, const char *nome, Registro **enfileirado) {
+    // Verifica se o paciente existe na lista de cadastrados
+    ELista *pacienteEncontrado = consultar_paciente_nome(lista, nome);
+    if (pacienteEncontrado == NULL) {
+        return OPERACAO_NAO_ENCONTRADO;
+    }
+    if (buscar_mapa_espera(&fila->mapa, pacienteEncontrado->dados->rg) >= 0) {
+        return OPERACAO_DUPLICADA;
+    }
+    // A fila guarda uma cópia própria, independente do cadastro
+    Registro *copiaRegistro = copiar_registro(MEM_FILA, pacienteEncontrado->dados);
+    inserir_na_fila(fila, copiaRegistro);
+    // Registra a operação de enfileiramento na pilha de operações para possibilidade de desfazer
+    push(pilhaOperacoes, 'E', copiaRegistro);
+    *enfileirado = copiaRegistro;
+    return OPERACAO_OK;
+}
+
+// Adiciona (enfileira) um paciente cadastrado na fila de atendimento comum
+void enfileirar_paciente(Sessao *sessao) {
+    Operacao op = {.tipo = OP_ENFILEIRAR};
+    printf("\nDigite o NOME do paciente que deseja adicionar a fila: ");
+    fgets(op.texto, sizeof(op.texto), stdin);
+    op.texto[strcspn(op.texto, "\n")] = '\0';
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.status == OPERACAO_RECUSADA) {
+        printf("\nERRO!\nOrçamento de memória esgotado (veja Ferramentas > Memória).\n");
+    } else if (resultado.status == OPERACAO_DUPLICADA) {
+        printf("\nERRO!\nEsse paciente já está na fila de atendimento.\n");
+    } else if (resultado.paciente == NULL) {
+        printf("\nERRO!\nNão existe paciente com esse NOME cadastrado.\n");
+    } else {
+        printf("\nSUCESSO!\nPaciente %s adicionado à fila de atendimento.\n", resultado.paciente->nome);
+    }
+    limpar_console_dinamico();
+}
+
+// Retira o primeiro paciente da fila comum, contabiliza a espera e registra a operação na
+// pilha. Retorna o paciente atendido ou NULL se a fila está vazia.
+Registro* desenfileirar_registro(Fila *fila, Stack *pilhaOperacoes) {
+    long long sequencia = fila->primeiraSequencia;
+    long long enfileiradoEm, esperaMs;
+    Registro *atendido = retirar_da_fila(fila, &enfileiradoEm, &esperaMs);
+    if (atendido == NULL) {
+        return NULL;
+    }
+    // Registra a operação de desenfileiramento na pilha, que passa a ser dona do paciente
+    // atendido (mantido para um eventual desfazer)
+    transferir_memoria(MEM_FILA, MEM_PILHA, sizeof(Registro), 1);
+    push(pilhaOperacoes, 'D', atendido);
+    pilhaOperacoes->top->enfileiradoEm = enfileiradoEm;
+    pilhaOperacoes->top->sequencia = sequencia;
+    pilhaOperacoes->top->esperaMs = esperaMs;
+    return atendido;
+}
+
+// Remove (desenfileira) o primeiro paciente da fila de atendimento comum e o atende
+void desenfileirar_paciente(Sessao *sessao) {
+    Operacao op = {.tipo = OP_DESENFILEIRAR};
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.paciente == NULL) {
+        printf("\nERRO!\nNão há pacientes na fila de atendimento.\n");
+    } else {
+        printf("\nSUCESSO!\nPaciente %s atendido\n", resultado.paciente->nome);
+    }
+    limpar_console_dinamico();
+}
+
+// Retira da fila comum o paciente com o RG informado e registra a desistência na pilha, que
+// passa a ser dona do paciente. Retorna o paciente ou NULL se ele não aguarda na fila.
+Registro* desistir_registro(Fila *fila, Stack *pilhaOperacoes, const char *rg) {
+    EFila item;
+    long long sequencia;
+    if (!desistir_da_fila(fila, rg, &item, &sequencia)) {
+        return NULL;
+    }
+    transferir_memoria(MEM_FILA, MEM_PILHA, sizeof(Registro), 1);
+    push(pilhaOperacoes, 'C', item.dados);
+    pilhaOperacoes->top->enfileiradoEm = item.enfileiradoEm;
+    pilhaOperacoes->top->sequencia = sequencia;
+    return item.dados;
+}
+
+// Retira da fila comum um paciente que desistiu do atendimento
+void desistir_paciente(Sessao *sessao) {
+    Operacao op = {.tipo = OP_DESISTIR};
+    printf("\nDigite o RG do paciente que deixou a fila: ");
+    fgets(op.texto, sizeof(op.texto), stdin);
+    op.texto[strcspn(op.texto, "\n")] = '\0';
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.paciente == NULL) {
+        printf("\nERRO!\nNão há paciente com esse RG na fila de atendimento.\n");
+    } else {
+        printf("\nSUCESSO!\nPaciente %s retirado da fila de atendimento.\n", resultado.paciente->nome);
+    }
+    limpar_console_dinamico();
+}
+
+// Informa quantos pacientes estão à frente de um paciente da fila comum
+void consultar_posicao_fila(Sessao *sessao) {
+    Operacao op = {.tipo = OP_POSICAO_FILA};
+    printf("\nDigite o RG do paciente: ");
+    fgets(op.texto, sizeof(op.texto), stdin);
+    op.texto[strcspn(op.texto, "\n")] = '\0';
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.status != OPERACAO_OK) {
+        printf("\nERRO!\nNão há paciente com esse RG na fila de atendimento.\n");
+    } else if (resultado.posicao == 0) {
+        printf("\n%s é o próximo a ser atendido.\n", resultado.paciente->nome);
+    } else {
+        printf("\n%s é o %dº da fila: %d paciente(s) à frente.\n", resultado.paciente->nome,
+               resultado.posicao + 1, resultado.posicao);
+    }
+    limpar_console_dinamico();
+}
+
+// Exibe todos os pacientes atualmente na fila de atendimento comum, na ordem de chegada
+void mostrar_fila(const Fila *fila) {
+    if (pacientes_na_fila(fila) == 0) {
+        limpar_console();
+        printf("\nERRO!\nA fila de atendimento está vazia.\n");
+        limpar_console_dinamico();
+        return;
+    }
+    limpar_console();
+    printf("Pacientes na fila de atendimento:\n");
+    // Percorre o anel do primeiro ao último imprimindo os pacientes em sequência (sem as lápides)
+    char data[TAMANHO_DATA_TEXTO];
+    int ordem = 0;
+    for (int i = 0; i < fila->qtde; i++) {
+        const Registro *paciente = elemento_fila(fila, i)->dados;
+        if (paciente == NULL) {
+            continue;
+        }
+        printf("%d. Nome: %s; Idade: %d; RG: %s; Entrada: %s\n",
+               ++ordem, paciente->nome, paciente->idade, paciente->rg, escrever_data_texto(paciente->entrada, data));
+    }
+}
+
+// Operações da fila encadeada de referência (um nó alocado por inserção, como a fila original)
+void encadeada_inserir_fim(FilaEncadeada *fila, EFila item) {
+    ENoFilaEncadeada *no = malloc(sizeof(ENoFilaEncadeada));
+    no->item = item;
+    no->proximo = NULL;
+    no->anterior = fila->tail;
+    if (fila->tail != NULL) {
+        fila->tail->proximo = no;
+    } else {
+        fila->head = no;
+    }
+    fila->tail = no;
+    fila->qtde++;
+}
+
+void encadeada_inserir_inicio(FilaEncadeada *fila, EFila item) {
+    ENoFilaEncadeada *no = malloc(sizeof(ENoFilaEncadeada));
+    no->item = item;
+    no->anterior = NULL;
+    no->proximo = fila->head;
+    if (fila->head != NULL) {
+        fila->head->anterior = no;
+    } else {
+        fila->tail = no;
+    }
+    fila->head = no;
+    fila->qtde++;
+}
+
+int encadeada_retirar_inicio(FilaEncadeada *fila, EFila *item) {
+    ENoFilaEncadeada *no = fila->head;
+    if (no == NULL) {
+        return 0;
+    }
+    *item = no->item;
+    fila->head = no->proximo;
+    if (fila->head != NULL) {
+        fila->head->anterior = NULL;
+    } else {
+        fila->tail = NULL;
+    }
+    free(no);
+    fila->qtde--;
+    return 1;
+}
+
+// Compara a fila em anel com a encadeada em três cargas: encher e esvaziar n pacientes,
+// regime estável (atende e enfileira, com 1 em 8 atendimentos desfeitos) e percurso
+// completo da fila, como em mostrar_fila. Os tempos são em ns por operação.
+void comparar_desempenho_fila(int n, int repeticoes) {
+    Registro paciente = {"Paciente", 40, "1", cria_data(1, 1, 2024)};
+    EFila item = {&paciente, 0};
+    double tempos[2][3];
+    long long verificacao[2] = {0, 0};
+    for (int tipo = 0; tipo < 2; tipo++) {
+        Fila *anel = tipo == 0 ? inicializa_fila() : NULL;
+        FilaEncadeada encadeada = {NULL, NULL, 0};
+        // Carga 1: encher e esvaziar
+        long long inicio = instante_nanossegundos();
+        for (int r = 0; r < repeticoes; r++) {
+            for (int i = 0; i < n; i++) {
+                item.enfileiradoEm = i;
+                if (anel != NULL) fila_inserir_fim(anel, item);
+                else encadeada_inserir_fim(&encadeada, item);
+            }
+            EFila retirado;
+            while (anel != NULL ? fila_retirar_inicio(anel, &retirado) : encadeada_retirar_inicio(&encadeada, &retirado)) {
+                verificacao[tipo] += retirado.enfileiradoEm;
+            }
+        }
+        tempos[tipo][0] = (double)(instante_nanossegundos() - inicio) / (2.0 * n * repeticoes);
+        // Carga 2: regime estável com n pacientes aguardando
+        for (int i = 0; i < n; i++) {
+            item.enfileiradoEm = i;
+            if (anel != NULL) fila_inserir_fim(anel, item);
+            else encadeada_inserir_fim(&encadeada, item);
+        }
+        long operacoes = 0;
+        inicio = instante_nanossegundos();
+        for (int r = 0; r < repeticoes; r++) {
+            for (int i = 0; i < n; i++) {
+                EFila retirado;
+                if (anel != NULL) fila_retirar_inicio(anel, &retirado);
+                else encadeada_retirar_inicio(&encadeada, &retirado);
+                if ((i & 7) == 7) {
+                    // Desfazer: o atendido volta para a frente antes do próximo atendimento
+                    if (anel != NULL) fila_inserir_inicio(anel, retirado);
+                    else encadeada_inserir_inicio(&encadeada, retirado);
+                    if (anel != NULL) fila_retirar_inicio(anel, &retirado);
+                    else encadeada_retirar_inicio(&encadeada, &retirado);
+                    operacoes += 2;
+                }
+                if (anel != NULL) fila_inserir_fim(anel, retirado);
+                else encadeada_inserir_fim(&encadeada, retirado);
+                verificacao[tipo] += retirado.enfileiradoEm;
+                operacoes += 2;
+            }
+        }
+        tempos[tipo][1] = (double)(instante_nanossegundos() - inicio) / (double)operacoes;
+        // Carga 3: percurso completo
+        inicio = instante_nanossegundos();
+        for (int r = 0; r < repeticoes; r++) {
+            if (anel != NULL) {
+                for (int i = 0; i < anel->qtde; i++) {
+                    verificacao[tipo] += elemento_fila(anel, i)->enfileiradoEm;
+                }
+            } else {
+                for (ENoFilaEncadeada *no = encadeada.head; no != NULL; no = no->proximo) {
+                    verificacao[tipo] += no->item.enfileiradoEm;
+                }
+            }
+        }
+        tempos[tipo][2] = (double)(instante_nanossegundos() - inicio) / ((double)n * repeticoes);
+        if (anel != NULL) {
+            liberar_fila(anel);
+        } else {
+            EFila retirado;
+            while (encadeada_retirar_inicio(&encadeada, &retirado)) {
+            }
+        }
+    }
+    const char *cargas[3] = {"Encher e esvaziar", "Regime estável", "Percurso (mostrar)"};
+    printf("\nFila com %d pacientes, %d repetições (ns por operação)\n", n, repeticoes);
+    printf("%-20s %10s %10s %8s\n", "Carga", "Encadeada", "Anel", "Ganho");
+    for (int c = 0; c < 3; c++) {
+        printf("%-20s %10.2f %10.2f %7.1fx\n", cargas[c], tempos[1][c], tempos[0][c],
+               tempos[0][c] > 0 ? tempos[1][c] / tempos[0][c] : 0.0);
+    }
+    if (verificacao[0] != verificacao[1]) {
+        printf("\nATENÇÃO: as duas filas divergiram na ordem dos elementos.\n");
+    }
+}
+
+// Opção de menu: comparativo de desempenho da fila comum
+void menu_desempenho_fila() {
+    int n, repeticoes;
+    limpar_console();
+    printf("\nPacientes na fila (ex.: 100000): ");
+    scanf("%d", &n);
+    printf("Repetições (ex.: 20): ");
+    scanf("%d", &repeticoes);
+    getchar();
+    if (n < 1 || repeticoes < 1) {
+        printf("\nERRO!\nValores inválidos.\n");
+    } else {
+        comparar_desempenho_fila(n, repeticoes);
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Atendimento Prioritário (Heap) ** 
+
+// Calcula o índice do filho esquerdo no heap, dado o índice do pai
+int filho_esquerda(int indicePai) {
+    return 2 * indicePai + 1;
+}
+
+// Calcula o índice do filho direito no heap, dado o índice do pai
+int filho_direita(int indicePai) {
+    return 2 * indicePai + 2;
+}
+
+// Calcula o índice do pai no heap, dado o índice de um filho
+int pai(int indiceFilho) {
+    return (indiceFilho - 1) / 2;
+}
+
+// Critério padrão: idade continua pesando mais, mas cada 10 minutos de espera equivalem a 1 ano de idade
+CriterioPrioridade criterio_padrao() {
+    CriterioPrioridade criterio;
+    criterio.pesoIdade = 10;
+    criterio.pesoEspera = 10;
+    criterio.pesoTriagem = 100;
+    criterio.segundosPorFaixa = 600;
+    criterio.maxFaixas = 36;  // envelhecimento limitado a 6 horas de espera
+    return criterio;
+}
+
+// Retorna a faixa de tempo global correspondente a um instante (ms)
+long faixa_de_tempo(const CriterioPrioridade *criterio, long long instante) {
+    return (long)(instante / (1000LL * criterio->segundosPorFaixa));
+}
+
+// Calcula a chave de prioridade a partir das faixas de espera já completadas
+long calcular_chave(const CriterioPrioridade *criterio, const ChavePrioridade *prioridade) {
+    return (long)criterio->pesoIdade * prioridade->idade
+         + (long)criterio->pesoEspera * prioridade->faixas
+         + (long)criterio->pesoTriagem * prioridade->triagem;
+}
+
+// Preenche a chave de quem entra agora na fila prioritária (triagem limitada a 0..MAX_TRIAGEM)
+void iniciar_prioridade(ChavePrioridade *prioridade, const CriterioPrioridade *criterio, int idade,
+                        int triagem, long long agora, long faixaAtual) {
+    prioridade->enfileiradoEm = agora;
+    prioridade->faixaEntrada = faixaAtual;
+    prioridade->faixas = 0;
+    prioridade->triagem = triagem < 0 ? 0 : (triagem > MAX_TRIAGEM ? MAX_TRIAGEM : triagem);
+    prioridade->idade = idade;
+    prioridade->chave = calcular_chave(criterio, prioridade);
+}
+
+// Indica se a deve ser atendido antes de b (empate: quem chegou primeiro)
+int tem_prioridade(const ChavePrioridade *a, const ChavePrioridade *b) {
+    if (a->chave != b->chave) {
+        return a->chave > b->chave;
+    }
+    return a->enfileiradoEm < b->enfileiradoEm;
+}
+
+// Chave do elemento de índice i do vetor
+ChavePrioridade* prioridade_no_vetor(const VetorPrioridade *vetor, int i) {
+    return (ChavePrioridade *)((char *)vetor->elementos + (size_t)i * vetor->tamanho);
+}
+
+// Troca dois elementos de posição no vetor e avisa o dono dos novos índices
+void trocar_no_vetor(const VetorPrioridade *vetor, int i, int j) {
+    unsigned char temp[64];
+    char *a = (char *)prioridade_no_vetor(vetor, i);
+    char *b = (char *)prioridade_no_vetor(vetor, j);
+    for (size_t feito = 0; feito < vetor->tamanho; feito += sizeof(temp)) {
+        size_t parte = vetor->tamanho - feito < sizeof(temp) ? vetor->tamanho - feito : sizeof(temp);
+        memcpy(temp, a + feito, parte);
+        memcpy(a + feito, b + feito, parte);
+        memcpy(b + feito, temp, parte);
+    }
+    if (vetor->posicionar != NULL) {
+        vetor->posicionar(vetor->dono, i);
+        vetor->posicionar(vetor->dono, j);
+    }
+}
+
+// Desce um elemento até que nenhum filho tenha prioridade sobre ele (O(log n))
+void peneirar_vetor(const VetorPrioridade *vetor, int indice) {
+    for (;;) {
+        int maior = indice;
+        int esquerda = filho_esquerda(indice);
+        int direita = filho_direita(indice);
+        if (esquerda < vetor->qtde && tem_prioridade(prioridade_no_vetor(vetor, esquerda), prioridade_no_vetor(vetor, maior))) {
+            maior = esquerda;
+        }
+        if (direita < vetor->qtde && tem_prioridade(prioridade_no_vetor(vetor, direita), prioridade_no_vetor(vetor, maior))) {
+            maior = direita;
+        }
+        if (maior == indice) {
+            return;
+        }
+        trocar_no_vetor(vetor, indice, maior);
+        indice = maior;
+    }
+}
+
+// Sobe um elemento em direção à raiz enquanto ele tiver prioridade sobre o pai (O(log n))
+void subir_vetor(const VetorPrioridade *vetor, int indice) {
+    while (indice > 0 && tem_prioridade(prioridade_no_vetor(vetor, indice), prioridade_no_vetor(vetor, pai(indice)))) {
+        trocar_no_vetor(vetor, indice, pai(indice));
+        indice = pai(indice);
+    }
+}
+
+// Passo de reequilíbrio por faixas de tempo: só roda quando uma nova faixa começa
+// (*faixaAtual é avançada). Como as chaves apenas aumentam com a espera, basta subir os
+// elementos alterados em ordem de índice, sem reconstruir o heap inteiro.
+void envelhecer_vetor(const VetorPrioridade *vetor, const CriterioPrioridade *criterio, long *faixaAtual, long long agora) {
+    long faixa = faixa_de_tempo(criterio, agora);
+    if (faixa <= *faixaAtual) {
+        return;  // ainda na mesma faixa: nenhuma chave mudou
+    }
+    *faixaAtual = faixa;
+    for (int i = 0; i < vetor->qtde; i++) {
+        ChavePrioridade *prioridade = prioridade_no_vetor(vetor, i);
+        long faixas = faixa - prioridade->faixaEntrada;
+        if (faixas > criterio->maxFaixas) {
+            faixas = criterio->maxFaixas;
+        }
+        if (faixas != prioridade->faixas) {
+            prioridade->faixas = (int)faixas;
+            prioridade->chave = calcular_chave(criterio, prioridade);
+            subir_vetor(vetor, i);
+        }
+    }
+}
+
+// Atualiza no mapa de espera o índice do elemento que passou a ocupar a posição i
+void posicionar_no_mapa_heap(void *dono, int i) {
+    Heap *heap = dono;
+    heap->mapa.entradas[heap->dados[i].entradaMapa].valor = i;
+}
+
+// Vetor com os elementos do heap; com o mapa ativo, as trocas atualizam os índices no mapa
+VetorPrioridade vetor_do_heap(Heap *heap) {
+    VetorPrioridade vetor = {heap->dados, sizeof(EHeap), heap->qtde,
+                             heap->mapa.capacidade > 0 ? posicionar_no_mapa_heap : NULL, heap};
+    return vetor;
+}
+
+// Move o último elemento para a posição i, que ficou vaga
+void ocupar_vaga_heap(Heap *heap, int i) {
+    heap->qtde--;
+    if (i == heap->qtde) {
+        return;
+    }
+    heap->dados[i] = heap->dados[heap->qtde];
+    if (heap->mapa.capacidade > 0) {
+        posicionar_no_mapa_heap(heap, i);
+    }
+}
+
+// Função auxiliar para manter a propriedade do heap (reorganiza a partir de um índice pai)
+void peneirar(Heap *heap, int indicePai) {
+    VetorPrioridade vetor = vetor_do_heap(heap);
+    peneirar_vetor(&vetor, indicePai);
+}
+
+// Sobe um elemento em direção à raiz enquanto ele tiver prioridade sobre o pai (O(log n))
+void subir(Heap *heap, int indice) {
+    VetorPrioridade vetor = vetor_do_heap(heap);
+    subir_vetor(&vetor, indice);
+}
+
+// (Re)constrói o heap a partir dos dados atuais, garantindo a propriedade de max-heap
+void construir(Heap *heap) {
+    VetorPrioridade vetor = vetor_do_heap(heap);
+    // Ajusta a partir dos nós internos (metade inicial do array)
+    for (int i = (heap->qtde / 2) - 1; i >= 0; i--) {
+        peneirar_vetor(&vetor, i);
+    }
+}
+
+// Aplica ao heap o envelhecimento por faixas de tempo
+void atualizar_envelhecimento(Heap *heap, long long agora) {
+    VetorPrioridade vetor = vetor_do_heap(heap);
+    envelhecer_vetor(&vetor, &heap->criterio, &heap->faixaAtual, agora);
+}
+
+// Troca o critério de prioridade, recalculando as chaves e reconstruindo o heap uma única vez.
+// Pesos negativos são recusados (retorna 0): o envelhecimento só sobe elementos no heap e
+// conta com chaves que nunca diminuem com a espera.
+int definir_criterio_heap(Heap *heap, CriterioPrioridade criterio) {
+    if (criterio.pesoIdade < 0 || criterio.pesoEspera < 0 || criterio.pesoTriagem < 0) {
+        return 0;
+    }
+    if (criterio.segundosPorFaixa <= 0) {
+        criterio.segundosPorFaixa = 1;
+    }
+    if (criterio.maxFaixas < 0) {
+        criterio.maxFaixas = 0;
+    }
+    heap->criterio = criterio;
+    long faixa = faixa_de_tempo(&criterio, instante_atual());
+    heap->faixaAtual = faixa;
+    for (int i = 0; i < heap->qtde; i++) {
+        ChavePrioridade *prioridade = &heap->dados[i].prioridade;
+        prioridade->faixaEntrada = faixa_de_tempo(&criterio, prioridade->enfileiradoEm);
+        long faixas = faixa - prioridade->faixaEntrada;
+        prioridade->faixas = (int)(faixas > criterio.maxFaixas ? criterio.maxFaixas : faixas);
+        prioridade->chave = calcular_chave(&criterio, prioridade);
+    }
+    construir(heap);
+    return 1;
+}
+
+// Inicializa a estrutura de heap (fila prioritária) vazia
+void inicializar_heap(Heap *heap) {
+    heap->qtde = 0;
+    heap->capacidade = MAX_HEAP;
+    heap->limite = MAX_HEAP;
+    heap->dados = alocar_memoria(MEM_HEAP, heap->capacidade * sizeof(EHeap));
+    for (int i = 0; i < heap->capacidade; i++) {
+        heap->dados[i].paciente = NULL;
+    }
+    heap->criterio = criterio_padrao();
+    heap->faixaAtual = faixa_de_tempo(&heap->criterio, instante_atual());
+    heap->mapa.entradas = NULL;
+    heap->mapa.capacidade = 0;
+    memset(&heap->estatisticas, 0, sizeof(EstatisticasEspera));
+}
+
+// Libera o array do heap (os pacientes são liberados por quem os inseriu)
+void liberar_heap(Heap *heap) {
+    if (heap->mapa.capacidade > 0) {
+        liberar_mapa_espera(&heap->mapa);
+    }
+    liberar_memoria(MEM_HEAP, heap->dados, heap->capacidade * sizeof(EHeap));
+    heap->dados = NULL;
+    heap->qtde = 0;
+    heap->capacidade = 0;
+}
+
+// Libera uma fila prioritária alocada por criar_sessao, com as cópias dos pacientes
+void destruir_heap(Heap *heap) {
+    for (int i = 0; i < heap->qtde; i++) {
+        destruir_registro(MEM_HEAP, heap->dados[i].paciente);
+    }
+    liberar_heap(heap);
+    liberar_memoria(MEM_HEAP, heap, sizeof(Heap));
+}
+
+// Paciente de um índice do heap, consultado pelo mapa de espera para conferir o RG
+const Registro* registro_no_heap(const void *heap, long long indice) {
+    return ((const Heap *)heap)->dados[indice].paciente;
+}
+
+// Ativa o mapa RG -> índice, que permite desistências e consultas de posição por paciente
+void ativar_mapa_heap(Heap *heap) {
+    inicializar_mapa_espera(&heap->mapa, MEM_HEAP, heap, registro_no_heap);
+}
+
+// Registra no mapa o paciente do índice informado. Se o mapa crescer, as posições de todos
+// os pacientes no mapa mudam e são atualizadas.
+void mapear_paciente_heap(Heap *heap, int indice) {
+    if (heap->mapa.capacidade == 0) {
+        return;
+    }
+    int redimensionado;
+    heap->dados[indice].entradaMapa = inserir_mapa_espera(&heap->mapa, heap->dados[indice].paciente, indice, &redimensionado);
+    if (redimensionado) {
+        for (int i = 0; i < heap->mapa.capacidade; i++) {
+            if (heap->mapa.entradas[i].valor >= 0) {
+                heap->dados[heap->mapa.entradas[i].valor].entradaMapa = i;
+            }
+        }
+    }
+}
+
+// Insere um paciente na fila prioritária (heap). A chave combina idade, espera e triagem
+// e é calculada uma única vez na entrada; o envelhecimento é aplicado por faixas de tempo.
+// Retorna 0 se a fila prioritária atingiu seu limite. 'agora' é o instante da entrada (ms).
+int inserir_heap_em(Heap *heap, Registro *paciente, int triagem, long long agora) {
+    if (heap->limite > 0 && heap->qtde >= heap->limite) {
+        return 0;  // fila prioritária cheia
+    }
+    if (heap->qtde == heap->capacidade) {
+        heap->dados = realocar_memoria(MEM_HEAP, heap->dados, heap->capacidade * sizeof(EHeap),
+                                       2 * heap->capacidade * sizeof(EHeap));
+        heap->capacidade *= 2;
+    }
+    atualizar_envelhecimento(heap, agora);
+    // Insere o novo paciente no final do array e o sobe até sua posição
+    EHeap *novo = &heap->dados[heap->qtde];
+    novo->paciente = paciente;
+    iniciar_prioridade(&novo->prioridade, &heap->criterio, paciente->idade, triagem, agora, heap->faixaAtual);
+    novo->entradaMapa = -1;
+    heap->qtde++;
+    mapear_paciente_heap(heap, heap->qtde - 1);
+    subir(heap, heap->qtde - 1);
+    registrar_entrada(&heap->estatisticas);
+    return 1;
+}
+
+int inserir_heap(Heap *heap, Registro *paciente, int triagem) {
+    return inserir_heap_em(heap, paciente, triagem, instante_atual());
+}
+
+// Remove do heap o paciente de maior prioridade, copiando-o para 'atendido', e contabiliza
+// sua espera até 'agora' (ms). Retorna 0 se a fila prioritária está vazia.
+int remover_heap_em(Heap *heap, EHeap *atendido, long long agora) {
+    if (heap->qtde == 0) {
+        return 0;
+    }
+    atualizar_envelhecimento(heap, agora);
+
+    // O paciente de maior prioridade está no topo do heap
+    *atendido = heap->dados[0];
+    registrar_atendimento(&heap->estatisticas, agora - atendido->prioridade.enfileiradoEm);
+    if (heap->mapa.capacidade > 0) {
+        remover_mapa_espera(&heap->mapa, atendido->entradaMapa);
+    }
+
+    // Substitui a raiz pelo último elemento e reduz a quantidade
+    ocupar_vaga_heap(heap, 0);
+
+    // Desce a nova raiz até sua posição (O(log n))
+    peneirar(heap, 0);
+    return 1;
+}
+
+int remover_heap(Heap *heap, EHeap *atendido) {
+    return remover_heap_em(heap, atendido, instante_atual());
+}
+
+// Retira da fila prioritária o paciente com o RG informado, em qualquer posição: o mapa dá seu
+// índice em O(1) e o último elemento ocupa a vaga, subindo ou descendo (O(log n)). Devolve o
+// elemento em 'desistente'; retorna 0 se o paciente não aguarda na fila prioritária.
+int desistir_do_heap(Heap *heap, const char *rg, EHeap *desistente) {
+    int posicao = buscar_mapa_espera(&heap->mapa, rg);
+    if (posicao < 0) {
+        return 0;
+    }
+    int indice = (int)heap->mapa.entradas[posicao].valor;
+    *desistente = heap->dados[indice];
+    remover_mapa_espera(&heap->mapa, posicao);
+    ocupar_vaga_heap(heap, indice);
+    if (indice < heap->qtde) {
+        subir(heap, indice);
+        peneirar(heap, indice);
+    }
+    registrar_desistencia(&heap->estatisticas);
+    return 1;
+}
+
+// Conta os elementos da subárvore com prioridade sobre o alvo. Uma subárvore cuja raiz não
+// tem prioridade é descartada inteira, pois nenhum descendente passa à frente do pai.
+int contar_a_frente(const Heap *heap, int raiz, const EHeap *alvo) {
+    if (raiz >= heap->qtde || !tem_prioridade(&heap->dados[raiz].prioridade, &alvo->prioridade)) {
+        return 0;
+    }
+    return 1 + contar_a_frente(heap, filho_esquerda(raiz), alvo) + contar_a_frente(heap, filho_direita(raiz), alvo);
+}
+
+// Pacientes que seriam atendidos antes do paciente com o RG informado (0 = é o próximo), ou
+// -1 se ele não aguarda na fila prioritária; em 'paciente' devolve o paciente encontrado.
+// Visita só os pacientes à frente e seus filhos.
+int posicao_no_heap(Heap *heap, const char *rg, Registro **paciente) {
+    atualizar_envelhecimento(heap, instante_atual());
+    int posicao = buscar_mapa_espera(&heap->mapa, rg);
+    if (posicao < 0) {
+        return -1;
+    }
+    const EHeap *alvo = &heap->dados[heap->mapa.entradas[posicao].valor];
+    *paciente = alvo->paciente;
+    return contar_a_frente(heap, 0, alvo);
+}
+
+// Insere um paciente cadastrado na fila prioritária com o nível de triagem informado
+void inserir_paciente_prioritario(Sessao *sessao) {
+    Operacao op = {.tipo = OP_INSERIR_PRIORITARIO};
+    printf("\nNome do paciente para prioridade: ");
+    fgets(op.texto, sizeof(op.texto), stdin);
+    op.texto[strcspn(op.texto, "\n")] = '\0';
+    if (consultar_paciente_nome(sessao->lista, op.texto) == NULL) {
+        limpar_console();
+        printf("\nERRO!\nPaciente não encontrado no cadastro.\n");
+        limpar_console_dinamico();
+        return;
+    }
+    printf("Nível de triagem (0 a %d): ", MAX_TRIAGEM);
+    scanf("%d", &op.valores[0]);
+    getchar();
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.status == OPERACAO_OK) {
+        printf("\nPaciente %s inserido na fila prioritária.\n", resultado.paciente->nome);
+    } else if (resultado.status == OPERACAO_DUPLICADA) {
+        printf("\nERRO!\nEsse paciente já está na fila prioritária.\n");
+    } else {
+        printf("\nFila prioritária cheia ou orçamento de memória esgotado.\n");
+    }
+    limpar_console_dinamico();
+}
+
+// Atende o paciente de maior prioridade e mostra seus dados
+void atender_paciente_prioritario(Sessao *sessao) {
+    Operacao op = {.tipo = OP_ATENDER_PRIORITARIO};
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.status != OPERACAO_OK) {
+        printf("\nERRO!\nNão há pacientes na fila prioritária.\n");
+        limpar_console_dinamico();
+        return;
+    }
+    long long espera = instante_atual() - resultado.atendido.prioridade.enfileiradoEm;
+    printf("Paciente prioritário atendido: %s (Idade: %d; Triagem: %d; Espera: %lld min)\n",
+           resultado.atendido.paciente->nome, resultado.atendido.paciente->idade, resultado.atendido.prioridade.triagem,
+           espera / 60000);
+    limpar_console_dinamico();
+}
+
+// Retira da fila prioritária um paciente que desistiu do atendimento
+void desistir_paciente_prioritario(Sessao *sessao) {
+    Operacao op = {.tipo = OP_DESISTIR_PRIORITARIO};
+    printf("\nDigite o RG do paciente que deixou a fila prioritária: ");
+    fgets(op.texto, sizeof(op.texto), stdin);
+    op.texto[strcspn(op.texto, "\n")] = '\0';
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.status != OPERACAO_OK) {
+        printf("\nERRO!\nNão há paciente com esse RG na fila prioritária.\n");
+    } else {
+        printf("\nSUCESSO!\nPaciente %s retirado da fila prioritária.\n", resultado.paciente->nome);
+    }
+    limpar_console_dinamico();
+}
+
+// Informa quantos pacientes seriam atendidos antes de um paciente da fila prioritária
+void consultar_posicao_prioritaria(Sessao *sessao) {
+    Operacao op = {.tipo = OP_POSICAO_PRIORITARIO};
+    printf("\nDigite o RG do paciente: ");
+    fgets(op.texto, sizeof(op.texto), stdin);
+    op.texto[strcspn(op.texto, "\n")] = '\0';
+    ResultadoOperacao resultado;
+    executar_operacao(sessao, &op, &resultado);
+    limpar_console();
+    if (resultado.status != OPERACAO_OK) {
+        printf("\nERRO!\nNão há paciente com esse RG na fila prioritária.\n");
+    } else if (resultado.posicao == 0) {
+        printf("\n%s é o próximo a ser atendido.\n", resultado.paciente->nome);
+    } else {
+        printf("\n%s é o %dº da fila prioritária: %d paciente(s) à frente, com a pontuação atual.\n",
+               resultado.paciente->nome, resultado.posicao + 1, resultado.posicao);
+    }
+    limpar_console_dinamico();
+}
+
+// Mostra todos os pacientes presentes na fila de atendimento prioritário (heap)
+void mostrar_heap(Heap *heap) {
+    if (heap->qtde == 0) {
+        limpar_console();
+        printf("\nERRO!\nFila Prioritária Vazia.\n");
+        limpar_console_dinamico();
+        return;
+    }
+    long long agora = instante_atual();
+    atualizar_envelhecimento(heap, agora);
+    limpar_console();
+    printf("\nPacientes na fila prioritária:\n");
+    // Percorre o array do heap mostrando os pacientes em cada posição (não necessariamente em ordem de prioridade)
+    for (int i = 0; i < heap->qtde; i++) {
+        EHeap *e = &heap->dados[i];
+        Registro *p = e->paciente;
+        char data[TAMANHO_DATA_TEXTO];
+        printf("%d. Nome: %s; Idade: %d; RG: %s; Entrada: %s; Triagem: %d; Espera: %lld min; Pontos: %ld\n",
+               i + 1, p->nome, p->idade, p->rg, escrever_data_texto(p->entrada, data),
+               e->prioridade.triagem, (agora - e->prioridade.enfileiradoEm) / 60000, e->prioridade.chave);
+    }
+    limpar_console_dinamico();
+}
+
+// Lê do usuário novos pesos para o critério de prioridade e aplica ao heap
+void configurar_criterio_heap(Sessao *sessao) {
+    CriterioPrioridade novo = sessao->heap->criterio;
+    printf("\nCritério atual: idade x%d; espera x%d a cada %d s (máx. %d faixas); triagem x%d\n",
+           novo.pesoIdade, novo.pesoEspera, novo.segundosPorFaixa, novo.maxFaixas, novo.pesoTriagem);
+    printf("Peso por ano de idade: ");
+    scanf("%d", &novo.pesoIdade);
+    printf("Peso por faixa de espera: ");
+    scanf("%d", &novo.pesoEspera);
+    printf("Duração de cada faixa (segundos): ");
+    scanf("%d", &novo.segundosPorFaixa);
+    printf("Máximo de faixas consideradas: ");
+    scanf("%d", &novo.maxFaixas);
+    printf("Peso por nível de triagem: ");
+    scanf("%d", &novo.pesoTriagem);
+    getchar();
+    Operacao op = {.tipo = OP_CRITERIO,
+                   .valores = {novo.pesoIdade, novo.pesoEspera, novo.pesoTriagem, novo.segundosPorFaixa, novo.maxFaixas}};
+    int status = executar_operacao(sessao, &op, NULL);
+    limpar_console();
+    if (status == OPERACAO_INVALIDA) {
+        printf("\nERRO!\nOs pesos não podem ser negativos; critério mantido.\n");
+    } else {
+        printf("\nSUCESSO!\nCritério de prioridade atualizado.\n");
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Pesquisa de Pacientes (ABB) ** 
+
+// Cria uma nova árvore binária de busca vazia
+ABB* cria_abb() {
+    ABB *novaABB = alocar_memoria(MEM_ABB, sizeof(ABB));
+    if (novaABB != NULL) {
+        novaABB->raiz = NULL;
+        novaABB->qtde = 0;
+    }
+    return novaABB;
+}
+
+// Cria um novo nó (vértice) da ABB a partir de um registro de paciente (a árvore guarda uma cópia)
+EABB* cria_vertice(Registro paciente) {
+    EABB *novoVertice = alocar_memoria(MEM_ABB, sizeof(EABB));
+    if (novoVertice != NULL) {
+        novoVertice->dados = alocar_memoria(MEM_ABB, sizeof(Registro));
+        *(novoVertice->dados) = paciente;
+        novoVertice->filhoEsq = NULL;
+        novoVertice->filhoDir = NULL;
+    }
+    return novoVertice;
+}
+
+// Libera uma subárvore: vértices e suas cópias dos registros
+void destruir_vertices(EABB *raiz) {
+    if (raiz == NULL) {
+        return;
+    }
+    destruir_vertices(raiz->filhoEsq);
+    destruir_vertices(raiz->filhoDir);
+    liberar_memoria(MEM_ABB, raiz->dados, sizeof(Registro));
+    liberar_memoria(MEM_ABB, raiz, sizeof(EABB));
+}
+
+// Libera a árvore inteira, inclusive a estrutura
+void destruir_abb(ABB *arvore) {
+    destruir_vertices(arvore->raiz);
+    liberar_memoria(MEM_ABB, arvore, sizeof(ABB));
+}
+
+// Insere um paciente na ABB de acordo com um critério de comparação fornecido
+void inserir_abb(ABB *arvore, Registro paciente, int (*criterio)(Registro, Registro)) {
+    EABB *novoNo = cria_vertice(paciente);
+    if (arvore->raiz == NULL) {
+        // Insere na raiz se a árvore estiver vazia
+        arvore->raiz = novoNo;
+    } else {
+        // Percorre a árvore até encontrar a posição de inserção adequada
+        EABB *atual = arvore->raiz;
+        EABB *anterior = NULL;
+        while (atual != NULL) {
+            anterior = atual;
+            if (criterio(paciente, *(atual->dados)) <= 0) {
+                atual = atual->filhoEsq;
+            } else {
+                atual = atual->filhoDir;
+            }
+        }
+        // Insere o novo nó como filho esquerdo ou direito do último nó visitado
+        if (criterio(paciente, *(anterior->dados)) <= 0) {
+            anterior->filhoEsq = novoNo;
+        } else {
+            anterior->filhoDir = novoNo;
+        }
+    }
+    arvore->qtde++;
+}
+
+// Realiza o percurso in-order (ordem simétrica) na ABB e imprime os pacientes em ordem crescente de acordo com o critério atual
+void imprimir_in_ordem(EABB *raiz) {
+    if (raiz != NULL) {
+        imprimir_in_ordem(raiz->filhoEsq);
+        char data[TAMANHO_DATA_TEXTO];
+        printf("Nome: %s; Idade: %d; RG: %s; Entrada: %s\n",
+               raiz->dados->nome, raiz->dados->idade, raiz->dados->rg, escrever_data_texto(raiz->dados->entrada, data));
+        imprimir_in_ordem(raiz->filhoDir);
+    }
+}
+
+// Funções de comparação para dois registros de paciente, usadas na ordenação da ABB
+int comparar_por_ano(Registro a, Registro b) {
+    return data_calendario(a.entrada).ano - data_calendario(b.entrada).ano;
+}
+int comparar_por_mes(Registro a, Registro b) {
+    return data_calendario(a.entrada).mes - data_calendario(b.entrada).mes;
+}
+int comparar_por_dia(Registro a, Registro b) {
+    return data_calendario(a.entrada).dia - data_calendario(b.entrada).dia;
+}
+int comparar_por_idade(Registro a, Registro b) {
+    return a.idade - b.idade;
+}
+
+// Painel de contagens: lê apenas os agregados (O(anos x meses + faixas)), sem percorrer registros
+void mostrar_painel_contagens(const Lista *lista) {
+    const Agregados *agregados = &lista->agregados;
+    printf("\nTotal de pacientes cadastrados: %ld\n", total_pacientes(lista));
+    printf("\nPacientes por faixa de idade:\n");
+    for (int faixa = 0; faixa < FAIXAS_IDADE; faixa++) {
+        long qtde = pacientes_na_faixa_idade(lista, faixa);
+        if (qtde == 0) {
+            continue;
+        }
+        if (faixa == FAIXAS_IDADE - 1) {
+            printf("%3d+     : %ld\n", faixa * LARGURA_FAIXA_IDADE, qtde);
+        } else {
+            printf("%3d a %3d: %ld\n", faixa * LARGURA_FAIXA_IDADE, faixa * LARGURA_FAIXA_IDADE + LARGURA_FAIXA_IDADE - 1, qtde);
+        }
+    }
+    printf("\nAdmissões por ano (e por mês: jan a dez):\n");
+    for (int ano = ANO_MINIMO; ano <= ANO_MAXIMO; ano++) {
+        long qtde = admissoes_no_ano(lista, ano);
+        if (qtde == 0) {
+            continue;
+        }
+        printf("%04d: %ld |", ano, qtde);
+        for (int mes = 1; mes <= 12; mes++) {
+            printf(" %ld", admissoes_no_mes(lista, ano, mes));
+        }
+        printf("\n");
+    }
+    if (agregados->foraDoIntervalo > 0) {
+        printf("Entradas com data fora do intervalo %d-%d: %ld\n", ANO_MINIMO, ANO_MAXIMO, agregados->foraDoIntervalo);
+    }
+}
+
+// Intercala as metades ordenadas [inicio, meio) e [meio, fim) do vetor
+void intercalar_registros(Registro **vetor, Registro **auxiliar, int inicio, int meio, int fim,
+                          int (*criterio)(Registro, Registro)) {
+    if (criterio(*vetor[meio - 1], *vetor[meio]) <= 0) {
+        return;  // metades já estão em ordem
+    }
+    int i = inicio, j = meio, k = inicio;
+    while (i < meio && j < fim) {
+        auxiliar[k++] = (criterio(*vetor[i], *vetor[j]) <= 0) ? vetor[i++] : vetor[j++];
+    }
+    while (i < meio) auxiliar[k++] = vetor[i++];
+    while (j < fim) auxiliar[k++] = vetor[j++];
+    memcpy(vetor + inicio, auxiliar + inicio, (size_t)(fim - inicio) * sizeof(Registro *));
+}
+
+// Ordenação por intercalação de um vetor de registros (estável), usada para montar relatórios
+// e índices em lote. Intervalos pequenos são ordenados por inserção.
+void ordenar_intervalo(Registro **vetor, Registro **auxiliar, int inicio, int fim,
+                       int (*criterio)(Registro, Registro)) {
+    if (fim - inicio <= 16) {
+        for (int i = inicio + 1; i < fim; i++) {
+            Registro *atual = vetor[i];
+            int j = i - 1;
+            while (j >= inicio && criterio(*vetor[j], *atual) > 0) {
+                vetor[j + 1] = vetor[j];
+                j--;
+            }
+            vetor[j + 1] = atual;
+        }
+        return;
+    }
+    int meio = inicio + (fim - inicio) / 2;
+    ordenar_intervalo(vetor, auxiliar, inicio, meio, criterio);
+    ordenar_intervalo(vetor, auxiliar, meio, fim, criterio);
+    intercalar_registros(vetor, auxiliar, inicio, meio, fim, criterio);
+}
+
+void* executar_tarefa_ordenacao(void *argumento) {
+    TarefaOrdenacao *tarefa = argumento;
+    if (tarefa->meio > tarefa->inicio) {
+        intercalar_registros(tarefa->vetor, tarefa->auxiliar, tarefa->inicio, tarefa->meio, tarefa->fim, tarefa->criterio);
+    } else {
+        ordenar_intervalo(tarefa->vetor, tarefa->auxiliar, tarefa->inicio, tarefa->fim, tarefa->criterio);
+    }
+    return NULL;
+}
+
+// Número de threads disponíveis para tarefas paralelas (núcleos online, limitado a MAX_THREADS)
+int threads_disponiveis() {
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nucleos < 1) return 1;
+    return nucleos > MAX_THREADS ? MAX_THREADS : (int)nucleos;
+}
+
+// Executa as tarefas em threads (a última roda na thread atual); sem threads, roda tudo em sequência
+void executar_tarefas_ordenacao(TarefaOrdenacao *tarefas, int qtde) {
+    pthread_t threads[MAX_THREADS];
+    int criada[MAX_THREADS] = {0};
+    for (int t = 0; t < qtde - 1; t++) {
+        criada[t] = pthread_create(&threads[t], NULL, executar_tarefa_ordenacao, &tarefas[t]) == 0;
+        if (!criada[t]) {
+            executar_tarefa_ordenacao(&tarefas[t]);
+        }
+    }
+    executar_tarefa_ordenacao(&tarefas[qtde - 1]);
+    for (int t = 0; t < qtde - 1; t++) {
+        if (criada[t]) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+}
+
+// Ordena um vetor de registros pelo critério informado. Vetores grandes são divididos entre
+// os núcleos disponíveis e os trechos ordenados são intercalados em rodadas paralelas.
+void ordenar_registros(Registro **vetor, int n, int (*criterio)(Registro, Registro)) {
+    if (n < 2) {
+        return;
+    }
+    Registro **auxiliar = malloc((size_t)n * sizeof(Registro *));
+    int nThreads = (n >= LIMIAR_ORDENACAO_PARALELA) ? threads_disponiveis() : 1;
+    if (nThreads == 1) {
+        ordenar_intervalo(vetor, auxiliar, 0, n, criterio);
+        free(auxiliar);
+        return;
+    }
+    // Fase 1: cada thread ordena um trecho contíguo
+    int limites[MAX_THREADS + 1];
+    for (int t = 0; t <= nThreads; t++) {
+        limites[t] = (int)((long long)n * t / nThreads);
+    }
+    TarefaOrdenacao tarefas[MAX_THREADS];
+    for (int t = 0; t < nThreads; t++) {
+        tarefas[t] = (TarefaOrdenacao){vetor, auxiliar, limites[t], 0, limites[t + 1], criterio};
+    }
+    executar_tarefas_ordenacao(tarefas, nThreads);
+    // Fase 2: intercala trechos vizinhos, dobrando o tamanho a cada rodada
+    for (int passo = 1; passo < nThreads; passo *= 2) {
+        int qtde = 0;
+        for (int t = 0; t + passo < nThreads; t += 2 * passo) {
+            int fim = limites[(t + 2 * passo < nThreads) ? t + 2 * passo : nThreads];
+            tarefas[qtde++] = (TarefaOrdenacao){vetor, auxiliar, limites[t], limites[t + passo], fim, criterio};
+        }
+        executar_tarefas_ordenacao(tarefas, qtde);
+    }
+    free(auxiliar);
+}
+
+// Monta uma ABB balanceada a partir de um vetor já ordenado, em O(n) (sem comparações)
+EABB* construir_abb_ordenada(Registro **ordenados, int inicio, int fim) {
+    if (inicio > fim) {
+        return NULL;
+    }
+    int meio = inicio + (fim - inicio) / 2;
+    EABB *vertice = cria_vertice(*ordenados[meio]);
+    vertice->filhoEsq = construir_abb_ordenada(ordenados, inicio, meio - 1);
+    vertice->filhoDir = construir_abb_ordenada(ordenados, meio + 1, fim);
+    return vertice;
+}
+
+// Reconstrói a ABB a partir da lista de pacientes usando um critério de comparação especificado.
+// Os registros são reunidos em um vetor, ordenados uma única vez e a árvore é montada já
+// balanceada, evitando o pior caso quadrático de inserções sucessivas em dados ordenados.
+void reconstruir_abb(Lista *lista, ABB *arvore, int (*criterio)(Registro, Registro)) {
+    if (lista->qtde == 0) {
+        return;
+    }
+    // O vetor é preenchido de trás para frente para manter a mesma ordem entre empates
+    // que as inserções sucessivas produziam (último da lista primeiro)
+    Registro **vetor = malloc((size_t)lista->qtde * sizeof(Registro *));
+    int n = 0;
+    for (ELista *noAtual = lista->inicio; noAtual != NULL && n < lista->qtde; noAtual = noAtual->proximo) {
+        vetor[lista->qtde - 1 - n++] = noAtual->dados;
+    }
+    ordenar_registros(vetor, n, criterio);
+    arvore->raiz = construir_abb_ordenada(vetor, 0, n - 1);
+    arvore->qtde = n;
+    free(vetor);
+}
+
+// ** Módulo Relatórios Ordenados ** 
+
+const char *NOMES_ORDENS[QTDE_ORDENS] = {"ano", "mes", "dia", "idade"};
+
+// Valor do campo usado em cada ordem, como chave sem sinal que preserva a ordem dos inteiros.
+// A ordem por ano compara só o ano, como a ABB: dentro do ano vale a ordem de cadastro.
+unsigned int chave_relatorio(const Registro *paciente, int ordem) {
+    int valor;
+    if (ordem == ORDEM_IDADE) {
+        valor = paciente->idade;
+    } else {
+        DataCalendario entrada = data_calendario(paciente->entrada);
+        valor = ordem == ORDEM_ANO ? entrada.ano : (ordem == ORDEM_MES ? entrada.mes : entrada.dia);
+    }
+    return (unsigned int)valor ^ 0x80000000u;
+}
+
+void* executar_histograma_radix(void *argumento) {
+    TarefaRadix *tarefa = argumento;
+    memset(tarefa->contagem, 0, sizeof(tarefa->contagem));
+    for (int i = tarefa->inicio; i < tarefa->fim; i++) {
+        unsigned int chave = (unsigned int)(tarefa->origem[i] >> 32) - tarefa->minimo;
+        tarefa->contagem[(chave >> tarefa->deslocamento) & 0xFF]++;
+    }
+    return NULL;
+}
+
+void* executar_distribuicao_radix(void *argumento) {
+    TarefaRadix *tarefa = argumento;
+    for (int i = tarefa->inicio; i < tarefa->fim; i++) {
+        unsigned int chave = (unsigned int)(tarefa->origem[i] >> 32) - tarefa->minimo;
+        tarefa->destino[tarefa->contagem[(chave >> tarefa->deslocamento) & 0xFF]++] = tarefa->origem[i];
+    }
+    return NULL;
+}
+
+// Executa a mesma fase da ordenação radix em todas as tarefas (a última na thread atual)
+void executar_fase_radix(TarefaRadix *tarefas, int qtde, void *(*fase)(void *)) {
+    pthread_t threads[MAX_THREADS];
+    int criada[MAX_THREADS] = {0};
+    for (int t = 0; t < qtde - 1; t++) {
+        criada[t] = pthread_create(&threads[t], NULL, fase, &tarefas[t]) == 0;
+        if (!criada[t]) {
+            fase(&tarefas[t]);
+        }
+    }
+    fase(&tarefas[qtde - 1]);
+    for (int t = 0; t < qtde - 1; t++) {
+        if (criada[t]) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+}
+
+// Ordenação radix LSD (estável) dos itens pela chave dos 32 bits altos, dígitos de 8 bits.
+// Só são feitas as passadas necessárias para a amplitude das chaves (em geral uma só: ano, mês,
+// dia e idade variam menos de 256). Cada passada divide o vetor entre as threads: histogramas por trecho, posições
+// calculadas trecho a trecho (o que mantém a estabilidade) e distribuição em paralelo.
+void ordenar_radix(unsigned long long *itens, int n, int nThreads) {
+    if (n < 2) {
+        return;
+    }
+    unsigned int minimo = UINT_MAX, maximo = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned int chave = (unsigned int)(itens[i] >> 32);
+        if (chave < minimo) minimo = chave;
+        if (chave > maximo) maximo = chave;
+    }
+    if (n < LIMIAR_ORDENACAO_PARALELA || nThreads < 1) nThreads = 1;
+    if (nThreads > MAX_THREADS) nThreads = MAX_THREADS;
+    unsigned long long *auxiliar = malloc((size_t)n * sizeof(unsigned long long));
+    unsigned long long *origem = itens, *destino = auxiliar;
+    TarefaRadix *tarefas = malloc((size_t)nThreads * sizeof(TarefaRadix));
+    for (int deslocamento = 0; deslocamento < 32 && ((maximo - minimo) >> deslocamento) != 0; deslocamento += 8) {
+        for (int t = 0; t < nThreads; t++) {
+            tarefas[t].origem = origem;
+            tarefas[t].destino = destino;
+            tarefas[t].inicio = (int)((long long)n * t / nThreads);
+            tarefas[t].fim = (int)((long long)n * (t + 1) / nThreads);
+            tarefas[t].minimo = minimo;
+            tarefas[t].deslocamento = deslocamento;
+        }
+        executar_fase_radix(tarefas, nThreads, executar_histograma_radix);
+        long posicao = 0;
+        for (int digito = 0; digito < 256; digito++) {
+            for (int t = 0; t < nThreads; t++) {
+                long qtde = tarefas[t].contagem[digito];
+                tarefas[t].contagem[digito] = posicao;
+                posicao += qtde;
+            }
+        }
+        executar_fase_radix(tarefas, nThreads, executar_distribuicao_radix);
+        unsigned long long *troca = origem;
+        origem = destino;
+        destino = troca;
+    }
+    if (origem != itens) {
+        memcpy(itens, origem, (size_t)n * sizeof(unsigned long long));
+    }
+    free(tarefas);
+    free(auxiliar);
+}
+
+// Escritor com buffer sobre um arquivo já aberto (ou stdout)
+void iniciar_escritor(EscritorBuffer *escritor, FILE *destino) {
+    escritor->destino = destino;
+    escritor->dados = malloc(TAMANHO_ESCRITOR);
+    escritor->tamanho = 0;
+    escritor->bytes = 0;
+}
+
+void descarregar_escritor(EscritorBuffer *escritor) {
+    if (escritor->tamanho > 0) {
+        fwrite(escritor->dados, 1, escritor->tamanho, escritor->destino);
+        escritor->bytes += (long)escritor->tamanho;
+        escritor->tamanho = 0;
+    }
+}
+
+// Acrescenta a linha de um paciente, no mesmo formato do arquivo de pacientes
+void escrever_paciente(EscritorBuffer *escritor, const Registro *paciente) {
+    if (escritor->tamanho + 256 > TAMANHO_ESCRITOR) {
+        descarregar_escritor(escritor);
+    }
+    int escritos = snprintf(escritor->dados + escritor->tamanho, TAMANHO_ESCRITOR - escritor->tamanho,
+                            "Nome: %s; Idade: %d; RG: %s; Entrada: ", paciente->nome, paciente->idade, paciente->rg);
+    if (escritos > 0) {
+        escritor->tamanho += (size_t)escritos;
+        escrever_data_texto(paciente->entrada, escritor->dados + escritor->tamanho);
+        escritor->tamanho += TAMANHO_DATA_TEXTO - 1;
+        escritor->dados[escritor->tamanho++] = '\n';
+    }
+}
+
+// Grava o que restou no buffer e libera o escritor (o arquivo continua aberto)
+void encerrar_escritor(EscritorBuffer *escritor) {
+    descarregar_escritor(escritor);
+    fflush(escritor->destino);
+    free(escritor->dados);
+}
+
+// Escreve os pacientes na ordem pedida. Retorna 0 se houve erro de gravação.
+int escrever_relatorio(const Relatorio *relatorio, int ordem, FILE *destino) {
+    EscritorBuffer escritor;
+    iniciar_escritor(&escritor, destino);
+    const unsigned long long *itens = relatorio->ordens[ordem];
+    for (int i = 0; i < relatorio->qtde; i++) {
+        escrever_paciente(&escritor, relatorio->registros[itens[i] & 0xFFFFFFFFu]);
+    }
+    encerrar_escritor(&escritor);
+    return !ferror(destino);
+}
+
+void visitar_escrita(const Registro *paciente, void *escritor) {
+    escrever_paciente(escritor, paciente);
+}
+
+// Escreve os pacientes na ordem da lista (listagem do cadastro). Com versões, escreve a versão
+// atual, sem impedir alterações durante a escrita. Retorna 0 se houve erro de gravação.
+int escrever_lista(const Lista *lista, FILE *destino) {
+    EscritorBuffer escritor;
+    iniciar_escritor(&escritor, destino);
+    LeituraCadastro leitura;
+    if (abrir_leitura_cadastro(lista, &leitura)) {
+        percorrer_versao(leitura.versao, 1, visitar_escrita, &escritor);
+        fechar_leitura_cadastro(&leitura);
+    } else {
+        for (ELista *noAtual = lista->inicio; noAtual != NULL; noAtual = noAtual->proximo) {
+            escrever_paciente(&escritor, noAtual->dados);
+        }
+    }
+    encerrar_escritor(&escritor);
+    return !ferror(destino);
+}
+
+void* executar_ordenacao_relatorio(void *argumento) {
+    TarefaRelatorio *tarefa = argumento;
+    ordenar_radix(tarefa->relatorio->ordens[tarefa->ordem], tarefa->relatorio->qtde, tarefa->threads);
+    tarefa->ok = 1;
+    if (tarefa->prefixoArquivo != NULL) {
+        char nome[300];
+        snprintf(nome, sizeof(nome), "%s_%s.txt", tarefa->prefixoArquivo, NOMES_ORDENS[tarefa->ordem]);
+        FILE *arquivo = fopen(nome, "w");
+        tarefa->ok = arquivo != NULL && escrever_relatorio(tarefa->relatorio, tarefa->ordem, arquivo);
+        if (arquivo != NULL) {
+            tarefa->ok = (fclose(arquivo) == 0) && tarefa->ok;
+        }
+    }
+    return NULL;
+}
+
+void visitar_relatorio(const Registro *paciente, void *relatorio) {
+    Relatorio *destino = relatorio;
+    destino->registros[destino->qtde++] = (Registro *)paciente;
+}
+
+// Gera as ordens da máscara (bit 1 << ORDEM_*) em uma única passada pela lista: os registros e
+// as chaves de todas as ordens são reunidos juntos e cada ordem é ordenada em sua própria thread,
+// dividindo os núcleos entre elas. Empates ficam na ordem de cadastro (do mais antigo ao mais
+// recente), a mesma da listagem pela ABB. Se 'prefixoArquivo' não for NULL, cada ordem é gravada
+// em <prefixo>_<ordem>.txt assim que termina. Com versões, o relatório usa a versão atual do
+// cadastro, mantida até liberar_relatorio. Retorna 0 se alguma gravação falhou.
+int gerar_relatorios(const Lista *lista, int mascaraOrdens, const char *prefixoArquivo, Relatorio *relatorio) {
+    memset(relatorio, 0, sizeof(Relatorio));
+    int versionada = abrir_leitura_cadastro(lista, &relatorio->leitura);
+    int n = versionada ? relatorio->leitura.versao->qtde : lista->qtde;
+    relatorio->registros = malloc((size_t)(n > 0 ? n : 1) * sizeof(Registro *));
+    int pedidas[QTDE_ORDENS], qtdePedidas = 0;
+    for (int ordem = 0; ordem < QTDE_ORDENS; ordem++) {
+        if (mascaraOrdens & (1 << ordem)) {
+            relatorio->ordens[ordem] = malloc((size_t)(n > 0 ? n : 1) * sizeof(unsigned long long));
+            pedidas[qtdePedidas++] = ordem;
+        }
+    }
+    if (versionada) {
+        percorrer_versao(relatorio->leitura.versao, 0, visitar_relatorio, relatorio);
+    } else {
+        int linha = n;
+        for (ELista *no = lista->inicio; no != NULL && linha > 0; no = no->proximo) {
+            relatorio->registros[--linha] = no->dados;
+        }
+        relatorio->qtde = n;
+    }
+    for (int linha = 0; linha < n; linha++) {
+        for (int k = 0; k < qtdePedidas; k++) {
+            relatorio->ordens[pedidas[k]][linha] =
+                (unsigned long long)chave_relatorio(relatorio->registros[linha], pedidas[k]) << 32 | (unsigned int)linha;
+        }
+    }
+    if (qtdePedidas == 0) {
+        return 1;
+    }
+    int threadsPorOrdem = threads_disponiveis() / qtdePedidas;
+    TarefaRelatorio tarefas[QTDE_ORDENS];
+    pthread_t threads[QTDE_ORDENS];
+    int criada[QTDE_ORDENS] = {0};
+    for (int k = 0; k < qtdePedidas; k++) {
+        tarefas[k] = (TarefaRelatorio){relatorio, pedidas[k], threadsPorOrdem > 1 ? threadsPorOrdem : 1, prefixoArquivo, 0};
+    }
+    for (int k = 0; k < qtdePedidas - 1; k++) {
+        criada[k] = pthread_create(&threads[k], NULL, executar_ordenacao_relatorio, &tarefas[k]) == 0;
+        if (!criada[k]) {
+            executar_ordenacao_relatorio(&tarefas[k]);
+        }
+    }
+    executar_ordenacao_relatorio(&tarefas[qtdePedidas - 1]);
+    int ok = 1;
+    for (int k = 0; k < qtdePedidas; k++) {
+        if (k < qtdePedidas - 1 && criada[k]) {
+            pthread_join(threads[k], NULL);
+        }
+        ok = ok && tarefas[k].ok;
+    }
+    return ok;
+}
+
+void liberar_relatorio(Relatorio *relatorio) {
+    fechar_leitura_cadastro(&relatorio->leitura);
+    free(relatorio->registros);
+    for (int ordem = 0; ordem < QTDE_ORDENS; ordem++) {
+        free(relatorio->ordens[ordem]);
+    }
+    memset(relatorio, 0, sizeof(Relatorio));
+}
+
+// Opção de menu: lista os pacientes na ordem pedida
+void mostrar_relatorio(Sessao *sessao, int ordem, const char *titulo) {
+    limpar_console();
+    printf("\nPacientes ordenados por %s:\n\n", titulo);
+    fflush(stdout);
+    Operacao op = {.tipo = OP_RELATORIO, .valores = {ordem}};
+    executar_operacao(sessao, &op, NULL);
+    limpar_console_dinamico();
+}
+
+// Opção de menu: grava as quatro ordens em arquivos, geradas simultaneamente
+void gravar_relatorios_arquivo(const Lista *lista) {
+    char prefixo[200];
+    printf("\nPrefixo dos arquivos (ex.: relatorio): ");
+    fgets(prefixo, sizeof(prefixo), stdin);
+    prefixo[strcspn(prefixo, "\n")] = '\0';
+    if (prefixo[0] == '\0') {
+        strcpy(prefixo, "relatorio");
+    }
+    Relatorio relatorio;
+    long long inicio = instante_atual();
+    int ok = gerar_relatorios(lista, TODAS_AS_ORDENS, prefixo, &relatorio);
+    long long duracao = instante_atual() - inicio;
+    liberar_relatorio(&relatorio);
+    limpar_console();
+    if (ok) {
+        printf("\nSUCESSO!\nArquivos %s_ano.txt, %s_mes.txt, %s_dia.txt e %s_idade.txt gravados (%d pacientes, %lld ms).\n",
+               prefixo, prefixo, prefixo, prefixo, lista->qtde, duracao);
+    } else {
+        printf("\nERRO!\nNão foi possível gravar todos os relatórios.\n");
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Arquivos (Carregar/Salvar Dados) ** 
+
+// Grava a lista no formato texto (uma linha por paciente), sem interação. Retorna 1 se gravou.
+int gravar_arquivo_texto(const Lista *lista, const char *nomeArquivo) {
+    FILE *arquivo = fopen(nomeArquivo, "w");
+    if (arquivo == NULL) {
+        return 0;
+    }
+    // Escreve cada paciente em uma linha do arquivo, com campos separados por delimitadores
+    int ok = escrever_lista(lista, arquivo);
+    return (fclose(arquivo) == 0) && ok;
+}
+
+// Salva todos os pacientes da lista no arquivo (.pca = compactado, demais = texto). Retorna 1 se gravou.
+int salvar_arquivo_pacientes(const Lista *lista, const char *nomeArquivo) {
+    // Arquivos .pca usam o formato colunar compactado
+    if (termina_com(nomeArquivo, EXTENSAO_COMPACTADA)) {
+        return salvar_arquivo_compactado(lista, nomeArquivo);
+    }
+    return gravar_arquivo_texto(lista, nomeArquivo);
+}
+
+// Opção de menu: salva o cadastro e informa o resultado
+void salvar_lista(Sessao *sessao, const char *nomeArquivo) {
+    Operacao op = {.tipo = OP_SALVAR};
+    snprintf(op.texto, sizeof(op.texto), "%s", nomeArquivo);
+    int status = executar_operacao(sessao, &op, NULL);
+    limpar_console();
+    if (status == OPERACAO_OK) {
+        printf("\nSUCESSO!\nBase de pacientes atualizada!\n");
+    } else {
+        printf("\nERRO!\nDesculpe, tivemos problemas para acessar a base de clientes\n");
+    }
+    limpar_console_dinamico();
+}
+
+// Cria um lote vazio para carga em massa
+Lote* iniciar_lote(int capacidadeInicial) {
+    Lote *lote = malloc(sizeof(Lote));
+    if (lote != NULL) {
+        lote->capacidade = capacidadeInicial > 0 ? capacidadeInicial : 64;
+        lote->qtde = 0;
+        lote->invalidos = 0;
+        lote->registros = malloc((size_t)lote->capacidade * sizeof(Registro));
+    }
+    return lote;
+}
+
+// Acrescenta um registro ao lote (crescimento geométrico, O(1) amortizado)
+void adicionar_ao_lote(Lote *lote, Registro paciente) {
+    if (lote->qtde == lote->capacidade) {
+        lote->capacidade *= 2;
+        lote->registros = realloc(lote->registros, (size_t)lote->capacidade * sizeof(Registro));
+    }
+    lote->registros[lote->qtde++] = paciente;
+}
+
+// Libera o lote (os registros já foram copiados para a lista na confirmação)
+void liberar_lote(Lote *lote) {
+    free(lote->registros);
+    free(lote);
+}
+
+// Confirma o lote na lista: aloca e encadeia todos os nós de uma vez e atualiza os agregados
+// em uma única passada. O resultado é o mesmo de chamar cadastrar_paciente para cada registro.
+void confirmar_lote(Lista *lista, Lote *lote) {
+    if (lote->qtde == 0) {
+        return;
+    }
+    // Cada nó continua sendo uma alocação própria, pois remover_paciente libera nós individualmente.
+    // O último registro do lote fica no início da lista, como nas inserções individuais.
+    ELista *inicio = lista->inicio;
+    for (int i = 0; i < lote->qtde; i++) {
+        ELista *novoNo = alocar_memoria(MEM_CADASTRO, sizeof(ELista));
+        novoNo->dados = alocar_memoria(MEM_CADASTRO, sizeof(Registro));
+        *novoNo->dados = lote->registros[i];
+        novoNo->chave = proxima_chave_lista(lista);
+        novoNo->proximo = inicio;
+        inicio = novoNo;
+        contabilizar_registro(&lista->agregados, novoNo->dados, 1);
+        // Todo o lote entra em uma única versão (os nós copiados pela primeira inserção são
+        // reaproveitados pelas seguintes)
+        if (lista->versoes != NULL) {
+            gravar_versao(lista->versoes, novoNo->chave, novoNo->dados);
+        }
+    }
+    lista->inicio = inicio;
+    lista->qtde += lote->qtde;
+    lista->versao++;
+    // Índice de RGs atualizado uma única vez, depois de todos os nós encadeados: a tabela é
+    // dimensionada para o lote inteiro e os nós são indexados na ordem do lote, para que um
+    // RG repetido aponte para o registro mais recente, como na busca a partir do início da lista
+    int capacidade = lista->indiceRg.capacidade;
+    while ((lista->indiceRg.ocupadas + lote->qtde + 1) * 4 >= capacidade * 3) {
+        capacidade *= 2;
+    }
+    if (capacidade != lista->indiceRg.capacidade) {
+        redimensionar_indice_rg(&lista->indiceRg, capacidade);
+    }
+    int restantes = lote->qtde;
+    ELista **novos = malloc((size_t)restantes * sizeof(ELista *));
+    for (ELista *no = lista->inicio; restantes > 0; no = no->proximo) {
+        novos[--restantes] = no;
+    }
+    for (int i = 0; i < lote->qtde; i++) {
+        indexar_rg(&lista->indiceRg, novos[i]);
+    }
+    free(novos);
+    if (lista->versoes != NULL) {
+        publicar_versao(lista->versoes, lista);
+    }
+    lote->qtde = 0;
+}
+
+// Interpreta uma linha no formato do arquivo de pacientes. Retorna 1 se a linha for válida
+// (inclusive a idade e a data de entrada, lida direto para a forma compacta).
+int interpretar_linha_paciente(const char *linha, Registro *novoRegistro) {
+    // Extrai os campos do paciente da linha formatada
+    int posicaoData = 0;
+    int lidos = sscanf(linha, "Nome: %99[^;]; Idade: %d; RG: %19[^;]; Entrada: %n",
+                       novoRegistro->nome, &novoRegistro->idade, novoRegistro->rg, &posicaoData);
+    if (lidos != 3 || posicaoData == 0 || ler_data_texto(linha + posicaoData, &novoRegistro->entrada) == NULL ||
+        !registro_valido(novoRegistro)) {
+        return 0;
+    }
+    // Remove espaços e quebras de linha ao final do nome e do RG
+    size_t len;
+    len = strlen(novoRegistro->nome);
+    while (len > 0 && (novoRegistro->nome[len-1] == ' ' || novoRegistro->nome[len-1] == '\n')) {
+        novoRegistro->nome[len-1] = '\0';
+        len--;
+    }
+    len = strlen(novoRegistro->rg);
+    while (len > 0 && (novoRegistro->rg[len-1] == ' ' || novoRegistro->rg[len-1] == '\n')) {
+        novoRegistro->rg[len-1] = '\0';
+        len--;
+    }
+    return 1;
+}
+
+// Lê um arquivo texto de pacientes para o lote, sem interação. Retorna 0 se não conseguiu abrir.
+int ler_lote_texto(const char *nomeArquivo, Lote *lote) {
+    FILE *arquivo = fopen(nomeArquivo, "r");
+    if (arquivo == NULL) {
+        return 0;
+    }
+    char linha[256];
+    // Lê o arquivo linha por linha, criando um novo registro para cada linha
+    while (fgets(linha, sizeof(linha), arquivo) != NULL) {
+        Registro novoRegistro;
+        if (!interpretar_linha_paciente(linha, &novoRegistro)) {
+            // Linha fora do formato ou com data/idade inválida (linhas vazias não contam)
+            if (linha[strspn(linha, " \r\n")] != '\0') {
+                lote->invalidos++;
+            }
+            continue;
+        }
+        adicionar_ao_lote(lote, novoRegistro);
+    }
+    fclose(arquivo);
+    return 1;
+}
+
+// Carrega os pacientes de um arquivo para a lista. Retorna 0 se não conseguiu ler o arquivo.
+// As linhas de texto são reunidas em um lote e confirmadas de uma só vez, em vez de um
+// cadastro individual por linha. Em 'resumo' informa os inseridos e os descartados.
+int carregar_arquivo_pacientes(Lista *lista, const char *nomeArquivo, ResumoImportacao *resumo) {
+    // Arquivos .pca usam o formato colunar compactado
+    if (termina_com(nomeArquivo, EXTENSAO_COMPACTADA)) {
+        return carregar_arquivo_compactado(lista, nomeArquivo, resumo);
+    }
+    memset(resumo, 0, sizeof(ResumoImportacao));
+    Lote *lote = iniciar_lote(1024);
+    if (!ler_lote_texto(nomeArquivo, lote)) {
+        liberar_lote(lote);
+        return 0;
+    }
+    resumo->inseridos = lote->qtde;
+    resumo->invalidos = lote->invalidos;
+    // Insere todos os registros lidos na lista encadeada de pacientes
+    confirmar_lote(lista, lote);
+    liberar_lote(lote);
+    return 1;
+}
+
+// Opção de menu: carrega o arquivo e informa o resultado
+void carregar_lista(Sessao *sessao, const char *nomeArquivo) {
+    Operacao op = {.tipo = OP_CARREGAR};
+    snprintf(op.texto, sizeof(op.texto), "%s", nomeArquivo);
+    ResultadoOperacao resultado;
+    if (executar_operacao(sessao, &op, &resultado) != OPERACAO_OK) {
+        printf("\nERRO!\nDesculpe, tivemos problemas ao acessar a base de clientes\n");
+        limpar_console_dinamico();
+        return;
+    }
+    limpar_console();
+    printf("\nSUCESSO!\nDados importados!\n");
+    printf("Carregados: %d\n", resultado.resumo.inseridos);
+    if (resultado.resumo.invalidos > 0) {
+        printf("Registros inválidos descartados: %d\n", resultado.resumo.invalidos);
+    }
+    limpar_console_dinamico();
+}
+
+// Importa um arquivo mesclando pelo RG normalizado, em uma única passada O(n): RGs novos são
+// cadastrados, RGs já existentes têm os campos alterados atualizados e linhas idênticas são
+// ignoradas. O índice de RGs funciona como conjunto de duplicatas, inclusive dentro do arquivo.
+int importar_lista(Lista *lista, const char *nomeArquivo, ResumoImportacao *resumo) {
+    memset(resumo, 0, sizeof(ResumoImportacao));
+    FILE *arquivo = fopen(nomeArquivo, "r");
+    if (arquivo == NULL) {
+        return 0;
+    }
+    char linha[256];
+    while (fgets(linha, sizeof(linha), arquivo) != NULL) {
+        Registro lido;
+        if (!interpretar_linha_paciente(linha, &lido)) {
+            if (linha[strspn(linha, " \r\n")] != '\0') {
+                resumo->invalidos++;
+            }
+            continue;
+        }
+        ELista *existente = consultar_paciente_rg(lista, lido.rg);
+        if (existente == NULL) {
+            cadastrar_paciente(lista, lido);
+            resumo->inseridos++;
+            continue;
+        }
+        Registro *atual = existente->dados;
+        if (strcmp(atual->nome, lido.nome) == 0 && atual->idade == lido.idade &&
+            atual->entrada == lido.entrada) {
+            resumo->ignorados++;
+            continue;
+        }
+        // Atualiza os campos alterados (a formatação original do RG é mantida)
+        Registro atualizado = *atual;
+        strcpy(atualizado.nome, lido.nome);
+        atualizado.idade = lido.idade;
+        atualizado.entrada = lido.entrada;
+        alterar_paciente(lista, existente, &atualizado);
+        resumo->atualizados++;
+    }
+    fclose(arquivo);
+    return 1;
+}
+
+// Opção de menu: importa com mesclagem por RG e mostra o resumo
+void importar_lista_mesclando(Sessao *sessao, const char *nomeArquivo) {
+    Operacao op = {.tipo = OP_IMPORTAR};
+    snprintf(op.texto, sizeof(op.texto), "%s", nomeArquivo);
+    ResultadoOperacao resultado;
+    limpar_console();
+    if (executar_operacao(sessao, &op, &resultado) != OPERACAO_OK) {
+        printf("\nERRO!\nDesculpe, tivemos problemas ao acessar a base de clientes\n");
+        limpar_console_dinamico();
+        return;
+    }
+    printf("\nSUCESSO!\nImportação concluída:\n");
+    printf("Inseridos: %d\nAtualizados: %d\nIgnorados (sem alterações): %d\nLinhas inválidas: %d\n",
+           resultado.resumo.inseridos, resultado.resumo.atualizados, resultado.resumo.ignorados, resultado.resumo.invalidos);
+    limpar_console_dinamico();
+}
+
+// ** Módulo Salvamento em Segundo Plano ** 
+// O menu congela uma versão imutável do cadastro (a versão publicada, quando a lista tem versões,
+// ou uma cópia compacta dos registros) e a entrega a uma thread, que formata e grava o arquivo
+// enquanto o atendimento segue. No salvamento automático, a própria thread congela a versão
+// publicada quando o intervalo vence.
+// A gravação vai para um arquivo temporário renomeado no fim, então o arquivo nunca fica pela metade.
+
+// Congela o estado atual da lista em uma foto imutável: O(1) com versões (a foto mantém a
+// versão atual aberta até ser liberada), senão O(n) cópias de memória. Nenhuma E/S.
+FotoRegistro* congelar_lista(const Lista *lista) {
+    FotoRegistro *foto = malloc(sizeof(FotoRegistro));
+    foto->qtde = 0;
+    foto->versao = lista->versao;
+    foto->registros = NULL;
+    if (abrir_leitura_cadastro(lista, &foto->leitura)) {
+        foto->qtde = foto->leitura.versao->qtde;
+        return foto;
+    }
+    foto->registros = malloc((size_t)(lista->qtde > 0 ? lista->qtde : 1) * sizeof(Registro));
+    for (ELista *noAtual = lista->inicio; noAtual != NULL && foto->qtde < lista->qtde; noAtual = noAtual->proximo) {
+        foto->registros[foto->qtde++] = *noAtual->dados;
+    }
+    return foto;
+}
+
+// Congela a versão publicada do cadastro sem ler a lista em si, o que permite chamá-la fora da
+// thread do menu. Retorna NULL se a lista não tem versões ou não há vaga de leitura.
+FotoRegistro* congelar_versao_publicada(const Lista *lista) {
+    FotoRegistro *foto = malloc(sizeof(FotoRegistro));
+    foto->registros = NULL;
+    if (!abrir_leitura_cadastro(lista, &foto->leitura)) {
+        free(foto);
+        return NULL;
+    }
+    foto->qtde = foto->leitura.versao->qtde;
+    foto->versao = foto->leitura.versao->versao;
+    return foto;
+}
+
+void liberar_foto(FotoRegistro *foto) {
+    fechar_leitura_cadastro(&foto->leitura);
+    free(foto->registros);
+    free(foto);
+}
+
+// Grava a foto no formato texto de salvar_lista, via arquivo temporário. Retorna 1 se gravou.
+int gravar_foto(const FotoRegistro *foto, const char *nomeArquivo) {
+    char temporario[300];
+    snprintf(temporario, sizeof(temporario), "%s.tmp", nomeArquivo);
+    FILE *arquivo = fopen(temporario, "w");
+    if (arquivo == NULL) {
+        return 0;
+    }
+    EscritorBuffer escritor;
+    iniciar_escritor(&escritor, arquivo);
+    if (foto->leitura.versao != NULL) {
+        percorrer_versao(foto->leitura.versao, 1, visitar_escrita, &escritor);
+    } else {
+        for (int i = 0; i < foto->qtde; i++) {
+            escrever_paciente(&escritor, &foto->registros[i]);
+        }
+    }
+    encerrar_escritor(&escritor);
+    int ok = !ferror(arquivo);
+    ok = (fclose(arquivo) == 0) && ok;
+    if (!ok || rename(temporario, nomeArquivo) != 0) {
+        remove(temporario);
+        return 0;
+    }
+    return 1;
+}
+
+// Salvamento automático, com a trava: se o intervalo venceu, congela a versão publicada e a
+// deixa pendente quando ela ainda não foi gravada. Senão, devolve em 'prazo' o instante (ms)
+// da próxima verificação. Retorna 1 se deixou uma foto pendente.
+int agendar_salvamento_automatico(SalvamentoAssincrono *sa, long long *prazo) {
+    *prazo = sa->ultimoPedido + (long long)sa->intervaloAutomatico * 1000;
+    if (instante_atual() < *prazo) {
+        return 0;
+    }
+    // Abrir a leitura pode esperar por uma vaga: a trava é solta enquanto isso
+    pthread_mutex_unlock(&sa->trava);
+    FotoRegistro *foto = congelar_versao_publicada(sa->lista);
+    pthread_mutex_lock(&sa->trava);
+    sa->ultimoPedido = instante_atual();
+    *prazo = sa->ultimoPedido + (long long)sa->intervaloAutomatico * 1000;
+    if (foto != NULL && foto->versao != sa->versaoSalva && sa->pendente == NULL) {
+        sa->pendente = foto;
+        return 1;
+    }
+    if (foto != NULL) {
+        liberar_foto(foto);
+    }
+    return 0;
+}
+
+// Laço da thread de gravação: espera fotos pendentes e as grava uma a uma. Com o salvamento
+// automático ligado, a espera tem prazo: ao vencer o intervalo a própria thread congela o
+// cadastro, sem depender de o menu ser redesenhado.
+void* executar_salvamento(void *argumento) {
+    SalvamentoAssincrono *sa = argumento;
+    pthread_mutex_lock(&sa->trava);
+    while (1) {
+        while (sa->pendente == NULL && !sa->encerrar) {
+            long long prazo;
+            if (sa->intervaloAutomatico <= 0 || sa->lista == NULL) {
+                pthread_cond_wait(&sa->sinal, &sa->trava);
+            } else if (!agendar_salvamento_automatico(sa, &prazo)) {
+                // O relógio da condição é o monotônico, o mesmo que move instante_atual
+                long long restante = prazo - instante_atual();
+                struct timespec limite;
+                clock_gettime(CLOCK_MONOTONIC, &limite);
+                limite.tv_sec += restante / 1000;
+                limite.tv_nsec += (restante % 1000) * 1000000L;
+                if (limite.tv_nsec >= 1000000000L) {
+                    limite.tv_sec++;
+                    limite.tv_nsec -= 1000000000L;
+                }
+                pthread_cond_timedwait(&sa->sinal, &sa->trava, &limite);
+            }
+        }
+        if (sa->pendente == NULL && sa->encerrar) {
+            break;
+        }
+        FotoRegistro *foto = sa->pendente;
+        sa->pendente = NULL;
+        sa->estado = SALVAMENTO_EM_ANDAMENTO;
+        pthread_mutex_unlock(&sa->trava);
+
+        long long inicio = instante_atual();
+        int ok = gravar_foto(foto, sa->nomeArquivo);
+        long long fim = instante_atual();
+
+        pthread_mutex_lock(&sa->trava);
+        sa->estado = ok ? SALVAMENTO_CONCLUIDO : SALVAMENTO_FALHOU;
+        sa->ultimoTermino = fim;
+        sa->ultimaDuracaoMs = fim - inicio;
+        sa->ultimosRegistros = foto->qtde;
+        if (ok) {
+            sa->versaoSalva = foto->versao;
+            sa->salvamentos++;
+        } else {
+            sa->falhas++;
+        }
+        pthread_mutex_unlock(&sa->trava);
+        liberar_foto(foto);
+        pthread_mutex_lock(&sa->trava);
+    }
+    pthread_mutex_unlock(&sa->trava);
+    return NULL;
+}
+
+// Cria o serviço de salvamento do cadastro 'lista' e sua thread de gravação
+SalvamentoAssincrono* iniciar_salvamento_assincrono(const char *nomeArquivo, const Lista *lista) {
+    SalvamentoAssincrono *sa = calloc(1, sizeof(SalvamentoAssincrono));
+    snprintf(sa->nomeArquivo, sizeof(sa->nomeArquivo), "%s", nomeArquivo);
+    sa->lista = lista;
+    pthread_mutex_init(&sa->trava, NULL);
+    pthread_condattr_t atributos;
+    pthread_condattr_init(&atributos);
+    pthread_condattr_setclock(&atributos, CLOCK_MONOTONIC);
+    pthread_cond_init(&sa->sinal, &atributos);
+    pthread_condattr_destroy(&atributos);
+    sa->estado = SALVAMENTO_NUNCA;
+    sa->versaoSalva = (unsigned long)-1;
+    sa->threadAtiva = pthread_create(&sa->thread, NULL, executar_salvamento, sa) == 0;
+    return sa;
+}
+
+// Congela a lista e agenda a gravação. Se já houver uma foto aguardando, ela é substituída
+// pela mais recente. Sem thread disponível, grava na hora.
+void solicitar_salvamento(SalvamentoAssincrono *sa, const Lista *lista) {
+    FotoRegistro *foto = congelar_lista(lista);
+    if (!sa->threadAtiva) {
+        long long inicio = instante_atual();
+        int ok = gravar_foto(foto, sa->nomeArquivo);
+        sa->estado = ok ? SALVAMENTO_CONCLUIDO : SALVAMENTO_FALHOU;
+        sa->ultimoTermino = instante_atual();
+        sa->ultimaDuracaoMs = sa->ultimoTermino - inicio;
+        sa->ultimosRegistros = foto->qtde;
+        if (ok) sa->versaoSalva = foto->versao;
+        liberar_foto(foto);
+        return;
+    }
+    pthread_mutex_lock(&sa->trava);
+    FotoRegistro *descartada = sa->pendente;
+    sa->pendente = foto;
+    sa->ultimoPedido = instante_atual();
+    pthread_cond_signal(&sa->sinal);
+    pthread_mutex_unlock(&sa->trava);
+    if (descartada != NULL) {
+        liberar_foto(descartada);
+    }
+}
+
+// Mostra o estado do último salvamento
+void mostrar_status_salvamento(SalvamentoAssincrono *sa, const Lista *lista) {
+    const char *estados[] = {"nenhum salvamento realizado", "gravando...", "concluído", "FALHOU"};
+    pthread_mutex_lock(&sa->trava);
+    printf("\nArquivo: %s\n", sa->nomeArquivo);
+    printf("Último salvamento: %s\n", estados[sa->estado]);
+    if (sa->estado == SALVAMENTO_CONCLUIDO || sa->estado == SALVAMENTO_FALHOU) {
+        time_t termino = (time_t)(sa->ultimoTermino / 1000);
+        char horario[32];
+        strftime(horario, sizeof(horario), "%d/%m/%Y %H:%M:%S", localtime(&termino));
+        printf("Terminado em: %s (%lld ms, %d registros)\n", horario, sa->ultimaDuracaoMs, sa->ultimosRegistros);
+    }
+    printf("Salvamentos concluídos: %ld | Falhas: %ld\n", sa->salvamentos, sa->falhas);
+    printf("Alterações não salvas: %s\n", lista->versao != sa->versaoSalva ? "sim" : "não");
+    if (sa->intervaloAutomatico > 0) {
+        printf("Salvamento automático: a cada %d s\n", sa->intervaloAutomatico);
+    } else {
+        printf("Salvamento automático: desligado\n");
+    }
+    pthread_mutex_unlock(&sa->trava);
+}
+
+// Define o intervalo do salvamento automático (0 desliga) e acorda a thread para que ela
+// recalcule o prazo da espera
+void configurar_salvamento_automatico(SalvamentoAssincrono *sa) {
+    int intervalo;
+    printf("\nIntervalo do salvamento automático em segundos (0 = desligado): ");
+    scanf("%d", &intervalo);
+    getchar();
+    pthread_mutex_lock(&sa->trava);
+    sa->intervaloAutomatico = intervalo > 0 ? intervalo : 0;
+    pthread_cond_signal(&sa->sinal);
+    pthread_mutex_unlock(&sa->trava);
+}
+
+// Aguarda a gravação pendente terminar e encerra a thread
+void encerrar_salvamento_assincrono(SalvamentoAssincrono *sa) {
+    if (sa->threadAtiva) {
+        pthread_mutex_lock(&sa->trava);
+        sa->encerrar = 1;
+        pthread_cond_signal(&sa->sinal);
+        pthread_mutex_unlock(&sa->trava);
+        pthread_join(sa->thread, NULL);
+    }
+    pthread_mutex_destroy(&sa->trava);
+    pthread_cond_destroy(&sa->sinal);
+    free(sa);
+}
+
+// ** Módulo Arquivo Compactado ** 
+// Formato colunar para o histórico de pacientes (extensão .pca). Após o cabeçalho "PCA1",
+// o arquivo é uma sequência de blocos de até REGISTROS_POR_BLOCO pacientes, cada um com:
+//   cabeçalho: qtde de registros, menor e maior data (em dias) e tamanho da carga (bytes)
+//   carga: idades (varint) | datas (1ª absoluta, demais em delta zigzag varint) |
+//          RGs (formato em 2 bits, nº de dígitos em 5 bits, valor numérico em largura mínima,
+//          RGs fora do padrão como texto) | nomes (dicionário do bloco + índices em largura mínima)
+// A leitura decodifica um bloco por vez e pula blocos fora do período pedido sem lê-los. Uma
+// carga maior que MAX_BYTES_BLOCO não pode ter sido gravada e torna o arquivo inválido.
+
+// Indica se o nome do arquivo termina com a extensão informada
+int termina_com(const char *texto, const char *sufixo) {
+    size_t lenTexto = strlen(texto), lenSufixo = strlen(sufixo);
+    return lenTexto >= lenSufixo && strcmp(texto + lenTexto - lenSufixo, sufixo) == 0;
+}
+
+// Garante espaço para mais 'extra' bytes no buffer. Retorna 0 (e marca o erro do buffer, que
+// mantém os dados que já tinha) se não há memória.
+int buffer_reservar(Buffer *buffer, size_t extra) {
+    if (buffer->tamanho + extra <= buffer->capacidade) {
+        return 1;
+    }
+    size_t capacidade = buffer->capacidade ? buffer->capacidade : 4096;
+    while (capacidade < buffer->tamanho + extra) {
+        capacidade *= 2;
+    }
+    unsigned char *dados = realloc(buffer->dados, capacidade);
+    if (dados == NULL) {
+        buffer->erro = 1;
+        return 0;
+    }
+    buffer->dados = dados;
+    buffer->capacidade = capacidade;
+    return 1;
+}
+
+void buffer_bytes(Buffer *buffer, const void *dados, size_t tamanho) {
+    if (tamanho == 0 || !buffer_reservar(buffer, tamanho)) {
+        return;
+    }
+    memcpy(buffer->dados + buffer->tamanho, dados, tamanho);
+    buffer->tamanho += tamanho;
+}
+
+// Inteiro sem sinal em 7 bits por byte (bit 8 indica continuação)
+void buffer_varint(Buffer *buffer, unsigned long long valor) {
+    if (!buffer_reservar(buffer, 10)) {
+        return;
+    }
+    while (valor >= 0x80) {
+        buffer->dados[buffer->tamanho++] = (unsigned char)(valor | 0x80);
+        valor >>= 7;
+    }
+    buffer->dados[buffer->tamanho++] = (unsigned char)valor;
+}
+
+// Empacota n valores usando exatamente 'largura' bits cada (0 a 64)
+void buffer_bits(Buffer *buffer, const unsigned long long *valores, int n, int largura) {
+    unsigned long long acumulador = 0;
+    int bits = 0;
+    if (!buffer_reservar(buffer, ((size_t)n * largura + 7) / 8 + 8)) {
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        unsigned long long valor = valores[i];
+        int restantes = largura;
+        while (restantes > 0) {
+            int usar = restantes < 56 ? restantes : 56;
+            acumulador |= (valor & ((1ULL << usar) - 1)) << bits;
+            bits += usar;
+            valor >>= usar;
+            restantes -= usar;
+            while (bits >= 8) {
+                buffer->dados[buffer->tamanho++] = (unsigned char)acumulador;
+                acumulador >>= 8;
+                bits -= 8;
+            }
+        }
+    }
+    if (bits > 0) {
+        buffer->dados[buffer->tamanho++] = (unsigned char)acumulador;
+    }
+}
+
+// Quantidade de bits necessária para representar o valor
+int largura_bits(unsigned long long valor) {
+    return valor ? 64 - __builtin_clzll(valor) : 0;
+}
+
+unsigned long long leitor_varint(Leitor *leitor) {
+    unsigned long long valor = 0;
+    for (int deslocamento = 0; deslocamento < 64; deslocamento += 7) {
+        if (leitor->posicao >= leitor->tamanho) {
+            leitor->erro = 1;
+            return 0;
+        }
+        unsigned char byte = leitor->dados[leitor->posicao++];
+        valor |= (unsigned long long)(byte & 0x7F) << deslocamento;
+        if (!(byte & 0x80)) {
+            return valor;
+        }
+    }
+    leitor->erro = 1;
+    return 0;
+}
+
+const unsigned char* leitor_bytes(Leitor *leitor, size_t tamanho) {
+    if (leitor->posicao + tamanho > leitor->tamanho) {
+        leitor->erro = 1;
+        return NULL;
+    }
+    const unsigned char *inicio = leitor->dados + leitor->posicao;
+    leitor->posicao += tamanho;
+    return inicio;
+}
+
+// Desempacota n valores gravados com buffer_bits
+void leitor_bits(Leitor *leitor, unsigned long long *valores, int n, int largura) {
+    size_t tamanho = ((size_t)n * largura + 7) / 8;
+    const unsigned char *dados = leitor_bytes(leitor, tamanho);
+    if (dados == NULL) {
+        return;
+    }
+    unsigned long long acumulador = 0;
+    int bits = 0;
+    size_t posicao = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned long long valor = 0;
+        int obtidos = 0;
+        while (obtidos < largura) {
+            int usar = largura - obtidos < 56 ? largura - obtidos : 56;
+            while (bits < usar) {
+                acumulador |= (unsigned long long)dados[posicao++] << bits;
+                bits += 8;
+            }
+            valor |= (acumulador & ((1ULL << usar) - 1)) << obtidos;
+            acumulador >>= usar;
+            bits -= usar;
+            obtidos += usar;
+        }
+        valores[i] = valor;
+    }
+}
+
+void escrever_u32(FILE *arquivo, unsigned int valor) {
+    unsigned char bytes[4] = {valor & 0xFF, (valor >> 8) & 0xFF, (valor >> 16) & 0xFF, (valor >> 24) & 0xFF};
+    fwrite(bytes, 1, 4, arquivo);
+}
+
+int ler_u32(FILE *arquivo, unsigned int *valor) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, 4, arquivo) != 4) {
+        return 0;
+    }
+    *valor = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+    return 1;
+}
+
+// Classifica o RG para o empacotamento: só dígitos, padrão NN.NNN.NNN-N ou texto livre
+int formato_rg(const char *rg, char *digitos) {
+    extrair_numeros_rg(rg, digitos);
+    size_t n = strlen(digitos);
+    if (n == 0 || n > 19) {
+        return RG_TEXTO;
+    }
+    if (strcmp(rg, digitos) == 0) {
+        return RG_DIGITOS;
+    }
+    char formatado[20];
+    if (n == 9) {
+        snprintf(formatado, sizeof(formatado), "%.2s.%.3s.%.3s-%c", digitos, digitos + 2, digitos + 5, digitos[8]);
+        if (strcmp(rg, formatado) == 0) {
+            return RG_PONTUADO;
+        }
+    }
+    return RG_TEXTO;
+}
+
+// Codifica e grava um bloco de registros
+// Grava um bloco. Retorna 0 se faltou memória para montar a carga (nada é gravado).
+int gravar_bloco_compactado(FILE *arquivo, Registro **registros, int n, Buffer *carga) {
+    // Zerado: cada coluna sobrescreve os valores antes de empacotá-los
+    unsigned long long *valores = calloc((size_t)n, sizeof(unsigned long long));
+    int *dias = malloc((size_t)n * sizeof(int));
+    carga->tamanho = 0;
+    int dataMin = 0, dataMax = 0;
+    // Coluna de idades
+    for (int i = 0; i < n; i++) {
+        buffer_varint(carga, (unsigned long long)(registros[i]->idade < 0 ? 0 : registros[i]->idade));
+        dias[i] = registros[i]->entrada;
+        if (i == 0 || dias[i] < dataMin) dataMin = dias[i];
+        if (i == 0 || dias[i] > dataMax) dataMax = dias[i];
+    }
+    // Coluna de datas: deltas entre registros consecutivos em zigzag
+    for (int i = 0; i < n; i++) {
+        long long delta = (long long)dias[i] - (i ? dias[i - 1] : 0);
+        buffer_varint(carga, ((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63));
+    }
+    // Coluna de RGs: formatos, quantidade de dígitos (preserva zeros à esquerda) e valores
+    char (*digitos)[20] = malloc((size_t)n * sizeof(*digitos));
+    int *formatos = malloc((size_t)n * sizeof(int));
+    unsigned long long maiorValor = 0;
+    for (int i = 0; i < n; i++) {
+        formatos[i] = formato_rg(registros[i]->rg, digitos[i]);
+        valores[i] = formatos[i];
+    }
+    buffer_bits(carga, valores, n, 2);
+    for (int i = 0; i < n; i++) {
+        valores[i] = formatos[i] == RG_TEXTO ? 0 : strlen(digitos[i]);
+    }
+    buffer_bits(carga, valores, n, 5);
+    for (int i = 0; i < n; i++) {
+        valores[i] = formatos[i] == RG_TEXTO ? 0 : strtoull(digitos[i], NULL, 10);
+        if (valores[i] > maiorValor) maiorValor = valores[i];
+    }
+    int largura = largura_bits(maiorValor);
+    buffer_varint(carga, (unsigned long long)largura);
+    buffer_bits(carga, valores, n, largura);
+    for (int i = 0; i < n; i++) {
+        if (formatos[i] == RG_TEXTO) {
+            size_t len = strlen(registros[i]->rg);
+            buffer_varint(carga, len);
+            buffer_bytes(carga, registros[i]->rg, len);
+        }
+    }
+    // Coluna de nomes: dicionário do bloco (tabela hash local) e índices empacotados
+    int capacidadeTabela = 1;
+    while (capacidadeTabela < 2 * n) capacidadeTabela *= 2;
+    int *tabela = malloc((size_t)capacidadeTabela * sizeof(int));
+    int *dicionario = malloc((size_t)n * sizeof(int));  // posição do registro que define cada entrada
+    memset(tabela, -1, (size_t)capacidadeTabela * sizeof(int));
+    int qtdeDicionario = 0;
+    for (int i = 0; i < n; i++) {
+        int j = (int)(hash_rg(registros[i]->nome) & (capacidadeTabela - 1));
+        while (tabela[j] >= 0 && strcmp(registros[dicionario[tabela[j]]]->nome, registros[i]->nome) != 0) {
+            j = (j + 1) & (capacidadeTabela - 1);
+        }
+        if (tabela[j] < 0) {
+            dicionario[qtdeDicionario] = i;
+            tabela[j] = qtdeDicionario++;
+        }
+        valores[i] = (unsigned long long)tabela[j];
+    }
+    buffer_varint(carga, (unsigned long long)qtdeDicionario);
+    for (int d = 0; d < qtdeDicionario; d++) {
+        const char *nome = registros[dicionario[d]]->nome;
+        size_t len = strlen(nome);
+        buffer_varint(carga, len);
+        buffer_bytes(carga, nome, len);
+    }
+    buffer_bits(carga, valores, n, largura_bits((unsigned long long)(qtdeDicionario - 1)));
+    // Cabeçalho do bloco seguido da carga
+    int montado = !carga->erro;
+    if (montado) {
+        escrever_u32(arquivo, (unsigned int)n);
+        escrever_u32(arquivo, (unsigned int)dataMin);
+        escrever_u32(arquivo, (unsigned int)dataMax);
+        escrever_u32(arquivo, (unsigned int)carga->tamanho);
+        fwrite(carga->dados, 1, carga->tamanho, arquivo);
+    }
+    free(tabela);
+    free(dicionario);
+    free(formatos);
+    free(digitos);
+    free(dias);
+    free(valores);
+    return montado;
+}
+
+// Exporta a lista no formato compactado. Retorna 1 em caso de sucesso.
+int salvar_arquivo_compactado(const Lista *lista, const char *nomeArquivo) {
+    FILE *arquivo = fopen(nomeArquivo, "wb");
+    if (arquivo == NULL) {
+        return 0;
+    }
+    fwrite(MAGICO_ARQUIVO_COMPACTADO, 1, 4, arquivo);
+    Registro **bloco = malloc(REGISTROS_POR_BLOCO * sizeof(Registro *));
+    Buffer carga = {NULL, 0, 0, 0};
+    int n = 0, montados = 1;
+    for (ELista *noAtual = lista->inicio; noAtual != NULL && montados; noAtual = noAtual->proximo) {
+        bloco[n++] = noAtual->dados;
+        if (n == REGISTROS_POR_BLOCO) {
+            montados = gravar_bloco_compactado(arquivo, bloco, n, &carga);
+            n = 0;
+        }
+    }
+    if (n > 0 && montados) {
+        montados = gravar_bloco_compactado(arquivo, bloco, n, &carga);
+    }
+    free(carga.dados);
+    free(bloco);
+    int ok = montados && !ferror(arquivo);
+    return fclose(arquivo) == 0 && ok;
+}
+
+// Decodifica a carga de um bloco em 'registros' (capacidade REGISTROS_POR_BLOCO)
+int decodificar_bloco_compactado(Leitor *leitor, int n, Registro *registros, unsigned long long *valores) {
+    for (int i = 0; i < n; i++) {
+        registros[i].idade = (int)leitor_varint(leitor);
+    }
+    long long dias = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned long long zigzag = leitor_varint(leitor);
+        dias += (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+        registros[i].entrada = (Data)dias;
+    }
+    int *formatos = malloc((size_t)n * sizeof(int));
+    int *qtdeDigitos = malloc((size_t)n * sizeof(int));
+    leitor_bits(leitor, valores, n, 2);
+    for (int i = 0; i < n; i++) formatos[i] = (int)valores[i];
+    leitor_bits(leitor, valores, n, 5);
+    for (int i = 0; i < n; i++) qtdeDigitos[i] = (int)valores[i];
+    int largura = (int)leitor_varint(leitor);
+    if (largura > 64) leitor->erro = 1;
+    if (!leitor->erro) leitor_bits(leitor, valores, n, largura);
+    for (int i = 0; i < n && !leitor->erro; i++) {
+        if (formatos[i] == RG_TEXTO) {
+            size_t len = (size_t)leitor_varint(leitor);
+            const unsigned char *texto = len < sizeof(registros[i].rg) ? leitor_bytes(leitor, len) : NULL;
+            if (texto == NULL) {
+                leitor->erro = 1;
+                break;
+            }
+            memcpy(registros[i].rg, texto, len);
+            registros[i].rg[len] = '\0';
+            continue;
+        }
+        snprintf(registros[i].rg, sizeof(registros[i].rg), "%0*llu", qtdeDigitos[i], valores[i]);
+        if (formatos[i] == RG_PONTUADO) {
+            char digitos[20];
+            memcpy(digitos, registros[i].rg, sizeof(digitos));
+            snprintf(registros[i].rg, sizeof(registros[i].rg), "%.2s.%.3s.%.3s-%c",
+                     digitos, digitos + 2, digitos + 5, digitos[8]);
+        }
+    }
+    free(formatos);
+    free(qtdeDigitos);
+    // Dicionário de nomes: guarda só as posições na carga, copiando cada nome uma única vez por registro
+    int qtdeDicionario = (int)leitor_varint(leitor);
+    if (leitor->erro || qtdeDicionario < 1 || qtdeDicionario > n) {
+        return 0;
+    }
+    const unsigned char **nomes = malloc((size_t)qtdeDicionario * sizeof(unsigned char *));
+    size_t *tamanhos = malloc((size_t)qtdeDicionario * sizeof(size_t));
+    for (int d = 0; d < qtdeDicionario && !leitor->erro; d++) {
+        tamanhos[d] = (size_t)leitor_varint(leitor);
+        nomes[d] = tamanhos[d] < sizeof(registros[0].nome) ? leitor_bytes(leitor, tamanhos[d]) : NULL;
+        if (nomes[d] == NULL) leitor->erro = 1;
+    }
+    if (!leitor->erro) {
+        leitor_bits(leitor, valores, n, largura_bits((unsigned long long)(qtdeDicionario - 1)));
+    }
+    for (int i = 0; i < n && !leitor->erro; i++) {
+        if (valores[i] >= (unsigned long long)qtdeDicionario) {
+            leitor->erro = 1;
+            break;
+        }
+        memcpy(registros[i].nome, nomes[valores[i]], tamanhos[valores[i]]);
+        registros[i].nome[tamanhos[valores[i]]] = '\0';
+    }
+    free(nomes);
+    free(tamanhos);
+    return !leitor->erro;
+}
+
+// Percorre o arquivo compactado entregando ao consumidor os registros com entrada entre
+// diaMin e diaMax (em dias desde 1970). Usa memória limitada a um bloco por vez.
+// Retorna a quantidade de registros entregues ou -1 em caso de arquivo inválido.
+long percorrer_arquivo_compactado(const char *nomeArquivo, int diaMin, int diaMax,
+                                  void (*consumidor)(void *contexto, Registro *paciente),
+                                  void *contexto, long *blocosPulados) {
+    FILE *arquivo = fopen(nomeArquivo, "rb");
+    if (arquivo == NULL) {
+        return -1;
+    }
+    char magico[4];
+    if (fread(magico, 1, 4, arquivo) != 4 || memcmp(magico, MAGICO_ARQUIVO_COMPACTADO, 4) != 0) {
+        fclose(arquivo);
+        return -1;
+    }
+    struct stat estado;
+    long tamanhoArquivo = fstat(fileno(arquivo), &estado) == 0 ? (long)estado.st_size : LONG_MAX;
+    Registro *registros = malloc(REGISTROS_POR_BLOCO * sizeof(Registro));
+    unsigned long long *valores = malloc(REGISTROS_POR_BLOCO * sizeof(unsigned long long));
+    Buffer carga = {NULL, 0, 0, 0};
+    long entregues = 0;
+    if (blocosPulados != NULL) *blocosPulados = 0;
+    unsigned int n, dataMin, dataMax, tamanho;
+    while (ler_u32(arquivo, &n)) {
+        if (!ler_u32(arquivo, &dataMin) || !ler_u32(arquivo, &dataMax) || !ler_u32(arquivo, &tamanho) ||
+            n == 0 || n > REGISTROS_POR_BLOCO || tamanho > MAX_BYTES_BLOCO) {
+            entregues = -1;
+            break;
+        }
+        // Pula o bloco inteiro se seu intervalo de datas não cruza o período pedido
+        if ((int)dataMax < diaMin || (int)dataMin > diaMax) {
+            // Um bloco pulado que passa do fim do arquivo indica arquivo truncado
+            if (fseek(arquivo, (long)tamanho, SEEK_CUR) != 0 || ftell(arquivo) > tamanhoArquivo) {
+                entregues = -1;
+                break;
+            }
+            if (blocosPulados != NULL) (*blocosPulados)++;
+            continue;
+        }
+        carga.tamanho = 0;
+        if (!buffer_reservar(&carga, tamanho) || fread(carga.dados, 1, tamanho, arquivo) != tamanho) {
+            entregues = -1;
+            break;
+        }
+        Leitor leitor = {carga.dados, tamanho, 0, 0};
+        if (!decodificar_bloco_compactado(&leitor, (int)n, registros, valores)) {
+            entregues = -1;
+            break;
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            if (registros[i].entrada >= diaMin && registros[i].entrada <= diaMax) {
+                consumidor(contexto, &registros[i]);
+                entregues++;
+            }
+        }
+    }
+    free(carga.dados);
+    free(valores);
+    free(registros);
+    fclose(arquivo);
+    return entregues;
+}
+
+// Consumidor de carga: copia o registro decodificado para o lote (registros inválidos são
+// descartados e contados)
+void adicionar_registro_decodificado(void *contexto, Registro *paciente) {
+    Lote *lote = contexto;
+    if (registro_valido(paciente)) {
+        adicionar_ao_lote(lote, *paciente);
+    } else {
+        lote->invalidos++;
+    }
+}
+
+// Importa todo o arquivo compactado para a lista (via lote). Retorna 1 em caso de sucesso.
+int carregar_arquivo_compactado(Lista *lista, const char *nomeArquivo, ResumoImportacao *resumo) {
+    memset(resumo, 0, sizeof(ResumoImportacao));
+    Lote *lote = iniciar_lote(REGISTROS_POR_BLOCO);
+    long lidos = percorrer_arquivo_compactado(nomeArquivo, INT_MIN, INT_MAX, adicionar_registro_decodificado, lote, NULL);
+    if (lidos < 0) {
+        // Descarta o que foi decodificado antes do erro
+        liberar_lote(lote);
+        return 0;
+    }
+    resumo->inseridos = lote->qtde;
+    resumo->invalidos = lote->invalidos;
+    confirmar_lote(lista, lote);
+    liberar_lote(lote);
+    return 1;
+}
+
+// Consumidor de consulta: imprime o registro sem carregá-lo na lista
+void imprimir_registro_decodificado(void *contexto, Registro *paciente) {
+    (void)contexto;
+    char data[TAMANHO_DATA_TEXTO];
+    printf("Nome: %s; Idade: %d; RG: %s; Entrada: %s\n",
+           paciente->nome, paciente->idade, paciente->rg, escrever_data_texto(paciente->entrada, data));
+}
+
+// Opção de menu: lista os pacientes de um período direto do arquivo compactado
+void consultar_periodo_compactado(const char *nomeArquivo) {
+    int diaIni, mesIni, anoIni, diaFim, mesFim, anoFim;
+    printf("\nData inicial (dd mm aaaa): ");
+    scanf("%d %d %d", &diaIni, &mesIni, &anoIni);
+    printf("Data final (dd mm aaaa): ");
+    scanf("%d %d %d", &diaFim, &mesFim, &anoFim);
+    getchar();
+    limpar_console();
+    long blocosPulados = 0;
+    long encontrados = percorrer_arquivo_compactado(nomeArquivo, dias_desde_epoca(diaIni, mesIni, anoIni),
+                                                    dias_desde_epoca(diaFim, mesFim, anoFim),
+                                                    imprimir_registro_decodificado, NULL, &blocosPulados);
+    if (encontrados < 0) {
+        printf("\nERRO!\nArquivo compactado ausente ou inválido.\n");
+    } else {
+        printf("\n%ld paciente(s) no período (%ld bloco(s) pulado(s) sem leitura).\n", encontrados, blocosPulados);
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Registro em Disco (B+tree) ** 
+// Armazenamento fora da memória: um arquivo de páginas de TAMANHO_PAGINA bytes com três B+trees
+// (primária por RG normalizado com o registro completo nas folhas; secundárias por nome e por
+// data de entrada, cujas chaves terminam no RG para serem únicas). Todo acesso passa por um
+// cache de quadros de tamanho fixo com substituição CLOCK, de modo que a memória usada é
+// limitada e cada operação lê O(log n) páginas. Remoções apagam apenas a entrada na folha
+// (sem fusão de páginas); as chaves separadoras continuam válidas para a busca.
+// As páginas usam a ordem de bytes da máquina: o arquivo não é portável entre arquiteturas.
+
+// Leitura/escrita de inteiros em posições não alinhadas da página
+unsigned int pagina_u32(const unsigned char *p) {
+    unsigned int valor;
+    memcpy(&valor, p, 4);
+    return valor;
+}
+
+void pagina_definir_u32(unsigned char *p, unsigned int valor) {
+    memcpy(p, &valor, 4);
+}
+
+int pagina_qtde(const unsigned char *pagina) {
+    return pagina[1] | (pagina[2] << 8);
+}
+
+void pagina_definir_qtde(unsigned char *pagina, int qtde) {
+    pagina[1] = (unsigned char)(qtde & 0xFF);
+    pagina[2] = (unsigned char)(qtde >> 8);
+}
+
+// Grava um quadro sujo de volta no arquivo. Retorna 0 (e mantém o quadro sujo) se a gravação falhar.
+int gravar_quadro(CachePaginas *cache, QuadroPagina *quadro) {
+    if (quadro->suja) {
+        ssize_t gravados = pwrite(cache->descritor, quadro->dados, TAMANHO_PAGINA,
+                                  (off_t)quadro->numero * TAMANHO_PAGINA);
+        if (gravados != TAMANHO_PAGINA) {
+            cache->erro = 1;
+            return 0;
+        }
+        quadro->suja = 0;
+        cache->escritas++;
+    }
+    return 1;
+}
+
+void inicializar_cache(CachePaginas *cache, int descritor, int qtdeQuadros) {
+    cache->descritor = descritor;
+    cache->qtdeQuadros = qtdeQuadros;
+    cache->quadros = calloc((size_t)qtdeQuadros, sizeof(QuadroPagina));
+    cache->memoria = malloc((size_t)qtdeQuadros * TAMANHO_PAGINA);
+    cache->qtdeBaldes = 1;
+    while (cache->qtdeBaldes < 2 * qtdeQuadros) cache->qtdeBaldes *= 2;
+    cache->baldes = malloc((size_t)cache->qtdeBaldes * sizeof(int));
+    memset(cache->baldes, -1, (size_t)cache->qtdeBaldes * sizeof(int));
+    for (int i = 0; i < qtdeQuadros; i++) {
+        cache->quadros[i].dados = cache->memoria + (size_t)i * TAMANHO_PAGINA;
+        cache->quadros[i].numero = PAGINA_NENHUMA;
+        cache->quadros[i].proximoNoBalde = -1;
+    }
+    cache->ponteiro = 0;
+    cache->leituras = cache->escritas = cache->acertos = 0;
+    cache->erro = 0;
+}
+
+// Grava todos os quadros sujos. Retorna 0 se alguma página não pôde ser gravada.
+int sincronizar_cache(CachePaginas *cache) {
+    int ok = 1;
+    for (int i = 0; i < cache->qtdeQuadros; i++) {
+        ok &= gravar_quadro(cache, &cache->quadros[i]);
+    }
+    return ok;
+}
+
+// Grava as páginas pendentes e libera o cache. Retorna 0 se alguma gravação falhou.
+int liberar_cache(CachePaginas *cache) {
+    int ok = sincronizar_cache(cache);
+    free(cache->quadros);
+    free(cache->memoria);
+    free(cache->baldes);
+    return ok;
+}
+
+// Retira o quadro do balde de sua página atual
+void desassociar_quadro(CachePaginas *cache, int indice) {
+    QuadroPagina *quadro = &cache->quadros[indice];
+    if (quadro->numero == PAGINA_NENHUMA) {
+        return;
+    }
+    int *elo = &cache->baldes[quadro->numero & (cache->qtdeBaldes - 1)];
+    while (*elo != indice) {
+        elo = &cache->quadros[*elo].proximoNoBalde;
+    }
+    *elo = quadro->proximoNoBalde;
+    quadro->numero = PAGINA_NENHUMA;
+}
+
+// Escolhe um quadro para substituição pelo algoritmo CLOCK (pula quadros fixados)
+int escolher_vitima(CachePaginas *cache) {
+    for (int voltas = 0; voltas < 2 * cache->qtdeQuadros + 1; voltas++) {
+        int indice = cache->ponteiro;
+        cache->ponteiro = (cache->ponteiro + 1) % cache->qtdeQuadros;
+        QuadroPagina *quadro = &cache->quadros[indice];
+        if (quadro->pinos > 0) {
+            continue;
+        }
+        if (quadro->referencia) {
+            quadro->referencia = 0;  // segunda chance
+            continue;
+        }
+        return indice;
+    }
+    return -1;  // todos os quadros fixados
+}
+
+// Fixa a página no cache e devolve seu conteúdo. Com 'nova', a página não é lida do disco.
+unsigned char* fixar_pagina(CachePaginas *cache, unsigned int numero, int nova) {
+    for (int i = cache->baldes[numero & (cache->qtdeBaldes - 1)]; i >= 0; i = cache->quadros[i].proximoNoBalde) {
+        if (cache->quadros[i].numero == numero) {
+            cache->quadros[i].pinos++;
+            cache->quadros[i].referencia = 1;
+            cache->acertos++;
+            return cache->quadros[i].dados;
+        }
+    }
+    int indice = escolher_vitima(cache);
+    if (indice < 0) {
+        return NULL;
+    }
+    QuadroPagina *quadro = &cache->quadros[indice];
+    if (!gravar_quadro(cache, quadro)) {
+        return NULL;  // a página suja não pode sair do cache sem ir para o disco
+    }
+    desassociar_quadro(cache, indice);
+    if (nova) {
+        memset(quadro->dados, 0, TAMANHO_PAGINA);
+        quadro->suja = 1;
+    } else {
+        ssize_t lidos = pread(cache->descritor, quadro->dados, TAMANHO_PAGINA, (off_t)numero * TAMANHO_PAGINA);
+        if (lidos < TAMANHO_PAGINA) {
+            memset(quadro->dados + (lidos > 0 ? lidos : 0), 0, TAMANHO_PAGINA - (lidos > 0 ? lidos : 0));
+        }
+        cache->leituras++;
+    }
+    quadro->numero = numero;
+    quadro->pinos = 1;
+    quadro->referencia = 1;
+    int balde = (int)(numero & (cache->qtdeBaldes - 1));
+    quadro->proximoNoBalde = cache->baldes[balde];
+    cache->baldes[balde] = indice;
+    return quadro->dados;
+}
+
+// Desafixa a página; 'alterada' marca o quadro para ser gravado antes de sair do cache
+void soltar_pagina(CachePaginas *cache, const unsigned char *dados, int alterada) {
+    int indice = (int)((dados - cache->memoria) / TAMANHO_PAGINA);
+    QuadroPagina *quadro = &cache->quadros[indice];
+    quadro->pinos--;
+    if (alterada) {
+        quadro->suja = 1;
+    }
+}
+
+// Reserva uma nova página no fim do arquivo e a devolve fixada
+unsigned char* nova_pagina(RegistroDisco *rd, unsigned int *numero, int tipo) {
+    *numero = rd->totalPaginas++;
+    unsigned char *pagina = fixar_pagina(&rd->cache, *numero, 1);
+    if (pagina != NULL) {
+        pagina[0] = (unsigned char)tipo;
+        pagina_definir_u32(pagina + 3, PAGINA_NENHUMA);
+    }
+    return pagina;
+}
+
+// Tamanhos e capacidades de entradas nas páginas de uma árvore
+int tamanho_entrada_folha(const ArvoreBMais *arvore) {
+    return arvore->tamanhoChave + arvore->tamanhoValor;
+}
+
+int capacidade_folha(const ArvoreBMais *arvore) {
+    return (TAMANHO_PAGINA - CABECALHO_PAGINA) / tamanho_entrada_folha(arvore);
+}
+
+int capacidade_interna(const ArvoreBMais *arvore) {
+    return (TAMANHO_PAGINA - CABECALHO_PAGINA - 4) / (arvore->tamanhoChave + 4);
+}
+
+unsigned char* chave_folha(const ArvoreBMais *arvore, unsigned char *pagina, int i) {
+    return pagina + CABECALHO_PAGINA + (size_t)i * tamanho_entrada_folha(arvore);
+}
+
+// Página interna: filho 0 logo após o cabeçalho, seguido de pares (chave, filho i+1)
+unsigned char* chave_interna(const ArvoreBMais *arvore, unsigned char *pagina, int i) {
+    return pagina + CABECALHO_PAGINA + 4 + (size_t)i * (arvore->tamanhoChave + 4);
+}
+
+unsigned int filho_interno(const ArvoreBMais *arvore, unsigned char *pagina, int i) {
+    return i == 0 ? pagina_u32(pagina + CABECALHO_PAGINA)
+                  : pagina_u32(chave_interna(arvore, pagina, i - 1) + arvore->tamanhoChave);
+}
+
+// Primeira posição da folha cuja chave é >= chave
+int limite_inferior_folha(const ArvoreBMais *arvore, unsigned char *pagina, const unsigned char *chave) {
+    int inicio = 0, fim = pagina_qtde(pagina);
+    while (inicio < fim) {
+        int meio = (inicio + fim) / 2;
+        if (memcmp(chave_folha(arvore, pagina, meio), chave, arvore->tamanhoChave) < 0) {
+            inicio = meio + 1;
+        } else {
+            fim = meio;
+        }
+    }
+    return inicio;
+}
+
+// Índice do filho a seguir: quantidade de separadores <= chave
+int filho_para_chave(const ArvoreBMais *arvore, unsigned char *pagina, const unsigned char *chave) {
+    int inicio = 0, fim = pagina_qtde(pagina);
+    while (inicio < fim) {
+        int meio = (inicio + fim) / 2;
+        if (memcmp(chave_interna(arvore, pagina, meio), chave, arvore->tamanhoChave) <= 0) {
+            inicio = meio + 1;
+        } else {
+            fim = meio;
+        }
+    }
+    return inicio;
+}
+
+// Inserção recursiva. Retorna 1 se a página se dividiu (chave promovida e nova página preenchidas),
+// 0 se não, e -1 se a chave já existia ou o cache esgotou.
+int inserir_bmais_recursivo(RegistroDisco *rd, ArvoreBMais *arvore, unsigned int numero,
+                            const unsigned char *chave, const unsigned char *valor,
+                            unsigned char *chavePromovida, unsigned int *novaNumero) {
+    unsigned char *pagina = fixar_pagina(&rd->cache, numero, 0);
+    if (pagina == NULL) {
+        return -1;
+    }
+    int qtde = pagina_qtde(pagina);
+    int tamChave = arvore->tamanhoChave;
+    if (pagina[0] == PAGINA_FOLHA) {
+        int tamEntrada = tamanho_entrada_folha(arvore);
+        int posicao = limite_inferior_folha(arvore, pagina, chave);
+        if (posicao < qtde && memcmp(chave_folha(arvore, pagina, posicao), chave, tamChave) == 0) {
+            soltar_pagina(&rd->cache, pagina, 0);
+            return -1;
+        }
+        if (qtde < capacidade_folha(arvore)) {
+            unsigned char *destino = chave_folha(arvore, pagina, posicao);
+            memmove(destino + tamEntrada, destino, (size_t)(qtde - posicao) * tamEntrada);
+            memcpy(destino, chave, tamChave);
+            if (arvore->tamanhoValor > 0) memcpy(destino + tamChave, valor, arvore->tamanhoValor);
+            pagina_definir_qtde(pagina, qtde + 1);
+            soltar_pagina(&rd->cache, pagina, 1);
+            return 0;
+        }
+        // Folha cheia: monta as qtde+1 entradas em ordem e divide ao meio
+        unsigned char temporario[2 * TAMANHO_PAGINA];
+        unsigned char *inicio = chave_folha(arvore, pagina, 0);
+        memcpy(temporario, inicio, (size_t)posicao * tamEntrada);
+        memcpy(temporario + (size_t)posicao * tamEntrada, chave, tamChave);
+        if (arvore->tamanhoValor > 0) {
+            memcpy(temporario + (size_t)posicao * tamEntrada + tamChave, valor, arvore->tamanhoValor);
+        }
+        memcpy(temporario + (size_t)(posicao + 1) * tamEntrada, inicio + (size_t)posicao * tamEntrada,
+               (size_t)(qtde - posicao) * tamEntrada);
+        int total = qtde + 1, esquerda = total / 2;
+        unsigned char *irma = nova_pagina(rd, novaNumero, PAGINA_FOLHA);
+        if (irma == NULL) {
+            soltar_pagina(&rd->cache, pagina, 0);
+            return -1;
+        }
+        memcpy(inicio, temporario, (size_t)esquerda * tamEntrada);
+        pagina_definir_qtde(pagina, esquerda);
+        memcpy(chave_folha(arvore, irma, 0), temporario + (size_t)esquerda * tamEntrada,
+               (size_t)(total - esquerda) * tamEntrada);
+        pagina_definir_qtde(irma, total - esquerda);
+        // Encadeia as folhas para as varreduras por intervalo
+        pagina_definir_u32(irma + 3, pagina_u32(pagina + 3));
+        pagina_definir_u32(pagina + 3, *novaNumero);
+        memcpy(chavePromovida, chave_folha(arvore, irma, 0), tamChave);
+        soltar_pagina(&rd->cache, irma, 1);
+        soltar_pagina(&rd->cache, pagina, 1);
+        return 1;
+    }
+    // Página interna: desce pelo filho adequado
+    int indiceFilho = filho_para_chave(arvore, pagina, chave);
+    unsigned int filho = filho_interno(arvore, pagina, indiceFilho);
+    unsigned char promovidaFilho[TAMANHO_MAX_CHAVE];
+    unsigned int novoFilho;
+    int resultado = inserir_bmais_recursivo(rd, arvore, filho, chave, valor, promovidaFilho, &novoFilho);
+    if (resultado != 1) {
+        soltar_pagina(&rd->cache, pagina, 0);
+        return resultado;
+    }
+    int tamPar = tamChave + 4;
+    if (qtde < capacidade_interna(arvore)) {
+        unsigned char *destino = chave_interna(arvore, pagina, indiceFilho);
+        memmove(destino + tamPar, destino, (size_t)(qtde - indiceFilho) * tamPar);
+        memcpy(destino, promovidaFilho, tamChave);
+        pagina_definir_u32(destino + tamChave, novoFilho);
+        pagina_definir_qtde(pagina, qtde + 1);
+        soltar_pagina(&rd->cache, pagina, 1);
+        return 0;
+    }
+    // Página interna cheia: a chave do meio sobe e não fica em nenhuma das metades
+    unsigned char temporario[2 * TAMANHO_PAGINA];
+    unsigned char *pares = chave_interna(arvore, pagina, 0);
+    memcpy(temporario, pares, (size_t)indiceFilho * tamPar);
+    memcpy(temporario + (size_t)indiceFilho * tamPar, promovidaFilho, tamChave);
+    pagina_definir_u32(temporario + (size_t)indiceFilho * tamPar + tamChave, novoFilho);
+    memcpy(temporario + (size_t)(indiceFilho + 1) * tamPar, pares + (size_t)indiceFilho * tamPar,
+           (size_t)(qtde - indiceFilho) * tamPar);
+    int total = qtde + 1, esquerda = total / 2;
+    unsigned char *irma = nova_pagina(rd, novaNumero, PAGINA_INTERNA);
+    if (irma == NULL) {
+        soltar_pagina(&rd->cache, pagina, 0);
+        return -1;
+    }
+    memcpy(pares, temporario, (size_t)esquerda * tamPar);
+    pagina_definir_qtde(pagina, esquerda);
+    unsigned char *meio = temporario + (size_t)esquerda * tamPar;
+    memcpy(chavePromovida, meio, tamChave);
+    pagina_definir_u32(irma + CABECALHO_PAGINA, pagina_u32(meio + tamChave));
+    memcpy(chave_interna(arvore, irma, 0), meio + tamPar, (size_t)(total - esquerda - 1) * tamPar);
+    pagina_definir_qtde(irma, total - esquerda - 1);
+    soltar_pagina(&rd->cache, irma, 1);
+    soltar_pagina(&rd->cache, pagina, 1);
+    return 1;
+}
+
+// Insere a chave na árvore, criando nova raiz quando a raiz se divide. Retorna 1 se inseriu.
+int inserir_bmais(RegistroDisco *rd, ArvoreBMais *arvore, const unsigned char *chave, const unsigned char *valor) {
+    unsigned char promovida[TAMANHO_MAX_CHAVE];
+    unsigned int novaNumero;
+    int resultado = inserir_bmais_recursivo(rd, arvore, arvore->raiz, chave, valor, promovida, &novaNumero);
+    if (resultado < 0) {
+        return 0;
+    }
+    if (resultado == 1) {
+        unsigned int numeroRaiz;
+        unsigned char *raiz = nova_pagina(rd, &numeroRaiz, PAGINA_INTERNA);
+        if (raiz == NULL) {
+            return 0;
+        }
+        pagina_definir_u32(raiz + CABECALHO_PAGINA, arvore->raiz);
+        memcpy(chave_interna(arvore, raiz, 0), promovida, arvore->tamanhoChave);
+        pagina_definir_u32(chave_interna(arvore, raiz, 0) + arvore->tamanhoChave, novaNumero);
+        pagina_definir_qtde(raiz, 1);
+        soltar_pagina(&rd->cache, raiz, 1);
+        arvore->raiz = numeroRaiz;
+    }
+    return 1;
+}
+
+// Desce até a folha que conteria a chave e a devolve fixada
+unsigned char* buscar_folha_bmais(RegistroDisco *rd, ArvoreBMais *arvore, const unsigned char *chave) {
+    unsigned char *pagina = fixar_pagina(&rd->cache, arvore->raiz, 0);
+    while (pagina != NULL && pagina[0] == PAGINA_INTERNA) {
+        unsigned int filho = filho_interno(arvore, pagina, filho_para_chave(arvore, pagina, chave));
+        soltar_pagina(&rd->cache, pagina, 0);
+        pagina = fixar_pagina(&rd->cache, filho, 0);
+    }
+    return pagina;
+}
+
+// Busca exata: copia o valor para 'valor' (se não for NULL) e retorna 1 se a chave existe
+int buscar_bmais(RegistroDisco *rd, ArvoreBMais *arvore, const unsigned char *chave, unsigned char *valor) {
+    unsigned char *folha = buscar_folha_bmais(rd, arvore, chave);
+    if (folha == NULL) {
+        return 0;
+    }
+    int posicao = limite_inferior_folha(arvore, folha, chave);
+    int achou = posicao < pagina_qtde(folha) &&
+                memcmp(chave_folha(arvore, folha, posicao), chave, arvore->tamanhoChave) == 0;
+    if (achou && valor != NULL) {
+        memcpy(valor, chave_folha(arvore, folha, posicao) + arvore->tamanhoChave, arvore->tamanhoValor);
+    }
+    soltar_pagina(&rd->cache, folha, 0);
+    return achou;
+}
+
+// Substitui o valor de uma chave existente
+int regravar_bmais(RegistroDisco *rd, ArvoreBMais *arvore, const unsigned char *chave, const unsigned char *valor) {
+    unsigned char *folha = buscar_folha_bmais(rd, arvore, chave);
+    if (folha == NULL) {
+        return 0;
+    }
+    int posicao = limite_inferior_folha(arvore, folha, chave);
+    int achou = posicao < pagina_qtde(folha) &&
+                memcmp(chave_folha(arvore, folha, posicao), chave, arvore->tamanhoChave) == 0;
+    if (achou) {
+        memcpy(chave_folha(arvore, folha, posicao) + arvore->tamanhoChave, valor, arvore->tamanhoValor);
+    }
+    soltar_pagina(&rd->cache, folha, achou);
+    return achou;
+}
+
+// Remove a chave da folha (sem fusão de páginas)
+int remover_bmais(RegistroDisco *rd, ArvoreBMais *arvore, const unsigned char *chave) {
+    unsigned char *folha = buscar_folha_bmais(rd, arvore, chave);
+    if (folha == NULL) {
+        return 0;
+    }
+    int qtde = pagina_qtde(folha);
+    int posicao = limite_inferior_folha(arvore, folha, chave);
+    int achou = posicao < qtde && memcmp(chave_folha(arvore, folha, posicao), chave, arvore->tamanhoChave) == 0;
+    if (achou) {
+        int tamEntrada = tamanho_entrada_folha(arvore);
+        unsigned char *destino = chave_folha(arvore, folha, posicao);
+        memmove(destino, destino + tamEntrada, (size_t)(qtde - posicao - 1) * tamEntrada);
+        pagina_definir_qtde(folha, qtde - 1);
+    }
+    soltar_pagina(&rd->cache, folha, achou);
+    return achou;
+}
+
+// Percorre as entradas com chave em [chaveMin, chaveMax] seguindo o encadeamento das folhas.
+// O consumidor recebe chave e valor; se retornar 0 a varredura é interrompida.
+long varrer_bmais(RegistroDisco *rd, ArvoreBMais *arvore, const unsigned char *chaveMin, const unsigned char *chaveMax,
+                  int (*consumidor)(void *contexto, const unsigned char *chave, const unsigned char *valor),
+                  void *contexto) {
+    long visitadas = 0;
+    unsigned char *folha = buscar_folha_bmais(rd, arvore, chaveMin);
+    int posicao = folha ? limite_inferior_folha(arvore, folha, chaveMin) : 0;
+    // As entradas são copiadas antes de chamar o consumidor, que pode consultar outras árvores
+    unsigned char entrada[TAMANHO_MAX_CHAVE + TAMANHO_REGISTRO_DISCO];
+    while (folha != NULL) {
+        if (posicao >= pagina_qtde(folha)) {
+            unsigned int proxima = pagina_u32(folha + 3);
+            soltar_pagina(&rd->cache, folha, 0);
+            folha = proxima == PAGINA_NENHUMA ? NULL : fixar_pagina(&rd->cache, proxima, 0);
+            posicao = 0;
+            continue;
+        }
+        memcpy(entrada, chave_folha(arvore, folha, posicao), tamanho_entrada_folha(arvore));
+        if (memcmp(entrada, chaveMax, arvore->tamanhoChave) > 0) {
+            break;
+        }
+        posicao++;
+        visitadas++;
+        if (!consumidor(contexto, entrada, entrada + arvore->tamanhoChave)) {
+            break;
+        }
+    }
+    if (folha != NULL) {
+        soltar_pagina(&rd->cache, folha, 0);
+    }
+    return visitadas;
+}
+
+// Chaves: RG só com dígitos (completado com zeros binários), nome + RG e data (big-endian) + RG,
+// de forma que a comparação byte a byte respeite a ordem desejada
+void chave_primaria_disco(const char *rg, unsigned char *chave) {
+    char rgNumerico[20];
+    extrair_numeros_rg(rg, rgNumerico);
+    memset(chave, 0, TAMANHO_CHAVE_RG);
+    memcpy(chave, rgNumerico, strlen(rgNumerico));
+}
+
+void chave_nome_disco(const char *nome, const unsigned char *chaveRg, unsigned char *chave) {
+    // Nome truncado e completado com zeros: sempre termina em '\0' dentro do campo
+    memset(chave, 0, TAMANHO_NOME_DISCO);
+    memcpy(chave, nome, strnlen(nome, TAMANHO_NOME_DISCO - 1));
+    memcpy(chave + TAMANHO_NOME_DISCO, chaveRg, TAMANHO_CHAVE_RG);
+}
+
+void chave_data_disco(int dias, const unsigned char *chaveRg, unsigned char *chave) {
+    unsigned int ordenavel = (unsigned int)dias ^ 0x80000000u;
+    chave[0] = (unsigned char)(ordenavel >> 24);
+    chave[1] = (unsigned char)(ordenavel >> 16);
+    chave[2] = (unsigned char)(ordenavel >> 8);
+    chave[3] = (unsigned char)ordenavel;
+    memcpy(chave + 4, chaveRg, TAMANHO_CHAVE_RG);
+}
+
+// Serialização do registro na folha da árvore primária
+void serializar_registro_disco(const Registro *paciente, unsigned char *valor) {
+    DataCalendario entrada = data_calendario(paciente->entrada);
+    int campos[4] = {paciente->idade, entrada.dia, entrada.mes, entrada.ano};
+    memset(valor, 0, TAMANHO_REGISTRO_DISCO);
+    memcpy(valor, paciente->nome, strnlen(paciente->nome, TAMANHO_NOME_DISCO - 1));
+    memcpy(valor + TAMANHO_NOME_DISCO, paciente->rg, strnlen(paciente->rg, sizeof(paciente->rg) - 1));
+    memcpy(valor + TAMANHO_NOME_DISCO + sizeof(paciente->rg), campos, sizeof(campos));
+}
+
+// Recupera o registro (a data continua gravada como dia, mês e ano na página)
+void desserializar_registro_disco(const unsigned char *valor, Registro *paciente) {
+    int campos[4];
+    memcpy(paciente->nome, valor, TAMANHO_NOME_DISCO);
+    paciente->nome[TAMANHO_NOME_DISCO - 1] = '\0';
+    memcpy(paciente->rg, valor + TAMANHO_NOME_DISCO, sizeof(paciente->rg));
+    paciente->rg[sizeof(paciente->rg) - 1] = '\0';
+    memcpy(campos, valor + TAMANHO_NOME_DISCO + sizeof(paciente->rg), sizeof(campos));
+    paciente->idade = campos[0];
+    paciente->entrada = dias_desde_epoca(campos[1], campos[2], campos[3]);
+}
+
+// Atualiza a página de metadados (raízes das árvores, total de páginas e de registros) no cache
+int gravar_meta_disco(RegistroDisco *rd) {
+    unsigned char *meta = fixar_pagina(&rd->cache, 0, 0);
+    if (meta == NULL) {
+        return 0;
+    }
+    memcpy(meta, MAGICO_REGISTRO_DISCO, 4);
+    pagina_definir_u32(meta + 4, rd->totalPaginas);
+    pagina_definir_u32(meta + 8, (unsigned int)rd->qtde);
+    for (int i = 0; i < ARVORES_DISCO; i++) {
+        pagina_definir_u32(meta + 12 + 4 * i, rd->arvores[i].raiz);
+    }
+    soltar_pagina(&rd->cache, meta, 1);
+    return 1;
+}
+
+// Confirma uma alteração: grava primeiro as páginas das árvores e só depois os metadados,
+// para que o arquivo nunca aponte para raízes que ainda não chegaram ao disco
+int confirmar_registro_disco(RegistroDisco *rd) {
+    if (!sincronizar_cache(&rd->cache) || !gravar_meta_disco(rd)) {
+        return 0;
+    }
+    return sincronizar_cache(&rd->cache);
+}
+
+// Abre (ou cria) o arquivo do registro em disco com um cache de 'quadros' páginas
+RegistroDisco* abrir_registro_disco(const char *nomeArquivo, int quadros) {
+    int descritor = open(nomeArquivo, O_RDWR | O_CREAT, 0644);
+    if (descritor < 0) {
+        return NULL;
+    }
+    RegistroDisco *rd = malloc(sizeof(RegistroDisco));
+    inicializar_cache(&rd->cache, descritor, quadros < QUADROS_MINIMOS ? QUADROS_MINIMOS : quadros);
+    int tamanhosChave[ARVORES_DISCO] = {TAMANHO_CHAVE_RG, TAMANHO_NOME_DISCO + TAMANHO_CHAVE_RG, 4 + TAMANHO_CHAVE_RG};
+    int tamanhosValor[ARVORES_DISCO] = {TAMANHO_REGISTRO_DISCO, 0, 0};
+    for (int i = 0; i < ARVORES_DISCO; i++) {
+        rd->arvores[i].tamanhoChave = tamanhosChave[i];
+        rd->arvores[i].tamanhoValor = tamanhosValor[i];
+    }
+    off_t tamanho = lseek(descritor, 0, SEEK_END);
+    if (tamanho >= TAMANHO_PAGINA) {
+        unsigned char *meta = fixar_pagina(&rd->cache, 0, 0);
+        if (memcmp(meta, MAGICO_REGISTRO_DISCO, 4) != 0) {
+            soltar_pagina(&rd->cache, meta, 0);
+            liberar_cache(&rd->cache);
+            close(descritor);
+            free(rd);
+            return NULL;
+        }
+        rd->totalPaginas = pagina_u32(meta + 4);
+        rd->qtde = pagina_u32(meta + 8);
+        for (int i = 0; i < ARVORES_DISCO; i++) {
+            rd->arvores[i].raiz = pagina_u32(meta + 12 + 4 * i);
+        }
+        soltar_pagina(&rd->cache, meta, 0);
+        return rd;
+    }
+    // Arquivo novo: página 0 de metadados e uma folha vazia como raiz de cada árvore
+    rd->totalPaginas = 1;
+    rd->qtde = 0;
+    soltar_pagina(&rd->cache, fixar_pagina(&rd->cache, 0, 1), 1);
+    for (int i = 0; i < ARVORES_DISCO; i++) {
+        soltar_pagina(&rd->cache, nova_pagina(rd, &rd->arvores[i].raiz, PAGINA_FOLHA), 1);
+    }
+    confirmar_registro_disco(rd);
+    return rd;
+}
+
+// Grava metadados e páginas sujas e fecha o arquivo. Retorna 0 se alguma gravação falhou.
+int fechar_registro_disco(RegistroDisco *rd) {
+    int ok = confirmar_registro_disco(rd);
+    ok &= liberar_cache(&rd->cache) && !rd->cache.erro;
+    ok &= close(rd->cache.descritor) == 0;
+    free(rd);
+    return ok;
+}
+
+// Insere as chaves secundárias (nome e data) de um registro. Se a segunda falhar,
+// a primeira é retirada, de modo que o registro fica nas duas árvores ou em nenhuma.
+int indexar_secundarias_disco(RegistroDisco *rd, const Registro *paciente, const unsigned char *chaveRg) {
+    unsigned char chaveNome[TAMANHO_MAX_CHAVE], chaveData[TAMANHO_MAX_CHAVE];
+    chave_nome_disco(paciente->nome, chaveRg, chaveNome);
+    chave_data_disco(paciente->entrada, chaveRg, chaveData);
+    if (!inserir_bmais(rd, &rd->arvores[ARVORE_NOME], chaveNome, NULL)) {
+        return 0;
+    }
+    if (!inserir_bmais(rd, &rd->arvores[ARVORE_DATA], chaveData, NULL)) {
+        remover_bmais(rd, &rd->arvores[ARVORE_NOME], chaveNome);
+        return 0;
+    }
+    return 1;
+}
+
+// Retira as chaves secundárias (nome e data) de um registro
+void desindexar_secundarias_disco(RegistroDisco *rd, const Registro *paciente, const unsigned char *chaveRg) {
+    unsigned char chave[TAMANHO_MAX_CHAVE];
+    chave_nome_disco(paciente->nome, chaveRg, chave);
+    remover_bmais(rd, &rd->arvores[ARVORE_NOME], chave);
+    chave_data_disco(paciente->entrada, chaveRg, chave);
+    remover_bmais(rd, &rd->arvores[ARVORE_DATA], chave);
+}
+
+// Insere o registro nas três árvores sem confirmar no disco: a primária vai primeiro (ela
+// detecta o RG repetido) e é desfeita se as secundárias não puderem ser inseridas
+int inserir_registro_disco(RegistroDisco *rd, const Registro *paciente) {
+    unsigned char chaveRg[TAMANHO_CHAVE_RG];
+    unsigned char valor[TAMANHO_REGISTRO_DISCO];
+    chave_primaria_disco(paciente->rg, chaveRg);
+    serializar_registro_disco(paciente, valor);
+    if (!inserir_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveRg, valor)) {
+        return 0;
+    }
+    if (!indexar_secundarias_disco(rd, paciente, chaveRg)) {
+        remover_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveRg);
+        return 0;
+    }
+    rd->qtde++;
+    return 1;
+}
+
+// Cadastra um paciente no disco. Retorna 0 se o RG já existir ou o cache esgotar.
+int disco_cadastrar(RegistroDisco *rd, const Registro *paciente) {
+    if (!inserir_registro_disco(rd, paciente)) {
+        return 0;
+    }
+    confirmar_registro_disco(rd);
+    return 1;
+}
+
+// Consulta por RG (em qualquer formatação): O(log n) páginas
+int disco_consultar_rg(RegistroDisco *rd, const char *rg, Registro *paciente) {
+    unsigned char chaveRg[TAMANHO_CHAVE_RG];
+    unsigned char valor[TAMANHO_REGISTRO_DISCO];
+    chave_primaria_disco(rg, chaveRg);
+    if (!buscar_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveRg, valor)) {
+        return 0;
+    }
+    desserializar_registro_disco(valor, paciente);
+    return 1;
+}
+
+// Consumidor da busca por nome: guarda o RG da primeira entrada e para a varredura
+int capturar_rg_por_nome(void *contexto, const unsigned char *chave, const unsigned char *valor) {
+    (void)valor;
+    memcpy(contexto, chave + TAMANHO_NOME_DISCO, TAMANHO_CHAVE_RG);
+    return 0;
+}
+
+// Consulta pelo nome exato usando o índice secundário: O(log n) páginas
+int disco_consultar_nome(RegistroDisco *rd, const char *nome, Registro *paciente) {
+    unsigned char chaveMin[TAMANHO_MAX_CHAVE], chaveMax[TAMANHO_MAX_CHAVE];
+    unsigned char chaveRg[TAMANHO_CHAVE_RG];
+    unsigned char rgMin[TAMANHO_CHAVE_RG] = {0};
+    chave_nome_disco(nome, rgMin, chaveMin);
+    memcpy(chaveMax, chaveMin, TAMANHO_NOME_DISCO);
+    memset(chaveMax + TAMANHO_NOME_DISCO, 0xFF, TAMANHO_CHAVE_RG);
+    if (varrer_bmais(rd, &rd->arvores[ARVORE_NOME], chaveMin, chaveMax, capturar_rg_por_nome, chaveRg) == 0) {
+        return 0;
+    }
+    unsigned char valor[TAMANHO_REGISTRO_DISCO];
+    if (!buscar_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveRg, valor)) {
+        return 0;
+    }
+    desserializar_registro_disco(valor, paciente);
+    return 1;
+}
+
+// Atualiza o paciente com o RG informado para os dados em 'novo' (o RG também pode mudar)
+int disco_atualizar(RegistroDisco *rd, const char *rg, const Registro *novo) {
+    Registro antigo;
+    if (!disco_consultar_rg(rd, rg, &antigo)) {
+        return 0;
+    }
+    unsigned char chaveAntiga[TAMANHO_CHAVE_RG], chaveNova[TAMANHO_CHAVE_RG];
+    chave_primaria_disco(antigo.rg, chaveAntiga);
+    chave_primaria_disco(novo->rg, chaveNova);
+    unsigned char valor[TAMANHO_REGISTRO_DISCO];
+    serializar_registro_disco(novo, valor);
+    int rgAlterado = memcmp(chaveAntiga, chaveNova, TAMANHO_CHAVE_RG) != 0;
+    // RG alterado: a entrada muda de posição na árvore primária
+    if (rgAlterado && !inserir_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveNova, valor)) {
+        return 0;  // novo RG já pertence a outro paciente (ou o cache esgotou)
+    }
+    // Troca as secundárias; se as novas não entrarem, as antigas voltam e a primária é desfeita
+    desindexar_secundarias_disco(rd, &antigo, chaveAntiga);
+    if (!indexar_secundarias_disco(rd, novo, chaveNova)) {
+        indexar_secundarias_disco(rd, &antigo, chaveAntiga);
+        if (rgAlterado) {
+            remover_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveNova);
+        }
+        return 0;
+    }
+    if (rgAlterado) {
+        remover_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveAntiga);
+    } else {
+        regravar_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveAntiga, valor);
+    }
+    confirmar_registro_disco(rd);
+    return 1;
+}
+
+// Remove o paciente com o RG informado das três árvores
+int disco_remover(RegistroDisco *rd, const char *rg) {
+    Registro antigo;
+    if (!disco_consultar_rg(rd, rg, &antigo)) {
+        return 0;
+    }
+    unsigned char chaveRg[TAMANHO_CHAVE_RG];
+    chave_primaria_disco(antigo.rg, chaveRg);
+    remover_bmais(rd, &rd->arvores[ARVORE_PRIMARIA], chaveRg);
+    desindexar_secundarias_disco(rd, &antigo, chaveRg);
+    rd->qtde--;
+    confirmar_registro_disco(rd);
+    return 1;
+}
+
+// Consumidor da varredura por data: lê o registro na árvore primária e o entrega
+int entregar_registro_periodo(void *contexto, const unsigned char *chave, const unsigned char *valor) {
+    (void)valor;
+    ContextoPeriodoDisco *periodo = contexto;
+    unsigned char registro[TAMANHO_REGISTRO_DISCO];
+    if (buscar_bmais(periodo->rd, &periodo->rd->arvores[ARVORE_PRIMARIA], chave + 4, registro)) {
+        Registro paciente;
+        desserializar_registro_disco(registro, &paciente);
+        periodo->consumidor(periodo->contexto, &paciente);
+    }
+    return 1;
+}
+
+// Lista em ordem de data os pacientes com entrada entre diaMin e diaMax (dias desde 1970)
+long disco_listar_periodo(RegistroDisco *rd, int diaMin, int diaMax,
+                          void (*consumidor)(void *contexto, Registro *paciente), void *contexto) {
+    unsigned char chaveMin[TAMANHO_MAX_CHAVE], chaveMax[TAMANHO_MAX_CHAVE];
+    unsigned char rgMin[TAMANHO_CHAVE_RG], rgMax[TAMANHO_CHAVE_RG];
+    memset(rgMin, 0, sizeof(rgMin));
+    memset(rgMax, 0xFF, sizeof(rgMax));
+    chave_data_disco(diaMin, rgMin, chaveMin);
+    chave_data_disco(diaMax, rgMax, chaveMax);
+    ContextoPeriodoDisco periodo = {rd, consumidor, contexto};
+    return varrer_bmais(rd, &rd->arvores[ARVORE_DATA], chaveMin, chaveMax, entregar_registro_periodo, &periodo);
+}
+
+// Copia o cadastro em memória para o disco. O disco guarda um registro por RG: com RGs
+// repetidos, vai o paciente que o índice de RGs devolve. Retorna quantos foram inseridos.
+long disco_importar_lista(RegistroDisco *rd, const Lista *lista) {
+    long inseridos = 0;
+    for (ELista *noAtual = lista->inicio; noAtual != NULL; noAtual = noAtual->proximo) {
+        if (consultar_paciente_rg(lista, noAtual->dados->rg) == noAtual) {
+            inseridos += inserir_registro_disco(rd, noAtual->dados);
+        }
+    }
+    confirmar_registro_disco(rd);
+    return inseridos;
+}
+
+// Leva ao disco o estado de um RG no cadastro em memória: grava o paciente que o índice de
+// RGs devolve para ele ou, se não restou nenhum, retira o RG do disco
+void sincronizar_rg_disco(RegistroDisco *rd, const Lista *lista, const char *rg) {
+    ELista *no = consultar_paciente_rg(lista, rg);
+    if (no == NULL) {
+        disco_remover(rd, rg);
+    } else if (!disco_atualizar(rd, rg, no->dados)) {
+        disco_cadastrar(rd, no->dados);
+    }
+}
+
+// Fecha o registro anterior (se houver) e recria o arquivo com o conteúdo atual do cadastro.
+// Retorna NULL se o arquivo não pôde ser criado.
+RegistroDisco* recriar_registro_disco(RegistroDisco *anterior, const Lista *lista) {
+    if (anterior != NULL) {
+        fechar_registro_disco(anterior);
+    }
+    unlink(ARQUIVO_REGISTRO_DISCO);
+    RegistroDisco *rd = abrir_registro_disco(ARQUIVO_REGISTRO_DISCO, QUADROS_PADRAO);
+    if (rd != NULL) {
+        disco_importar_lista(rd, lista);
+    }
+    return rd;
+}
+
+// Lê os campos de um paciente do teclado. Retorna 0 se a idade ou a data não são válidas.
+int ler_paciente_teclado(Registro *paciente) {
+    printf("\nNome: ");
+    fgets(paciente->nome, sizeof(paciente->nome), stdin);
+    paciente->nome[strcspn(paciente->nome, "\n")] = '\0';
+    printf("Idade: ");
+    scanf("%d", &paciente->idade);
+    getchar();
+    printf("RG: ");
+    fgets(paciente->rg, sizeof(paciente->rg), stdin);
+    paciente->rg[strcspn(paciente->rg, "\n")] = '\0';
+    printf("Data de entrada (dd mm aaaa): ");
+    DataCalendario data;
+    scanf("%d %d %d", &data.dia, &data.mes, &data.ano);
+    getchar();
+    paciente->entrada = cria_data(data.dia, data.mes, data.ano);
+    return registro_valido(paciente);
+}
+
+// Submenu do registro em disco (arquivo dbPacientes.bpt). Ativado, ele passa a acompanhar o
+// cadastro da sessão: as operações do menu Cadastro gravam também no arquivo e a consulta por
+// nome usa o índice em disco.
+void menu_registro_disco(Sessao *sessao) {
+    int opcao;
+    do {
+        limpar_console();
+        printf("\n╔════════════════════════════════════════════╗\n");
+        printf("║        REGISTRO EM DISCO (B+TREE)          ║\n");
+        printf("╠════════════════════════════════════════════╣\n");
+        printf("║ 1 - Ativar/desativar o registro em disco   ║\n");
+        printf("║ 2 - Listar por período de entrada          ║\n");
+        printf("║ 3 - Estatísticas do cache de páginas       ║\n");
+        printf("║ 0 - Voltar                                 ║\n");
+        printf("╚════════════════════════════════════════════╝\n");
+        RegistroDisco *rd = sessao->disco;
+        if (rd == NULL) {
+            printf("\nCadastro apenas em memória.");
+        } else {
+            printf("\nCadastro espelhado em %s: %ld paciente(s) em disco.", ARQUIVO_REGISTRO_DISCO, rd->qtde);
+            if (rd->cache.erro) {
+                printf("\nATENÇÃO: houve falha ao gravar páginas em %s.", ARQUIVO_REGISTRO_DISCO);
+            }
+        }
+        printf("\nSelecione uma opção: ");
+        scanf("%d", &opcao);
+        getchar();
+        switch (opcao) {
+            case 1:
+                limpar_console();
+                if (rd != NULL) {
+                    sessao->disco = NULL;
+                    if (fechar_registro_disco(rd)) {
+                        printf("\nRegistro em disco desativado; o cadastro segue apenas em memória.\n");
+                    } else {
+                        printf("\nERRO!\nFalha ao gravar %s; alterações podem ter se perdido.\n", ARQUIVO_REGISTRO_DISCO);
+                    }
+                } else {
+                    // O arquivo é refeito a partir do cadastro, que continua sendo a referência
+                    sessao->disco = recriar_registro_disco(NULL, sessao->lista);
+                    if (sessao->disco != NULL) {
+                        printf("\nSUCESSO!\n%ld paciente(s) gravados em %s.\n", sessao->disco->qtde, ARQUIVO_REGISTRO_DISCO);
+                    } else {
+                        printf("\nERRO!\nNão foi possível criar %s.\n", ARQUIVO_REGISTRO_DISCO);
+                    }
+                }
+                limpar_console_dinamico();
+                break;
+            case 2: {
+                if (rd == NULL) {
+                    printf("\nAtive o registro em disco primeiro.\n");
+                    limpar_console_dinamico();
+                    break;
+                }
+                int diaIni, mesIni, anoIni, diaFim, mesFim, anoFim;
+                printf("\nData inicial (dd mm aaaa): ");
+                scanf("%d %d %d", &diaIni, &mesIni, &anoIni);
+                printf("Data final (dd mm aaaa): ");
+                scanf("%d %d %d", &diaFim, &mesFim, &anoFim);
+                getchar();
+                limpar_console();
+                long qtde = disco_listar_periodo(rd, dias_desde_epoca(diaIni, mesIni, anoIni),
+                                                 dias_desde_epoca(diaFim, mesFim, anoFim),
+                                                 imprimir_registro_decodificado, NULL);
+                printf("\n%ld paciente(s) no período.\n", qtde);
+                limpar_console_dinamico();
+                break;
+            }
+            case 3:
+                limpar_console();
+                if (rd == NULL) {
+                    printf("\nAtive o registro em disco primeiro.\n");
+                } else {
+                    printf("\nPáginas no arquivo: %u | Quadros no cache: %d (%d KB)\n",
+                           rd->totalPaginas, rd->cache.qtdeQuadros, rd->cache.qtdeQuadros * TAMANHO_PAGINA / 1024);
+                    printf("Acertos: %ld | Leituras do disco: %ld | Escritas: %ld\n",
+                           rd->cache.acertos, rd->cache.leituras, rd->cache.escritas);
+                }
+                limpar_console_dinamico();
+                break;
+            case 0:
+                break;
+            default:
+                printf("\nOpção inválida. Tente novamente.\n");
+                limpar_console_dinamico();
+        }
+    } while (opcao != 0);
+}
+
+// ** Módulo Varredura por Colunas ** 
+
+// Consumidor do relatório: imprime só os primeiros registros e conta o restante
+void imprimir_relatorio_limitado(void *contexto, Registro *paciente) {
+    long *restantes = contexto;
+    if (*restantes > 0) {
+        imprimir_registro_decodificado(NULL, paciente);
+        (*restantes)--;
+    }
+}
+
+// Extrai (ou atualiza, se a lista mudou) as colunas de idade, data, mês e dígitos do RG
+void extrair_colunas(ColunasPacientes *colunas, const Lista *lista) {
+    if (colunas->registros != NULL && colunas->versao == lista->versao && colunas->qtde == lista->qtde) {
+        return;
+    }
+    free(colunas->registros);
+    free(colunas->idades);
+    free(colunas->dias);
+    free(colunas->meses);
+    free(colunas->digitosRg);
+    int n = lista->qtde;
+    colunas->qtde = n;
+    colunas->versao = lista->versao;
+    colunas->registros = malloc((size_t)(n + 1) * sizeof(Registro *));
+    colunas->idades = malloc((size_t)(n + 1) * sizeof(int));
+    colunas->dias = malloc((size_t)(n + 1) * sizeof(int));
+    colunas->meses = malloc((size_t)(n + 1) * sizeof(int));
+    // A linha de folga permite aos núcleos vetoriais ler além do último RG
+    colunas->digitosRg = calloc((size_t)(n + 1), LARGURA_RG_COLUNA);
+    int i = 0;
+    for (ELista *no = lista->inicio; no != NULL && i < n; no = no->proximo, i++) {
+        const Registro *r = no->dados;
+        colunas->registros[i] = no->dados;
+        colunas->idades[i] = r->idade;
+        colunas->dias[i] = r->entrada;
+        colunas->meses[i] = data_calendario(r->entrada).mes;
+        extrair_numeros_rg(r->rg, colunas->digitosRg + (size_t)i * LARGURA_RG_COLUNA);
+    }
+}
+
+void liberar_colunas(ColunasPacientes *colunas) {
+    free(colunas->registros);
+    free(colunas->idades);
+    free(colunas->dias);
+    free(colunas->meses);
+    free(colunas->digitosRg);
+    memset(colunas, 0, sizeof(ColunasPacientes));
+}
+
+// Cria um mapa com todas as linhas selecionadas (os bits além da última linha ficam zerados)
+void iniciar_mapa(MapaSelecao *mapa, int qtde) {
+    mapa->qtde = qtde;
+    mapa->qtdePalavras = (qtde + 63) / 64;
+    mapa->palavras = malloc((size_t)(mapa->qtdePalavras > 0 ? mapa->qtdePalavras : 1) * sizeof(unsigned long long));
+    for (int w = 0; w < mapa->qtdePalavras; w++) {
+        mapa->palavras[w] = ~0ULL;
+    }
+    if (qtde % 64 != 0) {
+        mapa->palavras[mapa->qtdePalavras - 1] = (1ULL << (qtde % 64)) - 1;
+    }
+}
+
+void liberar_mapa(MapaSelecao *mapa) {
+    free(mapa->palavras);
+    mapa->palavras = NULL;
+}
+
+// Linhas selecionadas no mapa
+long contar_selecao(const MapaSelecao *mapa) {
+    long total = 0;
+    for (int w = 0; w < mapa->qtdePalavras; w++) {
+        total += __builtin_popcountll(mapa->palavras[w]);
+    }
+    return total;
+}
+
+// Entrega ao consumidor os registros das linhas selecionadas, na ordem das colunas
+void percorrer_selecao(const MapaSelecao *mapa, const ColunasPacientes *colunas,
+                       void (*consumidor)(void *contexto, Registro *paciente), void *contexto) {
+    for (int w = 0; w < mapa->qtdePalavras; w++) {
+        for (unsigned long long bits = mapa->palavras[w]; bits != 0; bits &= bits - 1) {
+            consumidor(contexto, colunas->registros[w * 64 + __builtin_ctzll(bits)]);
+        }
+    }
+}
+
+// Bits das linhas [inicio, fim) cujo valor está em [minimo, maximo]
+unsigned long long faixa_palavra_escalar(const int *coluna, int inicio, int fim, int minimo, int maximo) {
+    unsigned long long bits = 0;
+    for (int i = inicio; i < fim; i++) {
+        bits |= (unsigned long long)(coluna[i] >= minimo && coluna[i] <= maximo) << (i - inicio);
+    }
+    return bits;
+}
+
+// Núcleos de filtro por faixa: restringem o mapa às linhas com valor em [minimo, maximo].
+// Palavras já zeradas por condições anteriores são puladas.
+void filtrar_faixa_escalar(const int *coluna, int n, int minimo, int maximo, unsigned long long *mapa) {
+    for (int w = 0; w * 64 < n; w++) {
+        if (mapa[w] != 0) {
+            int fim = (w + 1) * 64 < n ? (w + 1) * 64 : n;
+            mapa[w] &= faixa_palavra_escalar(coluna, w * 64, fim, minimo, maximo);
+        }
+    }
+}
+
+// Núcleos de filtro por dígitos do RG: mantêm as linhas cujo RG contém o trecho
+void filtrar_rg_escalar(const char *digitos, int n, const char *trecho, unsigned long long *mapa) {
+    for (int w = 0; w * 64 < n; w++) {
+        for (unsigned long long bits = mapa[w]; bits != 0; bits &= bits - 1) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            if (strstr(digitos + (size_t)i * LARGURA_RG_COLUNA, trecho) == NULL) {
+                mapa[w] &= ~(1ULL << (i - w * 64));
+            }
+        }
+    }
+}
+
+#ifdef VARREDURA_X86
+void filtrar_faixa_sse2(const int *coluna, int n, int minimo, int maximo, unsigned long long *mapa) {
+    __m128i vMinimo = _mm_set1_epi32(minimo), vMaximo = _mm_set1_epi32(maximo);
+    for (int w = 0; w * 64 < n; w++) {
+        if (mapa[w] == 0) continue;
+        int base = w * 64;
+        if (base + 64 > n) {
+            mapa[w] &= faixa_palavra_escalar(coluna, base, n, minimo, maximo);
+            continue;
+        }
+        unsigned long long bits = 0;
+        for (int k = 0; k < 64; k += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(coluna + base + k));
+            __m128i fora = _mm_or_si128(_mm_cmplt_epi32(v, vMinimo), _mm_cmpgt_epi32(v, vMaximo));
+            unsigned dentro = ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(fora)) & 0xF;
+            bits |= (unsigned long long)dentro << k;
+        }
+        mapa[w] &= bits;
+    }
+}
+
+__attribute__((target("avx2")))
+void filtrar_faixa_avx2(const int *coluna, int n, int minimo, int maximo, unsigned long long *mapa) {
+    __m256i vMinimo = _mm256_set1_epi32(minimo), vMaximo = _mm256_set1_epi32(maximo);
+    for (int w = 0; w * 64 < n; w++) {
+        if (mapa[w] == 0) continue;
+        int base = w * 64;
+        if (base + 64 > n) {
+            mapa[w] &= faixa_palavra_escalar(coluna, base, n, minimo, maximo);
+            continue;
+        }
+        unsigned long long bits = 0;
+        for (int k = 0; k < 64; k += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(coluna + base + k));
+            __m256i fora = _mm256_or_si256(_mm256_cmpgt_epi32(vMinimo, v), _mm256_cmpgt_epi32(v, vMaximo));
+            unsigned dentro = ~(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(fora)) & 0xFF;
+            bits |= (unsigned long long)dentro << k;
+        }
+        mapa[w] &= bits;
+    }
+}
+
+// Busca vetorial do trecho: para cada posição inicial p do RG, compara o byte p + j com o
+// j-ésimo dígito do trecho. Os zeros ao final de cada RG impedem casamentos fora dele.
+void filtrar_rg_sse2(const char *digitos, int n, const char *trecho, unsigned long long *mapa) {
+    int tamanho = (int)strlen(trecho);
+    __m128i alvo[20];
+    for (int j = 0; j < tamanho; j++) {
+        alvo[j] = _mm_set1_epi8(trecho[j]);
+    }
+    for (int w = 0; w * 64 < n; w++) {
+        for (unsigned long long bits = mapa[w]; bits != 0; bits &= bits - 1) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            const char *rg = digitos + (size_t)i * LARGURA_RG_COLUNA;
+            __m128i baixo = _mm_set1_epi8(-1), alto = _mm_set1_epi8(-1);
+            for (int j = 0; j < tamanho; j++) {
+                baixo = _mm_and_si128(baixo, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(rg + j)), alvo[j]));
+                alto = _mm_and_si128(alto, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(rg + 16 + j)), alvo[j]));
+            }
+            if ((_mm_movemask_epi8(baixo) | _mm_movemask_epi8(alto)) == 0) {
+                mapa[w] &= ~(1ULL << (i - w * 64));
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void filtrar_rg_avx2(const char *digitos, int n, const char *trecho, unsigned long long *mapa) {
+    int tamanho = (int)strlen(trecho);
+    __m256i alvo[20];
+    for (int j = 0; j < tamanho; j++) {
+        alvo[j] = _mm256_set1_epi8(trecho[j]);
+    }
+    for (int w = 0; w * 64 < n; w++) {
+        for (unsigned long long bits = mapa[w]; bits != 0; bits &= bits - 1) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            const char *rg = digitos + (size_t)i * LARGURA_RG_COLUNA;
+            __m256i igual = _mm256_set1_epi8(-1);
+            for (int j = 0; j < tamanho; j++) {
+                igual = _mm256_and_si256(igual, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(rg + j)), alvo[j]));
+            }
+            if (_mm256_movemask_epi8(igual) == 0) {
+                mapa[w] &= ~(1ULL << (i - w * 64));
+            }
+        }
+    }
+}
+#endif
+
+// Melhor conjunto de instruções suportado pelo processador
+int melhor_nivel_varredura() {
+#ifdef VARREDURA_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return VARREDURA_AVX2;
+    }
+#if defined(__x86_64__) || defined(__SSE2__)
+    return VARREDURA_SSE2;
+#endif
+#endif
+    return VARREDURA_ESCALAR;
+}
+
+const char* nome_nivel_varredura(int nivel) {
+    return nivel == VARREDURA_AVX2 ? "AVX2" : nivel == VARREDURA_SSE2 ? "SSE2" : "escalar";
+}
+
+// Predicado que aceita qualquer paciente (base para montar filtros)
+PredicadoVarredura predicado_vazio() {
+    PredicadoVarredura predicado = {INT_MIN, INT_MAX, INT_MIN, INT_MAX, 0, ""};
+    return predicado;
+}
+
+// Avalia o predicado sobre as colunas com os núcleos do nível informado (limitado ao suportado).
+// As condições baratas vêm primeiro, para que a busca no RG visite só as linhas restantes.
+void varrer_colunas(const ColunasPacientes *colunas, const PredicadoVarredura *predicado, int nivel, MapaSelecao *mapa) {
+    void (*faixa)(const int *, int, int, int, unsigned long long *) = filtrar_faixa_escalar;
+    void (*rg)(const char *, int, const char *, unsigned long long *) = filtrar_rg_escalar;
+    if (nivel > melhor_nivel_varredura()) {
+        nivel = melhor_nivel_varredura();
+    }
+#ifdef VARREDURA_X86
+    if (nivel == VARREDURA_AVX2) {
+        faixa = filtrar_faixa_avx2;
+        rg = filtrar_rg_avx2;
+    } else if (nivel == VARREDURA_SSE2) {
+        faixa = filtrar_faixa_sse2;
+        rg = filtrar_rg_sse2;
+    }
+#endif
+    int n = colunas->qtde;
+    iniciar_mapa(mapa, n);
+    if (predicado->idadeMinima != INT_MIN || predicado->idadeMaxima != INT_MAX) {
+        faixa(colunas->idades, n, predicado->idadeMinima, predicado->idadeMaxima, mapa->palavras);
+    }
+    if (predicado->diaMinimo != INT_MIN || predicado->diaMaximo != INT_MAX) {
+        faixa(colunas->dias, n, predicado->diaMinimo, predicado->diaMaximo, mapa->palavras);
+    }
+    if (predicado->mes != 0) {
+        faixa(colunas->meses, n, predicado->mes, predicado->mes, mapa->palavras);
+    }
+    if (predicado->trechoRg[0] != '\0') {
+        rg(colunas->digitosRg, n, predicado->trechoRg, mapa->palavras);
+    }
+}
+
+// Referência: o mesmo predicado avaliado percorrendo a lista encadeada
+long contar_lista_predicado(const Lista *lista, const PredicadoVarredura *predicado) {
+    long total = 0;
+    for (ELista *no = lista->inicio; no != NULL; no = no->proximo) {
+        const Registro *r = no->dados;
+        if (r->idade < predicado->idadeMinima || r->idade > predicado->idadeMaxima ||
+            r->entrada < predicado->diaMinimo || r->entrada > predicado->diaMaximo ||
+            (predicado->mes != 0 && data_calendario(r->entrada).mes != predicado->mes)) {
+            continue;
+        }
+        if (predicado->trechoRg[0] != '\0') {
+            char digitos[20];
+            extrair_numeros_rg(r->rg, digitos);
+            if (strstr(digitos, predicado->trechoRg) == NULL) {
+                continue;
+            }
+        }
+        total++;
+    }
+    return total;
+}
+
+// Lê o predicado do teclado
+void ler_predicado_teclado(PredicadoVarredura *predicado) {
+    int anoInicial, anoFinal;
+    *predicado = predicado_vazio();
+    printf("\nIdade mínima e máxima: ");
+    scanf("%d %d", &predicado->idadeMinima, &predicado->idadeMaxima);
+    printf("Ano de entrada inicial e final: ");
+    scanf("%d %d", &anoInicial, &anoFinal);
+    printf("Mês de entrada (0 = qualquer): ");
+    scanf("%d", &predicado->mes);
+    getchar();
+    printf("Dígitos contidos no RG (vazio = qualquer): ");
+    fgets(predicado->trechoRg, sizeof(predicado->trechoRg), stdin);
+    predicado->trechoRg[strcspn(predicado->trechoRg, "\n")] = '\0';
+    predicado->diaMinimo = dias_desde_epoca(1, 1, anoInicial);
+    predicado->diaMaximo = dias_desde_epoca(31, 12, anoFinal);
+}
+
+// Compara a varredura em cada nível com a busca na lista sobre uma base sintética de n pacientes
+void comparar_desempenho_varredura(int n, const PredicadoVarredura *predicado, int repeticoes) {
+    Lista *sintetica = inicializa_lista();
+    Lote *lote = iniciar_lote(n);
+    unsigned int semente = 12345;
+    for (int i = 0; i < n; i++) {
+        Registro r;
+        semente = semente * 1103515245u + 12345u;
+        snprintf(r.nome, sizeof(r.nome), "Paciente %d", i);
+        r.idade = (int)(semente >> 16) % 100;
+        snprintf(r.rg, sizeof(r.rg), "%02u.%03u.%03u-%u", (semente >> 3) % 100, (semente >> 9) % 1000, (unsigned)i % 1000, semente % 10);
+        r.entrada = cria_data(1 + (int)(semente >> 5) % 28, 1 + (int)(semente >> 11) % 12, 1990 + (int)(semente >> 20) % 35);
+        adicionar_ao_lote(lote, r);
+    }
+    confirmar_lote(sintetica, lote);
+    liberar_lote(lote);
+    ColunasPacientes colunas = {0};
+    long long inicio = instante_atual();
+    extrair_colunas(&colunas, sintetica);
+    printf("\nBase sintética: %d pacientes | extração das colunas: %lld ms\n", n, instante_atual() - inicio);
+    long referencia = 0;
+    inicio = instante_atual();
+    for (int r = 0; r < repeticoes; r++) {
+        referencia = contar_lista_predicado(sintetica, predicado);
+    }
+    long long tempoLista = instante_atual() - inicio;
+    printf("%-10s %8lld ms  %ld selecionados\n", "lista", tempoLista, referencia);
+    for (int nivel = VARREDURA_ESCALAR; nivel <= melhor_nivel_varredura(); nivel++) {
+        MapaSelecao mapa;
+        long selecionados = 0;
+        inicio = instante_atual();
+        for (int r = 0; r < repeticoes; r++) {
+            varrer_colunas(&colunas, predicado, nivel, &mapa);
+            selecionados = contar_selecao(&mapa);
+            liberar_mapa(&mapa);
+        }
+        long long tempo = instante_atual() - inicio;
+        printf("%-10s %8lld ms  %ld selecionados%s (%.1fx)\n", nome_nivel_varredura(nivel), tempo, selecionados,
+               selecionados == referencia ? "" : " DIVERGENTE", tempo > 0 ? (double)tempoLista / tempo : 0.0);
+    }
+    liberar_colunas(&colunas);
+    destruir_lista(sintetica);
+}
+
+// Submenu das varreduras por colunas
+void menu_varredura_colunas(Lista *lista) {
+    ColunasPacientes colunas = {0};
+    int opcao;
+    do {
+        limpar_console();
+        printf("\n╔════════════════════════════════════════════╗\n");
+        printf("║          VARREDURA POR COLUNAS             ║\n");
+        printf("╠════════════════════════════════════════════╣\n");
+        printf("║ 1 - Filtrar o cadastro                     ║\n");
+        printf("║ 2 - Comparar desempenho (base sintética)   ║\n");
+        printf("║ 0 - Voltar ao menu anterior                ║\n");
+        printf("╚════════════════════════════════════════════╝\n");
+        printf("\nNúcleos em uso: %s. Selecione uma opção: ", nome_nivel_varredura(melhor_nivel_varredura()));
+        scanf("%d", &opcao);
+        getchar();
+        PredicadoVarredura predicado;
+        switch (opcao) {
+            case 1: {
+                ler_predicado_teclado(&predicado);
+                extrair_colunas(&colunas, lista);
+                MapaSelecao mapa;
+                varrer_colunas(&colunas, &predicado, melhor_nivel_varredura(), &mapa);
+                limpar_console();
+                long exibir = 50;
+                percorrer_selecao(&mapa, &colunas, imprimir_relatorio_limitado, &exibir);
+                long qtde = contar_selecao(&mapa);
+                printf("\n%ld paciente(s) selecionados%s\n", qtde, qtde > 50 ? " (exibidos 50)" : "");
+                liberar_mapa(&mapa);
+                limpar_console_dinamico();
+                break;
+            }
+            case 2: {
+                int n;
+                printf("\nQuantidade de pacientes da base sintética: ");
+                scanf("%d", &n);
+                getchar();
+                ler_predicado_teclado(&predicado);
+                limpar_console();
+                comparar_desempenho_varredura(n > 0 ? n : 1, &predicado, 20);
+                limpar_console_dinamico();
+                break;
+            }
+            case 0:
+                break;
+            default:
+                printf("\nOpção inválida. Tente novamente.\n");
+                limpar_console_dinamico();
+        }
+    } while (opcao != 0);
+    liberar_colunas(&colunas);
+}
+
+// ** Módulo Registro Compartilhado (Terminais) ** 
+
+// Converte um deslocamento do segmento em endereço neste processo (0 = NULL)
+void* endereco_compartilhado(const SegmentoCompartilhado *segmento, unsigned int deslocamento) {
+    return deslocamento == 0 ? NULL : (char *)segmento + deslocamento;
+}
+
+unsigned int deslocamento_compartilhado(const SegmentoCompartilhado *segmento, const void *endereco) {
+    return endereco == NULL ? 0 : (unsigned int)((const char *)endereco - (const char *)segmento);
+}
+
+unsigned int* indice_compartilhado(const SegmentoCompartilhado *segmento) {
+    return endereco_compartilhado(segmento, segmento->deslocIndice);
+}
+
+ENoCompartilhado* nos_compartilhados(const SegmentoCompartilhado *segmento) {
+    return endereco_compartilhado(segmento, segmento->deslocNos);
+}
+
+EFilaCompartilhada* fila_compartilhada(const SegmentoCompartilhado *segmento) {
+    return endereco_compartilhado(segmento, segmento->deslocFila);
+}
+
+EHeapCompartilhado* heap_compartilhado(const SegmentoCompartilhado *segmento) {
+    return endereco_compartilhado(segmento, segmento->deslocHeap);
+}
+
+EHeapCompartilhado* reserva_heap_compartilhado(const SegmentoCompartilhado *segmento) {
+    return endereco_compartilhado(segmento, segmento->deslocReserva);
+}
+
+// Indica se um deslocamento aponta para um nó do cadastro (protege os leitores de ler
+// encadeamentos pela metade)
+int no_compartilhado_valido(const SegmentoCompartilhado *segmento, unsigned int deslocamento) {
+    unsigned int relativo = deslocamento - segmento->deslocNos;
+    return deslocamento >= segmento->deslocNos && relativo % sizeof(ENoCompartilhado) == 0 &&
+           relativo / sizeof(ENoCompartilhado) < (unsigned int)segmento->capacidade;
+}
+
+// Calcula as áreas do segmento para a capacidade dada e retorna seu tamanho total
+size_t planejar_segmento(SegmentoCompartilhado *segmento, int capacidade) {
+    size_t posicao = (sizeof(SegmentoCompartilhado) + 63) & ~(size_t)63;
+    segmento->deslocIndice = (unsigned int)posicao;
+    posicao += 2 * (size_t)capacidade * sizeof(unsigned int);
+    segmento->deslocNos = (unsigned int)posicao;
+    posicao += (size_t)capacidade * sizeof(ENoCompartilhado);
+    segmento->deslocFila = (unsigned int)posicao;
+    posicao += (size_t)capacidade * sizeof(EFilaCompartilhada);
+    segmento->deslocHeap = (unsigned int)posicao;
+    posicao += MAX_HEAP * sizeof(EHeapCompartilhado);
+    segmento->deslocReserva = (unsigned int)posicao;
+    posicao += MAX_HEAP * sizeof(EHeapCompartilhado);
+    return posicao;
+}
+
+// Prepara um segmento recém-criado (ainda zerado): áreas, trava compartilhada e nós livres
+void inicializar_segmento(SegmentoCompartilhado *segmento, int capacidade, size_t tamanho) {
+    memcpy(segmento->magico, MAGICO_SEGMENTO, 4);
+    segmento->capacidade = capacidade;
+    segmento->tamanho = (unsigned int)tamanho;
+    planejar_segmento(segmento, capacidade);
+    pthread_mutexattr_t atributos;
+    pthread_mutexattr_init(&atributos);
+    pthread_mutexattr_setpshared(&atributos, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&atributos, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&segmento->trava, &atributos);
+    pthread_mutexattr_destroy(&atributos);
+    ENoCompartilhado *nos = nos_compartilhados(segmento);
+    for (int i = 0; i < capacidade; i++) {
+        nos[i].proximo = i + 1 < capacidade ? deslocamento_compartilhado(segmento, &nos[i + 1]) : 0;
+    }
+    segmento->livres = deslocamento_compartilhado(segmento, &nos[0]);
+    segmento->criterio = criterio_padrao();
+    segmento->faixaAtual = faixa_de_tempo(&segmento->criterio, instante_atual());
+    // Publicado por último: quem abre o segmento espera por esta marca
+    __atomic_store_n(&segmento->pronto, 1, __ATOMIC_RELEASE);
+}
+
+// Reconstrói o índice de RG a partir do cadastro (com a escrita iniciada), descartando as
+// lápides. Os leitores não consultam o índice, então ele pode ser refeito no lugar.
+void reorganizar_indice_compartilhado(SegmentoCompartilhado *segmento) {
+    unsigned int *indice = indice_compartilhado(segmento);
+    int mascara = 2 * segmento->capacidade - 1;
+    memset(indice, 0, 2 * (size_t)segmento->capacidade * sizeof(unsigned int));
+    for (unsigned int deslocamento = segmento->inicioCadastro; deslocamento != 0;) {
+        ENoCompartilhado *no = endereco_compartilhado(segmento, deslocamento);
+        char rgNumerico[20];
+        extrair_numeros_rg(no->dados.rg, rgNumerico);
+        int i = (int)(hash_rg(rgNumerico) & mascara);
+        while (indice[i] != 0) {
+            i = (i + 1) & mascara;
+        }
+        indice[i] = deslocamento;
+        deslocamento = no->proximo;
+    }
+    segmento->lapidesIndice = 0;
+}
+
+// Abre um passo de escrita: o diário guarda os campos do cabeçalho que o passo pode alterar.
+// Enquanto é preenchido, o diário fica inativo (o segmento ainda está consistente).
+void abrir_passo_compartilhado(SegmentoCompartilhado *segmento) {
+    DiarioCompartilhado *diario = &segmento->diario;
+    diario->ativo = 0;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    diario->inicioCadastro = segmento->inicioCadastro;
+    diario->livres = segmento->livres;
+    diario->qtdeCadastro = segmento->qtdeCadastro;
+    diario->filaInicio = segmento->filaInicio;
+    diario->filaQtde = segmento->filaQtde;
+    diario->heapQtde = segmento->heapQtde;
+    diario->faixaAtual = segmento->faixaAtual;
+    diario->qtdePalavras = 0;
+    diario->heapSalvo = 0;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    diario->ativo = 1;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+void fechar_passo_compartilhado(SegmentoCompartilhado *segmento) {
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    segmento->diario.ativo = 0;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+// Altera um encadeamento do cadastro depois de anotar no diário o valor anterior
+void alterar_encadeamento(SegmentoCompartilhado *segmento, unsigned int *encadeamento, unsigned int valor) {
+    DiarioCompartilhado *diario = &segmento->diario;
+    diario->deslocPalavra[diario->qtdePalavras] = deslocamento_compartilhado(segmento, encadeamento);
+    diario->valorPalavra[diario->qtdePalavras] = *encadeamento;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    diario->qtdePalavras++;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    *encadeamento = valor;
+}
+
+// Copia o heap para a reserva antes da primeira alteração do passo
+void salvar_heap_diario(SegmentoCompartilhado *segmento) {
+    if (segmento->diario.heapSalvo) {
+        return;
+    }
+    memcpy(reserva_heap_compartilhado(segmento), heap_compartilhado(segmento),
+           (size_t)segmento->heapQtde * sizeof(EHeapCompartilhado));
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    segmento->diario.heapSalvo = 1;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+// Desfaz o passo interrompido: encadeamentos em ordem inversa, cabeçalho e heap. Pode ser
+// repetido se quem recupera também cair no meio.
+void desfazer_passo_compartilhado(SegmentoCompartilhado *segmento) {
+    DiarioCompartilhado *diario = &segmento->diario;
+    int palavras = diario->qtdePalavras;
+    if (palavras < 0 || palavras > MAX_PALAVRAS_DIARIO) {
+        palavras = 0;  // diário ilegível: a validação decide
+    }
+    for (int i = palavras - 1; i >= 0; i--) {
+        unsigned int deslocamento = diario->deslocPalavra[i];
+        if (deslocamento >= segmento->deslocNos && deslocamento + sizeof(unsigned int) <= segmento->deslocFila &&
+            deslocamento % sizeof(unsigned int) == 0) {
+            *(unsigned int *)endereco_compartilhado(segmento, deslocamento) = diario->valorPalavra[i];
+        }
+    }
+    segmento->inicioCadastro = diario->inicioCadastro;
+    segmento->livres = diario->livres;
+    segmento->qtdeCadastro = diario->qtdeCadastro;
+    segmento->filaInicio = diario->filaInicio;
+    segmento->filaQtde = diario->filaQtde;
+    segmento->heapQtde = diario->heapQtde;
+    segmento->faixaAtual = diario->faixaAtual;
+    if (diario->heapSalvo && diario->heapQtde >= 0 && diario->heapQtde <= MAX_HEAP) {
+        memcpy(heap_compartilhado(segmento), reserva_heap_compartilhado(segmento),
+               (size_t)diario->heapQtde * sizeof(EHeapCompartilhado));
+    }
+    fechar_passo_compartilhado(segmento);
+}
+
+// Confere os encadeamentos do cadastro e dos nós livres e as quantidades das filas
+int validar_segmento(const SegmentoCompartilhado *segmento) {
+    int capacidade = segmento->capacidade;
+    unsigned char *visitados = calloc((size_t)capacidade, 1);
+    int usados = 0, livres = 0, valido = 1;
+    unsigned int anterior = 0;
+    for (unsigned int deslocamento = segmento->inicioCadastro; valido && deslocamento != 0;) {
+        int indice = (int)((deslocamento - segmento->deslocNos) / sizeof(ENoCompartilhado));
+        const ENoCompartilhado *no = endereco_compartilhado(segmento, deslocamento);
+        valido = no_compartilhado_valido(segmento, deslocamento) && !visitados[indice] && no->anterior == anterior;
+        if (valido) {
+            visitados[indice] = 1;
+            usados++;
+            anterior = deslocamento;
+            deslocamento = no->proximo;
+        }
+    }
+    for (unsigned int deslocamento = segmento->livres; valido && deslocamento != 0;) {
+        int indice = (int)((deslocamento - segmento->deslocNos) / sizeof(ENoCompartilhado));
+        valido = no_compartilhado_valido(segmento, deslocamento) && !visitados[indice];
+        if (valido) {
+            visitados[indice] = 1;
+            livres++;
+            deslocamento = ((const ENoCompartilhado *)endereco_compartilhado(segmento, deslocamento))->proximo;
+        }
+    }
+    free(visitados);
+    return valido && usados == segmento->qtdeCadastro && usados + livres == capacidade &&
+           segmento->filaInicio >= 0 && segmento->filaInicio < capacidade &&
+           segmento->filaQtde >= 0 && segmento->filaQtde <= capacidade &&
+           segmento->heapQtde >= 0 && segmento->heapQtde <= MAX_HEAP;
+}
+
+// Recupera a trava de um terminal que caiu segurando-a: desfaz o passo de escrita que ele
+// deixou pela metade, confere a estrutura e refaz o índice de RG. Um segmento que não passa
+// na conferência é marcado como inutilizável. A versão volta a ser par, para que os leitores
+// não esperem para sempre.
+void recuperar_segmento(SegmentoCompartilhado *segmento, int resultadoTrava) {
+    if (resultadoTrava == EOWNERDEAD) {
+        pthread_mutex_consistent(&segmento->trava);
+        if (segmento->diario.ativo) {
+            desfazer_passo_compartilhado(segmento);
+        }
+        if (validar_segmento(segmento)) {
+            reorganizar_indice_compartilhado(segmento);
+        } else {
+            segmento->inutilizavel = 1;
+        }
+        if (segmento->versao & 1) {
+            __atomic_store_n(&segmento->versao, segmento->versao + 1, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+// Trava o segmento para escrita
+void travar_segmento(SegmentoCompartilhado *segmento) {
+    recuperar_segmento(segmento, pthread_mutex_lock(&segmento->trava));
+}
+
+// Início e fim de uma escrita: trava, torna a versão ímpar e abre o primeiro passo do diário;
+// depois fecha o passo, torna a versão par e destrava. Retorna 0 (sem travar) se o segmento
+// está inutilizável.
+int iniciar_escrita_compartilhada(SegmentoCompartilhado *segmento) {
+    travar_segmento(segmento);
+    if (segmento->inutilizavel) {
+        pthread_mutex_unlock(&segmento->trava);
+        return 0;
+    }
+    __atomic_store_n(&segmento->versao, segmento->versao + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    abrir_passo_compartilhado(segmento);
+    return 1;
+}
+
+void concluir_escrita_compartilhada(SegmentoCompartilhado *segmento) {
+    fechar_passo_compartilhado(segmento);
+    __atomic_store_n(&segmento->versao, segmento->versao + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&segmento->trava);
+}
+
+// Cria o segmento compartilhado ou se conecta a um já existente. Retorna NULL se o segmento
+// não pôde ser aberto ou não é um segmento de pacientes.
+RegistroCompartilhado* conectar_registro_compartilhado(const char *nome, int capacidade) {
+    SegmentoCompartilhado plano;
+    size_t tamanho = planejar_segmento(&plano, capacidade);
+    int criador = 1;
+    int descritor = shm_open(nome, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (descritor < 0 && errno == EEXIST) {
+        criador = 0;
+        descritor = shm_open(nome, O_RDWR, 0600);
+    }
+    if (descritor < 0) {
+        return NULL;
+    }
+    if (criador && ftruncate(descritor, (off_t)tamanho) != 0) {
+        close(descritor);
+        shm_unlink(nome);
+        return NULL;
+    }
+    // Quem chega durante a criação espera o criador dimensionar e inicializar o segmento
+    struct stat estado;
+    int esperaMs = 0;
+    while (!criador && (fstat(descritor, &estado) != 0 || estado.st_size == 0) && esperaMs < ESPERA_SEGMENTO_MS) {
+        usleep(1000);
+        esperaMs++;
+    }
+    if (!criador) {
+        tamanho = estado.st_size > 0 ? (size_t)estado.st_size : 0;
+    }
+    SegmentoCompartilhado *segmento = tamanho >= sizeof(SegmentoCompartilhado)
+        ? mmap(NULL, tamanho, PROT_READ | PROT_WRITE, MAP_SHARED, descritor, 0) : MAP_FAILED;
+    if (segmento == MAP_FAILED) {
+        close(descritor);
+        return NULL;
+    }
+    if (criador) {
+        inicializar_segmento(segmento, capacidade, tamanho);
+    }
+    while (!__atomic_load_n(&segmento->pronto, __ATOMIC_ACQUIRE) && esperaMs < ESPERA_SEGMENTO_MS) {
+        usleep(1000);
+        esperaMs++;
+    }
+    if (!segmento->pronto || memcmp(segmento->magico, MAGICO_SEGMENTO, 4) != 0 || segmento->tamanho != tamanho) {
+        munmap(segmento, tamanho);
+        close(descritor);
+        return NULL;
+    }
+    RegistroCompartilhado *rc = malloc(sizeof(RegistroCompartilhado));
+    rc->segmento = segmento;
+    rc->descritor = descritor;
+    travar_segmento(segmento);
+    segmento->terminais++;
+    pthread_mutex_unlock(&segmento->trava);
+    return rc;
+}
+
+// Desconecta o terminal (o segmento continua existindo para os demais)
+void desconectar_registro_compartilhado(RegistroCompartilhado *rc) {
+    SegmentoCompartilhado *segmento = rc->segmento;
+    travar_segmento(segmento);
+    segmento->terminais--;
+    pthread_mutex_unlock(&segmento->trava);
+    munmap(segmento, segmento->tamanho);
+    close(rc->descritor);
+    free(rc);
+}
+
+// Posição do RG normalizado no índice do segmento, ou da primeira posição livre do caminho
+// (com 'livre' = 1) se ele não está cadastrado. A sondagem percorre no máximo o índice
+// inteiro; retorna -1 (com 'livre' = 1) se não há posição livre.
+int posicao_indice_compartilhado(const SegmentoCompartilhado *segmento, const char *rgNumerico, int *livre) {
+    const unsigned int *indice = indice_compartilhado(segmento);
+    int posicoes = 2 * segmento->capacidade;
+    int mascara = posicoes - 1;
+    int primeiraLivre = -1;
+    int i = (int)(hash_rg(rgNumerico) & mascara);
+    for (int passos = 0; passos < posicoes; passos++, i = (i + 1) & mascara) {
+        if (indice[i] == 0) {
+            *livre = 1;
+            return primeiraLivre >= 0 ? primeiraLivre : i;
+        }
+        if (indice[i] == LAPIDE_COMPARTILHADA) {
+            if (primeiraLivre < 0) primeiraLivre = i;
+            continue;
+        }
+        char rgEntrada[20];
+        extrair_numeros_rg(((ENoCompartilhado *)endereco_compartilhado(segmento, indice[i]))->dados.rg, rgEntrada);
+        if (strcmp(rgEntrada, rgNumerico) == 0) {
+            *livre = 0;
+            return i;
+        }
+    }
+    *livre = 1;
+    return primeiraLivre;
+}
+
+// Cadastra no segmento (com a escrita já iniciada). Retorna 1 se cadastrou, 0 se o RG já
+// existe e -1 se o segmento está cheio.
+int inserir_cadastro_compartilhado(SegmentoCompartilhado *segmento, const Registro *paciente) {
+    char rgNumerico[20];
+    extrair_numeros_rg(paciente->rg, rgNumerico);
+    int livre;
+    int posicao = posicao_indice_compartilhado(segmento, rgNumerico, &livre);
+    if (!livre) {
+        return 0;
+    }
+    if (segmento->livres == 0 || posicao < 0) {
+        return -1;
+    }
+    unsigned int *indice = indice_compartilhado(segmento);
+    if (indice[posicao] == LAPIDE_COMPARTILHADA) {
+        segmento->lapidesIndice--;
+    }
+    ENoCompartilhado *no = endereco_compartilhado(segmento, segmento->livres);
+    segmento->livres = no->proximo;
+    no->dados = *paciente;
+    no->anterior = 0;
+    alterar_encadeamento(segmento, &no->proximo, segmento->inicioCadastro);
+    unsigned int deslocamento = deslocamento_compartilhado(segmento, no);
+    if (segmento->inicioCadastro != 0) {
+        ENoCompartilhado *primeiro = endereco_compartilhado(segmento, segmento->inicioCadastro);
+        alterar_encadeamento(segmento, &primeiro->anterior, deslocamento);
+    }
+    segmento->inicioCadastro = deslocamento;
+    indice[posicao] = deslocamento;
+    segmento->qtdeCadastro++;
+    return 1;
+}
+
+// Retorna o mesmo que inserir_cadastro_compartilhado ou -2 se o segmento está inutilizável
+int compartilhado_cadastrar(RegistroCompartilhado *rc, const Registro *paciente) {
+    if (!iniciar_escrita_compartilhada(rc->segmento)) {
+        return -2;
+    }
+    int resultado = inserir_cadastro_compartilhado(rc->segmento, paciente);
+    concluir_escrita_compartilhada(rc->segmento);
+    return resultado;
+}
+
+// Copia o cadastro local para o segmento (RGs já existentes são mantidos). Retorna quantos
+// pacientes foram copiados. Cada paciente é um passo do diário: uma queda no meio da cópia
+// desfaz só o paciente em andamento. A trava é solta a cada IMPORTACAO_POR_ESCRITA pacientes,
+// para que os outros terminais (e os leitores, que esperam a versão voltar a ser par) não
+// fiquem parados durante uma importação grande.
+long compartilhado_importar_lista(RegistroCompartilhado *rc, const Lista *lista) {
+    long inseridos = 0;
+    int noLote = 0;
+    if (!iniciar_escrita_compartilhada(rc->segmento)) {
+        return 0;
+    }
+    for (const ELista *no = lista->inicio; no != NULL; no = no->proximo) {
+        if (noLote == IMPORTACAO_POR_ESCRITA) {
+            concluir_escrita_compartilhada(rc->segmento);
+            if (!iniciar_escrita_compartilhada(rc->segmento)) {
+                return inseridos;
+            }
+            noLote = 0;
+        }
+        int resultado = inserir_cadastro_compartilhado(rc->segmento, no->dados);
+        if (resultado < 0) {
+            break;
+        }
+        inseridos += resultado;
+        noLote++;
+        abrir_passo_compartilhado(rc->segmento);
+    }
+    concluir_escrita_compartilhada(rc->segmento);
+    return inseridos;
+}
+
+// Remove do cadastro compartilhado o paciente com o RG informado: O(1) pelo índice e pelos
+// encadeamentos duplos. Retorna 0 se o RG não está cadastrado.
+int compartilhado_remover(RegistroCompartilhado *rc, const char *rg) {
+    SegmentoCompartilhado *segmento = rc->segmento;
+    char rgNumerico[20];
+    extrair_numeros_rg(rg, rgNumerico);
+    if (!iniciar_escrita_compartilhada(segmento)) {
+        return 0;
+    }
+    int livre;
+    int posicao = posicao_indice_compartilhado(segmento, rgNumerico, &livre);
+    if (livre) {
+        concluir_escrita_compartilhada(segmento);
+        return 0;
+    }
+    unsigned int *indice = indice_compartilhado(segmento);
+    ENoCompartilhado *no = endereco_compartilhado(segmento, indice[posicao]);
+    if (no->anterior != 0) {
+        ENoCompartilhado *anterior = endereco_compartilhado(segmento, no->anterior);
+        alterar_encadeamento(segmento, &anterior->proximo, no->proximo);
+    } else {
+        segmento->inicioCadastro = no->proximo;
+    }
+    if (no->proximo != 0) {
+        ENoCompartilhado *proximo = endereco_compartilhado(segmento, no->proximo);
+        alterar_encadeamento(segmento, &proximo->anterior, no->anterior);
+    }
+    alterar_encadeamento(segmento, &no->proximo, segmento->livres);
+    segmento->livres = indice[posicao];
+    indice[posicao] = LAPIDE_COMPARTILHADA;
+    segmento->qtdeCadastro--;
+    // Com até metade da capacidade em lápides, o índice (o dobro da capacidade) sempre tem
+    // posições vazias que encerram as sondagens
+    if (++segmento->lapidesIndice > segmento->capacidade / 2) {
+        reorganizar_indice_compartilhado(segmento);
+    }
+    concluir_escrita_compartilhada(segmento);
+    return 1;
+}
+
+// Procura um paciente do cadastro compartilhado pelo nome (com a escrita iniciada)
+const ENoCompartilhado* buscar_nome_compartilhado(const SegmentoCompartilhado *segmento, const char *nome) {
+    for (const ENoCompartilhado *no = endereco_compartilhado(segmento, segmento->inicioCadastro); no != NULL;
+         no = endereco_compartilhado(segmento, no->proximo)) {
+        if (strcmp(no->dados.nome, nome) == 0) {
+            return no;
+        }
+    }
+    return NULL;
+}
+
+// Indica se o paciente já aguarda na fila comum (prioritaria = 0) ou na prioritária do
+// segmento. Percorre a fila inteira: as filas compartilhadas são limitadas pela capacidade.
+int aguarda_compartilhado(const SegmentoCompartilhado *segmento, const Registro *paciente, int prioritaria) {
+    char rgNumerico[20], rgEntrada[20];
+    extrair_numeros_rg(paciente->rg, rgNumerico);
+    int qtde = prioritaria ? segmento->heapQtde : segmento->filaQtde;
+    for (int i = 0; i < qtde; i++) {
+        const Registro *dados = prioritaria
+            ? &heap_compartilhado(segmento)[i].dados
+            : &fila_compartilhada(segmento)[(segmento->filaInicio + i) & (segmento->capacidade - 1)].dados;
+        extrair_numeros_rg(dados->rg, rgEntrada);
+        if (strcmp(rgEntrada, rgNumerico) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Coloca no fim da fila comum compartilhada uma cópia do paciente com o nome informado.
+// Retorna OPERACAO_DUPLICADA se ele já aguarda na fila.
+int compartilhado_enfileirar(RegistroCompartilhado *rc, const char *nome) {
+    SegmentoCompartilhado *segmento = rc->segmento;
+    if (!iniciar_escrita_compartilhada(segmento)) {
+        return OPERACAO_RECUSADA;
+    }
+    const ENoCompartilhado *no = buscar_nome_compartilhado(segmento, nome);
+    int status = OPERACAO_OK;
+    if (no == NULL) {
+        status = OPERACAO_NAO_ENCONTRADO;
+    } else if (aguarda_compartilhado(segmento, &no->dados, 0)) {
+        status = OPERACAO_DUPLICADA;
+    } else if (segmento->filaQtde == segmento->capacidade) {
+        status = OPERACAO_RECUSADA;
+    } else {
+        EFilaCompartilhada *item = &fila_compartilhada(segmento)[(segmento->filaInicio + segmento->filaQtde) & (segmento->capacidade - 1)];
+        item->dados = no->dados;
+        item->enfileiradoEm = instante_atual();
+        segmento->filaQtde++;
+    }
+    concluir_escrita_compartilhada(segmento);
+    return status;
+}
+
+// Atende o primeiro paciente da fila comum compartilhada. Retorna 0 se a fila está vazia.
+int compartilhado_atender(RegistroCompartilhado *rc, EFilaCompartilhada *atendido) {
+    SegmentoCompartilhado *segmento = rc->segmento;
+    if (!iniciar_escrita_compartilhada(segmento)) {
+        return 0;
+    }
+    int atendeu = segmento->filaQtde > 0;
+    if (atendeu) {
+        *atendido = fila_compartilhada(segmento)[segmento->filaInicio];
+        segmento->filaInicio = (segmento->filaInicio + 1) & (segmento->capacidade - 1);
+        segmento->filaQtde--;
+    }
+    concluir_escrita_compartilhada(segmento);
+    return atendeu;
+}
+
+// Vetor com os elementos do heap compartilhado (sem mapa: ninguém acompanha os índices)
+VetorPrioridade vetor_compartilhado(SegmentoCompartilhado *segmento) {
+    VetorPrioridade vetor = {heap_compartilhado(segmento), sizeof(EHeapCompartilhado), segmento->heapQtde, NULL, NULL};
+    return vetor;
+}
+
+// Insere na fila prioritária compartilhada uma cópia do paciente com o nome informado.
+// Retorna OPERACAO_DUPLICADA se ele já aguarda na fila prioritária.
+int compartilhado_inserir_prioritario(RegistroCompartilhado *rc, const char *nome, int triagem) {
+    SegmentoCompartilhado *segmento = rc->segmento;
+    if (!iniciar_escrita_compartilhada(segmento)) {
+        return OPERACAO_RECUSADA;
+    }
+    const ENoCompartilhado *no = buscar_nome_compartilhado(segmento, nome);
+    int status = OPERACAO_OK;
+    if (no == NULL) {
+        status = OPERACAO_NAO_ENCONTRADO;
+    } else if (aguarda_compartilhado(segmento, &no->dados, 1)) {
+        status = OPERACAO_DUPLICADA;
+    } else if (segmento->heapQtde == MAX_HEAP) {
+        status = OPERACAO_RECUSADA;
+    } else {
+        long long agora = instante_atual();
+        salvar_heap_diario(segmento);
+        VetorPrioridade vetor = vetor_compartilhado(segmento);
+        envelhecer_vetor(&vetor, &segmento->criterio, &segmento->faixaAtual, agora);
+        EHeapCompartilhado *novo = &heap_compartilhado(segmento)[segmento->heapQtde];
+        novo->dados = no->dados;
+        iniciar_prioridade(&novo->prioridade, &segmento->criterio, no->dados.idade, triagem, agora, segmento->faixaAtual);
+        segmento->heapQtde++;
+        vetor.qtde++;
+        subir_vetor(&vetor, segmento->heapQtde - 1);
+    }
+    concluir_escrita_compartilhada(segmento);
+    return status;
+}
+
+// Atende o paciente de maior prioridade da fila compartilhada. Retorna 0 se ela está vazia.
+int compartilhado_atender_prioritario(RegistroCompartilhado *rc, EHeapCompartilhado *atendido) {
+    SegmentoCompartilhado *segmento = rc->segmento;
+    if (!iniciar_escrita_compartilhada(segmento)) {
+        return 0;
+    }
+    int atendeu = segmento->heapQtde > 0;
+    if (atendeu) {
+        EHeapCompartilhado *heap = heap_compartilhado(segmento);
+        salvar_heap_diario(segmento);
+        VetorPrioridade vetor = vetor_compartilhado(segmento);
+        envelhecer_vetor(&vetor, &segmento->criterio, &segmento->faixaAtual, instante_atual());
+        *atendido = heap[0];
+        heap[0] = heap[--segmento->heapQtde];
+        vetor.qtde--;
+        peneirar_vetor(&vetor, 0);
+    }
+    concluir_escrita_compartilhada(segmento);
+    return atendeu;
+}
+
+// Copia o estado do segmento para a foto. Pode ver uma escrita pela metade (a versão dirá);
+// retorna 0 se os encadeamentos lidos não fazem sentido.
+int copiar_segmento(const SegmentoCompartilhado *segmento, FotoCompartilhada *foto) {
+    int capacidade = segmento->capacidade;
+    foto->qtdeCadastro = 0;
+    for (unsigned int deslocamento = segmento->inicioCadastro; deslocamento != 0;) {
+        if (!no_compartilhado_valido(segmento, deslocamento) || foto->qtdeCadastro == capacidade) {
+            return 0;
+        }
+        const ENoCompartilhado *no = endereco_compartilhado(segmento, deslocamento);
+        foto->cadastro[foto->qtdeCadastro++] = no->dados;
+        deslocamento = no->proximo;
+    }
+    int inicio = segmento->filaInicio;
+    foto->qtdeFila = segmento->filaQtde;
+    foto->qtdeHeap = segmento->heapQtde;
+    if (foto->qtdeFila < 0 || foto->qtdeFila > capacidade || foto->qtdeHeap < 0 || foto->qtdeHeap > MAX_HEAP) {
+        return 0;
+    }
+    const EFilaCompartilhada *fila = fila_compartilhada(segmento);
+    for (int i = 0; i < foto->qtdeFila; i++) {
+        foto->fila[i] = fila[(inicio + i) & (capacidade - 1)];
+    }
+    memcpy(foto->heap, heap_compartilhado(segmento), foto->qtdeHeap * sizeof(EHeapCompartilhado));
+    foto->terminais = segmento->terminais;
+    return 1;
+}
+
+// Lê o segmento sem travar: repete a cópia enquanto um escritor estiver no meio de uma
+// alteração ou se a versão mudou durante a cópia. Retorna 0 se o segmento está corrompido.
+int ler_segmento(SegmentoCompartilhado *segmento, FotoCompartilhada *foto) {
+    for (int esperas = 1;; esperas++) {
+        if (__atomic_load_n(&segmento->inutilizavel, __ATOMIC_ACQUIRE)) {
+            return 0;
+        }
+        unsigned long long antes = __atomic_load_n(&segmento->versao, __ATOMIC_ACQUIRE);
+        if (antes & 1) {
+            // Escrita demorada: confere (sem bloquear) se o escritor ainda existe
+            if (esperas % 1024 == 0) {
+                int resultado = pthread_mutex_trylock(&segmento->trava);
+                if (resultado != EBUSY) {
+                    recuperar_segmento(segmento, resultado);
+                    pthread_mutex_unlock(&segmento->trava);
+                }
+            }
+            sched_yield();
+            continue;
+        }
+        int consistente = copiar_segmento(segmento, foto);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&segmento->versao, __ATOMIC_RELAXED) == antes) {
+            return consistente;
+        }
+    }
+}
+
+FotoCompartilhada* criar_foto_compartilhada(int capacidade) {
+    FotoCompartilhada *foto = calloc(1, sizeof(FotoCompartilhada));
+    foto->cadastro = malloc(capacidade * sizeof(Registro));
+    foto->fila = malloc(capacidade * sizeof(EFilaCompartilhada));
+    foto->heap = malloc(MAX_HEAP * sizeof(EHeapCompartilhado));
+    return foto;
+}
+
+void liberar_foto_compartilhada(FotoCompartilhada *foto) {
+    free(foto->cadastro);
+    free(foto->fila);
+    free(foto->heap);
+    free(foto);
+}
+
+// Mostra o cadastro ou as duas filas do segmento, lidos sem bloquear os outros terminais
+void mostrar_segmento(RegistroCompartilhado *rc, int filas) {
+    FotoCompartilhada *foto = criar_foto_compartilhada(rc->segmento->capacidade);
+    limpar_console();
+    if (!ler_segmento(rc->segmento, foto)) {
+        printf("\nERRO!\nSegmento compartilhado inconsistente.\n");
+    } else if (!filas) {
+        printf("\nCadastro compartilhado (%d paciente(s), %d terminal(is) conectado(s)):\n",
+               foto->qtdeCadastro, foto->terminais);
+        for (int i = 0; i < foto->qtdeCadastro; i++) {
+            imprimir_registro_decodificado(NULL, &foto->cadastro[i]);
+        }
+    } else {
+        long long agora = instante_atual();
+        printf("\nFila comum compartilhada (%d):\n", foto->qtdeFila);
+        for (int i = 0; i < foto->qtdeFila; i++) {
+            printf("%d. %s (RG: %s; Espera: %lld min)\n", i + 1, foto->fila[i].dados.nome, foto->fila[i].dados.rg,
+                   (agora - foto->fila[i].enfileiradoEm) / 60000);
+        }
+        printf("\nFila prioritária compartilhada (%d):\n", foto->qtdeHeap);
+        for (int i = 0; i < foto->qtdeHeap; i++) {
+            const EHeapCompartilhado *e = &foto->heap[i];
+            printf("%d. %s (RG: %s; Triagem: %d; Espera: %lld min; Pontos: %ld)\n", i + 1, e->dados.nome,
+                   e->dados.rg, e->prioridade.triagem, (agora - e->prioridade.enfileiradoEm) / 60000, e->prioridade.chave);
+        }
+    }
+    liberar_foto_compartilhada(foto);
+    limpar_console_dinamico();
+}
+
+// Copia o cadastro compartilhado para o cadastro da sessão (RGs já cadastrados são mantidos).
+// Cada paciente entra por executar_operacao, e assim a cópia fica na gravação da sessão.
+long compartilhado_exportar_lista(RegistroCompartilhado *rc, Sessao *sessao) {
+    FotoCompartilhada *foto = criar_foto_compartilhada(rc->segmento->capacidade);
+    long copiados = 0;
+    if (ler_segmento(rc->segmento, foto)) {
+        for (int i = foto->qtdeCadastro - 1; i >= 0; i--) {
+            if (consultar_paciente_rg(sessao->lista, foto->cadastro[i].rg) == NULL) {
+                Operacao op = {.tipo = OP_CADASTRAR, .paciente = foto->cadastro[i]};
+                copiados += executar_operacao(sessao, &op, NULL) == OPERACAO_OK;
+            }
+        }
+    }
+    liberar_foto_compartilhada(foto);
+    return copiados;
+}
+
+// Menu do registro compartilhado: vários terminais (processos) da recepção trabalham sobre
+// o mesmo cadastro e as mesmas filas, mantidos em um segmento de memória compartilhada
+void menu_registro_compartilhado(Sessao *sessao) {
+    Lista *lista = sessao->lista;
+    RegistroCompartilhado *rc = conectar_registro_compartilhado(NOME_SEGMENTO_COMPARTILHADO, CAPACIDADE_COMPARTILHADA);
+    if (rc == NULL) {
+        limpar_console();
+        printf("\nERRO!\nNão foi possível conectar ao segmento %s.\n", NOME_SEGMENTO_COMPARTILHADO);
+        limpar_console_dinamico();
+        return;
+    }
+    int opcao;
+    do {
+        limpar_console();
+        printf("\n╔════════════════════════════════════════════╗\n");
+        printf("║     REGISTRO COMPARTILHADO (TERMINAIS)     ║\n");
+        printf("╠════════════════════════════════════════════╣\n");
+        printf("║ 1 - Copiar cadastro local p/ o segmento    ║\n");
+        printf("║ 2 - Copiar cadastro do segmento p/ o local ║\n");
+        printf("║ 3 - Cadastrar paciente                     ║\n");
+        printf("║ 4 - Remover paciente (RG)                  ║\n");
+        printf("║ 5 - Listar cadastro compartilhado          ║\n");
+        printf("║ 6 - Enfileirar na fila comum               ║\n");
+        printf("║ 7 - Atender da fila comum                  ║\n");
+        printf("║ 8 - Inserir na fila prioritária            ║\n");
+        printf("║ 9 - Atender da fila prioritária            ║\n");
+        printf("║ 10 - Mostrar filas compartilhadas          ║\n");
+        printf("║ 11 - Apagar o segmento (todos os terminais)║\n");
+        printf("║ 0 - Voltar (desconecta este terminal)      ║\n");
+        printf("╚════════════════════════════════════════════╝\n");
+        if (__atomic_load_n(&rc->segmento->inutilizavel, __ATOMIC_ACQUIRE)) {
+            printf("\nATENÇÃO: um terminal caiu e o segmento ficou inconsistente; as alterações estão\n");
+            printf("bloqueadas. Apague o segmento (opção 11) e copie o cadastro de novo.\n");
+        }
+        printf("\n%d paciente(s) no segmento. Selecione uma opção: ", __atomic_load_n(&rc->segmento->qtdeCadastro, __ATOMIC_RELAXED));
+        scanf("%d", &opcao);
+        getchar();
+        Registro paciente;
+        char texto[100];
+        switch (opcao) {
+            case 1: {
+                long inseridos = compartilhado_importar_lista(rc, lista);
+                limpar_console();
+                printf("\nSUCESSO!\n%ld paciente(s) copiados (RGs já existentes foram mantidos).\n", inseridos);
+                limpar_console_dinamico();
+                break;
+            }
+            case 2: {
+                long copiados = compartilhado_exportar_lista(rc, sessao);
+                limpar_console();
+                printf("\nSUCESSO!\n%ld paciente(s) copiados para o cadastro local.\n", copiados);
+                limpar_console_dinamico();
+                break;
+            }
+            case 3: {
+                if (!ler_paciente_teclado(&paciente)) {
+                    avisar_registro_invalido();
+                    break;
+                }
+                int resultado = compartilhado_cadastrar(rc, &paciente);
+                limpar_console();
+                printf(resultado > 0 ? "\nSUCESSO!\nPaciente cadastrado!\n"
+                       : resultado == 0 ? "\nERRO!\nJá existe paciente com esse RG.\n"
+                       : resultado == -1 ? "\nERRO!\nSegmento compartilhado cheio.\n"
+                                         : "\nERRO!\nSegmento compartilhado inutilizável.\n");
+                limpar_console_dinamico();
+                break;
+            }
+            case 4:
+                printf("\nRG do paciente para remover: ");
+                fgets(texto, sizeof(texto), stdin);
+                texto[strcspn(texto, "\n")] = '\0';
+                limpar_console();
+                printf(compartilhado_remover(rc, texto) ? "\nSUCESSO!\nExclusão realizada.\n"
+                                                        : "\nERRO!\nNão existe paciente com esse RG.\n");
+                limpar_console_dinamico();
+                break;
+            case 5:
+            case 10:
+                mostrar_segmento(rc, opcao == 10);
+                break;
+            case 6:
+            case 8: {
+                printf("\nNome do paciente: ");
+                fgets(texto, sizeof(texto), stdin);
+                texto[strcspn(texto, "\n")] = '\0';
+                int status;
+                if (opcao == 6) {
+                    status = compartilhado_enfileirar(rc, texto);
+                } else {
+                    int triagem;
+                    printf("Nível de triagem (0 a %d): ", MAX_TRIAGEM);
+                    scanf("%d", &triagem);
+                    getchar();
+                    status = compartilhado_inserir_prioritario(rc, texto, triagem);
+                }
+                limpar_console();
+                printf(status == OPERACAO_OK ? "\nSUCESSO!\nPaciente adicionado à fila.\n"
+                       : status == OPERACAO_NAO_ENCONTRADO ? "\nERRO!\nPaciente não encontrado no cadastro compartilhado.\n"
+                       : status == OPERACAO_DUPLICADA      ? "\nERRO!\nEsse paciente já está nessa fila.\n"
+                                                           : "\nERRO!\nFila cheia.\n");
+                limpar_console_dinamico();
+                break;
+            }
+            case 7: {
+                EFilaCompartilhada atendido;
+                limpar_console();
+                if (compartilhado_atender(rc, &atendido)) {
+                    printf("\nSUCESSO!\nPaciente %s atendido\n", atendido.dados.nome);
+                } else {
+                    printf("\nERRO!\nNão há pacientes na fila comum compartilhada.\n");
+                }
+                limpar_console_dinamico();
+                break;
+            }
+            case 9: {
+                EHeapCompartilhado atendido;
+                limpar_console();
+                if (compartilhado_atender_prioritario(rc, &atendido)) {
+                    printf("Paciente prioritário atendido: %s (Idade: %d; Triagem: %d; Espera: %lld min)\n",
+                           atendido.dados.nome, atendido.dados.idade, atendido.prioridade.triagem,
+                           (instante_atual() - atendido.prioridade.enfileiradoEm) / 60000);
+                } else {
+                    printf("\nERRO!\nNão há pacientes na fila prioritária compartilhada.\n");
+                }
+                limpar_console_dinamico();
+                break;
+            }
+            case 11:
+                // Os terminais conectados continuam com seus mapeamentos; novos terminais criam outro segmento
+                shm_unlink(NOME_SEGMENTO_COMPARTILHADO);
+                limpar_console();
+                printf("\nSegmento apagado. Ao sair, este terminal libera sua conexão.\n");
+                limpar_console_dinamico();
+                break;
+            case 0:
+                break;
+            default:
+                printf("\nOpção inválida. Tente novamente.\n");
+                limpar_console_dinamico();
+        }
+    } while (opcao != 0);
+    desconectar_registro_compartilhado(rc);
+}
+
+// ** Módulo Teste de Leituras Isoladas ** 
+// Thread de leitura do teste de leituras isoladas: percorre versões seguidas do cadastro,
+// como fariam listagens e relatórios, conferindo se cada versão está completa
+void* executar_leitor_versoes(void *argumento) {
+    LeitorVersoes *leitor = argumento;
+    while (!__atomic_load_n(leitor->encerrar, __ATOMIC_ACQUIRE)) {
+        LeituraCadastro leitura;
+        if (!abrir_leitura_cadastro(leitor->lista, &leitura)) {
+            sched_yield();  // vagas esgotadas: tenta de novo mais tarde
+            continue;
+        }
+        Relatorio contagem = {0};
+        contagem.registros = leitor->registros;
+        percorrer_versao(leitura.versao, 0, visitar_relatorio, &contagem);
+        for (int i = 0; i < contagem.qtde; i++) {
+            if (!registro_valido(contagem.registros[i])) {
+                leitor->inconsistentes++;
+            }
+        }
+        if (contagem.qtde != leitura.versao->qtde) {
+            leitor->inconsistentes++;
+        }
+        fechar_leitura_cadastro(&leitura);
+        leitor->leituras++;
+        leitor->registrosLidos += contagem.qtde;
+    }
+    return NULL;
+}
+
+// Mede as alterações do cadastro (cadastros, atualizações e remoções) com e sem leituras
+// percorrendo o cadastro inteiro ao mesmo tempo. Com as versões, as alterações não esperam
+// pelas leituras: a latência deve ficar próxima nas duas rodadas.
+void comparar_leituras_isoladas(int n, int operacoes, int leitores) {
+    if (leitores > MAX_THREADS) leitores = MAX_THREADS;
+    printf("\nCadastro sintético: %d pacientes | %d alterações por rodada\n", n, operacoes);
+    printf("\n%-9s %12s %9s %9s %9s %10s %14s %8s\n", "Leitores", "Alterações/s", "p50(us)", "p99(us)",
+           "Máx(us)", "Leituras", "Registros/s", "Erros");
+    for (int rodada = 0; rodada < 2; rodada++) {
+        int qtdeLeitores = rodada == 0 ? 0 : leitores;
+        Lista *lista = inicializa_lista();
+        Lote *lote = iniciar_lote(n);
+        unsigned int semente = 12345;
+        Registro r;
+        for (int i = 0; i < n; i++) {
+            semente = semente * 1103515245u + 12345u;
+            snprintf(r.nome, sizeof(r.nome), "Paciente %d", i);
+            snprintf(r.rg, sizeof(r.rg), "%d", i);
+            r.idade = (int)(semente >> 16) % 100;
+            r.entrada = cria_data(1 + (int)(semente >> 5) % 28, 1 + (int)(semente >> 11) % 12, 1990 + (int)(semente >> 20) % 35);
+            adicionar_ao_lote(lote, r);
+        }
+        confirmar_lote(lista, lote);
+        liberar_lote(lote);
+        ativar_versoes_lista(lista);
+
+        int encerrar = 0;
+        LeitorVersoes estado[MAX_THREADS];
+        pthread_t threads[MAX_THREADS];
+        int capacidadeLeitura = n + operacoes + 1;
+        for (int t = 0; t < qtdeLeitores; t++) {
+            estado[t] = (LeitorVersoes){lista, &encerrar, malloc((size_t)capacidadeLeitura * sizeof(Registro *)), 0, 0, 0};
+            pthread_create(&threads[t], NULL, executar_leitor_versoes, &estado[t]);
+        }
+        // Mistura: 40% cadastros, 40% atualizações e 20% remoções
+        EstatisticasEspera latencia;
+        memset(&latencia, 0, sizeof(latencia));
+        int proximoRg = n;
+        long long inicio = instante_nanossegundos();
+        for (int i = 0; i < operacoes; i++) {
+            semente = semente * 1103515245u + 12345u;
+            int sorteio = (int)(semente >> 16) % 10;
+            char rg[20];
+            snprintf(rg, sizeof(rg), "%u", (semente >> 8) % (unsigned int)proximoRg);
+            long long antes = instante_nanossegundos();
+            ELista *no = sorteio < 4 ? NULL : consultar_paciente_rg(lista, rg);
+            if (no == NULL) {
+                snprintf(r.nome, sizeof(r.nome), "Paciente %d", proximoRg);
+                snprintf(r.rg, sizeof(r.rg), "%d", proximoRg++);
+                cadastrar_paciente(lista, r);
+            } else if (sorteio < 8) {
+                Registro novo = *no->dados;
+                novo.idade = (novo.idade + 1) % 100;
+                alterar_paciente(lista, no, &novo);
+            } else {
+                remover_paciente_rg(lista, rg);
+            }
+            registrar_atendimento(&latencia, instante_nanossegundos() - antes);
+        }
+        double segundos = (instante_nanossegundos() - inicio) / 1e9;
+        __atomic_store_n(&encerrar, 1, __ATOMIC_RELEASE);
+        long leituras = 0, inconsistentes = 0;
+        long long registros = 0;
+        for (int t = 0; t < qtdeLeitores; t++) {
+            pthread_join(threads[t], NULL);
+            leituras += estado[t].leituras;
+            inconsistentes += estado[t].inconsistentes;
+            registros += estado[t].registrosLidos;
+            free(estado[t].registros);
+        }
+        printf("%-9d %12.0f %9.1f %9.1f %9.1f %10ld %14.0f %8ld\n", qtdeLeitores, operacoes / segundos,
+               percentil_espera(&latencia, 50) / 1000.0, percentil_espera(&latencia, 99) / 1000.0,
+               latencia.maxEspera / 1000.0, leituras, registros / segundos, inconsistentes);
+        if (rodada == 1) {
+            printf("\nVersões publicadas: %ld | blocos liberados: %ld | aguardando leituras: %d\n",
+                   lista->versoes->publicadas, lista->versoes->liberados, lista->versoes->qtdeAposentados);
+        }
+        destruir_lista(lista);
+    }
+}
+
+// Opção de menu: teste de leituras isoladas do cadastro
+void menu_leituras_isoladas() {
+    int n, operacoes, leitores;
+    limpar_console();
+    printf("\nPacientes no cadastro (ex.: 20000): ");
+    scanf("%d", &n);
+    printf("Alterações por rodada (ex.: 50000): ");
+    scanf("%d", &operacoes);
+    printf("Threads de leitura (ex.: 4): ");
+    scanf("%d", &leitores);
+    getchar();
+    if (n < 1 || operacoes < 1 || leitores < 1) {
+        printf("\nERRO!\nValores inválidos.\n");
+    } else {
+        comparar_leituras_isoladas(n, operacoes, leitores);
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Sessão (Gravação e Reprodução) ** 
+
+const char *NOMES_OPERACOES[QTDE_TIPOS_OPERACAO] = {
+    "?", "cadastrar", "consultar nome", "atualizar", "remover", "listar", "enfileirar", "desenfileirar",
+    "inserir prioritário", "atender prioritário", "critério", "relatório", "desfazer", "carregar",
+    "importar", "salvar", "desistir", "posição na fila", "desistir prioritário", "posição prioritária"
+};
+
+// Cria uma sessão vazia (cadastro, filas e pilha) com as listagens enviadas para 'saida'
+Sessao* criar_sessao(FILE *saida) {
+    Sessao *sessao = malloc(sizeof(Sessao));
+    sessao->lista = inicializa_lista();
+    ativar_versoes_lista(sessao->lista);
+    sessao->fila = inicializa_fila();
+    ativar_mapa_fila(sessao->fila);
+    sessao->heap = alocar_memoria(MEM_HEAP, sizeof(Heap));
+    inicializar_heap(sessao->heap);
+    ativar_mapa_heap(sessao->heap);
+    sessao->pilha = start_stack();
+    sessao->saida = saida;
+    sessao->gravador = NULL;
+    sessao->departamentos = NULL;
+    sessao->rascunho = NULL;
+    sessao->disco = NULL;
+    return sessao;
+}
+
+// Inteiro com sinal em varint (codificação zigzag: valores pequenos ocupam poucos bytes)
+void buffer_inteiro(Buffer *buffer, long long valor) {
+    buffer_varint(buffer, ((unsigned long long)valor << 1) ^ (unsigned long long)(valor >> 63));
+}
+
+long long leitor_inteiro(Leitor *leitor) {
+    unsigned long long codificado = leitor_varint(leitor);
+    return (long long)(codificado >> 1) ^ -(long long)(codificado & 1);
+}
+
+// Texto com o tamanho na frente
+void buffer_texto(Buffer *buffer, const char *texto) {
+    size_t tamanho = strlen(texto);
+    buffer_varint(buffer, tamanho);
+    buffer_bytes(buffer, texto, tamanho);
+}
+
+void leitor_texto(Leitor *leitor, char *destino, size_t capacidade) {
+    unsigned long long tamanho = leitor_varint(leitor);
+    const unsigned char *dados = tamanho < capacidade ? leitor_bytes(leitor, (size_t)tamanho) : NULL;
+    if (dados == NULL) {
+        leitor->erro = 1;
+        destino[0] = '\0';
+        return;
+    }
+    memcpy(destino, dados, (size_t)tamanho);
+    destino[tamanho] = '\0';
+}
+
+// Paciente completo: nome, idade, RG e a data decomposta (dia, mês e ano); uma data
+// inválida vira 0/0/0
+void buffer_registro(Buffer *buffer, const Registro *paciente) {
+    buffer_texto(buffer, paciente->nome);
+    buffer_inteiro(buffer, paciente->idade);
+    buffer_texto(buffer, paciente->rg);
+    DataCalendario data = {0, 0, 0};
+    if (paciente->entrada != DATA_INVALIDA) {
+        data = data_calendario(paciente->entrada);
+    }
+    buffer_inteiro(buffer, data.dia);
+    buffer_inteiro(buffer, data.mes);
+    buffer_inteiro(buffer, data.ano);
+}
+
+void leitor_registro(Leitor *leitor, Registro *paciente) {
+    leitor_texto(leitor, paciente->nome, sizeof(paciente->nome));
+    paciente->idade = (int)leitor_inteiro(leitor);
+    leitor_texto(leitor, paciente->rg, sizeof(paciente->rg));
+    DataCalendario data;
+    data.dia = (int)leitor_inteiro(leitor);
+    data.mes = (int)leitor_inteiro(leitor);
+    data.ano = (int)leitor_inteiro(leitor);
+    paciente->entrada = cria_data(data.dia, data.mes, data.ano);
+}
+
+// Formato de cada operação: tipo (1 byte), diferença de tempo para a anterior em ms e apenas
+// os argumentos usados pelo tipo
+void codificar_operacao(Buffer *buffer, const Operacao *op, long long anterior) {
+    unsigned char tipo = (unsigned char)op->tipo;
+    buffer_bytes(buffer, &tipo, 1);
+    buffer_inteiro(buffer, op->instante - anterior);
+    switch (op->tipo) {
+        case OP_ATUALIZAR:
+            // O RG do paciente alterado e os dados completos, como no cadastro
+            buffer_texto(buffer, op->texto);
+            buffer_registro(buffer, &op->paciente);
+            break;
+        case OP_CADASTRAR:
+            buffer_registro(buffer, &op->paciente);
+            break;
+        case OP_INSERIR_PRIORITARIO:
+            buffer_texto(buffer, op->texto);
+            buffer_inteiro(buffer, op->valores[0]);
+            break;
+        case OP_CARREGAR:
+        case OP_IMPORTAR:
+            // O conteúdo lido vai junto (tamanho + 1; 0 = arquivo inexistente)
+            buffer_texto(buffer, op->texto);
+            buffer_varint(buffer, op->conteudo != NULL ? op->tamanhoConteudo + 1 : 0);
+            if (op->conteudo != NULL) {
+                buffer_bytes(buffer, op->conteudo, op->tamanhoConteudo);
+            }
+            break;
+        case OP_CONSULTAR_NOME:
+        case OP_REMOVER:
+        case OP_ENFILEIRAR:
+        case OP_SALVAR:
+        case OP_DESISTIR:
+        case OP_POSICAO_FILA:
+        case OP_DESISTIR_PRIORITARIO:
+        case OP_POSICAO_PRIORITARIO:
+            buffer_texto(buffer, op->texto);
+            break;
+        case OP_CRITERIO:
+            for (int i = 0; i < 5; i++) {
+                buffer_inteiro(buffer, op->valores[i]);
+            }
+            break;
+        case OP_RELATORIO:
+            buffer_inteiro(buffer, op->valores[0]);
+            break;
+    }
+}
+
+// Lê a próxima operação. Retorna 0 no fim da gravação ou se os dados estão corrompidos.
+int decodificar_operacao(Leitor *leitor, Operacao *op, long long anterior) {
+    if (leitor->posicao >= leitor->tamanho) {
+        return 0;
+    }
+    const unsigned char *tipo = leitor_bytes(leitor, 1);
+    if (tipo == NULL || *tipo == 0 || *tipo >= QTDE_TIPOS_OPERACAO) {
+        leitor->erro = 1;
+        return 0;
+    }
+    memset(op, 0, sizeof(Operacao));
+    op->tipo = *tipo;
+    op->instante = anterior + leitor_inteiro(leitor);
+    switch (op->tipo) {
+        case OP_ATUALIZAR:
+            leitor_texto(leitor, op->texto, sizeof(op->texto));
+            leitor_registro(leitor, &op->paciente);
+            break;
+        case OP_CADASTRAR:
+            leitor_registro(leitor, &op->paciente);
+            break;
+        case OP_INSERIR_PRIORITARIO:
+            leitor_texto(leitor, op->texto, sizeof(op->texto));
+            op->valores[0] = (int)leitor_inteiro(leitor);
+            break;
+        case OP_CARREGAR:
+        case OP_IMPORTAR: {
+            // O conteúdo aponta para os dados da própria gravação
+            leitor_texto(leitor, op->texto, sizeof(op->texto));
+            unsigned long long tamanho = leitor_varint(leitor);
+            if (tamanho > 0 && tamanho - 1 <= leitor->tamanho - leitor->posicao) {
+                op->tamanhoConteudo = (size_t)(tamanho - 1);
+                op->conteudo = leitor_bytes(leitor, op->tamanhoConteudo);
+            } else if (tamanho > 0) {
+                leitor->erro = 1;
+            }
+            break;
+        }
+        case OP_CONSULTAR_NOME:
+        case OP_REMOVER:
+        case OP_ENFILEIRAR:
+        case OP_SALVAR:
+        case OP_DESISTIR:
+        case OP_POSICAO_FILA:
+        case OP_DESISTIR_PRIORITARIO:
+        case OP_POSICAO_PRIORITARIO:
+            leitor_texto(leitor, op->texto, sizeof(op->texto));
+            break;
+        case OP_CRITERIO:
+            for (int i = 0; i < 5; i++) {
+                op->valores[i] = (int)leitor_inteiro(leitor);
+            }
+            break;
+        case OP_RELATORIO:
+            op->valores[0] = (int)leitor_inteiro(leitor);
+            break;
+    }
+    return !leitor->erro;
+}
+
+// Acrescenta uma operação ao arquivo da gravação (gravada imediatamente, para sobreviver a uma queda)
+void gravar_operacao(GravadorSessao *gravador, const Operacao *op) {
+    gravador->buffer.tamanho = 0;
+    codificar_operacao(&gravador->buffer, op, gravador->ultimoInstante);
+    if (gravador->buffer.erro) {
+        // Uma operação pela metade corromperia a gravação: ela fica de fora e é contada
+        gravador->buffer.erro = 0;
+        gravador->perdidas++;
+        return;
+    }
+    gravador->ultimoInstante = op->instante;
+    fwrite(gravador->buffer.dados, 1, gravador->buffer.tamanho, gravador->arquivo);
+    fflush(gravador->arquivo);
+    gravador->operacoes++;
+}
+
+// Lê um arquivo inteiro para a memória (em *dados, liberado por quem chamou). Retorna 1 se leu,
+// 0 se o arquivo não pôde ser aberto ou -1 se faltou memória ou a leitura falhou.
+int ler_arquivo_inteiro(const char *nomeArquivo, unsigned char **dados, size_t *tamanho) {
+    *dados = NULL;
+    *tamanho = 0;
+    FILE *arquivo = fopen(nomeArquivo, "rb");
+    if (arquivo == NULL) {
+        return 0;
+    }
+    long fim = -1;
+    if (fseek(arquivo, 0, SEEK_END) == 0) {
+        fim = ftell(arquivo);
+    }
+    if (fim < 0 || fseek(arquivo, 0, SEEK_SET) != 0 || (*dados = malloc(fim > 0 ? (size_t)fim : 1)) == NULL) {
+        fclose(arquivo);
+        return -1;
+    }
+    *tamanho = fread(*dados, 1, (size_t)fim, arquivo);
+    int erro = ferror(arquivo);
+    fclose(arquivo);
+    if (erro) {
+        free(*dados);
+        *dados = NULL;
+        *tamanho = 0;
+        return -1;
+    }
+    return 1;
+}
+
+// Arquivo usado por salvar, carregar e importar. Fora da reprodução é o arquivo digitado; na
+// reprodução é o rascunho da sessão (com a mesma extensão): os salvamentos vão para ele e as
+// leituras recebem nele o conteúdo guardado na gravação, sem tocar nos arquivos reais.
+// Retorna NULL se o arquivo não existia quando a operação foi gravada.
+const char* arquivo_da_operacao(const Sessao *sessao, const Operacao *op, char *caminho, size_t capacidade) {
+    if (sessao->rascunho == NULL) {
+        return op->texto;
+    }
+    snprintf(caminho, capacidade, "%s%s", sessao->rascunho,
+             termina_com(op->texto, EXTENSAO_COMPACTADA) ? EXTENSAO_COMPACTADA : ".txt");
+    if (op->tipo == OP_SALVAR) {
+        return caminho;
+    }
+    if (op->conteudo == NULL) {
+        return NULL;
+    }
+    FILE *arquivo = fopen(caminho, "wb");
+    if (arquivo == NULL) {
+        return NULL;
+    }
+    size_t gravados = fwrite(op->conteudo, 1, op->tamanhoConteudo, arquivo);
+    if (fclose(arquivo) != 0 || gravados != op->tamanhoConteudo) {
+        return NULL;
+    }
+    return caminho;
+}
+
+// Executa uma operação sobre a sessão e, se a sessão estiver sendo gravada, acrescenta a
+// operação ao arquivo. É o único ponto de entrada das alterações feitas pelos menus de
+// cadastro, atendimento, pesquisa, desfazer e arquivos, o que garante que a reprodução de uma
+// gravação repete exatamente o mesmo trabalho (a cópia do registro compartilhado para o
+// cadastro também passa por aqui). Com o registro em disco ativo, cadastrar, atualizar,
+// remover, carregar e importar também o mantêm em dia, e a consulta por nome é feita nele.
+// O restante das Ferramentas Avançadas fica de fora da gravação: registro compartilhado,
+// varredura por colunas, departamentos, simulação e medições trabalham sobre dados próprios
+// (ou de outros processos) e não alteram a sessão.
+int executar_operacao(Sessao *sessao, const Operacao *op, ResultadoOperacao *resultado) {
+    ResultadoOperacao local;
+    if (resultado == NULL) {
+        resultado = &local;
+    }
+    memset(resultado, 0, sizeof(ResultadoOperacao));
+    Operacao executada = *op;
+    executada.instante = instante_atual();
+    Lista *lista = sessao->lista;
+    int status = OPERACAO_OK;
+    // Com o orçamento de memória esgotado, as operações que admitem pacientes são recusadas
+    int admissao = op->tipo == OP_CADASTRAR || op->tipo == OP_ENFILEIRAR || op->tipo == OP_INSERIR_PRIORITARIO ||
+                   op->tipo == OP_CARREGAR || op->tipo == OP_IMPORTAR;
+    if (admissao && memoria_esgotada()) {
+        resultado->status = OPERACAO_RECUSADA;
+        return OPERACAO_RECUSADA;
+    }
+    // A gravação guarda o conteúdo lido por carregar e importar: a reprodução não depende do
+    // arquivo como ele estiver no dia. Sem memória para guardá-lo, a operação é recusada (como
+    // as admissões acima), para que a gravação continue fiel à sessão.
+    unsigned char *conteudoGravado = NULL;
+    if (sessao->gravador != NULL && (op->tipo == OP_CARREGAR || op->tipo == OP_IMPORTAR)) {
+        if (ler_arquivo_inteiro(op->texto, &conteudoGravado, &executada.tamanhoConteudo) < 0) {
+            resultado->status = OPERACAO_RECUSADA;
+            return OPERACAO_RECUSADA;
+        }
+        executada.conteudo = conteudoGravado;
+    }
+    char caminho[300];
+    const char *arquivo = NULL;
+    if (op->tipo == OP_CARREGAR || op->tipo == OP_IMPORTAR || op->tipo == OP_SALVAR) {
+        arquivo = arquivo_da_operacao(sessao, op, caminho, sizeof(caminho));
+    }
+    switch (op->tipo) {
+        case OP_CADASTRAR:
+            if (!registro_valido(&op->paciente)) {
+                status = OPERACAO_INVALIDA;
+                break;
+            }
+            cadastrar_paciente(lista, op->paciente);
+            if (sessao->disco != NULL) {
+                sincronizar_rg_disco(sessao->disco, lista, op->paciente.rg);
+            }
+            break;
+        case OP_CONSULTAR_NOME: {
+            if (sessao->disco != NULL) {
+                // Com o registro em disco, a consulta usa o índice de nomes do arquivo: O(log n) páginas
+                int achou = disco_consultar_nome(sessao->disco, op->texto, &resultado->registroAtendido);
+                resultado->paciente = achou ? &resultado->registroAtendido : NULL;
+                status = achou ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+                break;
+            }
+            ELista *no = consultar_paciente_nome(lista, op->texto);
+            resultado->paciente = no != NULL ? no->dados : NULL;
+            status = no != NULL ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            break;
+        }
+        case OP_ATUALIZAR: {
+            ELista *no = consultar_paciente_rg(lista, op->texto);
+            if (no == NULL) {
+                status = OPERACAO_NAO_ENCONTRADO;
+                break;
+            }
+            if (!registro_valido(&op->paciente)) {
+                status = OPERACAO_INVALIDA;
+                break;
+            }
+            char rgAnterior[sizeof(no->dados->rg)];
+            strcpy(rgAnterior, no->dados->rg);
+            alterar_paciente(lista, no, &op->paciente);
+            resultado->paciente = no->dados;
+            if (sessao->disco != NULL) {
+                sincronizar_rg_disco(sessao->disco, lista, rgAnterior);
+                sincronizar_rg_disco(sessao->disco, lista, op->paciente.rg);
+            }
+            break;
+        }
+        case OP_REMOVER: {
+            // O cadastro em memória escolhe o paciente; o disco acompanha pelo RG dele
+            ELista *no = sessao->disco != NULL ? consultar_paciente_nome(lista, op->texto) : NULL;
+            char rgRemovido[sizeof(((Registro*)0)->rg)] = "";
+            if (no != NULL) {
+                strcpy(rgRemovido, no->dados->rg);
+            }
+            status = remover_paciente_nome(lista, op->texto) ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            if (no != NULL) {
+                sincronizar_rg_disco(sessao->disco, lista, rgRemovido);
+            }
+            break;
+        }
+        case OP_LISTAR:
+            escrever_lista(lista, sessao->saida);
+            break;
+        case OP_ENFILEIRAR:
+            status = enfileirar_registro(lista, sessao->fila, sessao->pilha, op->texto, &resultado->paciente);
+            break;
+        case OP_DESENFILEIRAR:
+            resultado->paciente = desenfileirar_registro(sessao->fila, sessao->pilha);
+            status = resultado->paciente != NULL ? OPERACAO_OK : OPERACAO_RECUSADA;
+            break;
+        case OP_INSERIR_PRIORITARIO: {
+            ELista *no = consultar_paciente_nome(lista, op->texto);
+            if (no == NULL) {
+                status = OPERACAO_NAO_ENCONTRADO;
+                break;
+            }
+            if (buscar_mapa_espera(&sessao->heap->mapa, no->dados->rg) >= 0) {
+                status = OPERACAO_DUPLICADA;
+                break;
+            }
+            // O heap guarda uma cópia própria, que continua válida se o paciente for removido do cadastro
+            Registro *copia = copiar_registro(MEM_HEAP, no->dados);
+            resultado->paciente = no->dados;
+            status = inserir_heap(sessao->heap, copia, op->valores[0]) ? OPERACAO_OK : OPERACAO_RECUSADA;
+            if (status != OPERACAO_OK) {
+                destruir_registro(MEM_HEAP, copia);
+            }
+            break;
+        }
+        case OP_ATENDER_PRIORITARIO:
+            status = remover_heap(sessao->heap, &resultado->atendido) ? OPERACAO_OK : OPERACAO_RECUSADA;
+            if (status == OPERACAO_OK) {
+                // O resultado fica com uma cópia do atendido; a do heap é liberada
+                resultado->registroAtendido = *resultado->atendido.paciente;
+                destruir_registro(MEM_HEAP, resultado->atendido.paciente);
+                resultado->atendido.paciente = &resultado->registroAtendido;
+            }
+            resultado->paciente = status == OPERACAO_OK ? resultado->atendido.paciente : NULL;
+            break;
+        case OP_DESISTIR:
+            resultado->paciente = desistir_registro(sessao->fila, sessao->pilha, op->texto);
+            status = resultado->paciente != NULL ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            break;
+        case OP_POSICAO_FILA:
+            resultado->posicao = posicao_na_fila(sessao->fila, op->texto, &resultado->paciente);
+            status = resultado->posicao >= 0 ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            break;
+        case OP_DESISTIR_PRIORITARIO:
+            // Como no atendimento, o resultado fica com uma cópia do paciente e a do heap é liberada
+            status = desistir_do_heap(sessao->heap, op->texto, &resultado->atendido) ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            if (status == OPERACAO_OK) {
+                resultado->registroAtendido = *resultado->atendido.paciente;
+                destruir_registro(MEM_HEAP, resultado->atendido.paciente);
+                resultado->atendido.paciente = &resultado->registroAtendido;
+                resultado->paciente = resultado->atendido.paciente;
+            }
+            break;
+        case OP_POSICAO_PRIORITARIO:
+            resultado->posicao = posicao_no_heap(sessao->heap, op->texto, &resultado->paciente);
+            status = resultado->posicao >= 0 ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            break;
+        case OP_CRITERIO: {
+            CriterioPrioridade criterio = {op->valores[0], op->valores[1], op->valores[2], op->valores[3], op->valores[4]};
+            status = definir_criterio_heap(sessao->heap, criterio) ? OPERACAO_OK : OPERACAO_INVALIDA;
+            break;
+        }
+        case OP_RELATORIO: {
+            int ordem = op->valores[0];
+            if (ordem < 0 || ordem >= QTDE_ORDENS) {
+                status = OPERACAO_NAO_ENCONTRADO;
+                break;
+            }
+            Relatorio relatorio;
+            gerar_relatorios(lista, 1 << ordem, NULL, &relatorio);
+            escrever_relatorio(&relatorio, ordem, sessao->saida);
+            liberar_relatorio(&relatorio);
+            break;
+        }
+        case OP_DESFAZER:
+            resultado->desfeita = desfazer_operacao(sessao->pilha, sessao->fila);
+            status = resultado->desfeita != 0 ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            break;
+        case OP_CARREGAR:
+            status = arquivo != NULL && carregar_arquivo_pacientes(lista, arquivo, &resultado->resumo) ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            if (status == OPERACAO_OK && sessao->disco != NULL) {
+                sessao->disco = recriar_registro_disco(sessao->disco, lista);
+            }
+            break;
+        case OP_IMPORTAR:
+            status = arquivo != NULL && importar_lista(lista, arquivo, &resultado->resumo) ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            if (status == OPERACAO_OK && sessao->disco != NULL) {
+                sessao->disco = recriar_registro_disco(sessao->disco, lista);
+            }
+            break;
+        case OP_SALVAR:
+            status = arquivo != NULL && salvar_arquivo_pacientes(lista, arquivo) ? OPERACAO_OK : OPERACAO_NAO_ENCONTRADO;
+            break;
+        default:
+            return OPERACAO_NAO_ENCONTRADO;
+    }
+    resultado->status = status;
+    if (sessao->gravador != NULL) {
+        gravar_operacao(sessao->gravador, &executada);
+    }
+    free(conteudoGravado);
+    return status;
+}
+
+// Começa a gravar as operações da sessão no arquivo (substituindo seu conteúdo). Retorna 1 se conseguiu.
+int iniciar_gravacao(Sessao *sessao, const char *nomeArquivo) {
+    if (sessao->gravador != NULL) {
+        return 0;
+    }
+    FILE *arquivo = fopen(nomeArquivo, "wb");
+    if (arquivo == NULL) {
+        return 0;
+    }
+    fwrite(MAGICO_SESSAO, 1, 4, arquivo);
+    GravadorSessao *gravador = calloc(1, sizeof(GravadorSessao));
+    gravador->arquivo = arquivo;
+    snprintf(gravador->nomeArquivo, sizeof(gravador->nomeArquivo), "%s", nomeArquivo);
+    sessao->gravador = gravador;
+    return 1;
+}
+
+// Encerra a gravação em andamento (se houver)
+void parar_gravacao(Sessao *sessao) {
+    GravadorSessao *gravador = sessao->gravador;
+    if (gravador == NULL) {
+        return;
+    }
+    fclose(gravador->arquivo);
+    free(gravador->buffer.dados);
+    free(gravador);
+    sessao->gravador = NULL;
+}
+
+// Libera uma sessão: o cadastro, as filas, as operações da pilha e os departamentos
+void encerrar_sessao(Sessao *sessao) {
+    parar_gravacao(sessao);
+    if (sessao->departamentos != NULL) {
+        fechar_central_departamentos(sessao->departamentos);
+    }
+    if (sessao->disco != NULL) {
+        fechar_registro_disco(sessao->disco);
+    }
+    destruir_pilha(sessao->pilha);
+    destruir_fila(sessao->fila);
+    destruir_heap(sessao->heap);
+    destruir_lista(sessao->lista);
+    free(sessao);
+}
+
+// Tabela de latências por tipo de operação (amostras em ns, exibidas em us)
+void mostrar_latencias(const EstatisticasEspera *latencias) {
+    printf("\n%-20s %8s %10s %10s %10s %10s\n", "Operação", "Qtde", "Média(us)", "p50(us)", "p99(us)", "Máx(us)");
+    for (int tipo = 1; tipo < QTDE_TIPOS_OPERACAO; tipo++) {
+        const EstatisticasEspera *est = &latencias[tipo];
+        if (est->amostras == 0) {
+            continue;
+        }
+        printf("%-20s %8ld %10.1f %10.1f %10.1f %10.1f\n", NOMES_OPERACOES[tipo], est->amostras,
+               media_espera(est) / 1000.0, percentil_espera(est, 50) / 1000.0,
+               percentil_espera(est, 99) / 1000.0, est->maxEspera / 1000.0);
+    }
+}
+
+// Reexecuta uma sessão gravada sobre um cadastro vazio e mostra a latência de cada tipo de
+// operação. O relógio da sessão segue os instantes gravados, de modo que esperas e
+// envelhecimento na fila prioritária se repetem; com 'ritmoOriginal', a reprodução também
+// espera entre as operações os mesmos intervalos da gravação. Os arquivos reais não são
+// tocados: salvamentos vão para um rascunho e carregamentos leem o conteúdo gravado.
+// Retorna o número de operações reproduzidas ou -1 se o arquivo não pôde ser lido.
+long reproduzir_sessao(const char *nomeArquivo, int ritmoOriginal) {
+    size_t lidos;
+    unsigned char *dados;
+    if (ler_arquivo_inteiro(nomeArquivo, &dados, &lidos) <= 0) {
+        return -1;
+    }
+    if (lidos < 4 || memcmp(dados, MAGICO_SESSAO, 4) != 0) {
+        free(dados);
+        return -1;
+    }
+    Leitor leitor = {dados + 4, lidos - 4, 0, 0};
+    FILE *descarte = fopen("/dev/null", "w");
+    Sessao *sessao = criar_sessao(descarte != NULL ? descarte : stdout);
+    // Salvamentos e leituras de arquivos usam um rascunho ao lado da gravação
+    char rascunho[300], caminho[310];
+    snprintf(rascunho, sizeof(rascunho), "%s.reproducao", nomeArquivo);
+    sessao->rascunho = rascunho;
+    // A latência de cada tipo de operação usa o mesmo esboço de percentis das filas (em ns)
+    EstatisticasEspera *latencias = calloc(QTDE_TIPOS_OPERACAO, sizeof(EstatisticasEspera));
+    long total = 0;
+    long long anterior = 0, primeiro = -1;
+    long long inicioReal = instante_nanossegundos();
+    Operacao op;
+    while (decodificar_operacao(&leitor, &op, anterior)) {
+        anterior = op.instante;
+        if (primeiro < 0) {
+            primeiro = op.instante;
+        }
+        if (ritmoOriginal) {
+            long long atraso = (op.instante - primeiro) * 1000000LL - (instante_nanossegundos() - inicioReal);
+            if (atraso > 0) {
+                usleep((useconds_t)(atraso / 1000));
+            }
+        }
+        definir_instante_simulado(op.instante);
+        long long inicio = instante_nanossegundos();
+        executar_operacao(sessao, &op, NULL);
+        registrar_atendimento(&latencias[op.tipo], instante_nanossegundos() - inicio);
+        total++;
+    }
+    long long duracaoReal = instante_nanossegundos() - inicioReal;
+    definir_instante_simulado(-1);
+    printf("\nReprodução de %s: %ld operação(ões) em %.3f s%s\n", nomeArquivo, total, duracaoReal / 1e9,
+           leitor.erro ? " (gravação truncada)" : "");
+    if (total > 0 && !ritmoOriginal) {
+        printf("Vazão: %.0f operações/s\n", total / (duracaoReal / 1e9));
+    }
+    mostrar_latencias(latencias);
+    printf("\nCadastro ao final: %d paciente(s) | Fila comum: %d | Fila prioritária: %d\n",
+           sessao->lista->qtde, pacientes_na_fila(sessao->fila), sessao->heap->qtde);
+    free(latencias);
+    encerrar_sessao(sessao);
+    if (descarte != NULL) {
+        fclose(descarte);
+    }
+    snprintf(caminho, sizeof(caminho), "%s.txt", rascunho);
+    remove(caminho);
+    snprintf(caminho, sizeof(caminho), "%s%s", rascunho, EXTENSAO_COMPACTADA);
+    remove(caminho);
+    free(dados);
+    return total;
+}
+
+// Submenu de gravação e reprodução de sessões
+void menu_sessao(Sessao *sessao) {
+    char nome[200];
+    limpar_console();
+    if (sessao->gravador != NULL) {
+        printf("\nGravando em %s (%ld operações", sessao->gravador->nomeArquivo, sessao->gravador->operacoes);
+        if (sessao->gravador->perdidas > 0) {
+            printf("; %ld não gravadas por falta de memória", sessao->gravador->perdidas);
+        }
+        printf("). Encerrar a gravação? (s/n): ");
+        char resposta;
+        scanf(" %c", &resposta);
+        getchar();
+        if (resposta == 's' || resposta == 'S') {
+            parar_gravacao(sessao);
+            printf("\nGravação encerrada.\n");
+        }
+        limpar_console_dinamico();
+        return;
+    }
+    printf("\nArquivo da gravação (ex.: sessao.pss): ");
+    fgets(nome, sizeof(nome), stdin);
+    nome[strcspn(nome, "\n")] = '\0';
+    limpar_console();
+    if (nome[0] != '\0' && iniciar_gravacao(sessao, nome)) {
+        printf("\nSUCESSO!\nAs operações a partir de agora serão gravadas em %s.\n", nome);
+        printf("(As Ferramentas Avançadas não alteram a sessão e não são gravadas.)\n");
+    } else {
+        printf("\nERRO!\nNão foi possível criar o arquivo da gravação.\n");
+    }
+    limpar_console_dinamico();
+}
+
+// Opção de menu: reproduz uma gravação e mostra as latências
+void menu_reproduzir_sessao() {
+    char nome[200];
+    printf("\nArquivo da gravação: ");
+    fgets(nome, sizeof(nome), stdin);
+    nome[strcspn(nome, "\n")] = '\0';
+    printf("Ritmo: 1 - Velocidade máxima | 2 - Intervalos originais: ");
+    int ritmo;
+    scanf("%d", &ritmo);
+    getchar();
+    limpar_console();
+    if (reproduzir_sessao(nome, ritmo == 2) < 0) {
+        printf("\nERRO!\nNão foi possível ler a gravação %s.\n", nome);
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Simulação de Atendimento ** 
+
+// Gerador pseudoaleatório xorshift64* (a mesma semente reproduz a mesma simulação)
+unsigned long long proximo_aleatorio(unsigned long long *estado) {
+    unsigned long long x = *estado;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *estado = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Número uniforme em [0, 1)
+double aleatorio_uniforme(unsigned long long *estado) {
+    return (proximo_aleatorio(estado) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Intervalo com distribuição exponencial de média 'media' (chegadas de Poisson)
+double amostrar_exponencial(double media, unsigned long long *estado) {
+    return -media * log(1.0 - aleatorio_uniforme(estado));
+}
+
+// Duração de um atendimento conforme a distribuição configurada
+double amostrar_duracao(int distribuicao, double media, unsigned long long *estado) {
+    switch (distribuicao) {
+        case DISTRIBUICAO_FIXA:
+            return media;
+        case DISTRIBUICAO_UNIFORME:  // entre 50% e 150% da média
+            return media * (0.5 + aleatorio_uniforme(estado));
+        case DISTRIBUICAO_ERLANG: {  // soma de 4 exponenciais: menos variável que a exponencial
+            double soma = 0;
+            for (int i = 0; i < 4; i++) {
+                soma += amostrar_exponencial(media / 4, estado);
+            }
+            return soma;
+        }
+        default:
+            return amostrar_exponencial(media, estado);
+    }
+}
+
+const char *NOMES_DISTRIBUICOES[QTDE_DISTRIBUICOES] = {"exponencial", "fixa", "uniforme", "Erlang-4"};
+
+// Agenda de eventos: min-heap por instante; eventos simultâneos saem na ordem de agendamento
+int evento_antes(const EventoSimulacao *a, const EventoSimulacao *b) {
+    if (a->instante != b->instante) {
+        return a->instante < b->instante;
+    }
+    return a->sequencia < b->sequencia;
+}
+
+void agendar_evento(AgendaEventos *agenda, long long instante, int tipo, int atendente) {
+    if (agenda->qtde == agenda->capacidade) {
+        agenda->capacidade = agenda->capacidade ? agenda->capacidade * 2 : 64;
+        agenda->eventos = realloc(agenda->eventos, agenda->capacidade * sizeof(EventoSimulacao));
+    }
+    EventoSimulacao novo = {instante, agenda->sequencia++, tipo, atendente};
+    int i = agenda->qtde++;
+    while (i > 0 && evento_antes(&novo, &agenda->eventos[(i - 1) / 2])) {
+        agenda->eventos[i] = agenda->eventos[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    agenda->eventos[i] = novo;
+}
+
+// Retira o próximo evento da agenda. Retorna 0 se a agenda está vazia.
+int proximo_evento(AgendaEventos *agenda, EventoSimulacao *evento) {
+    if (agenda->qtde == 0) {
+        return 0;
+    }
+    *evento = agenda->eventos[0];
+    EventoSimulacao ultimo = agenda->eventos[--agenda->qtde];
+    int i = 0;
+    while (1) {
+        int filho = 2 * i + 1;
+        if (filho >= agenda->qtde) {
+            break;
+        }
+        if (filho + 1 < agenda->qtde && evento_antes(&agenda->eventos[filho + 1], &agenda->eventos[filho])) {
+            filho++;
+        }
+        if (!evento_antes(&agenda->eventos[filho], &ultimo)) {
+            break;
+        }
+        agenda->eventos[i] = agenda->eventos[filho];
+        i = filho;
+    }
+    agenda->eventos[i] = ultimo;
+    return 1;
+}
+
+// Paciente fictício para uma chegada; os registros atendidos são reaproveitados
+Registro* obter_registro_simulado(EstadoSimulacao *sim) {
+    Registro *paciente;
+    if (sim->qtdeReserva > 0) {
+        paciente = sim->reserva[--sim->qtdeReserva];
+    } else {
+        paciente = malloc(sizeof(Registro));
+        paciente->entrada = sim->dataSimulada;
+    }
+    long numero = sim->resultado->chegadas[0] + sim->resultado->chegadas[1];
+    snprintf(paciente->nome, sizeof(paciente->nome), "Simulado %ld", numero);
+    snprintf(paciente->rg, sizeof(paciente->rg), "%ld", numero);
+    paciente->idade = (int)(proximo_aleatorio(&sim->estado) % 100);
+    return paciente;
+}
+
+void devolver_registro_simulado(EstadoSimulacao *sim, Registro *paciente) {
+    if (sim->qtdeReserva == sim->capacidadeReserva) {
+        sim->capacidadeReserva = sim->capacidadeReserva ? sim->capacidadeReserva * 2 : 64;
+        sim->reserva = realloc(sim->reserva, sim->capacidadeReserva * sizeof(Registro *));
+    }
+    sim->reserva[sim->qtdeReserva++] = paciente;
+}
+
+// O atendente livre chama o próximo paciente: primeiro da fila que prefere, depois da outra.
+// Retorna 0 se as duas filas estão vazias.
+int chamar_proximo(EstadoSimulacao *sim, int atendente) {
+    long long agora = sim->relogio;
+    int preferida = atendente < sim->config->atendentesPrioritarios ? LINHA_PRIORITARIA : LINHA_COMUM;
+    for (int tentativa = 0; tentativa < 2; tentativa++) {
+        int linha = tentativa == 0 ? preferida : 1 - preferida;
+        Registro *paciente = NULL;
+        if (linha == LINHA_PRIORITARIA) {
+            EHeap atendido;
+            if (remover_heap_em(&sim->heap, &atendido, agora)) {
+                paciente = atendido.paciente;
+            }
+        } else {
+            paciente = retirar_da_fila_em(sim->fila, NULL, NULL, agora);
+        }
+        if (paciente == NULL) {
+            continue;
+        }
+        long long duracao = (long long)amostrar_duracao(sim->config->distribuicao, sim->mediaAtendimentoMs, &sim->estado);
+        if (duracao < 1) {
+            duracao = 1;
+        }
+        sim->emAtendimento[atendente] = paciente;
+        sim->linhaAtendimento[atendente] = linha;
+        sim->msOcupados += duracao < sim->fim - agora ? duracao : sim->fim - agora;
+        agendar_evento(&sim->agenda, agora + duracao, EVENTO_FIM_ATENDIMENTO, atendente);
+        return 1;
+    }
+    return 0;
+}
+
+// Acumula os comprimentos das filas até o instante do próximo evento (média ponderada e curva)
+void acompanhar_filas(EstadoSimulacao *sim, long long agora) {
+    int comprimento[2] = {sim->fila->qtde, sim->heap.qtde};
+    ResultadoSimulacao *resultado = sim->resultado;
+    while (sim->pontoCurva < PONTOS_CURVA && agora >= sim->proximaAmostra) {
+        resultado->curva[LINHA_COMUM][sim->pontoCurva] = comprimento[LINHA_COMUM];
+        resultado->curva[LINHA_PRIORITARIA][sim->pontoCurva] = comprimento[LINHA_PRIORITARIA];
+        sim->pontoCurva++;
+        sim->proximaAmostra = sim->fim * (sim->pontoCurva + 1) / PONTOS_CURVA;
+    }
+    for (int linha = 0; linha < 2; linha++) {
+        sim->areaFila[linha] += (double)comprimento[linha] * (agora - sim->ultimoEvento);
+        if (comprimento[linha] > resultado->maxFila[linha]) {
+            resultado->maxFila[linha] = comprimento[linha];
+        }
+    }
+    sim->ultimoEvento = agora;
+}
+
+// Simula o atendimento da clínica usando a Fila e o Heap reais sobre um relógio virtual,
+// guardado no estado da simulação e passado a cada operação (o relógio do programa, lido
+// pelas threads de salvamento e dos departamentos, não é alterado). Chegadas seguem um
+// processo de Poisson; uma parcela vai para a fila prioritária com triagem sorteada. Cada
+// atendente livre chama o próximo paciente da fila que prefere.
+void simular_atendimento(const ConfigSimulacao *config, ResultadoSimulacao *resultado) {
+    memset(resultado, 0, sizeof(ResultadoSimulacao));
+    EstadoSimulacao sim;
+    memset(&sim, 0, sizeof(EstadoSimulacao));
+    sim.config = config;
+    sim.resultado = resultado;
+    sim.estado = config->semente != 0 ? config->semente : 1;
+    sim.fim = (long long)(config->horas * 3600000.0);
+    sim.mediaAtendimentoMs = config->minutosAtendimento * 60000.0;
+    sim.proximaAmostra = sim.fim / PONTOS_CURVA;
+    sim.dataSimulada = cria_data(1, 1, 2000);
+    sim.fila = inicializa_fila();
+    inicializar_heap(&sim.heap);
+    sim.heap.limite = 0;  // na simulação a fila prioritária não tem capacidade máxima
+    sim.heap.faixaAtual = faixa_de_tempo(&sim.heap.criterio, 0);
+    sim.emAtendimento = calloc(config->atendentes, sizeof(Registro *));
+    sim.linhaAtendimento = calloc(config->atendentes, sizeof(int));
+    int *livres = malloc(config->atendentes * sizeof(int));
+    int qtdeLivres = 0;
+    for (int i = config->atendentes - 1; i >= 0; i--) {
+        livres[qtdeLivres++] = i;
+    }
+    double mediaChegadaMs = 3600000.0 / config->chegadasPorHora;
+
+    long long inicioReal = instante_nanossegundos();
+    agendar_evento(&sim.agenda, (long long)amostrar_exponencial(mediaChegadaMs, &sim.estado), EVENTO_CHEGADA, -1);
+    EventoSimulacao evento;
+    while (proximo_evento(&sim.agenda, &evento) && evento.instante <= sim.fim) {
+        acompanhar_filas(&sim, evento.instante);
+        sim.relogio = evento.instante;
+        resultado->eventos++;
+        if (evento.tipo == EVENTO_CHEGADA) {
+            Registro *paciente = obter_registro_simulado(&sim);
+            int linha = aleatorio_uniforme(&sim.estado) < config->fracaoPrioritaria ? LINHA_PRIORITARIA : LINHA_COMUM;
+            if (linha == LINHA_PRIORITARIA) {
+                inserir_heap_em(&sim.heap, paciente, 1 + (int)(proximo_aleatorio(&sim.estado) % MAX_TRIAGEM), sim.relogio);
+            } else {
+                inserir_na_fila_em(sim.fila, paciente, sim.relogio);
+            }
+            resultado->chegadas[linha]++;
+            long long intervalo = (long long)amostrar_exponencial(mediaChegadaMs, &sim.estado);
+            agendar_evento(&sim.agenda, evento.instante + intervalo, EVENTO_CHEGADA, -1);
+            if (qtdeLivres > 0) {
+                // Prefere um atendente livre dedicado à fila do paciente que chegou
+                int escolhido = qtdeLivres - 1;
+                for (int i = qtdeLivres - 1; i >= 0; i--) {
+                    if ((livres[i] < config->atendentesPrioritarios) == (linha == LINHA_PRIORITARIA)) {
+                        escolhido = i;
+                        break;
+                    }
+                }
+                int atendente = livres[escolhido];
+                livres[escolhido] = livres[--qtdeLivres];
+                chamar_proximo(&sim, atendente);
+            }
+        } else {
+            int atendente = evento.atendente;
+            resultado->concluidos[sim.linhaAtendimento[atendente]]++;
+            devolver_registro_simulado(&sim, sim.emAtendimento[atendente]);
+            sim.emAtendimento[atendente] = NULL;
+            if (!chamar_proximo(&sim, atendente)) {
+                livres[qtdeLivres++] = atendente;
+            }
+        }
+    }
+    acompanhar_filas(&sim, sim.fim);
+    resultado->segundosReais = (instante_nanossegundos() - inicioReal) / 1e9;
+
+    resultado->espera[LINHA_COMUM] = sim.fila->estatisticas;
+    resultado->espera[LINHA_PRIORITARIA] = sim.heap.estatisticas;
+    for (int linha = 0; linha < 2; linha++) {
+        resultado->mediaFila[linha] = sim.fim > 0 ? sim.areaFila[linha] / sim.fim : 0;
+    }
+    resultado->ocupacao = sim.fim > 0 ? (double)sim.msOcupados / ((double)sim.fim * config->atendentes) : 0;
+
+    // Libera os pacientes que ficaram nas filas, em atendimento ou na reserva
+    for (int i = 0; i < sim.fila->qtde; i++) {
+        free(elemento_fila(sim.fila, i)->dados);
+    }
+    for (int i = 0; i < sim.heap.qtde; i++) {
+        free(sim.heap.dados[i].paciente);
+    }
+    for (int i = 0; i < config->atendentes; i++) {
+        free(sim.emAtendimento[i]);
+    }
+    for (int i = 0; i < sim.qtdeReserva; i++) {
+        free(sim.reserva[i]);
+    }
+    free(sim.reserva);
+    liberar_fila(sim.fila);
+    liberar_heap(&sim.heap);
+    free(sim.agenda.eventos);
+    free(sim.emAtendimento);
+    free(sim.linhaAtendimento);
+    free(livres);
+}
+
+// Relatório de uma simulação: vazão, esperas das duas filas e curva de comprimento das filas
+void mostrar_resultado_simulacao(const ConfigSimulacao *config, const ResultadoSimulacao *resultado) {
+    printf("\nSimulação: %.1f h | %.1f chegadas/h (%.0f%% prioritárias) | %d atendente(s), %d com preferência pela prioritária\n",
+           config->horas, config->chegadasPorHora, config->fracaoPrioritaria * 100, config->atendentes,
+           config->atendentesPrioritarios);
+    printf("Atendimento: média de %.1f min, distribuição %s | semente %llu\n", config->minutosAtendimento,
+           NOMES_DISTRIBUICOES[config->distribuicao], config->semente);
+    printf("\n%ld eventos em %.3f s (%.2f milhões de eventos/s)\n", resultado->eventos, resultado->segundosReais,
+           resultado->segundosReais > 0 ? resultado->eventos / resultado->segundosReais / 1e6 : 0.0);
+    printf("Ocupação dos atendentes: %.1f%%\n", resultado->ocupacao * 100);
+    const char *titulos[2] = {"Fila Comum", "Fila Prioritária"};
+    for (int linha = 0; linha < 2; linha++) {
+        printf("\n%s: %ld chegadas | %ld atendimentos concluídos (%.1f/h) | comprimento médio %.1f, máximo %d\n",
+               titulos[linha], resultado->chegadas[linha], resultado->concluidos[linha],
+               resultado->concluidos[linha] / config->horas, resultado->mediaFila[linha], resultado->maxFila[linha]);
+        mostrar_estatisticas(titulos[linha], &resultado->espera[linha]);
+    }
+    // Curva do comprimento das filas ao fim de cada intervalo (barras proporcionais ao maior valor)
+    int maior = 1;
+    for (int i = 0; i < PONTOS_CURVA; i++) {
+        for (int linha = 0; linha < 2; linha++) {
+            if (resultado->curva[linha][i] > maior) {
+                maior = resultado->curva[linha][i];
+            }
+        }
+    }
+    printf("\nComprimento das filas ao longo do tempo (C = comum, P = prioritária):\n");
+    for (int i = 0; i < PONTOS_CURVA; i++) {
+        double horas = config->horas * (i + 1) / PONTOS_CURVA;
+        printf("%6.1f h | C %6d %-30.*s| P %6d %.*s\n", horas,
+               resultado->curva[LINHA_COMUM][i], resultado->curva[LINHA_COMUM][i] * 30 / maior,
+               "##############################",
+               resultado->curva[LINHA_PRIORITARIA][i], resultado->curva[LINHA_PRIORITARIA][i] * 30 / maior,
+               "##############################");
+    }
+}
+
+// Compara quadros de atendentes e políticas com as mesmas chegadas (mesma semente): de
+// N-2 a N+2 atendentes, todos chamando a prioritária primeiro ou só um quarto deles
+void comparar_politicas_simulacao(const ConfigSimulacao *base) {
+    printf("\n%-10s %-14s %9s %12s %12s %12s %12s\n", "Atendentes", "Preferem P", "Ocupação",
+           "p50 C (min)", "p99 C (min)", "p50 P (min)", "p99 P (min)");
+    for (int atendentes = base->atendentes - 2; atendentes <= base->atendentes + 2; atendentes++) {
+        if (atendentes < 1) {
+            continue;
+        }
+        int preferencias[2] = {atendentes, (atendentes + 3) / 4};
+        for (int p = 0; p < 2; p++) {
+            if (p == 1 && preferencias[1] == preferencias[0]) {
+                continue;
+            }
+            ConfigSimulacao config = *base;
+            config.atendentes = atendentes;
+            config.atendentesPrioritarios = preferencias[p];
+            ResultadoSimulacao resultado;
+            simular_atendimento(&config, &resultado);
+            printf("%-10d %-14d %8.1f%% %12.1f %12.1f %12.1f %12.1f\n", atendentes, preferencias[p],
+                   resultado.ocupacao * 100,
+                   percentil_espera(&resultado.espera[LINHA_COMUM], 50) / 60000.0,
+                   percentil_espera(&resultado.espera[LINHA_COMUM], 99) / 60000.0,
+                   percentil_espera(&resultado.espera[LINHA_PRIORITARIA], 50) / 60000.0,
+                   percentil_espera(&resultado.espera[LINHA_PRIORITARIA], 99) / 60000.0);
+        }
+    }
+}
+
+// Submenu da simulação: lê os parâmetros, roda e mostra o relatório ou a comparação
+void menu_simulacao() {
+    ConfigSimulacao config = {60, 0.2, 12, DISTRIBUICAO_EXPONENCIAL, 14, 14, 24, 42};
+    limpar_console();
+    printf("\nSimulação de atendimento (Enter mantém o valor padrão)\n");
+    char linha[100];
+    printf("Chegadas por hora [%.0f]: ", config.chegadasPorHora);
+    if (fgets(linha, sizeof(linha), stdin) && atof(linha) > 0) config.chegadasPorHora = atof(linha);
+    printf("Parcela prioritária, de 0 a 1 [%.2f]: ", config.fracaoPrioritaria);
+    if (fgets(linha, sizeof(linha), stdin) && linha[0] != '\n') config.fracaoPrioritaria = atof(linha);
+    printf("Duração média do atendimento em minutos [%.0f]: ", config.minutosAtendimento);
+    if (fgets(linha, sizeof(linha), stdin) && atof(linha) > 0) config.minutosAtendimento = atof(linha);
+    printf("Distribuição (0 exponencial, 1 fixa, 2 uniforme, 3 Erlang-4) [%d]: ", config.distribuicao);
+    if (fgets(linha, sizeof(linha), stdin) && linha[0] != '\n') config.distribuicao = atoi(linha);
+    printf("Atendentes [%d]: ", config.atendentes);
+    if (fgets(linha, sizeof(linha), stdin) && atoi(linha) > 0) config.atendentes = atoi(linha);
+    config.atendentesPrioritarios = config.atendentes;
+    printf("Atendentes que chamam primeiro a prioritária [%d]: ", config.atendentesPrioritarios);
+    if (fgets(linha, sizeof(linha), stdin) && linha[0] != '\n') config.atendentesPrioritarios = atoi(linha);
+    printf("Horas simuladas [%.0f]: ", config.horas);
+    if (fgets(linha, sizeof(linha), stdin) && atof(linha) > 0) config.horas = atof(linha);
+    printf("Semente [%llu]: ", config.semente);
+    if (fgets(linha, sizeof(linha), stdin) && linha[0] != '\n') config.semente = strtoull(linha, NULL, 10);
+    printf("1 - Simular | 2 - Comparar quadros de atendentes e políticas: ");
+    int opcao = 1;
+    if (fgets(linha, sizeof(linha), stdin)) opcao = atoi(linha);
+    if (config.distribuicao < 0 || config.distribuicao >= QTDE_DISTRIBUICOES) {
+        config.distribuicao = DISTRIBUICAO_EXPONENCIAL;
+    }
+    if (config.fracaoPrioritaria < 0) config.fracaoPrioritaria = 0;
+    if (config.fracaoPrioritaria > 1) config.fracaoPrioritaria = 1;
+    if (config.atendentesPrioritarios < 0) config.atendentesPrioritarios = 0;
+    if (config.atendentesPrioritarios > config.atendentes) config.atendentesPrioritarios = config.atendentes;
+    limpar_console();
+    if (opcao == 2) {
+        comparar_politicas_simulacao(&config);
+    } else {
+        ResultadoSimulacao resultado;
+        simular_atendimento(&config, &resultado);
+        mostrar_resultado_simulacao(&config, &resultado);
+    }
+    limpar_console_dinamico();
+}
+
+// ** Módulo Departamentos (Filas por Especialidade) ** 
+
+// Operações do deque circular de um departamento (chamador segura a trava da linha).
+// A quantidade é publicada de forma atômica para que atendentes de outras linhas possam
+// avaliar o acúmulo sem travar.
+void deque_inserir_fim(Departamento *dep, ItemDepartamento item) {
+    if (dep->qtde == dep->capacidade) {
+        int novaCapacidade = dep->capacidade ? dep->capacidade * 2 : CAPACIDADE_INICIAL_DEQUE;
+        ItemDepartamento *novos = alocar_memoria(MEM_DEPARTAMENTOS, novaCapacidade * sizeof(ItemDepartamento));
+        for (int i = 0; i < dep->qtde; i++) {
+            novos[i] = dep->itens[(dep->inicio + i) % dep->capacidade];
+        }
+        liberar_memoria(MEM_DEPARTAMENTOS, dep->itens, dep->capacidade * sizeof(ItemDepartamento));
+        dep->itens = novos;
+        dep->capacidade = novaCapacidade;
+        dep->inicio = 0;
+    }
+    dep->itens[(dep->inicio + dep->qtde) % dep->capacidade] = item;
+    __atomic_store_n(&dep->qtde, dep->qtde + 1, __ATOMIC_RELEASE);
+}
+
+void deque_retirar_inicio(Departamento *dep, ItemDepartamento *item) {
+    *item = dep->itens[dep->inicio];
+    dep->inicio = (dep->inicio + 1) % dep->capacidade;
+    __atomic_store_n(&dep->qtde, dep->qtde - 1, __ATOMIC_RELEASE);
+}
+
+// Acrescenta um departamento. Por padrão seus atendentes podem ajudar todas as outras linhas
+// quando elas acumulam LIMIAR_ROUBO_PADRAO pacientes. Toda linha precisa de ao menos um
+// atendente próprio (sem ele, seus pacientes dependeriam da ajuda de outras linhas). Retorna
+// o índice ou -1 se não há espaço ou os atendentes passariam de MAX_ATENDENTES.
+int adicionar_departamento(CentralDepartamentos *central, const char *nome, int atendentes, int tempoAtendimentoMs) {
+    int somaAtendentes = atendentes;
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        somaAtendentes += central->departamentos[d].atendentes;
+    }
+    if (central->qtdeDepartamentos == MAX_DEPARTAMENTOS || central->qtdeAtendentes > 0 || atendentes < 1 ||
+        tempoAtendimentoMs < 0 || somaAtendentes > MAX_ATENDENTES) {
+        return -1;
+    }
+    int indice = central->qtdeDepartamentos++;
+    Departamento *dep = &central->departamentos[indice];
+    memset(dep, 0, sizeof(Departamento));
+    snprintf(dep->nome, sizeof(dep->nome), "%s", nome);
+    pthread_mutex_init(&dep->trava, NULL);
+    pthread_cond_init(&dep->sinal, NULL);
+    dep->atendentes = atendentes;
+    dep->tempoAtendimentoMs = tempoAtendimentoMs;
+    dep->mascaraAjuda = ~(1u << indice);
+    dep->limiarRoubo = LIMIAR_ROUBO_PADRAO;
+    return indice;
+}
+
+// Cria a central com os departamentos padrão da clínica (atendentes parados)
+CentralDepartamentos* criar_central_departamentos() {
+    CentralDepartamentos *central = calloc(1, sizeof(CentralDepartamentos));
+    const char *nomes[] = {"Clínica Geral", "Pediatria", "Ortopedia", "Cardiologia"};
+    for (int i = 0; i < 4; i++) {
+        adicionar_departamento(central, nomes[i], 2, 20);
+    }
+    return central;
+}
+
+// Coloca uma cópia do paciente no fim da linha do departamento e acorda um atendente dela
+void enfileirar_departamento(CentralDepartamentos *central, int indice, const Registro *paciente) {
+    Departamento *dep = &central->departamentos[indice];
+    ItemDepartamento item;
+    item.paciente = copiar_registro(MEM_DEPARTAMENTOS, paciente);
+    item.enfileiradoEm = instante_atual();
+    pthread_mutex_lock(&dep->trava);
+    deque_inserir_fim(dep, item);
+    dep->chegadas++;
+    if (dep->qtde > dep->maiorFila) {
+        dep->maiorFila = dep->qtde;
+    }
+    registrar_entrada(&dep->espera);
+    pthread_cond_signal(&dep->sinal);
+    pthread_mutex_unlock(&dep->trava);
+}
+
+// Atendente ocioso procura a linha elegível mais acumulada e atende o paciente da frente dela,
+// como fariam os atendentes da própria linha: a linha continua em ordem de chegada e as
+// esperas medidas não dependem de quem atendeu. A trava é só a da linha roubada. Retorna o
+// índice da linha roubada ou -1 se nenhuma linha está acima do limiar.
+int roubar_paciente(CentralDepartamentos *central, int proprio, ItemDepartamento *item) {
+    unsigned mascara = __atomic_load_n(&central->departamentos[proprio].mascaraAjuda, __ATOMIC_RELAXED);
+    int vitima = -1, maiorAcumulo = 0;
+    for (int i = 0; i < central->qtdeDepartamentos; i++) {
+        if (i == proprio || !(mascara & (1u << i))) {
+            continue;
+        }
+        int acumulo = __atomic_load_n(&central->departamentos[i].qtde, __ATOMIC_ACQUIRE);
+        if (acumulo >= __atomic_load_n(&central->departamentos[i].limiarRoubo, __ATOMIC_RELAXED) && acumulo > maiorAcumulo) {
+            vitima = i;
+            maiorAcumulo = acumulo;
+        }
+    }
+    if (vitima < 0) {
+        return -1;
+    }
+    Departamento *dep = &central->departamentos[vitima];
+    pthread_mutex_lock(&dep->trava);
+    // Confere de novo sob a trava: os atendentes da linha podem ter esvaziado o acúmulo
+    int roubou = dep->qtde > 0 && dep->qtde >= dep->limiarRoubo;
+    if (roubou) {
+        deque_retirar_inicio(dep, item);
+        registrar_atendimento(&dep->espera, instante_atual() - item->enfileiradoEm);
+        dep->roubados++;
+    }
+    pthread_mutex_unlock(&dep->trava);
+    return roubou ? vitima : -1;
+}
+
+// Laço de um atendente: atende a própria linha em ordem de chegada; ocioso, ajuda outra linha
+void* executar_atendente(void *argumento) {
+    AtendenteDepartamento *atendente = argumento;
+    CentralDepartamentos *central = atendente->central;
+    Departamento *dep = &central->departamentos[atendente->departamento];
+    while (!__atomic_load_n(&central->encerrar, __ATOMIC_ACQUIRE)) {
+        ItemDepartamento item;
+        int origem = -1;
+        pthread_mutex_lock(&dep->trava);
+        if (dep->qtde > 0) {
+            deque_retirar_inicio(dep, &item);
+            registrar_atendimento(&dep->espera, instante_atual() - item.enfileiradoEm);
+            origem = atendente->departamento;
+        }
+        pthread_mutex_unlock(&dep->trava);
+        if (origem < 0) {
+            origem = roubar_paciente(central, atendente->departamento, &item);
+            if (origem >= 0) {
+                __atomic_fetch_add(&dep->ajudas, 1, __ATOMIC_RELAXED);
+            }
+        }
+        if (origem < 0) {
+            // Nada a fazer: espera um paciente na própria linha ou reavalia as outras em breve
+            struct timespec limite;
+            clock_gettime(CLOCK_REALTIME, &limite);
+            limite.tv_nsec += ESPERA_OCIOSA_MS * 1000000L;
+            if (limite.tv_nsec >= 1000000000L) {
+                limite.tv_sec++;
+                limite.tv_nsec -= 1000000000L;
+            }
+            pthread_mutex_lock(&dep->trava);
+            if (dep->qtde == 0 && !__atomic_load_n(&central->encerrar, __ATOMIC_ACQUIRE)) {
+                pthread_cond_timedwait(&dep->sinal, &dep->trava, &limite);
+            }
+            pthread_mutex_unlock(&dep->trava);
+            continue;
+        }
+        // O atendimento dura o tempo configurado na linha de origem do paciente
+        int duracaoMs = central->departamentos[origem].tempoAtendimentoMs;
+        if (duracaoMs > 0) {
+            usleep((useconds_t)duracaoMs * 1000);
+        }
+        destruir_registro(MEM_DEPARTAMENTOS, item.paciente);
+        __atomic_fetch_add(&dep->atendidos, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Inicia as threads dos atendentes de todos os departamentos. Retorna quantas foram criadas.
+int iniciar_atendentes(CentralDepartamentos *central) {
+    if (central->qtdeAtendentes > 0) {
+        return central->qtdeAtendentes;
+    }
+    __atomic_store_n(&central->encerrar, 0, __ATOMIC_RELEASE);
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        for (int k = 0; k < central->departamentos[d].atendentes && central->qtdeAtendentes < MAX_ATENDENTES; k++) {
+            AtendenteDepartamento *atendente = &central->atendentes[central->qtdeAtendentes];
+            memset(atendente, 0, sizeof(AtendenteDepartamento));
+            atendente->central = central;
+            atendente->departamento = d;
+            if (pthread_create(&atendente->thread, NULL, executar_atendente, atendente) == 0) {
+                central->qtdeAtendentes++;
+            }
+        }
+    }
+    return central->qtdeAtendentes;
+}
+
+// Para os atendentes (cada um termina o atendimento em curso); os pacientes seguem nas linhas
+void parar_atendentes(CentralDepartamentos *central) {
+    __atomic_store_n(&central->encerrar, 1, __ATOMIC_RELEASE);
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        pthread_mutex_lock(&central->departamentos[d].trava);
+        pthread_cond_broadcast(&central->departamentos[d].sinal);
+        pthread_mutex_unlock(&central->departamentos[d].trava);
+    }
+    for (int i = 0; i < central->qtdeAtendentes; i++) {
+        pthread_join(central->atendentes[i].thread, NULL);
+    }
+    central->qtdeAtendentes = 0;
+}
+
+// Para os atendentes e libera as linhas com os pacientes que ainda aguardavam
+void fechar_central_departamentos(CentralDepartamentos *central) {
+    parar_atendentes(central);
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        Departamento *dep = &central->departamentos[d];
+        ItemDepartamento item;
+        while (dep->qtde > 0) {
+            deque_retirar_inicio(dep, &item);
+            destruir_registro(MEM_DEPARTAMENTOS, item.paciente);
+        }
+        liberar_memoria(MEM_DEPARTAMENTOS, dep->itens, dep->capacidade * sizeof(ItemDepartamento));
+        pthread_mutex_destroy(&dep->trava);
+        pthread_cond_destroy(&dep->sinal);
+    }
+    free(central);
+}
+
+// Total de atendimentos concluídos em todas as linhas
+long atendimentos_concluidos(const CentralDepartamentos *central) {
+    long soma = 0;
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        soma += __atomic_load_n(&central->departamentos[d].atendidos, __ATOMIC_RELAXED);
+    }
+    return soma;
+}
+
+// Métricas por linha: acúmulo atual e máximo, roubos sofridos e feitos e tempos de espera
+void mostrar_metricas_departamentos(CentralDepartamentos *central) {
+    printf("\n%-3s %-18s %5s %8s %7s %7s %10s %10s %10s %9s %9s\n", "#", "Departamento", "Atend", "Chegadas",
+           "Fila", "Máx", "Roubados", "Ajudas", "Atendidos", "p50 (ms)", "p99 (ms)");
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        Departamento *dep = &central->departamentos[d];
+        pthread_mutex_lock(&dep->trava);
+        printf("%-3d %-18s %5d %8ld %7d %7d %10ld %10ld %10ld %9lld %9lld\n", d + 1, dep->nome, dep->atendentes,
+               dep->chegadas, dep->qtde, dep->maiorFila, dep->roubados, __atomic_load_n(&dep->ajudas, __ATOMIC_RELAXED),
+               __atomic_load_n(&dep->atendidos, __ATOMIC_RELAXED),
+               percentil_espera(&dep->espera, 50), percentil_espera(&dep->espera, 99));
+        pthread_mutex_unlock(&dep->trava);
+    }
+    printf("\nRoubados = pacientes da linha levados por atendentes de outra; Ajudas = atendimentos\n");
+    printf("feitos pelos atendentes da linha em outras linhas. Atendentes %s.\n",
+           central->qtdeAtendentes > 0 ? "em execução" : "parados");
+}
+
+// Teste de carga: distribui 'total' pacientes de forma desigual (peso 1/(d+1) para o
+// departamento d, sobrecarregando os primeiros) e espera as linhas esvaziarem. Se nenhum
+// atendimento é concluído por ESPERA_CARGA_MS além do atendimento mais longo, desiste e
+// mostra as linhas que ficaram com pacientes.
+void teste_carga_departamentos(CentralDepartamentos *central, const Lista *lista, int total) {
+    int iniciou = central->qtdeAtendentes == 0;
+    iniciar_atendentes(central);
+    double pesos[MAX_DEPARTAMENTOS], somaPesos = 0;
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        pesos[d] = 1.0 / (d + 1);
+        somaPesos += pesos[d];
+    }
+    unsigned long long estado = 0x9E3779B97F4A7C15ULL;
+    Data dataSintetica = cria_data(1, 1, 2024);
+    const ELista *noCadastro = lista->inicio;
+    long concluidosAntes = atendimentos_concluidos(central);
+    long long inicio = instante_nanossegundos();
+    for (int i = 0; i < total; i++) {
+        Registro paciente;
+        if (noCadastro != NULL) {
+            paciente = *noCadastro->dados;
+            noCadastro = noCadastro->proximo != NULL ? noCadastro->proximo : lista->inicio;
+        } else {
+            snprintf(paciente.nome, sizeof(paciente.nome), "Paciente %d", i + 1);
+            snprintf(paciente.rg, sizeof(paciente.rg), "%d", i + 1);
+            paciente.idade = (int)(proximo_aleatorio(&estado) % 100);
+            paciente.entrada = dataSintetica;
+        }
+        double sorteio = aleatorio_uniforme(&estado) * somaPesos;
+        int d = 0;
+        while (d < central->qtdeDepartamentos - 1 && sorteio >= pesos[d]) {
+            sorteio -= pesos[d];
+            d++;
+        }
+        enfileirar_departamento(central, d, &paciente);
+    }
+    // Espera os atendentes concluírem todos os pacientes do teste, enquanto houver progresso
+    int maiorAtendimentoMs = 0;
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        if (central->departamentos[d].tempoAtendimentoMs > maiorAtendimentoMs) {
+            maiorAtendimentoMs = central->departamentos[d].tempoAtendimentoMs;
+        }
+    }
+    long long limiteSemProgresso = ESPERA_CARGA_MS + (long long)maiorAtendimentoMs;
+    long concluidos = atendimentos_concluidos(central);
+    long long ultimoProgresso = instante_nanossegundos();
+    while (concluidos < concluidosAntes + total &&
+           (instante_nanossegundos() - ultimoProgresso) / 1000000 < limiteSemProgresso) {
+        usleep(1000);
+        long agora = atendimentos_concluidos(central);
+        if (agora != concluidos) {
+            concluidos = agora;
+            ultimoProgresso = instante_nanossegundos();
+        }
+    }
+    double segundos = (instante_nanossegundos() - inicio) / 1e9;
+    if (concluidos < concluidosAntes + total) {
+        printf("\nERRO!\nSó %ld de %d pacientes atendidos em %.2f s; sem progresso há %lld ms. Linhas paradas:\n",
+               concluidos - concluidosAntes, total, segundos, limiteSemProgresso);
+        for (int d = 0; d < central->qtdeDepartamentos; d++) {
+            int aguardando = __atomic_load_n(&central->departamentos[d].qtde, __ATOMIC_ACQUIRE);
+            if (aguardando > 0) {
+                printf("- %s: %d paciente(s) aguardando\n", central->departamentos[d].nome, aguardando);
+            }
+        }
+    } else {
+        printf("\n%d pacientes atendidos em %.2f s (%.0f atendimentos/s)\n", total, segundos, total / segundos);
+    }
+    mostrar_metricas_departamentos(central);
+    if (iniciou) {
+        parar_atendentes(central);
+    }
+}
+
+// Lê o número (1 a N) de um departamento. Retorna o índice ou -1 se inválido.
+int ler_departamento(const CentralDepartamentos *central) {
+    for (int d = 0; d < central->qtdeDepartamentos; d++) {
+        printf("%d - %s\n", d + 1, central->departamentos[d].nome);
+    }
+    printf("Departamento: ");
+    int numero;
+    if (scanf("%d", &numero) != 1) {
+        numero = 0;
+    }
+    getchar();
+    return numero >= 1 && numero <= central->qtdeDepartamentos ? numero - 1 : -1;
+}
+
+// Define quais linhas os atendentes de um departamento podem ajudar e o limiar de acúmulo
+// a partir do qual a linha deste departamento aceita ajuda
+void configurar_regras_departamento(CentralDepartamentos *central) {
+    int d = ler_departamento(central);
+    if (d < 0) {
+        printf("\nERRO!\nDepartamento inválido.\n");
+        return;
+    }
+    Departamento *dep = &central->departamentos[d];
+    char linha[200];
+    printf("Linhas que os atendentes de %s podem ajudar (números separados por espaço, 0 = nenhuma): ", dep->nome);
+    fgets(linha, sizeof(linha), stdin);
+    unsigned mascara = 0;
+    char *cursor = linha, *fim;
+    for (long numero = strtol(cursor, &fim, 10); fim != cursor; numero = strtol(cursor, &fim, 10)) {
+        if (numero >= 1 && numero <= central->qtdeDepartamentos && numero - 1 != d) {
+            mascara |= 1u << (numero - 1);
+        }
+        cursor = fim;
+    }
+    printf("Acúmulo mínimo na linha de %s para receber ajuda [%d]: ", dep->nome, dep->limiarRoubo);
+    fgets(linha, sizeof(linha), stdin);
+    pthread_mutex_lock(&dep->trava);
+    __atomic_store_n(&dep->mascaraAjuda, mascara, __ATOMIC_RELAXED);
+    if (atoi(linha) > 0) {
+        __atomic_store_n(&dep->limiarRoubo, atoi(linha), __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&dep->trava);
+    printf("\nSUCESSO!\nRegras de %s atualizadas.\n", dep->nome);
+}
+
+// Submenu dos departamentos: linhas por especialidade atendidas por threads de atendentes
+void menu_departamentos(Sessao *sessao) {
+    if (sessao->departamentos == NULL) {
+        sessao->departamentos = criar_central_departamentos();
+    }
+    CentralDepartamentos *central = sessao->departamentos;
+    int opcao;
+    do {
+        limpar_console();
+        printf("\n╔════════════════════════════════════════════╗\n");
+        printf("║        DEPARTAMENTOS (ESPECIALIDADES)      ║\n");
+        printf("╠════════════════════════════════════════════╣\n");
+        printf("║ 1 - Métricas por departamento              ║\n");
+        printf("║ 2 - Enfileirar paciente em departamento    ║\n");
+        printf("║ 3 - Iniciar/parar atendentes               ║\n");
+        printf("║ 4 - Novo departamento                      ║\n");
+        printf("║ 5 - Regras de ajuda entre linhas           ║\n");
+        printf("║ 6 - Teste de carga                         ║\n");
+        printf("║ 0 - Voltar                                 ║\n");
+        printf("╚════════════════════════════════════════════╝\n");
+        printf("\nSelecione uma opção: ");
+        scanf("%d", &opcao);
+        getchar();
+        switch (opcao) {
+            case 1:
+                limpar_console();
+                mostrar_metricas_departamentos(central);
+                limpar_console_dinamico();
+                break;
+            case 2: {
+                char nome[100];
+                printf("\nNome do paciente: ");
+                fgets(nome, sizeof(nome), stdin);
+                nome[strcspn(nome, "\n")] = '\0';
+                ELista *no = consultar_paciente_nome(sessao->lista, nome);
+                if (no == NULL) {
+                    printf("\nERRO!\nPaciente não encontrado no cadastro.\n");
+                } else {
+                    int d = ler_departamento(central);
+                    if (d < 0) {
+                        printf("\nERRO!\nDepartamento inválido.\n");
+                    } else {
+                        enfileirar_departamento(central, d, no->dados);
+                        printf("\nSUCESSO!\nPaciente %s na linha de %s.\n", no->dados->nome, central->departamentos[d].nome);
+                    }
+                }
+                limpar_console_dinamico();
+                break;
+            }
+            case 3:
+                if (central->qtdeAtendentes > 0) {
+                    parar_atendentes(central);
+                    printf("\nAtendentes parados; os pacientes continuam nas linhas.\n");
+                } else {
+                    printf("\n%d atendente(s) em execução.\n", iniciar_atendentes(central));
+                }
+                limpar_console_dinamico();
+                break;
+            case 4: {
+                if (central->qtdeAtendentes > 0) {
+                    printf("\nERRO!\nPare os atendentes antes de criar um departamento.\n");
+                    limpar_console_dinamico();
+                    break;
+                }
+                char nome[40];
+                int atendentes, tempo;
+                printf("\nNome do departamento: ");
+                fgets(nome, sizeof(nome), stdin);
+                nome[strcspn(nome, "\n")] = '\0';
+                printf("Atendentes: ");
+                scanf("%d", &atendentes);
+                printf("Duração de cada atendimento (ms): ");
+                scanf("%d", &tempo);
+                getchar();
+                if (adicionar_departamento(central, nome, atendentes, tempo) < 0) {
+                    printf("\nERRO!\nNão foi possível criar o departamento (ao menos 1 atendente; limites de %d "
+                           "departamentos e %d atendentes no total).\n", MAX_DEPARTAMENTOS, MAX_ATENDENTES);
+                } else {
+                    printf("\nSUCESSO!\nDepartamento %s criado.\n", nome);
+                }
+                limpar_console_dinamico();
+                break;
+            }
+            case 5:
+                printf("\n");
+                configurar_regras_departamento(central);
+                limpar_console_dinamico();
+                break;
+            case 6: {
+                int total;
+                printf("\nQuantidade de pacientes: ");
+                scanf("%d", &total);
+                getchar();
+                limpar_console();
+                if (total > 0) {
+                    teste_carga_departamentos(central, sessao->lista, total);
+                }
+                limpar_console_dinamico();
+                break;
+            }
+            case 0:
+                break;
+            default:
+                printf("\nOpção inválida. Tente novamente.\n");
+                limpar_console_dinamico();
+        }
+    } while (opcao != 0);
+}
+
+// ** Módulo Servidor Local (Socket Unix) ** 
+
+// Protocolo: cada requisição é uma operação no formato das gravações de sessão (instante 0),
+// precedida do seu tamanho em varint. Cada resposta, também precedida do tamanho, traz status,
+// operação desfeita, posição, o paciente envolvido (se houver) e o texto gerado por listagens
+// e relatórios. As respostas saem na ordem das requisições, de modo que o cliente pode enviar
+// várias requisições seguidas sem esperar pelas respostas.
+
+volatile sig_atomic_t servidorEncerrando = 0;
+
+void sinal_encerrar_servidor(int sinal) {
+    (void)sinal;
+    servidorEncerrando = 1;
+}
+
+// Acrescenta ao buffer o tamanho de 'conteudo' seguido do próprio conteúdo
+void buffer_quadro(Buffer *buffer, const Buffer *conteudo) {
+    buffer_varint(buffer, conteudo->tamanho);
+    buffer_bytes(buffer, conteudo->dados, conteudo->tamanho);
+}
+
+// Separa o próximo quadro do leitor. Retorna 1 com o conteúdo em 'quadro', 0 se os bytes
+// ainda não formam um quadro inteiro ou -1 se o tamanho é inválido ou passa do limite.
+int leitor_quadro(Leitor *leitor, Leitor *quadro, size_t limite) {
+    Leitor tentativa = *leitor;
+    unsigned long long tamanho = leitor_varint(&tentativa);
+    if (tentativa.erro) {
+        return leitor->tamanho - leitor->posicao >= 10 ? -1 : 0;
+    }
+    if (tamanho > limite) {
+        return -1;
+    }
+    if (tentativa.tamanho - tentativa.posicao < tamanho) {
+        return 0;
+    }
+    quadro->dados = tentativa.dados + tentativa.posicao;
+    quadro->tamanho = (size_t)tamanho;
+    quadro->posicao = 0;
+    quadro->erro = 0;
+    leitor->posicao = tentativa.posicao + (size_t)tamanho;
+    return 1;
+}
+
+// Acrescenta ao buffer uma requisição com a operação (usa 'rascunho' para medir o tamanho)
+void codificar_requisicao(Buffer *buffer, Buffer *rascunho, const Operacao *op) {
+    Operacao semInstante = *op;
+    semInstante.instante = 0;
+    rascunho->tamanho = 0;
+    codificar_operacao(rascunho, &semInstante, 0);
+    buffer_quadro(buffer, rascunho);
+}
+
+// Conteúdo da resposta a uma operação executada
+void codificar_resposta(Buffer *buffer, const ResultadoOperacao *resultado, const char *texto, size_t tamanhoTexto) {
+    buffer_inteiro(buffer, resultado->status);
+    buffer_inteiro(buffer, resultado->desfeita);
+    buffer_inteiro(buffer, resultado->posicao);
+    buffer_varint(buffer, resultado->paciente != NULL);
+    if (resultado->paciente != NULL) {
+        buffer_registro(buffer, resultado->paciente);
+    }
+    buffer_varint(buffer, tamanhoTexto);
+    buffer_bytes(buffer, texto, tamanhoTexto);
+}
+
+// Preenche o endereço do socket. Retorna 0 se o caminho não cabe.
+int endereco_socket(struct sockaddr_un *endereco, const char *caminho) {
+    memset(endereco, 0, sizeof(*endereco));
+    endereco->sun_family = AF_UNIX;
+    if (strlen(caminho) >= sizeof(endereco->sun_path)) {
+        return 0;
+    }
+    strcpy(endereco->sun_path, caminho);
+    return 1;
+}
+
+// Cria o socket de escuta (não bloqueante), substituindo um socket antigo no mesmo caminho
+int abrir_socket_servidor(const char *caminho) {
+    struct sockaddr_un endereco;
+    if (!endereco_socket(&endereco, caminho)) {
+        return -1;
+    }
+    int escuta = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (escuta < 0) {
+        return -1;
+    }
+    unlink(caminho);
+    if (bind(escuta, (struct sockaddr *)&endereco, sizeof(endereco)) != 0 || listen(escuta, SOMAXCONN) != 0) {
+        close(escuta);
+        return -1;
+    }
+    return escuta;
+}
+
+// Aceita todas as conexões pendentes no socket de escuta
+void aceitar_conexoes(ServidorLocal *servidor) {
+    int descritor;
+    while ((descritor = accept(servidor->escuta, NULL, NULL)) >= 0) {
+        // Uma conexão que não pode ser preparada é fechada: o laço nunca espera por ela
+        int flags = fcntl(descritor, F_GETFL);
+        ConexaoServidor *conexao = NULL;
+        if (flags < 0 || fcntl(descritor, F_SETFL, flags | O_NONBLOCK) != 0 || fcntl(descritor, F_SETFD, FD_CLOEXEC) != 0 ||
+            (conexao = calloc(1, sizeof(ConexaoServidor))) == NULL) {
+            close(descritor);
+            continue;
+        }
+        conexao->descritor = descritor;
+        conexao->eventos = EPOLLIN;
+        struct epoll_event evento = {.events = EPOLLIN, .data.ptr = conexao};
+        if (epoll_ctl(servidor->epoll, EPOLL_CTL_ADD, descritor, &evento) != 0) {
+            close(descritor);
+            free(conexao);
+            continue;
+        }
+        conexao->proxima = servidor->abertas;
+        if (servidor->abertas != NULL) {
+            servidor->abertas->anterior = conexao;
+        }
+        servidor->abertas = conexao;
+        servidor->conexoes++;
+    }
+}
+
+void fechar_conexao(ServidorLocal *servidor, ConexaoServidor *conexao) {
+    epoll_ctl(servidor->epoll, EPOLL_CTL_DEL, conexao->descritor, NULL);
+    close(conexao->descritor);
+    if (conexao->anterior != NULL) {
+        conexao->anterior->proxima = conexao->proxima;
+    } else {
+        servidor->abertas = conexao->proxima;
+    }
+    if (conexao->proxima != NULL) {
+        conexao->proxima->anterior = conexao->anterior;
+    }
+    free(conexao->entrada.dados);
+    free(conexao->saida.dados);
+    free(conexao);
+}
+
+// Troca o arquivo pedido por um cliente (salvar, carregar, importar) pelo caminho dentro do
+// diretório de dados do servidor. Só são aceitos nomes simples, sem '/' e sem começar por '.':
+// o cliente não escolhe onde o servidor lê ou grava. Retorna 0 se o nome foi recusado ou se o
+// caminho não cabe.
+int arquivo_do_cliente(const char *diretorio, char *texto, size_t capacidade) {
+    if (texto[0] == '\0' || texto[0] == '.' || strchr(texto, '/') != NULL) {
+        return 0;
+    }
+    char caminho[300];
+    int tamanho = snprintf(caminho, sizeof(caminho), "%s/%s", diretorio, texto);
+    if (tamanho < 0 || (size_t)tamanho >= capacidade) {
+        return 0;
+    }
+    memcpy(texto, caminho, (size_t)tamanho + 1);
+    return 1;
+}
+
+// Executa, na ordem de chegada, as requisições completas recebidas do cliente e acumula as
+// respostas. Pedidos de arquivo fora do diretório de dados são recusados com OPERACAO_INVALIDA. Retorna 0 quando não restam requisições completas, 1 se parou porque as
+// respostas pendentes atingiram o limite ou -1 se o cliente enviou dados inválidos.
+int atender_requisicoes(ServidorLocal *servidor, ConexaoServidor *conexao) {
+    Leitor leitor = {conexao->entrada.dados, conexao->entrada.tamanho, 0, 0};
+    int estado = 0;
+    while (estado == 0) {
+        if (conexao->saida.tamanho - conexao->enviados >= LIMITE_SAIDA_CONEXAO) {
+            estado = 1;
+            break;
+        }
+        Leitor quadro;
+        int lido = leitor_quadro(&leitor, &quadro, LIMITE_REQUISICAO);
+        if (lido == 0) {
+            break;
+        }
+        Operacao op;
+        if (lido < 0 || !decodificar_operacao(&quadro, &op, 0) || quadro.posicao != quadro.tamanho) {
+            estado = -1;
+            break;
+        }
+        // Listagens e relatórios são capturados para seguir na resposta
+        char *texto = NULL;
+        size_t tamanhoTexto = 0;
+        FILE *captura = NULL;
+        ResultadoOperacao resultado;
+        servidor->requisicoes++;
+        if ((op.tipo == OP_CARREGAR || op.tipo == OP_IMPORTAR || op.tipo == OP_SALVAR) &&
+            !arquivo_do_cliente(servidor->diretorioDados, op.texto, sizeof(op.texto))) {
+            memset(&resultado, 0, sizeof(resultado));
+            resultado.status = OPERACAO_INVALIDA;
+        } else {
+            if (op.tipo == OP_LISTAR || op.tipo == OP_RELATORIO) {
+                captura = open_memstream(&texto, &tamanhoTexto);
+                servidor->sessao->saida = captura != NULL ? captura : servidor->descarte;
+            }
+            long long inicio = instante_nanossegundos();
+            executar_operacao(servidor->sessao, &op, &resultado);
+            registrar_atendimento(&servidor->latencias[op.tipo], instante_nanossegundos() - inicio);
+        }
+        if (captura != NULL) {
+            fclose(captura);
+            servidor->sessao->saida = servidor->descarte;
+        }
+        servidor->rascunho.tamanho = 0;
+        codificar_resposta(&servidor->rascunho, &resultado, texto, tamanhoTexto);
+        buffer_quadro(&conexao->saida, &servidor->rascunho);
+        free(texto);
+        if (servidor->rascunho.erro || conexao->saida.erro) {
+            servidor->rascunho.erro = 0;  // sem memória para a resposta: a conexão é fechada
+            estado = -1;
+            break;
+        }
+    }
+    // Mantém no buffer só o que ainda não foi atendido
+    memmove(conexao->entrada.dados, conexao->entrada.dados + leitor.posicao, conexao->entrada.tamanho - leitor.posicao);
+    conexao->entrada.tamanho -= leitor.posicao;
+    return estado;
+}
 
-    // Reorganiza o heap para manter o paciente mais velho no topo
-    construir(heap);
+// Envia o que o socket aceitar das respostas pendentes. Retorna 0 se o cliente desconectou.
+int enviar_respostas(ConexaoServidor *conexao) {
+    while (conexao->enviados < conexao->saida.tamanho) {
+        ssize_t enviados = send(conexao->descritor, conexao->saida.dados + conexao->enviados,
+                                conexao->saida.tamanho - conexao->enviados, MSG_NOSIGNAL);
+        if (enviados < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        conexao->enviados += (size_t)enviados;
+    }
+    conexao->saida.tamanho = 0;
+    conexao->enviados = 0;
+    return 1;
 }
 
-// Mostra todos os pacientes presentes na fila de atendimento prioritário (heap)
-void mostrar_heap(const Heap *heap) {
-    if (heap->qtde == 0) {
-        limpar_console();
-        printf("\nERRO!\nFila Prioritária Vazia.\n");
-        limpar_console_dinamico();
-        return;
+// Trata um evento de uma conexão (leitura e/ou escrita). Retorna 0 se ela deve ser fechada.
+int tratar_conexao(ServidorLocal *servidor, ConexaoServidor *conexao, unsigned int eventos) {
+    if (eventos & EPOLLIN) {
+        if (!buffer_reservar(&conexao->entrada, LIMITE_REQUISICAO)) {
+            return 0;
+        }
+        ssize_t lidos = recv(conexao->descritor, conexao->entrada.dados + conexao->entrada.tamanho,
+                             conexao->entrada.capacidade - conexao->entrada.tamanho, 0);
+        if (lidos == 0 || (lidos < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            return 0;
+        }
+        if (lidos > 0) {
+            conexao->entrada.tamanho += (size_t)lidos;
+        }
+    } else if (eventos & (EPOLLHUP | EPOLLERR)) {
+        return 0;
     }
-    limpar_console();
-    printf("\nPacientes na fila prioritária:\n");
-    // Percorre o array do heap mostrando os pacientes em cada posição (não necessariamente em ordem de prioridade)
-    for (int i = 0; i < heap->qtde; i++) {
-        Registro *p = heap->dados[i];
-        printf("%d. Nome: %s; Idade: %d; RG: %s; Entrada: %02d/%02d/%04d\n",
-               i + 1, p->nome, p->idade, p->rg, p->entrada->dia, p->entrada->mes, p->entrada->ano);
+    // Se as respostas escoaram por completo, as requisições que esperavam por isso já podem
+    // ser atendidas (nenhum novo evento de leitura chegaria por elas)
+    int estado;
+    do {
+        estado = atender_requisicoes(servidor, conexao);
+        if (estado < 0 || !enviar_respostas(conexao)) {
+            return 0;
+        }
+    } while (estado > 0 && conexao->saida.tamanho == 0);
+    // Com muitas respostas pendentes, deixa de ler até o cliente consumi-las
+    size_t pendentes = conexao->saida.tamanho - conexao->enviados;
+    int interesse = (pendentes < LIMITE_SAIDA_CONEXAO ? EPOLLIN : 0) | (pendentes > 0 ? EPOLLOUT : 0);
+    if (interesse != conexao->eventos) {
+        struct epoll_event evento = {.events = (unsigned int)interesse, .data.ptr = conexao};
+        epoll_ctl(servidor->epoll, EPOLL_CTL_MOD, conexao->descritor, &evento);
+        conexao->eventos = interesse;
     }
-    limpar_console_dinamico();
+    return 1;
 }
 
-// ** Módulo Pesquisa de Pacientes (ABB) ** 
+// Modo servidor: atende clientes locais no socket até receber SIGINT ou SIGTERM. Um único
+// laço de eventos executa as requisições, uma de cada vez, sobre a mesma sessão (que também
+// pode estar sendo gravada). Os clientes só salvam e carregam arquivos de 'diretorioDados'.
+// Retorna 0 ao encerrar normalmente.
+int executar_servidor(const char *caminho, const char *arquivoGravacao, const char *diretorioDados) {
+    ServidorLocal servidor;
+    memset(&servidor, 0, sizeof(servidor));
+    servidor.diretorioDados = diretorioDados;
+    servidor.escuta = abrir_socket_servidor(caminho);
+    if (servidor.escuta < 0) {
+        fprintf(stderr, "Não foi possível abrir o socket %s\n", caminho);
+        return 1;
+    }
+    servidor.epoll = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event escuta = {.events = EPOLLIN, .data.ptr = NULL};
+    if (servidor.epoll < 0 || epoll_ctl(servidor.epoll, EPOLL_CTL_ADD, servidor.escuta, &escuta) != 0) {
+        fprintf(stderr, "Não foi possível preparar o laço de eventos do servidor\n");
+        if (servidor.epoll >= 0) {
+            close(servidor.epoll);
+        }
+        close(servidor.escuta);
+        unlink(caminho);
+        return 1;
+    }
+    servidor.descarte = fopen("/dev/null", "w");
+    servidor.sessao = criar_sessao(servidor.descarte != NULL ? servidor.descarte : stdout);
+    servidor.latencias = calloc(QTDE_TIPOS_OPERACAO, sizeof(EstatisticasEspera));
+    if (arquivoGravacao != NULL && !iniciar_gravacao(servidor.sessao, arquivoGravacao)) {
+        fprintf(stderr, "Não foi possível criar a gravação %s\n", arquivoGravacao);
+    }
+    // Sem SA_RESTART: o sinal interrompe o epoll_wait e o laço confere o pedido de encerramento
+    struct sigaction acao;
+    memset(&acao, 0, sizeof(acao));
+    acao.sa_handler = sinal_encerrar_servidor;
+    sigaction(SIGINT, &acao, NULL);
+    sigaction(SIGTERM, &acao, NULL);
+    printf("Servidor atendendo em %s, arquivos em %s (Ctrl+C encerra)\n", caminho, diretorioDados);
+    fflush(stdout);
 
-// Cria uma nova árvore binária de busca vazia
-ABB* cria_abb() {
-    ABB *novaABB = malloc(sizeof(ABB));
-    if (novaABB != NULL) {
-        novaABB->raiz = NULL;
-        novaABB->qtde = 0;
+    struct epoll_event eventos[MAX_EVENTOS_SERVIDOR];
+    long long inicio = instante_nanossegundos();
+    while (!servidorEncerrando) {
+        int qtde = epoll_wait(servidor.epoll, eventos, MAX_EVENTOS_SERVIDOR, -1);
+        // Cada descritor aparece no máximo uma vez por rodada, então fechar aqui é seguro
+        for (int i = 0; i < qtde; i++) {
+            ConexaoServidor *conexao = eventos[i].data.ptr;
+            if (conexao == NULL) {
+                aceitar_conexoes(&servidor);
+            } else if (!tratar_conexao(&servidor, conexao, eventos[i].events)) {
+                fechar_conexao(&servidor, conexao);
+            }
+        }
     }
-    return novaABB;
+    double segundos = (instante_nanossegundos() - inicio) / 1e9;
+
+    printf("\nServidor encerrado: %ld conexão(ões), %ld requisição(ões) em %.1f s\n",
+           servidor.conexoes, servidor.requisicoes, segundos);
+    mostrar_latencias(servidor.latencias);
+    while (servidor.abertas != NULL) {
+        fechar_conexao(&servidor, servidor.abertas);
+    }
+    close(servidor.escuta);
+    close(servidor.epoll);
+    unlink(caminho);
+    encerrar_sessao(servidor.sessao);
+    if (servidor.descarte != NULL) {
+        fclose(servidor.descarte);
+    }
+    free(servidor.rascunho.dados);
+    free(servidor.latencias);
+    return 0;
 }
 
-// Cria um novo nó (vértice) da ABB a partir de um registro de paciente
-EABB* cria_vertice(Registro paciente) {
-    EABB *novoVertice = malloc(sizeof(EABB));
-    if (novoVertice != NULL) {
-        novoVertice->dados = malloc(sizeof(Registro));
-        *(novoVertice->dados) = paciente;
-        novoVertice->filhoEsq = NULL;
-        novoVertice->filhoDir = NULL;
+// Conecta ao servidor local (socket bloqueante). Retorna -1 se não conseguiu.
+int conectar_servidor_local(const char *caminho) {
+    struct sockaddr_un endereco;
+    if (!endereco_socket(&endereco, caminho)) {
+        return -1;
     }
-    return novoVertice;
+    int descritor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (descritor >= 0 && connect(descritor, (struct sockaddr *)&endereco, sizeof(endereco)) != 0) {
+        close(descritor);
+        descritor = -1;
+    }
+    return descritor;
 }
 
-// Insere um paciente na ABB de acordo com um critério de comparação fornecido
-void inserir_abb(ABB *arvore, Registro paciente, int (*criterio)(Registro, Registro)) {
-    EABB *novoNo = cria_vertice(paciente);
-    if (arvore->raiz == NULL) {
-        // Insere na raiz se a árvore estiver vazia
-        arvore->raiz = novoNo;
-    } else {
-        // Percorre a árvore até encontrar a posição de inserção adequada
-        EABB *atual = arvore->raiz;
-        EABB *anterior = NULL;
-        while (atual != NULL) {
-            anterior = atual;
-            if (criterio(paciente, *(atual->dados)) <= 0) {
-                atual = atual->filhoEsq;
-            } else {
-                atual = atual->filhoDir;
-            }
+// Envia todo o buffer. Retorna 0 se a conexão caiu.
+int enviar_tudo(int descritor, const Buffer *buffer) {
+    if (buffer->erro) {
+        return 0;  // a montagem das requisições ficou sem memória
+    }
+    size_t enviados = 0;
+    while (enviados < buffer->tamanho) {
+        ssize_t n = send(descritor, buffer->dados + enviados, buffer->tamanho - enviados, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
         }
-        // Insere o novo nó como filho esquerdo ou direito do último nó visitado
-        if (criterio(paciente, *(anterior->dados)) <= 0) {
-            anterior->filhoEsq = novoNo;
-        } else {
-            anterior->filhoDir = novoNo;
+        if (n <= 0) {
+            return 0;
         }
+        enviados += (size_t)n;
     }
-    arvore->qtde++;
+    return 1;
 }
 
-// Realiza o percurso in-order (ordem simétrica) na ABB e imprime os pacientes em ordem crescente de acordo com o critério atual
-void imprimir_in_ordem(EABB *raiz) {
-    if (raiz != NULL) {
-        imprimir_in_ordem(raiz->filhoEsq);
-        printf("Nome: %s; Idade: %d; RG: %s; Entrada: %02d/%02d/%04d\n",
-               raiz->dados->nome, raiz->dados->idade, raiz->dados->rg,
-               raiz->dados->entrada->dia, raiz->dados->entrada->mes, raiz->dados->entrada->ano);
-        imprimir_in_ordem(raiz->filhoDir);
+// Recebe respostas até completar ao menos uma e devolve o status de cada resposta completa
+// em 'status' (no máximo 'maximo'). Retorna quantas foram lidas ou -1 se a conexão caiu.
+int receber_respostas(int descritor, Buffer *entrada, long long *status, int maximo) {
+    for (;;) {
+        Leitor leitor = {entrada->dados, entrada->tamanho, 0, 0};
+        Leitor quadro;
+        int qtde = 0, lido = 0;
+        while (qtde < maximo && (lido = leitor_quadro(&leitor, &quadro, SIZE_MAX)) > 0) {
+            status[qtde++] = leitor_inteiro(&quadro);
+        }
+        if (lido < 0) {
+            return -1;
+        }
+        if (qtde > 0) {
+            memmove(entrada->dados, entrada->dados + leitor.posicao, entrada->tamanho - leitor.posicao);
+            entrada->tamanho -= leitor.posicao;
+            return qtde;
+        }
+        if (!buffer_reservar(entrada, 65536)) {
+            return -1;
+        }
+        ssize_t n = recv(descritor, entrada->dados + entrada->tamanho, entrada->capacidade - entrada->tamanho, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        entrada->tamanho += (size_t)n;
     }
 }
 
-// Funções de comparação para dois registros de paciente, usadas na ordenação da ABB
-int comparar_por_ano(Registro a, Registro b) {
-    return a.entrada->ano - b.entrada->ano;
-}
-int comparar_por_mes(Registro a, Registro b) {
-    return a.entrada->mes - b.entrada->mes;
-}
-int comparar_por_dia(Registro a, Registro b) {
-    return a.entrada->dia - b.entrada->dia;
-}
-int comparar_por_idade(Registro a, Registro b) {
-    return a.idade - b.idade;
+// Operação sorteada pelo gerador de carga: metade consultas, o restante dividido entre as filas
+void sortear_operacao_carga(Operacao *op, unsigned long long *estado) {
+    memset(op, 0, sizeof(Operacao));
+    int sorteio = (int)(proximo_aleatorio(estado) % 100);
+    int paciente = (int)(proximo_aleatorio(estado) % PACIENTES_CARGA);
+    op->tipo = sorteio < 50 ? OP_CONSULTAR_NOME : sorteio < 65 ? OP_ENFILEIRAR : sorteio < 80 ? OP_DESENFILEIRAR :
+               sorteio < 90 ? OP_INSERIR_PRIORITARIO : OP_ATENDER_PRIORITARIO;
+    snprintf(op->texto, sizeof(op->texto), "Carga %d", paciente);
+    op->valores[0] = 1 + paciente % 5;
 }
 
-// Reconstrói a ABB a partir da lista de pacientes usando um critério de comparação especificado
-void reconstruir_abb(Lista *lista, ABB *arvore, int (*criterio)(Registro, Registro)) {
-    // Remove nós anteriores (não implementado – poderia ser adicionado se necessário)
-    // Percorre a lista encadeada e insere cada paciente na ABB de acordo com o critério
-    for (ELista *noAtual = lista->inicio; noAtual != NULL; noAtual = noAtual->proximo) {
-        inserir_abb(arvore, *(noAtual->dados), criterio);
+// Thread de uma conexão do gerador de carga: mantém 'profundidade' requisições em trânsito
+// e mede o tempo de cada uma, do envio até a chegada da resposta
+void* executar_cliente_carga(void *arg) {
+    ClienteCarga *cliente = arg;
+    int descritor = conectar_servidor_local(cliente->caminho);
+    if (descritor < 0) {
+        cliente->falhou = 1;
+        return NULL;
+    }
+    long long *enviadasEm = malloc(sizeof(long long) * cliente->profundidade);
+    long long *status = malloc(sizeof(long long) * cliente->profundidade);
+    Buffer saida = {0}, rascunho = {0}, entrada = {0};
+    int enviadas = 0, recebidas = 0;
+    Operacao op;
+    while (recebidas < cliente->requisicoes) {
+        // Completa a janela (os instantes de envio formam uma fila circular, como as respostas)
+        saida.tamanho = 0;
+        long long agora = instante_nanossegundos();
+        while (enviadas < cliente->requisicoes && enviadas - recebidas < cliente->profundidade) {
+            sortear_operacao_carga(&op, &cliente->estado);
+            codificar_requisicao(&saida, &rascunho, &op);
+            enviadasEm[enviadas % cliente->profundidade] = agora;
+            enviadas++;
+        }
+        if (saida.tamanho > 0 && !enviar_tudo(descritor, &saida)) {
+            cliente->falhou = 1;
+            break;
+        }
+        int qtde = receber_respostas(descritor, &entrada, status, enviadas - recebidas);
+        if (qtde < 0) {
+            cliente->falhou = 1;
+            break;
+        }
+        agora = instante_nanossegundos();
+        for (int i = 0; i < qtde; i++, recebidas++) {
+            registrar_atendimento(&cliente->latencia, agora - enviadasEm[recebidas % cliente->profundidade]);
+            if (status[i] != OPERACAO_OK) {
+                cliente->erros++;
+            }
+        }
     }
+    close(descritor);
+    free(enviadasEm);
+    free(status);
+    free(saida.dados);
+    free(rascunho.dados);
+    free(entrada.dados);
+    return NULL;
 }
 
-// ** Módulo Arquivos (Carregar/Salvar Dados) ** 
-
-// Salva todos os pacientes da lista em um arquivo de texto (nome especificado)
-void salvar_lista(Lista *lista, const char *nomeArquivo) {
-    FILE *arquivo = fopen(nomeArquivo, "w");
-    if (arquivo == NULL) {
-        limpar_console();
-        printf("\nERRO!\nDesculpe, tivemos problemas para acessar a base de clientes\n");
-        limpar_console_dinamico();
-        return;
+// Cadastra no servidor os pacientes usados pela carga ("Carga 0", "Carga 1", ...), em uma
+// única rajada de requisições. Retorna 0 se o servidor não respondeu.
+int preparar_carga(const char *caminho) {
+    int descritor = conectar_servidor_local(caminho);
+    if (descritor < 0) {
+        return 0;
     }
-    // Escreve cada paciente em uma linha do arquivo, com campos separados por delimitadores
-    for (ELista *noAtual = lista->inicio; noAtual != NULL; noAtual = noAtual->proximo) {
-        fprintf(arquivo, "Nome: %s; Idade: %d; RG: %s; Entrada: %02d/%02d/%04d\n",
-                noAtual->dados->nome, noAtual->dados->idade, noAtual->dados->rg,
-                noAtual->dados->entrada->dia, noAtual->dados->entrada->mes, noAtual->dados->entrada->ano);
+    Buffer saida = {0}, rascunho = {0}, entrada = {0};
+    Operacao op;
+    memset(&op, 0, sizeof(op));
+    // Numa segunda carga sobre o mesmo servidor os pacientes já estão cadastrados
+    op.tipo = OP_CONSULTAR_NOME;
+    snprintf(op.texto, sizeof(op.texto), "Carga %d", PACIENTES_CARGA - 1);
+    codificar_requisicao(&saida, &rascunho, &op);
+    long long status[64];
+    int ok = enviar_tudo(descritor, &saida) && receber_respostas(descritor, &entrada, status, 1) == 1;
+    int recebidas = ok && status[0] == OPERACAO_OK ? PACIENTES_CARGA : 0;
+    saida.tamanho = 0;
+    op.tipo = OP_CADASTRAR;
+    for (int i = 0; i < PACIENTES_CARGA && recebidas == 0; i++) {
+        snprintf(op.paciente.nome, sizeof(op.paciente.nome), "Carga %d", i);
+        snprintf(op.paciente.rg, sizeof(op.paciente.rg), "C%d", i);
+        op.paciente.idade = i % 100;
+        op.paciente.entrada = cria_data(1 + i % 28, 1 + i % 12, 2020);
+        codificar_requisicao(&saida, &rascunho, &op);
     }
-    fclose(arquivo);
-    limpar_console();
-    printf("\nSUCESSO!\nBase de pacientes atualizada!\n");
-    limpar_console_dinamico();
+    ok = ok && enviar_tudo(descritor, &saida);
+    while (ok && recebidas < PACIENTES_CARGA) {
+        int qtde = receber_respostas(descritor, &entrada, status, 64);
+        ok = qtde > 0;
+        recebidas += qtde;
+    }
+    close(descritor);
+    free(saida.dados);
+    free(rascunho.dados);
+    free(entrada.dados);
+    return ok;
 }
 
-// Carrega os pacientes de um arquivo de texto para a lista (substituindo os dados atuais da lista)
-void carregar_lista(Lista *lista, const char *nomeArquivo) {
-    FILE *arquivo = fopen(nomeArquivo, "r");
-    if (arquivo == NULL) {
-        printf("\nERRO!\nDesculpe, tivemos problemas ao acessar a base de clientes\n");
-        limpar_console_dinamico();
-        return;
+// Gerador de carga: 'conexoes' clientes simultâneos, cada um com 'requisicoes' requisições e
+// até 'profundidade' delas em trânsito. Mostra a vazão e a latência vista pelos clientes.
+int executar_carga(const char *caminho, int conexoes, int requisicoes, int profundidade) {
+    if (conexoes < 1) conexoes = 1;
+    if (requisicoes < 1) requisicoes = 1;
+    if (profundidade < 1) profundidade = 1;
+    if (!preparar_carga(caminho)) {
+        fprintf(stderr, "Não foi possível conectar ao servidor em %s\n", caminho);
+        return 1;
     }
-    char linha[256];
-    // Lê o arquivo linha por linha, criando um novo registro para cada linha
-    while (fgets(linha, sizeof(linha), arquivo) != NULL) {
-        Registro novoRegistro;
-        int dia, mes, ano;
-        // Extrai os campos do paciente da linha formatada
-        sscanf(linha, "Nome: %[^;]; Idade: %d; RG: %[^;]; Entrada: %d/%d/%d",
-               novoRegistro.nome, &novoRegistro.idade, novoRegistro.rg, &dia, &mes, &ano);
-        // Remove espaços e quebras de linha ao final do nome e do RG
-        size_t len;
-        len = strlen(novoRegistro.nome);
-        while (len > 0 && (novoRegistro.nome[len-1] == ' ' || novoRegistro.nome[len-1] == '\n')) {
-            novoRegistro.nome[len-1] = '\0';
-            len--;
-        }
-        len = strlen(novoRegistro.rg);
-        while (len > 0 && (novoRegistro.rg[len-1] == ' ' || novoRegistro.rg[len-1] == '\n')) {
-            novoRegistro.rg[len-1] = '\0';
-            len--;
-        }
-        // Cria a estrutura Data para a data de entrada e atribui ao novo registro
-        novoRegistro.entrada = cria_data(dia, mes, ano);
-        // Insere o novo registro na lista encadeada de pacientes
-        cadastrar_paciente(lista, novoRegistro);
+    ClienteCarga *clientes = calloc(conexoes, sizeof(ClienteCarga));
+    pthread_t *threads = malloc(sizeof(pthread_t) * conexoes);
+    int *criada = calloc(conexoes, sizeof(int));
+    long long inicio = instante_nanossegundos();
+    for (int i = 0; i < conexoes; i++) {
+        clientes[i].caminho = caminho;
+        clientes[i].requisicoes = requisicoes;
+        clientes[i].profundidade = profundidade;
+        clientes[i].estado = 0x9E3779B97F4A7C15ULL * (unsigned long long)(i + 1);
+        criada[i] = pthread_create(&threads[i], NULL, executar_cliente_carga, &clientes[i]) == 0;
     }
-    fclose(arquivo);
-    limpar_console();
-    printf("\nSUCESSO!\nDados importados!\n");
-    limpar_console_dinamico();
+    // Junta os esboços de latência das conexões em um só
+    EstatisticasEspera total;
+    memset(&total, 0, sizeof(total));
+    long erros = 0;
+    int falhas = 0;
+    int naoCriadas = 0;
+    for (int i = 0; i < conexoes; i++) {
+        if (!criada[i]) {
+            naoCriadas++;
+            continue;
+        }
+        pthread_join(threads[i], NULL);
+        const EstatisticasEspera *est = &clientes[i].latencia;
+        total.amostras += est->amostras;
+        total.somaEspera += est->somaEspera;
+        if (est->maxEspera > total.maxEspera) {
+            total.maxEspera = est->maxEspera;
+        }
+        for (int f = 0; f < FAIXAS_ESBOCO; f++) {
+            total.contagem[f] += est->contagem[f];
+        }
+        erros += clientes[i].erros;
+        falhas += clientes[i].falhou;
+    }
+    double segundos = (instante_nanossegundos() - inicio) / 1e9;
+    printf("\nCarga: %d conexão(ões) x %d requisição(ões), profundidade %d\n", conexoes, requisicoes, profundidade);
+    printf("Respostas: %ld em %.3f s (%.0f requisições/s)\n", total.amostras, segundos,
+           segundos > 0 ? total.amostras / segundos : 0.0);
+    printf("Latência (us): média %.1f | p50 %.1f | p99 %.1f | máx %.1f\n", media_espera(&total) / 1000.0,
+           percentil_espera(&total, 50) / 1000.0, percentil_espera(&total, 99) / 1000.0, total.maxEspera / 1000.0);
+    printf("Respostas sem sucesso (fila vazia, paciente já na fila...): %ld\n", erros);
+    if (falhas > 0) {
+        printf("Conexões perdidas: %d\n", falhas);
+    }
+    if (naoCriadas > 0) {
+        printf("Conexões não iniciadas (falha ao criar a thread): %d\n", naoCriadas);
+    }
+    free(clientes);
+    free(threads);
+    free(criada);
+    return falhas > 0 || naoCriadas > 0;
+}
+
+// ** Módulo Ferramentas Avançadas ** 
+
+// Submenu com os recursos de armazenamento e desempenho
+void menu_ferramentas(Sessao *sessao) {
+    int opcao;
+    do {
+        limpar_console();
+        printf("\n╔════════════════════════════════════════════╗\n");
+        printf("║           FERRAMENTAS AVANÇADAS            ║\n");
+        printf("╠════════════════════════════════════════════╣\n");
+        printf("║ 1 - Registro em disco (B+tree)             ║\n");
+        printf("║ 2 - Varredura por colunas (filtros)        ║\n");
+        printf("║ 3 - Gravar sessão (iniciar/encerrar)       ║\n");
+        printf("║ 4 - Reproduzir sessão gravada              ║\n");
+        printf("║ 5 - Simulação de atendimento               ║\n");
+        printf("║ 6 - Departamentos (filas por especialidade)║\n");
+        printf("║ 7 - Memória (uso e orçamento)              ║\n");
+        printf("║ 8 - Desempenho da fila (anel x encadeada)  ║\n");
+        printf("║ 9 - Terminais (memória compartilhada)      ║\n");
+        printf("║ 10 - Leituras isoladas (versões)           ║\n");
+        printf("║ 0 - Voltar ao menu principal               ║\n");
+        printf("╚════════════════════════════════════════════╝\n");
+        printf("\nSelecione uma opção: ");
+        scanf("%d", &opcao);
+        getchar();
+        switch (opcao) {
+            case 1:
+                menu_registro_disco(sessao);
+                break;
+            case 2:
+                menu_varredura_colunas(sessao->lista);
+                break;
+            case 3:
+                menu_sessao(sessao);
+                break;
+            case 4:
+                menu_reproduzir_sessao();
+                break;
+            case 5:
+                menu_simulacao();
+                break;
+            case 6:
+                menu_departamentos(sessao);
+                break;
+            case 7:
+                menu_memoria();
+                break;
+            case 8:
+                menu_desempenho_fila();
+                break;
+            case 9:
+                menu_registro_compartilhado(sessao);
+                break;
+            case 10:
+                menu_leituras_isoladas();
+                break;
+            case 0:
+                printf("\nVoltando ao menu principal...\n");
+                break;
+            default:
+                printf("\nOpção inválida. Tente novamente.\n");
+                limpar_console_dinamico();
+        }
+    } while (opcao != 0);
 }
 
 // ** Módulo Sobre ** 
@@ -831,6 +9467,265 @@ void extrair_numeros_rg(const char *rg_original, char *rg_numerico) {
     rg_numerico[j] = '\0';
 }
 
+// ** Módulo Autoteste ** 
+
+// Conferências não interativas das estruturas internas (opção "--testar"). Cada conferência
+// compara a estrutura com um modelo simples ou com o caminho de ida e volta e imprime OK ou
+// FALHA; os dados são gerados por um gerador congruencial fixo, para que as falhas se repitam.
+
+unsigned int sorteio_autoteste(unsigned int *semente) {
+    *semente = *semente * 1103515245u + 12345u;
+    return *semente >> 8;
+}
+
+int relatar_autoteste(const char *descricao, int aprovado) {
+    printf("  %-6s %s\n", aprovado ? "OK" : "FALHA", descricao);
+    return aprovado;
+}
+
+// Datas: toda a faixa aceita volta igual de dias para calendário e de texto para data, e as
+// datas inexistentes são recusadas
+int testar_datas() {
+    int aprovado = cria_data(1, 1, 1970) == 0 && cria_data(29, 2, 2024) != DATA_INVALIDA &&
+                   cria_data(29, 2, 2000) != DATA_INVALIDA && cria_data(29, 2, 1900) == DATA_INVALIDA &&
+                   cria_data(29, 2, 2023) == DATA_INVALIDA && cria_data(31, 4, 2024) == DATA_INVALIDA &&
+                   cria_data(1, 1, ANO_MINIMO - 1) == DATA_INVALIDA && cria_data(1, 13, 2024) == DATA_INVALIDA;
+    Data lida;
+    aprovado = aprovado && ler_data_texto("31/04/2024", &lida) == NULL && ler_data_texto("1/2/2024", &lida) != NULL &&
+               lida == cria_data(1, 2, 2024);
+    char texto[TAMANHO_DATA_TEXTO];
+    for (Data data = cria_data(1, 1, ANO_MINIMO); aprovado && data <= cria_data(31, 12, ANO_MAXIMO); data++) {
+        DataCalendario c = data_calendario(data);
+        aprovado = cria_data(c.dia, c.mes, c.ano) == data &&
+                   ler_data_texto(escrever_data_texto(data, texto), &lida) == texto + 10 && lida == data;
+    }
+    return relatar_autoteste("datas: codificação, validação e texto", aprovado);
+}
+
+// Deque em anel: as quatro pontas conferidas com um vetor, atravessando o fim do anel e os
+// crescimentos
+int testar_deque_fila() {
+    Fila *fila = inicializa_fila();
+    long long modelo[4096];
+    int inicio = 2048, qtde = 0, aprovado = 1;
+    unsigned int semente = 42;
+    for (int passo = 0; passo < 20000 && aprovado; passo++) {
+        EFila item = {NULL, passo};
+        unsigned int sorteio = sorteio_autoteste(&semente) % 8;
+        if (sorteio < 2 && qtde < 2000) {
+            fila_inserir_fim(fila, item);
+            modelo[inicio + qtde++] = passo;
+        } else if (sorteio < 4 && qtde < 2000) {
+            fila_inserir_inicio(fila, item);
+            modelo[--inicio] = passo;
+            qtde++;
+        } else if (sorteio < 6) {
+            aprovado = fila_retirar_inicio(fila, &item) == (qtde > 0) &&
+                       (qtde == 0 || item.enfileiradoEm == modelo[inicio]);
+            if (qtde > 0) {
+                inicio++;
+                qtde--;
+            }
+        } else {
+            aprovado = fila_retirar_fim(fila, &item) == (qtde > 0) &&
+                       (qtde == 0 || item.enfileiradoEm == modelo[inicio + qtde - 1]);
+            if (qtde > 0) {
+                qtde--;
+            }
+        }
+        if (qtde == 0 || inicio < 4 || inicio + qtde > 4092) {
+            // Recentra o modelo (a fila não muda)
+            memmove(modelo + 2048 - qtde / 2, modelo + inicio, (size_t)qtde * sizeof(long long));
+            inicio = 2048 - qtde / 2;
+        }
+        for (int i = 0; i < qtde && aprovado; i++) {
+            aprovado = elemento_fila(fila, i)->enfileiradoEm == modelo[inicio + i];
+        }
+        aprovado = aprovado && fila->qtde == qtde;
+    }
+    liberar_fila(fila);
+    return relatar_autoteste("fila: deque em anel", aprovado);
+}
+
+// Posição na fila: desistências no meio viram lápides e a posição de cada paciente, contada pela
+// árvore de Fenwick, é conferida com a ordem de um vetor
+int testar_posicao_fila() {
+    enum { PACIENTES = 600 };
+    Registro *pacientes = calloc(PACIENTES, sizeof(Registro));
+    int *modelo = malloc(PACIENTES * sizeof(int));
+    char *aguardando = calloc(PACIENTES, 1);
+    for (int i = 0; i < PACIENTES; i++) {
+        snprintf(pacientes[i].nome, sizeof(pacientes[i].nome), "Paciente %d", i);
+        snprintf(pacientes[i].rg, sizeof(pacientes[i].rg), "%d", 1000 + i);
+    }
+    Fila *fila = inicializa_fila();
+    ativar_mapa_fila(fila);
+    int qtde = 0, aprovado = 1;
+    unsigned int semente = 7;
+    for (int passo = 0; passo < 20000 && aprovado; passo++) {
+        int i = (int)(sorteio_autoteste(&semente) % PACIENTES);
+        unsigned int sorteio = sorteio_autoteste(&semente) % 6;
+        if (sorteio < 3 && !aguardando[i]) {
+            inserir_na_fila_em(fila, &pacientes[i], passo);
+            aguardando[i] = 1;
+            modelo[qtde++] = i;
+        } else if (sorteio == 3) {
+            Registro *atendido = retirar_da_fila_em(fila, NULL, NULL, passo);
+            aprovado = qtde == 0 ? atendido == NULL : atendido == &pacientes[modelo[0]];
+            if (qtde > 0) {
+                aguardando[modelo[0]] = 0;
+                memmove(modelo, modelo + 1, (size_t)--qtde * sizeof(int));
+            }
+        } else if (sorteio >= 4 && aguardando[i]) {
+            EFila item;
+            long long sequencia;
+            aprovado = desistir_da_fila(fila, pacientes[i].rg, &item, &sequencia) && item.dados == &pacientes[i];
+            int j = 0;
+            while (modelo[j] != i) j++;
+            memmove(modelo + j, modelo + j + 1, (size_t)(--qtde - j) * sizeof(int));
+            aguardando[i] = 0;
+        }
+        aprovado = aprovado && pacientes_na_fila(fila) == qtde;
+        if (passo % 50 == 0) {
+            for (int j = 0; j < qtde && aprovado; j++) {
+                Registro *encontrado;
+                aprovado = posicao_na_fila(fila, pacientes[modelo[j]].rg, &encontrado) == j &&
+                           encontrado == &pacientes[modelo[j]];
+            }
+        }
+    }
+    liberar_fila(fila);
+    free(aguardando);
+    free(modelo);
+    free(pacientes);
+    return relatar_autoteste("fila: posição com lápides (árvore de Fenwick)", aprovado);
+}
+
+// Ordenações: a radix (em paralelo, com mais de uma passada) e a intercalação precisam sair
+// ordenadas e estáveis
+int testar_ordenacoes() {
+    int n = 2 * LIMIAR_ORDENACAO_PARALELA;
+    unsigned int semente = 3;
+    unsigned long long *itens = malloc((size_t)n * sizeof(unsigned long long));
+    for (int i = 0; i < n; i++) {
+        itens[i] = (unsigned long long)(sorteio_autoteste(&semente) % 70000) << 32 | (unsigned int)i;
+    }
+    ordenar_radix(itens, n, threads_disponiveis());
+    int radix = 1;
+    for (int i = 1; i < n && radix; i++) {
+        radix = itens[i - 1] < itens[i];
+    }
+    free(itens);
+    Registro *registros = malloc((size_t)n * sizeof(Registro));
+    Registro **vetor = malloc((size_t)n * sizeof(Registro *));
+    for (int i = 0; i < n; i++) {
+        registros[i].idade = (int)(sorteio_autoteste(&semente) % (IDADE_MAXIMA + 1));
+        vetor[i] = &registros[i];
+    }
+    ordenar_registros(vetor, n, comparar_por_idade);
+    int intercalacao = 1;
+    for (int i = 1; i < n && intercalacao; i++) {
+        intercalacao = vetor[i - 1]->idade < vetor[i]->idade ||
+                       (vetor[i - 1]->idade == vetor[i]->idade && vetor[i - 1] < vetor[i]);
+    }
+    free(vetor);
+    free(registros);
+    relatar_autoteste("ordenação radix paralela", radix);
+    return relatar_autoteste("ordenação por intercalação", intercalacao) && radix;
+}
+
+// Arquivo compactado: grava e lê de volta vários blocos e confere cada paciente pelo RG
+int testar_arquivo_compactado() {
+    char nomeArquivo[] = "/tmp/dbPacientes.autoteste.XXXXXX";
+    int descritor = mkstemp(nomeArquivo);
+    if (descritor < 0) {
+        return relatar_autoteste("arquivo compactado: ida e volta (sem arquivo temporário)", 0);
+    }
+    close(descritor);
+    int n = 2 * REGISTROS_POR_BLOCO + 123;
+    unsigned int semente = 11;
+    Lista *original = inicializa_lista();
+    Lote *lote = iniciar_lote(n);
+    for (int i = 0; i < n; i++) {
+        Registro paciente;
+        unsigned int sorteio = sorteio_autoteste(&semente);
+        snprintf(paciente.nome, sizeof(paciente.nome), "Paciente %u", sorteio % 5000);
+        snprintf(paciente.rg, sizeof(paciente.rg), i % 3 ? "%09d" : "SP-%d-X", i);
+        paciente.idade = (int)(sorteio % (IDADE_MAXIMA + 1));
+        paciente.entrada = cria_data(1, 1, 1990) + (int)(sorteio % 12000);
+        adicionar_ao_lote(lote, paciente);
+    }
+    confirmar_lote(original, lote);
+    liberar_lote(lote);
+    Lista *lida = inicializa_lista();
+    ResumoImportacao resumo;
+    int aprovado = salvar_arquivo_compactado(original, nomeArquivo) &&
+                   carregar_arquivo_compactado(lida, nomeArquivo, &resumo) && lida->qtde == original->qtde;
+    for (ELista *no = original->inicio; no != NULL && aprovado; no = no->proximo) {
+        ELista *copia = consultar_paciente_rg(lida, no->dados->rg);
+        aprovado = copia != NULL && strcmp(copia->dados->nome, no->dados->nome) == 0 &&
+                   strcmp(copia->dados->rg, no->dados->rg) == 0 && copia->dados->idade == no->dados->idade &&
+                   copia->dados->entrada == no->dados->entrada;
+    }
+    unlink(nomeArquivo);
+    destruir_lista(lida);
+    destruir_lista(original);
+    return relatar_autoteste("arquivo compactado: ida e volta", aprovado);
+}
+
+// Segmento compartilhado: um terminal cai no meio de um cadastro segurando a trava; o próximo
+// terminal recupera a trava, desfaz o passo pela metade e continua usando o segmento
+int testar_recuperacao_segmento() {
+    char nome[64];
+    snprintf(nome, sizeof(nome), "/dbPacientes.autoteste.%d", (int)getpid());
+    RegistroCompartilhado *rc = conectar_registro_compartilhado(nome, 64);
+    if (rc == NULL) {
+        return relatar_autoteste("segmento compartilhado: recuperação (sem segmento)", 0);
+    }
+    Registro paciente = {"", 40, "", cria_data(1, 1, 2024)};
+    for (int i = 0; i < 20; i++) {
+        snprintf(paciente.nome, sizeof(paciente.nome), "Paciente %d", i);
+        snprintf(paciente.rg, sizeof(paciente.rg), "%d", 500 + i);
+        compartilhado_cadastrar(rc, &paciente);
+    }
+    snprintf(paciente.rg, sizeof(paciente.rg), "%d", 999);
+    pid_t terminal = fork();
+    if (terminal == 0) {
+        RegistroCompartilhado *outro = conectar_registro_compartilhado(nome, 64);
+        if (outro != NULL && iniciar_escrita_compartilhada(outro->segmento)) {
+            inserir_cadastro_compartilhado(outro->segmento, &paciente);
+        }
+        _exit(0);
+    }
+    int aprovado = terminal > 0 && waitpid(terminal, NULL, 0) == terminal;
+    // O cadastro desfeito pode ser refeito e o segmento continua consistente
+    aprovado = aprovado && compartilhado_cadastrar(rc, &paciente) == 1;
+    FotoCompartilhada *foto = criar_foto_compartilhada(64);
+    aprovado = aprovado && ler_segmento(rc->segmento, foto) && foto->qtdeCadastro == 21 &&
+               !(rc->segmento->versao & 1) && !rc->segmento->inutilizavel;
+    travar_segmento(rc->segmento);
+    aprovado = aprovado && validar_segmento(rc->segmento);
+    pthread_mutex_unlock(&rc->segmento->trava);
+    liberar_foto_compartilhada(foto);
+    desconectar_registro_compartilhado(rc);
+    shm_unlink(nome);
+    return relatar_autoteste("segmento compartilhado: recuperação após queda de um terminal", aprovado);
+}
+
+// Executa todas as conferências. Retorna o número de falhas.
+int executar_autotestes() {
+    int (*testes[])(void) = {testar_datas, testar_deque_fila, testar_posicao_fila, testar_ordenacoes,
+                             testar_arquivo_compactado, testar_recuperacao_segmento};
+    int qtde = (int)(sizeof(testes) / sizeof(testes[0]));
+    int falhas = 0;
+    printf("Autoteste:\n");
+    for (int i = 0; i < qtde; i++) {
+        falhas += !testes[i]();
+    }
+    printf("%s\n", falhas == 0 ? "Todas as conferências passaram." : "Há conferências com FALHA.");
+    return falhas;
+}
+
 // *******************************************
 // FUNÇÕES AUXILIARES
 // *******************************************
@@ -840,13 +9735,57 @@ void extrair_numeros_rg(const char *rg_original, char *rg_numerico) {
 // *******************************************
 // FUNÇÃO PRINCIPAL (main)
 // *******************************************
-int main() {
-    // Inicialização das estruturas principais
-    Lista *listaPacientes = inicializa_lista();
-    Fila *filaAtendimento = inicializa_fila();
-    Heap *filaPrioritaria = malloc(sizeof(Heap));
-    inicializar_heap(filaPrioritaria);
-    Stack *pilhaOperacoes = start_stack();
+int main(int argc, char *argv[]) {
+    // Linha de comando: "--reproduzir ARQ [--ritmo-original]" reexecuta uma sessão gravada e
+    // encerra; "--gravar ARQ" grava as operações desta sessão; "--servidor [SOCKET]" atende
+    // clientes locais em vez do menu, com os arquivos dos clientes no diretório de "--dados DIR"
+    // (padrão: o diretório atual); "--carga [SOCKET] [CONEXOES] [REQUISICOES] [PROFUNDIDADE]"
+    // mede a vazão e a latência de um servidor em execução; "--testar" executa as conferências
+    // internas (datas, fila, ordenações, arquivo compactado e segmento compartilhado) e
+    // retorna 1 se alguma falhar
+    const char *arquivoGravacao = NULL;
+    const char *diretorioDados = ".";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--testar") == 0) {
+            return executar_autotestes() == 0 ? 0 : 1;
+        }
+        if (strcmp(argv[i], "--reproduzir") == 0 && i + 1 < argc) {
+            int ritmoOriginal = i + 2 < argc && strcmp(argv[i + 2], "--ritmo-original") == 0;
+            if (reproduzir_sessao(argv[i + 1], ritmoOriginal) < 0) {
+                fprintf(stderr, "Não foi possível ler a gravação %s\n", argv[i + 1]);
+                return 1;
+            }
+            return 0;
+        }
+        if (strcmp(argv[i], "--gravar") == 0 && i + 1 < argc) {
+            arquivoGravacao = argv[++i];
+        }
+        if (strcmp(argv[i], "--dados") == 0 && i + 1 < argc) {
+            diretorioDados = argv[++i];
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--servidor") == 0) {
+            return executar_servidor(i + 1 < argc && argv[i + 1][0] != '-' ? argv[i + 1] : SOCKET_SERVIDOR_PADRAO,
+                                     arquivoGravacao, diretorioDados);
+        }
+        if (strcmp(argv[i], "--carga") == 0) {
+            const char *caminho = i + 1 < argc ? argv[i + 1] : SOCKET_SERVIDOR_PADRAO;
+            return executar_carga(caminho, i + 2 < argc ? atoi(argv[i + 2]) : 4,
+                                  i + 3 < argc ? atoi(argv[i + 3]) : 100000, i + 4 < argc ? atoi(argv[i + 4]) : 32);
+        }
+    }
+
+    // Inicialização das estruturas principais (todas as alterações passam pela sessão)
+    Sessao *sessao = criar_sessao(stdout);
+    Lista *listaPacientes = sessao->lista;
+    Fila *filaAtendimento = sessao->fila;
+    Heap *filaPrioritaria = sessao->heap;
+    Stack *pilhaOperacoes = sessao->pilha;
+    if (arquivoGravacao != NULL && !iniciar_gravacao(sessao, arquivoGravacao)) {
+        fprintf(stderr, "Não foi possível criar a gravação %s\n", arquivoGravacao);
+    }
+    SalvamentoAssincrono *salvamento = iniciar_salvamento_assincrono("dbPacientes.txt", listaPacientes);
 
     int opcaoMenuPrincipal;
     do {
@@ -862,6 +9801,7 @@ int main() {
         printf("║ 5 - Desfazer Operação          ║\n");
         printf("║ 6 - Carregar/Salvar Dados      ║\n");
         printf("║ 7 - Sobre                      ║\n");
+        printf("║ 8 - Ferramentas Avançadas      ║\n");
         printf("║ 0 - Sair                       ║\n");
         printf("╚════════════════════════════════╝\n");
         printf("\nSelecione uma opção: ");
@@ -889,38 +9829,34 @@ int main() {
                     switch (opcaoCadastro) {
                         case 1: {
                             // Cadastrar um novo paciente
-                            Registro novoPaciente;
-                            int dia, mes, ano;
-                            printf("\nNome: ");
-                            fgets(novoPaciente.nome, sizeof(novoPaciente.nome), stdin);
-                            novoPaciente.nome[strcspn(novoPaciente.nome, "\n")] = '\0';
-                            printf("Idade: ");
-                            scanf("%d", &novoPaciente.idade);
-                            getchar();
-                            printf("RG: ");
-                            fgets(novoPaciente.rg, sizeof(novoPaciente.rg), stdin);
-                            novoPaciente.rg[strcspn(novoPaciente.rg, "\n")] = '\0';
-                            printf("Data de entrada (dd mm aaaa): ");
-                            scanf("%d %d %d", &dia, &mes, &ano);
-                            getchar();
-                            novoPaciente.entrada = cria_data(dia, mes, ano);
-                            cadastrar_paciente(listaPacientes, novoPaciente);
+                            Operacao op = {.tipo = OP_CADASTRAR};
+                            ler_paciente_teclado(&op.paciente);
+                            int status = executar_operacao(sessao, &op, NULL);
+                            if (status == OPERACAO_INVALIDA) {
+                                avisar_registro_invalido();
+                                break;
+                            }
                             limpar_console();
-                            printf("\nSUCESSO!\nPaciente cadastrado!\n");
+                            if (status == OPERACAO_OK) {
+                                printf("\nSUCESSO!\nPaciente cadastrado!\n");
+                            } else {
+                                printf("\nERRO!\nOrçamento de memória esgotado (veja Ferramentas > Memória).\n");
+                            }
                             limpar_console_dinamico();
                             break;
                         }
                         case 2: {
                             // Consultar um paciente pelo nome
-                            char nomeBusca[100];
+                            Operacao op = {.tipo = OP_CONSULTAR_NOME};
                             printf("\nNome do paciente para consulta: ");
-                            fgets(nomeBusca, sizeof(nomeBusca), stdin);
-                            nomeBusca[strcspn(nomeBusca, "\n")] = '\0';
-                            ELista *resultado = consultar_paciente_nome(listaPacientes, nomeBusca);
-                            if (resultado != NULL) {
-                                printf("\nPaciente encontrado: %s | Idade: %d | RG: %s | Entrada: %02d/%02d/%04d\n",
-                                       resultado->dados->nome, resultado->dados->idade, resultado->dados->rg,
-                                       resultado->dados->entrada->dia, resultado->dados->entrada->mes, resultado->dados->entrada->ano);
+                            fgets(op.texto, sizeof(op.texto), stdin);
+                            op.texto[strcspn(op.texto, "\n")] = '\0';
+                            ResultadoOperacao resultado;
+                            if (executar_operacao(sessao, &op, &resultado) == OPERACAO_OK) {
+                                char data[TAMANHO_DATA_TEXTO];
+                                printf("\nPaciente encontrado: %s | Idade: %d | RG: %s | Entrada: %s (há %d dias)\n",
+                                       resultado.paciente->nome, resultado.paciente->idade, resultado.paciente->rg,
+                                       escrever_data_texto(resultado.paciente->entrada, data), dias_de_permanencia(resultado.paciente));
                                 limpar_console_dinamico();
                             } else {
                                 limpar_console();
@@ -931,7 +9867,7 @@ int main() {
                         }
                         case 3:
                             // Atualizar cadastro de um paciente
-                            atualizar_paciente(listaPacientes);
+                            atualizar_paciente(sessao);
                             break;
                         case 4: {
                             // Remover um paciente do cadastro
@@ -939,12 +9875,12 @@ int main() {
                             printf("\nNome do paciente para remover: ");
                             fgets(nomeRem, sizeof(nomeRem), stdin);
                             nomeRem[strcspn(nomeRem, "\n")] = '\0';
-                            remover_paciente(listaPacientes, nomeRem);
+                            remover_paciente(sessao, nomeRem);
                             break;
                         }
                         case 5:
                             // Listar todos os pacientes cadastrados
-                            imprimir_lista(listaPacientes);
+                            imprimir_lista(sessao);
                             limpar_console_dinamico();
                             break;
                         case 0:
@@ -966,6 +9902,9 @@ int main() {
                     printf("║ 1 - Enfileirar paciente            ║\n");
                     printf("║ 2 - Atender paciente               ║\n");
                     printf("║ 3 - Mostrar fila de atendimento    ║\n");
+                    printf("║ 4 - Estatísticas de espera         ║\n");
+                    printf("║ 5 - Registrar desistência          ║\n");
+                    printf("║ 6 - Posição de um paciente         ║\n");
                     printf("║ 0 - Voltar ao menu principal       ║\n");
                     printf("╚════════════════════════════════════╝\n");
                     printf("\nSelecione uma opção: ");
@@ -973,15 +9912,24 @@ int main() {
                     getchar();
                     switch (opcaoAtend) {
                         case 1:
-                            enfileirar_paciente(listaPacientes, filaAtendimento, pilhaOperacoes);
+                            enfileirar_paciente(sessao);
                             break;
                         case 2:
-                            desenfileirar_paciente(filaAtendimento, pilhaOperacoes);
+                            desenfileirar_paciente(sessao);
                             break;
                         case 3:
                             mostrar_fila(filaAtendimento);
                             limpar_console_dinamico();
                             break;
+                        case 4:
+                            consultar_estatisticas("Fila Comum", &filaAtendimento->estatisticas);
+                            break;
+                        case 5:
+                            desistir_paciente(sessao);
+                            break;
+                        case 6:
+                            consultar_posicao_fila(sessao);
+                            break;
                         case 0:
                             printf("\nVoltando ao menu principal...\n");
                             break;
@@ -1002,39 +9950,41 @@ int main() {
                     printf("║ 1 - Adicionar paciente à fila prioritária  ║\n");
                     printf("║ 2 - Atender paciente prioritário           ║\n");
                     printf("║ 3 - Mostrar fila prioritária               ║\n");
+                    printf("║ 4 - Configurar critério de prioridade      ║\n");
+                    printf("║ 5 - Estatísticas de espera                 ║\n");
+                    printf("║ 6 - Registrar desistência                  ║\n");
+                    printf("║ 7 - Posição de um paciente                 ║\n");
                     printf("║ 0 - Voltar ao menu principal               ║\n");
                     printf("╚════════════════════════════════════════════╝\n");
                     printf("\nSelecione uma opção: ");
                     scanf("%d", &opcaoPri);
                     getchar();
                     switch (opcaoPri) {
-                        case 1: {
+                        case 1:
                             // Enfileirar um paciente na fila prioritária
-                            char nomeBusca[100];
-                            printf("\nNome do paciente para prioridade: ");
-                            fgets(nomeBusca, sizeof(nomeBusca), stdin);
-                            nomeBusca[strcspn(nomeBusca, "\n")] = '\0';
-                            ELista *pacientePri = consultar_paciente_nome(listaPacientes, nomeBusca);
-                            if (pacientePri == NULL) {
-                                limpar_console();
-                                printf("\nERRO!\nPaciente não encontrado no cadastro.\n");
-                                limpar_console_dinamico();
-                            } else {
-                                inserir_heap(filaPrioritaria, pacientePri->dados);
-                                limpar_console();
-                                printf("\nPaciente %s inserido na fila prioritária.\n", pacientePri->dados->nome);
-                                limpar_console_dinamico();
-                            }
+                            inserir_paciente_prioritario(sessao);
                             break;
-                        }
                         case 2:
                             // Atender (remover) paciente prioritário da fila
-                            remover_heap(filaPrioritaria);
+                            atender_paciente_prioritario(sessao);
                             break;
                         case 3:
                             // Mostrar fila de atendimento prioritário
                             mostrar_heap(filaPrioritaria);
                             break;
+                        case 4:
+                            // Ajustar pesos de idade, espera e triagem
+                            configurar_criterio_heap(sessao);
+                            break;
+                        case 5:
+                            consultar_estatisticas("Fila Prioritária", &filaPrioritaria->estatisticas);
+                            break;
+                        case 6:
+                            desistir_paciente_prioritario(sessao);
+                            break;
+                        case 7:
+                            consultar_posicao_prioritaria(sessao);
+                            break;
                         case 0:
                             printf("\nVoltando ao menu principal...\n");
                             break;
@@ -1056,6 +10006,8 @@ int main() {
                     printf("║ 2 - Listar pacientes por mês de entrada    ║\n");
                     printf("║ 3 - Listar pacientes por dia de entrada    ║\n");
                     printf("║ 4 - Listar pacientes por idade             ║\n");
+                    printf("║ 5 - Painel de contagens                    ║\n");
+                    printf("║ 6 - Gravar relatórios em arquivos          ║\n");
                     printf("║ 0 - Voltar ao menu principal               ║\n");
                     printf("╚════════════════════════════════════════════╝\n");
                     printf("\nSelecione uma opção: ");
@@ -1063,43 +10015,32 @@ int main() {
                     scanf("%d", &opcaoPesq);
                     getchar();
                     if (opcaoPesq != 0) {
-                        // Cria uma árvore binária de busca temporária para ordenar os pacientes
-                        ABB *arvoreTemp = cria_abb();
+                        // As listagens ordenadas vêm do gerador de relatórios (ordenação radix paralela)
                         switch (opcaoPesq) {
                             case 1:
-                                limpar_console();
-                                reconstruir_abb(listaPacientes, arvoreTemp, comparar_por_ano);
-                                printf("\nPacientes ordenados por ano de entrada:\n\n");
-                                imprimir_in_ordem(arvoreTemp->raiz);
-                                limpar_console_dinamico();
+                                mostrar_relatorio(sessao, ORDEM_ANO, "ano de entrada");
                                 break;
                             case 2:
-                                limpar_console();
-                                reconstruir_abb(listaPacientes, arvoreTemp, comparar_por_mes);
-                                printf("\nPacientes ordenados por mês de entrada:\n\n");
-                                imprimir_in_ordem(arvoreTemp->raiz);
-                                limpar_console_dinamico();
+                                mostrar_relatorio(sessao, ORDEM_MES, "mês de entrada");
                                 break;
                             case 3:
-                                limpar_console();
-                                reconstruir_abb(listaPacientes, arvoreTemp, comparar_por_dia);
-                                printf("\nPacientes ordenados por dia de entrada:\n\n");
-                                imprimir_in_ordem(arvoreTemp->raiz);
-                                limpar_console_dinamico();
+                                mostrar_relatorio(sessao, ORDEM_DIA, "dia de entrada");
                                 break;
                             case 4:
+                                mostrar_relatorio(sessao, ORDEM_IDADE, "idade");
+                                break;
+                            case 5:
                                 limpar_console();
-                                reconstruir_abb(listaPacientes, arvoreTemp, comparar_por_idade);
-                                printf("\nPacientes ordenados por idade:\n\n");
-                                imprimir_in_ordem(arvoreTemp->raiz);
+                                mostrar_painel_contagens(listaPacientes);
                                 limpar_console_dinamico();
                                 break;
+                            case 6:
+                                gravar_relatorios_arquivo(listaPacientes);
+                                break;
                             default:
                                 printf("\nOpção inválida. Tente novamente.\n");
                                 limpar_console_dinamico();
                         }
-                        // Libera a estrutura da ABB temporária (os nós alocados não são liberados nesta implementação simplificada)
-                        free(arvoreTemp);
                     } else {
                         printf("\nVoltando ao menu principal...\n");
                     }
@@ -1113,7 +10054,7 @@ int main() {
                 scanf(" %c", &resposta);
                 getchar();
                 if (resposta == 's' || resposta == 'S') {
-                    desfazer_ultima_operacao(pilhaOperacoes, filaAtendimento);
+                    desfazer_ultima_operacao(sessao);
                 } else {
                     printf("\nNenhuma operação foi desfeita.\n");
                     limpar_console_dinamico();
@@ -1129,6 +10070,13 @@ int main() {
                     printf("╠════════════════════════════════════════════╣\n");
                     printf("║ 1 - Salvar lista de pacientes em arquivo   ║\n");
                     printf("║ 2 - Carregar lista de pacientes do arquivo ║\n");
+                    printf("║ 3 - Importar mesclando por RG              ║\n");
+                    printf("║ 4 - Salvar histórico compactado (.pca)     ║\n");
+                    printf("║ 5 - Carregar histórico compactado (.pca)   ║\n");
+                    printf("║ 6 - Consultar período no histórico .pca    ║\n");
+                    printf("║ 7 - Salvar em segundo plano                ║\n");
+                    printf("║ 8 - Status do último salvamento            ║\n");
+                    printf("║ 9 - Configurar salvamento automático       ║\n");
                     printf("║ 0 - Voltar ao menu principal               ║\n");
                     printf("╚════════════════════════════════════════════╝\n");
                     printf("\nSelecione uma opção: ");
@@ -1136,10 +10084,37 @@ int main() {
                     getchar();
                     switch (opcaoArq) {
                         case 1:
-                            salvar_lista(listaPacientes, "dbPacientes.txt");
+                            salvar_lista(sessao, "dbPacientes.txt");
                             break;
                         case 2:
-                            carregar_lista(listaPacientes, "dbPacientes.txt");
+                            carregar_lista(sessao, "dbPacientes.txt");
+                            break;
+                        case 3:
+                            importar_lista_mesclando(sessao, "dbPacientes.txt");
+                            break;
+                        case 4:
+                            salvar_lista(sessao, "dbPacientes.pca");
+                            break;
+                        case 5:
+                            carregar_lista(sessao, "dbPacientes.pca");
+                            break;
+                        case 6:
+                            consultar_periodo_compactado("dbPacientes.pca");
+                            break;
+                        case 7:
+                            // Congela o cadastro e grava em outra thread, sem bloquear o menu
+                            solicitar_salvamento(salvamento, listaPacientes);
+                            limpar_console();
+                            printf("\nSalvamento iniciado em segundo plano.\n");
+                            limpar_console_dinamico();
+                            break;
+                        case 8:
+                            limpar_console();
+                            mostrar_status_salvamento(salvamento, listaPacientes);
+                            limpar_console_dinamico();
+                            break;
+                        case 9:
+                            configurar_salvamento_automatico(salvamento);
                             break;
                         case 0:
                             printf("\nERRO!\nVoltando ao menu principal...\n");
@@ -1155,6 +10130,10 @@ int main() {
                 // Exibe informações sobre o projeto
                 mostrar_sobre();
                 break;
+            case 8:
+                // Recursos de armazenamento e desempenho
+                menu_ferramentas(sessao);
+                break;
             case 0:
                 // Encerra o programa
                 limpar_console();
@@ -1167,5 +10146,8 @@ int main() {
         }
     } while (opcaoMenuPrincipal != 0);
 
+    // Aguarda a conclusão de uma gravação em segundo plano antes de sair
+    encerrar_salvamento_assincrono(salvamento);
+    encerrar_sessao(sessao);
     return 0;
 }
\ No newline at end of file